@@ -1,5 +1,6 @@
 #version 450
 #extension GL_ARB_separate_shader_objects : enable
+#extension GL_GOOGLE_include_directive : require
 
 layout(binding = 0, set = 0) uniform ViewProj {
 	mat4 view;
@@ -19,13 +20,8 @@ layout(binding = 0, set = 4) uniform LightViewProj {
 	mat4 proj;
 } lightViewProj;
 
-layout(location = 0) in vec3 position;
-layout(location = 1) in vec3 normal;
-layout(location = 2) in vec3 tangent;
-layout(location = 3) in vec3 bitangent;
-layout(location = 4) in vec2 uv;
-layout(location = 5) in ivec3 boneIds;
-layout(location = 6) in vec3 boneWeights;
+#define ANIMATED_VERTICES
+#include "vertex_input.glsl"
 
 layout(location = 0) out vec3 fragNormal;
 layout(location = 1) out vec2 fragUv;
@@ -33,6 +29,8 @@ layout(location = 2) out vec3 fragPos;
 layout(location = 3) out vec3 lightFragPos;
 
 void main() {
+	DecodeVertex();
+
 	vec4 bonePosition1 = boneTransforms.m[max(0, boneIds[0])] * vec4(position, 1.0);
 	vec4 bonePosition2 = boneTransforms.m[max(0, boneIds[1])] * vec4(position, 1.0);
 	vec4 bonePosition3 = boneTransforms.m[max(0, boneIds[2])] * vec4(position, 1.0);
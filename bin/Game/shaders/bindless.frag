@@ -0,0 +1,85 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_EXT_nonuniform_qualifier : require
+
+layout(location = 0) in vec3 fragNormal;
+layout(location = 1) in vec2 fragUv;
+layout(location = 2) in vec3 fragPos;
+layout(location = 4) in mat3 tbn;
+layout(location = 7) in vec3 lightFragPos;
+layout(location = 8) flat in uint fragMaterialIndex;
+
+layout(location = 0) out vec4 outColor;
+
+struct MaterialData {
+	uint colorMap;
+	uint normalMap;
+	uint specularMap;
+	float shininess;
+	float useNormalMap;
+	float useSpecularMap;
+	float padding0;
+	float padding1;
+};
+
+layout(binding = 0, set = 2) uniform sampler2D textures[];
+
+layout(std430, binding = 1, set = 2) readonly buffer Materials {
+	MaterialData materials[];
+} materials;
+
+layout(binding = 0, set = 3) uniform DirectionalLight {
+	vec3 direction;
+	vec3 color;
+	float intensity;
+} directionalLight;
+
+layout(binding = 1, set = 3) uniform AmbientLight {
+	vec3 cameraPosition;
+	vec3 color;
+	float intensity;
+} ambientLight;
+
+layout(binding = 2, set = 3) uniform sampler2D shadowMap;
+
+float ShadowCalc() {
+	vec3 tmp = lightFragPos;
+	tmp.x = tmp.x * 0.5 + 0.5;
+	tmp.y = -(tmp.y * 0.5 + 0.5);
+	
+	float closestDepth = texture(shadowMap, tmp.xy).r;
+	
+	float currentDepth = tmp.z;
+	
+	float bias = 0.0005;
+	float shadow = currentDepth - bias < closestDepth ? 1.0 : 0.2;
+	
+	return shadow;
+}
+
+void main() {
+	MaterialData materialProperties = materials.materials[fragMaterialIndex];
+	
+	vec3 ambLight = ambientLight.color * ambientLight.intensity;
+	
+	vec3 lightDir = normalize(directionalLight.direction);
+	vec3 surfaceNormal = normalize(fragNormal);
+	if(materialProperties.useNormalMap > 0.0) {
+		// z is rebuilt from x and y so two channel (BC5) normal maps work too
+		vec2 normalXY = texture(textures[nonuniformEXT(materialProperties.normalMap)], fragUv).rg * 2.0 - 1.0;
+		surfaceNormal = vec3(normalXY, sqrt(max(1.0 - dot(normalXY, normalXY), 0.0)));
+		surfaceNormal = tbn * surfaceNormal;
+		surfaceNormal = normalize(surfaceNormal);
+	}
+	vec3 dirLight = directionalLight.color * max(0, dot(-lightDir, surfaceNormal)) * directionalLight.intensity;
+	
+	// specular 
+    vec3 viewDir = normalize(ambientLight.cameraPosition - fragPos);
+    vec3 halfwayDir = normalize(-lightDir + viewDir);
+	float spec = pow(max(dot(surfaceNormal, halfwayDir), 0.0), materialProperties.shininess);
+    vec3 specular = directionalLight.color * spec; 
+	
+	vec3 texcolor = texture(textures[nonuniformEXT(materialProperties.colorMap)], fragUv).xyz;
+    outColor = vec4(texcolor * (ambLight + (dirLight) * ShadowCalc()), 1);
+    //outColor = vec4(surfaceNormal, 1);
+}
\ No newline at end of file
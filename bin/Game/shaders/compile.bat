@@ -1,13 +1,28 @@
 C:\VulkanSDK\1.2.131.2\Bin\glslc.exe shader.vert -o out/vertex.spv
+C:\VulkanSDK\1.2.131.2\Bin\glslc.exe shader.vert -DPACKED_VERTICES -o out/vertex_packed.spv
 C:\VulkanSDK\1.2.131.2\Bin\glslc.exe shader.frag -o out/fragment.spv
+C:\VulkanSDK\1.2.131.2\Bin\glslc.exe instanced.vert -o out/instanced_vertex.spv
+C:\VulkanSDK\1.2.131.2\Bin\glslc.exe instanced.vert -DPACKED_VERTICES -o out/instanced_vertex_packed.spv
+C:\VulkanSDK\1.2.131.2\Bin\glslc.exe bindless.vert -o out/bindless_vertex.spv
+C:\VulkanSDK\1.2.131.2\Bin\glslc.exe bindless.vert -DPACKED_VERTICES -o out/bindless_vertex_packed.spv
+C:\VulkanSDK\1.2.131.2\Bin\glslc.exe bindless.frag -o out/bindless_fragment.spv
 
 C:\VulkanSDK\1.2.131.2\Bin\glslc.exe shadow.vert -o out/shadow_vertex.spv
+C:\VulkanSDK\1.2.131.2\Bin\glslc.exe shadow.vert -DPACKED_VERTICES -o out/shadow_vertex_packed.spv
 C:\VulkanSDK\1.2.131.2\Bin\glslc.exe shadow.frag -o out/shadow_fragment.spv
+C:\VulkanSDK\1.2.131.2\Bin\glslc.exe shadow_instanced.vert -o out/shadow_instanced_vertex.spv
+C:\VulkanSDK\1.2.131.2\Bin\glslc.exe shadow_instanced.vert -DPACKED_VERTICES -o out/shadow_instanced_vertex_packed.spv
 
 C:\VulkanSDK\1.2.131.2\Bin\glslc.exe animated_shader.vert -o out/animated_vertex.spv
+C:\VulkanSDK\1.2.131.2\Bin\glslc.exe animated_shader.vert -DPACKED_VERTICES -o out/animated_vertex_packed.spv
 C:\VulkanSDK\1.2.131.2\Bin\glslc.exe animated_shader.frag -o out/animated_fragment.spv
 
 C:\VulkanSDK\1.2.131.2\Bin\glslc.exe shadow_animated.vert -o out/shadow_animated_vertex.spv
+C:\VulkanSDK\1.2.131.2\Bin\glslc.exe shadow_animated.vert -DPACKED_VERTICES -o out/shadow_animated_vertex_packed.spv
 C:\VulkanSDK\1.2.131.2\Bin\glslc.exe shadow_animated.frag -o out/shadow_animated_fragment.spv
 
+C:\VulkanSDK\1.2.131.2\Bin\glslc.exe cull.comp -o out/cull_compute.spv
+C:\VulkanSDK\1.2.131.2\Bin\glslc.exe cull_compact.comp -o out/cull_compact_compute.spv
+C:\VulkanSDK\1.2.131.2\Bin\glslc.exe hiz.comp -o out/hiz_compute.spv
+
 pause
\ No newline at end of file
@@ -0,0 +1,52 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_GOOGLE_include_directive : require
+
+layout(binding = 0, set = 0) uniform ViewProj {
+	mat4 view;
+	mat4 proj;
+} viewProj;
+
+struct ObjectData {
+	mat4 model;
+	uint materialIndex;
+	uint firstIndex;
+	int vertexOffset;
+	uint indexCount;
+};
+
+layout(std430, binding = 0, set = 1) readonly buffer Objects {
+	ObjectData objects[];
+} objects;
+
+layout(binding = 0, set = 4) uniform LightViewProj {
+	mat4 view;
+	mat4 proj;
+} lightViewProj;
+
+#include "vertex_input.glsl"
+
+layout(location = 0) out vec3 fragNormal;
+layout(location = 1) out vec2 fragUv;
+layout(location = 2) out vec3 fragPos;
+layout(location = 4) out mat3 tbn;
+layout(location = 7) out vec3 lightFragPos;
+
+void main() {
+	DecodeVertex();
+
+	mat4 model = objects.objects[gl_InstanceIndex].model;
+
+	fragPos = vec3(model * vec4(position, 1.0));
+    fragNormal = mat3(transpose(inverse(model))) * normal;
+	fragUv = uv;
+	
+    gl_Position = viewProj.proj * viewProj.view * vec4(fragPos, 1.0);
+	
+	vec3 t = normalize(vec3(model * vec4(tangent, 0.0)));
+	vec3 b = normalize(vec3(model * vec4(bitangent, 0.0)));
+	vec3 n = normalize(vec3(model * vec4(normal, 0.0)));
+	tbn = transpose(mat3(t, b, n));
+	
+	lightFragPos = (lightViewProj.proj * lightViewProj.view * model * vec4(position.x, position.y, position.z, 1)).xyz;
+}
\ No newline at end of file
@@ -53,9 +53,10 @@ void main() {
 	vec3 lightDir = normalize(directionalLight.direction);
 	vec3 surfaceNormal = normalize(fragNormal);
 	if(materialProperties.useNormalMap > 0.0) {
-		surfaceNormal = texture(normalMap, fragUv).rgb;
-		//surfaceNormal = surfaceNormal * 2.0 - 1.0;
-		surfaceNormal = tbn * normalize(surfaceNormal);
+		// z is rebuilt from x and y so two channel (BC5) normal maps work too
+		vec2 normalXY = texture(normalMap, fragUv).rg * 2.0 - 1.0;
+		surfaceNormal = vec3(normalXY, sqrt(max(1.0 - dot(normalXY, normalXY), 0.0)));
+		surfaceNormal = tbn * surfaceNormal;
 		surfaceNormal = normalize(surfaceNormal);
 	}
 	vec3 dirLight = directionalLight.color * max(0, dot(-lightDir, surfaceNormal)) * directionalLight.intensity;
@@ -1,5 +1,6 @@
 #version 450
 #extension GL_ARB_separate_shader_objects : enable
+#extension GL_GOOGLE_include_directive : require
 
 layout(binding = 0, set = 0) uniform ViewProj {
 	mat4 view;
@@ -15,11 +16,7 @@ layout(binding = 0, set = 4) uniform LightViewProj {
 	mat4 proj;
 } lightViewProj;
 
-layout(location = 0) in vec3 position;
-layout(location = 1) in vec3 normal;
-layout(location = 2) in vec3 tangent;
-layout(location = 3) in vec3 bitangent;
-layout(location = 4) in vec2 uv;
+#include "vertex_input.glsl"
 
 layout(location = 0) out vec3 fragNormal;
 layout(location = 1) out vec2 fragUv;
@@ -28,6 +25,8 @@ layout(location = 4) out mat3 tbn;
 layout(location = 7) out vec3 lightFragPos;
 
 void main() {
+	DecodeVertex();
+
 	fragPos = vec3(model.model * vec4(position, 1.0));
     fragNormal = mat3(transpose(inverse(model.model))) * normal;
 	fragUv = uv;
@@ -0,0 +1,29 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_GOOGLE_include_directive : require
+
+layout(binding = 0, set = 0) uniform ViewProj {
+	mat4 view;
+	mat4 proj;
+} viewProj;
+
+struct ObjectData {
+	mat4 model;
+	uint materialIndex;
+	uint firstIndex;
+	int vertexOffset;
+	uint indexCount;
+};
+
+layout(std430, binding = 0, set = 1) readonly buffer Objects {
+	ObjectData objects[];
+} objects;
+
+#include "vertex_input.glsl"
+
+void main() {
+	DecodeVertex();
+
+	mat4 model = objects.objects[gl_InstanceIndex].model;
+	gl_Position = viewProj.proj * viewProj.view * model * vec4(position, 1);
+}
@@ -0,0 +1,61 @@
+// Vertex inputs of the model shaders. Compiled with -DPACKED_VERTICES they read PackedVertex (or PackedAnimatedVertex
+// with ANIMATED_VERTICES defined before the include) and DecodeVertex, called first in main, unpacks them into the
+// same names the full vertices use
+
+layout(location = 0) in vec3 position;
+
+#ifdef PACKED_VERTICES
+
+layout(location = 1) in vec2 packedNormal;
+layout(location = 2) in vec2 packedTangent;
+layout(location = 4) in vec2 uv;
+
+vec3 normal;
+vec3 tangent;
+vec3 bitangent;
+
+#ifdef ANIMATED_VERTICES
+layout(location = 5) in uvec4 packedBoneIds;
+layout(location = 6) in vec4 packedBoneWeights;
+
+ivec3 boneIds;
+vec3 boneWeights;
+#endif
+
+vec3 DecodeOctahedral(vec2 p) {
+	vec3 n = vec3(p, 1.0 - abs(p.x) - abs(p.y));
+	float fold = max(-n.z, 0.0);
+	n.xy += mix(vec2(fold), vec2(-fold), greaterThanEqual(n.xy, vec2(0.0)));
+	return normalize(n);
+}
+
+void DecodeVertex() {
+	normal = DecodeOctahedral(packedNormal);
+
+	// the sign of the tangent's second component is the handedness, its magnitude is remapped to [0, 1]
+	float handedness = packedTangent.y < 0.0 ? -1.0 : 1.0;
+	tangent = DecodeOctahedral(vec2(packedTangent.x, abs(packedTangent.y) * 2.0 - 1.0));
+	bitangent = handedness * cross(normal, tangent);
+
+#ifdef ANIMATED_VERTICES
+	boneIds = ivec3(packedBoneIds.xyz);
+	boneWeights = packedBoneWeights.xyz;
+#endif
+}
+
+#else
+
+layout(location = 1) in vec3 normal;
+layout(location = 2) in vec3 tangent;
+layout(location = 3) in vec3 bitangent;
+layout(location = 4) in vec2 uv;
+
+#ifdef ANIMATED_VERTICES
+layout(location = 5) in ivec3 boneIds;
+layout(location = 6) in vec3 boneWeights;
+#endif
+
+void DecodeVertex() {
+}
+
+#endif
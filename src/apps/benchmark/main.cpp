@@ -0,0 +1,320 @@
+#include <iostream>
+
+#include "App.h"
+#include "graphics/Mesh.h"
+#include "graphics/ModelPipeline.h"
+#include "graphics/AnimatedModelPipeline.h"
+#include "graphics/Camera.h"
+#include "graphics/Texture.h"
+#include "graphics/Material.h"
+#include "graphics/DirectionalLight.h"
+#include "graphics/Shadows.h"
+#include "graphics/AnimatedShadows.h"
+#include "math/Math.h"
+#include "resources/TextureResource.h"
+#include "resources/ModelResource.h"
+
+#include <vector>
+#include <thread>
+#include <string.h>
+#include <stdlib.h>
+
+using namespace Euler;
+
+// Renders a grid of balls headless and measures how long command recording takes on the render thread
+// with a growing number of recording threads. Run it from bin/Game so the resources can be found:
+//   Benchmark [--objects <count>] [--frames <frames per thread count>] [--indirect] [--bindless] [--no-culling] [--gpu-culling] [--occlusion] [--no-lods] [--packed] [--no-mipmaps] [--cooked]
+//   [--streaming] [--texture-budget <megabytes>]
+// The headless summary's ms/frame with and without --no-mipmaps compares texture sampling with and without mip chains,
+// --cooked loads the .ktx2 textures eulertexture writes next to the .png ones and --streaming streams their finer levels
+class BenchmarkApp : public App
+{
+private:
+	Graphics::ModelPipeline _modelPipeline;
+	Graphics::AnimatedModelPipeline _animatedPipeline;
+	Graphics::Shadows _shadows;
+	Graphics::AnimatedShadows _animatedShadows;
+	Graphics::DirectionalLight _dirLight;
+	Camera _camera;
+
+	Mesh _ballMesh;
+	Graphics::Texture _ballTexture, _ballNormalMap;
+	Graphics::Material _ballMaterial;
+	Graphics::MeshMaterial _ballMeshMaterial;
+	std::vector<Model> _balls;
+
+	std::vector<uint32_t> _threadCounts;
+	uint32_t _phase = 0;
+	uint32_t _phaseFrame = 0;
+	double _phaseRecordingTime = 0.0;
+
+public:
+	uint32_t ObjectCount = 4096;
+	uint32_t FramesPerPhase = 200;
+	bool IndirectDraws = false;
+	bool Bindless = false;
+	bool FrustumCulling = true;
+	bool GpuCulling = false;
+	bool OcclusionCulling = false;
+	bool Lods = true;
+	bool PackedVertices = false;
+	bool Mipmaps = true;
+	bool CookedTextures = false;
+	bool TextureStreaming = false;
+	uint32_t TextureBudget = 0;
+
+	void OnStart() override
+	{
+		// 0 is recording on the render thread, then powers of two up to the number of cores
+		uint32_t maxThreads = std::thread::hardware_concurrency();
+		_threadCounts.push_back(0);
+		for (uint32_t threads = 1; threads <= maxThreads; threads *= 2)
+		{
+			_threadCounts.push_back(threads);
+		}
+
+		Headless = true;
+		HeadlessFrameCount = FramesPerPhase * _threadCounts.size();
+
+		// a model matrix takes up to 256 bytes with the dynamic offset alignment, more than a ball's instance
+		// data and indirect command, plus room for the lights and the animated models
+		uint64_t frameBytes = (uint64_t)ObjectCount * 256 + 1024 * 1024;
+		uint32_t frameMemory = (uint32_t)((frameBytes + 1024 * 1024 - 1) / (1024 * 1024));
+		FrameMemory = frameMemory > FrameMemory ? frameMemory : FrameMemory;
+		RecordingThreads = _threadCounts[0];
+	}
+
+	void OnCreate() override
+	{
+		_modelPipeline.UseIndirectDraws = IndirectDraws;
+		_modelPipeline.UseBindless = Bindless;
+		_modelPipeline.UseFrustumCulling = FrustumCulling;
+		_modelPipeline.UseGpuCulling = GpuCulling;
+		_modelPipeline.UseOcclusionCulling = OcclusionCulling;
+		_modelPipeline.UseLods = Lods;
+		_modelPipeline.UsePackedVertices = PackedVertices;
+		_modelPipeline.Create(Vulkan, 1920, 1080);
+		_animatedPipeline.Create(Vulkan, 1920, 1080);
+
+		// setup light
+		_dirLight.Direction = Vec3(0, -1, 1).Normalized();
+		_dirLight.Color = Vec3(1, 1, 1);
+		_dirLight.Intensity = 1.0f;
+		_modelPipeline.DirLight = &_dirLight;
+		_modelPipeline.AmbLight.Color = Vec3(1, 1, 1);
+		_modelPipeline.AmbLight.Intensity = 0.1f;
+		_animatedPipeline.DirLight = &_dirLight;
+		_animatedPipeline.AmbLight.Color = Vec3(1, 1, 1);
+		_animatedPipeline.AmbLight.Intensity = 0.1f;
+
+		// create camera
+		_camera.Init(1920, 1080, 60.0f, 0.01f, 100.0f);
+		_camera.Transform.SetPosition(Vec3(0, 3, -3.7f));
+		_camera.Transform.SetRotation(Quaternion::Euler(Math::Rad(-45.0f), Vec3(1, 0, 0)));
+
+		SetupBalls();
+
+		// setup shadows, the animated shadows end the shadow render pass
+		_shadows.Create(Vulkan, &_modelPipeline, 1920, 1080);
+		_animatedShadows.Create(Vulkan, &_animatedPipeline, 1920, 1080, _shadows._shadowRenderPass);
+	}
+
+	void OnUpdate() override
+	{
+		if (_phaseFrame == FramesPerPhase)
+		{
+			std::cout << "Recording threads: " << _threadCounts[_phase] << ", "
+				<< _phaseRecordingTime / FramesPerPhase << " ms/frame recording" << std::endl;
+			PrintRenderQueueStats();
+
+			_phase++;
+			_phaseFrame = 0;
+			_phaseRecordingTime = 0.0;
+
+			if (_phase < _threadCounts.size())
+			{
+				Vulkan->_commandRecorder.SetWorkerCount(_threadCounts[_phase]);
+			}
+		}
+	}
+
+	void OnDraw() override
+	{
+		_modelPipeline.Update(&_camera, _camera.GetViewProj());
+		_animatedPipeline.Update(&_camera, _camera.GetViewProj(), std::vector<Mat4>());
+
+		_shadows.RecordCommands(_camera);
+		_animatedShadows.RecordCommands(_camera);
+		_modelPipeline.RecordCommands(_camera.GetViewProj());
+		_animatedPipeline.RecordCommands(_camera.GetViewProj(), std::vector<Mat4>());
+
+		_phaseRecordingTime += Vulkan->_commandRecorder.GetFrameRecordingTime();
+		_phaseFrame++;
+	}
+
+	void OnComplete() override
+	{
+		if (_phaseFrame > 0 && _phase < _threadCounts.size())
+		{
+			std::cout << "Recording threads: " << _threadCounts[_phase] << ", "
+				<< _phaseRecordingTime / _phaseFrame << " ms/frame recording" << std::endl;
+			PrintRenderQueueStats();
+		}
+	}
+
+	// counters of the last frame, the render queues are only used when the models aren't instanced
+	void PrintRenderQueueStats()
+	{
+		Graphics::RenderQueueStats stats = _modelPipeline._renderQueue.GetStats();
+		stats.Add(_shadows._renderQueue.GetStats());
+
+		std::cout << "  draws " << stats.Draws
+			<< ", pipeline binds " << stats.PipelineBinds << " (" << stats.PipelineBindsSkipped << " skipped)"
+			<< ", set binds " << stats.DescriptorSetBinds << " (" << stats.DescriptorSetBindsSkipped << " skipped)"
+			<< ", buffer binds " << stats.BufferBinds << " (" << stats.BufferBindsSkipped << " skipped)" << std::endl;
+
+		if (_modelPipeline.UseGpuCulling)
+		{
+			Graphics::GpuCullingStats cullingStats = _modelPipeline._gpuCulling.GetStats();
+
+			std::cout << "  objects " << cullingStats.Objects
+				<< ", frustum culled " << cullingStats.FrustumCulled
+				<< ", occluded " << cullingStats.Occluded
+				<< ", visible in the late pass " << cullingStats.LateVisible << std::endl;
+		}
+
+		if (Vulkan->_textureStreamer.HasTextures())
+		{
+			std::cout << "  streamed textures " << Vulkan->_textureStreamer.GetResidentBytes() / (1024 * 1024) << " MB"
+				<< " of a " << Vulkan->_textureStreamer.GetBudget() / (1024 * 1024) << " MB budget" << std::endl;
+		}
+	}
+
+	void SetupBalls()
+	{
+		ModelResource modelResource;
+		modelResource.Map("res/ball/ball.bem", _modelPipeline.GetVertexFormat());
+
+		// the vectors are only filled when the file had to be converted
+		_ballMesh.View = modelResource.View;
+		_ballMesh.Vertices = std::move(modelResource.Vertices);
+		_ballMesh.PackedVertices = std::move(modelResource.PackedVertices);
+		_ballMesh.Indices = std::move(modelResource.Indices);
+		_ballMesh.ShortIndices = std::move(modelResource.ShortIndices);
+		_ballMesh.Lods = modelResource.Lods;
+		_ballMesh.Create(Vulkan);
+
+		modelResource.Unload();
+
+		_ballTexture.UseMipmaps = Mipmaps;
+		_ballNormalMap.UseMipmaps = Mipmaps;
+		_ballNormalMap.Srgb = false;
+
+		// .ktx2 files are streamed when the streamer is enabled
+		Vulkan->_textureStreamer.Enabled = TextureStreaming;
+		Vulkan->_textureStreamer.Budget = (VkDeviceSize)TextureBudget * 1024 * 1024;
+
+		_ballTexture.Create(Vulkan, CookedTextures ? "res/ball/ballTexture.ktx2" : "res/ball/ballTexture.png", _modelPipeline.MaterialLayout);
+		_ballNormalMap.Create(Vulkan, CookedTextures ? "res/ball/ballNormalMap.ktx2" : "res/ball/ballNormalMap.png", _modelPipeline.MaterialLayout);
+
+		_ballMaterial.ColorMap = &_ballTexture;
+		_ballMaterial.NormalMap = &_ballNormalMap;
+		_ballMaterial.Properties.Shininess = 1.0f;
+		_ballMaterial.Properties.UseNormalMap = 1.0f;
+		_ballMaterial.Create(Vulkan, _modelPipeline.MaterialPropertiesLayout);
+
+		_ballMeshMaterial.Material = &_ballMaterial;
+		_ballMeshMaterial.Mesh = &_ballMesh;
+
+		// lay the balls out on a square grid
+		uint32_t side = 1;
+		while (side * side < ObjectCount)
+		{
+			side++;
+		}
+
+		_balls.resize(ObjectCount);
+		for (uint32_t i = 0; i < ObjectCount; i++)
+		{
+			float x = ((float)(i % side) / side - 0.5f) * 4.0f;
+			float z = ((float)(i / side) / side - 0.5f) * 4.0f;
+
+			_balls[i].Drawables.push_back(&_ballMeshMaterial);
+			_balls[i].Transform.SetPosition(x, 0.2f, z);
+			_balls[i].Transform.SetRotation(Quaternion::Euler(Math::Rad(90.0f), Vec3(1, 0, 0)));
+			_balls[i].Transform.SetScale(2.0f / side);
+
+			_modelPipeline.Models.push_back(&_balls[i]);
+		}
+	}
+};
+
+int main(int argc, char** argv)
+{
+	BenchmarkApp app;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--objects") == 0 && i + 1 < argc)
+		{
+			app.ObjectCount = (uint32_t)atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+		{
+			app.FramesPerPhase = (uint32_t)atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--indirect") == 0)
+		{
+			app.IndirectDraws = true;
+		}
+		else if (strcmp(argv[i], "--bindless") == 0)
+		{
+			app.Bindless = true;
+		}
+		else if (strcmp(argv[i], "--no-culling") == 0)
+		{
+			app.FrustumCulling = false;
+		}
+		else if (strcmp(argv[i], "--gpu-culling") == 0)
+		{
+			// the culling pass writes objects for the bindless shaders
+			app.Bindless = true;
+			app.GpuCulling = true;
+		}
+		else if (strcmp(argv[i], "--occlusion") == 0)
+		{
+			app.Bindless = true;
+			app.GpuCulling = true;
+			app.OcclusionCulling = true;
+		}
+		else if (strcmp(argv[i], "--no-lods") == 0)
+		{
+			app.Lods = false;
+		}
+		else if (strcmp(argv[i], "--packed") == 0)
+		{
+			app.PackedVertices = true;
+		}
+		else if (strcmp(argv[i], "--no-mipmaps") == 0)
+		{
+			app.Mipmaps = false;
+		}
+		else if (strcmp(argv[i], "--cooked") == 0)
+		{
+			app.CookedTextures = true;
+		}
+		else if (strcmp(argv[i], "--streaming") == 0)
+		{
+			app.CookedTextures = true;
+			app.TextureStreaming = true;
+		}
+		else if (strcmp(argv[i], "--texture-budget") == 0 && i + 1 < argc)
+		{
+			app.TextureBudget = (uint32_t)atoi(argv[++i]);
+		}
+	}
+
+	app.Run();
+
+	return 0;
+}
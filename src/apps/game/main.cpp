@@ -66,16 +66,14 @@ private:
 	Quaternion _originalCameraRotation;
 
 	// Floor
-	Mesh _floorMesh;
-	Graphics::Texture _floorTexture, _floorNormalMap;
-	Graphics::Material _floorMaterial;
+	LoadHandle<Mesh> _floorMesh;
+	LoadHandle<Graphics::Material> _floorMaterial;
 	Graphics::MeshMaterial _floorMeshMaterial;
 	Model _floorModel;
 
 	// Wall
-	Mesh _wallMesh;
-	Graphics::Texture _wallTexture, _wallNormalMap;
-	Graphics::Material _wallMaterial;
+	LoadHandle<Mesh> _wallMesh;
+	LoadHandle<Graphics::Material> _wallMaterial;
 	Graphics::MeshMaterial _wallMeshMaterial;
 	Model _wallModel;
 
@@ -89,9 +87,8 @@ private:
 	float _rot = 0.0f;
 
 	// Ball
-	Mesh _ballMesh;
-	Graphics::Texture _ballTexture, _ballNormalMap;
-	Graphics::Material _ballMaterial;
+	LoadHandle<Mesh> _ballMesh;
+	LoadHandle<Graphics::Material> _ballMaterial;
 	Graphics::MeshMaterial _ballMeshMaterial;
 
 	Ball Balls[MAX_BALLS];
@@ -129,6 +126,15 @@ public:
 		SetupChar();
 		SetupBall();
 
+		// the Setup functions only queued their files, the loader's workers read them all at once
+		Resources->GetLoader().FinishAll();
+		_floorMeshMaterial.Mesh = _floorMesh.Get();
+		_floorMeshMaterial.Material = _floorMaterial.Get();
+		_wallMeshMaterial.Mesh = _wallMesh.Get();
+		_wallMeshMaterial.Material = _wallMaterial.Get();
+		_ballMeshMaterial.Mesh = _ballMesh.Get();
+		_ballMeshMaterial.Material = _ballMaterial.Get();
+
 		// setup shadows
 		_shadows.Create(Vulkan, &_modelPipeline, 1920, 1080);
 		_animatedShadows.Create(Vulkan, &_animatedPipeline, 1920, 1080, _shadows._shadowRenderPass);
@@ -350,10 +356,13 @@ public:
 		_animatedPipeline.RecordCommands(_camera.GetViewProj(), _animator.BoneMatrices);
 	}
 
-	void OnDestroy() override
+	void OnComplete() override
 	{
-		_floorMesh.Destroy(Vulkan);
+		Resources->PrintStats();
+	}
 
+	void OnDestroy() override
+	{
 		_shadows.Destroy();
 
 		_animatedPipeline.Destroy();
@@ -362,33 +371,14 @@ public:
 
 	void SetupFloor()
 	{
-		ModelResource modelResource;
-		modelResource.Load("res/floor/floor.bem");
-
-		_floorMesh.Vertices = modelResource.Vertices;
-		_floorMesh.Indices = modelResource.Indices;
-		_floorMesh.Create(Vulkan);
-
-		modelResource.Unload();
-
-		TextureResource textureResource;
-
-		textureResource.Load("res/floor/floorTexture.png", TEXTURE_CHANNELS_RGBA);
-		_floorTexture.Create(Vulkan, &textureResource, _modelPipeline.MaterialLayout);
-		textureResource.Unload();
-
-		textureResource.Load("res/floor/floorNormalMap.png", TEXTURE_CHANNELS_RGBA);
-		_floorNormalMap .Create(Vulkan, &textureResource, _modelPipeline.MaterialLayout);
-		textureResource.Unload();
+		_floorMesh = Resources->GetMeshAsync("res/floor/floor.bem");
 
-		_floorMaterial.ColorMap = &_floorTexture;
-		_floorMaterial.NormalMap = &_floorNormalMap;
-		_floorMaterial.Properties.Shininess = 1.0f;
-		_floorMaterial.Properties.UseNormalMap = 1.0f;
-		_floorMaterial.Create(Vulkan, _modelPipeline.MaterialPropertiesLayout);
-		
-		_floorMeshMaterial.Material = &_floorMaterial;
-		_floorMeshMaterial.Mesh = &_floorMesh;
+		MaterialDesc materialDesc;
+		materialDesc.ColorMap = "res/floor/floorTexture.png";
+		materialDesc.NormalMap = "res/floor/floorNormalMap.png";
+		materialDesc.Properties.Shininess = 1.0f;
+		materialDesc.Properties.UseNormalMap = 1.0f;
+		_floorMaterial = Resources->GetMaterialAsync(materialDesc, _modelPipeline.MaterialLayout, _modelPipeline.MaterialPropertiesLayout);
 
 		_floorModel.Drawables.push_back(&_floorMeshMaterial);
 		_floorModel.Transform.SetRotation(Quaternion::Euler(Math::Rad(90.0f), Vec3(1, 0, 0)));
@@ -399,33 +389,14 @@ public:
 
 	void SetupWall()
 	{
-		ModelResource modelResource;
-		modelResource.Load("res/walls/walls.bem");
-
-		_wallMesh.Vertices = modelResource.Vertices;
-		_wallMesh.Indices = modelResource.Indices;
-		_wallMesh.Create(Vulkan);
-
-		modelResource.Unload();
+		_wallMesh = Resources->GetMeshAsync("res/walls/walls.bem");
 
-		TextureResource textureResource;
-
-		textureResource.Load("res/walls/wallsTexture.png", TEXTURE_CHANNELS_RGBA);
-		_wallTexture.Create(Vulkan, &textureResource, _modelPipeline.MaterialLayout);
-		textureResource.Unload();
-
-		textureResource.Load("res/walls/wallsNormalMap.png", TEXTURE_CHANNELS_RGBA);
-		_wallNormalMap.Create(Vulkan, &textureResource, _modelPipeline.MaterialLayout);
-		textureResource.Unload();
-
-		_wallMaterial.ColorMap = &_wallTexture;
-		_wallMaterial.NormalMap = &_wallNormalMap;
-		_wallMaterial.Properties.Shininess = 1.0f;
-		_wallMaterial.Properties.UseNormalMap = 1.0f;
-		_wallMaterial.Create(Vulkan, _modelPipeline.MaterialPropertiesLayout);
-
-		_wallMeshMaterial.Material = &_wallMaterial;
-		_wallMeshMaterial.Mesh = &_wallMesh;
+		MaterialDesc materialDesc;
+		materialDesc.ColorMap = "res/walls/wallsTexture.png";
+		materialDesc.NormalMap = "res/walls/wallsNormalMap.png";
+		materialDesc.Properties.Shininess = 1.0f;
+		materialDesc.Properties.UseNormalMap = 1.0f;
+		_wallMaterial = Resources->GetMaterialAsync(materialDesc, _modelPipeline.MaterialLayout, _modelPipeline.MaterialPropertiesLayout);
 
 		_wallModel.Drawables.push_back(&_wallMeshMaterial);
 		_wallModel.Transform.SetRotation(Quaternion::Euler(Math::Rad(90.0f), Vec3(1, 0, 0)));
@@ -445,10 +416,13 @@ public:
 		textureResource.Unload();
 
 		AnimatedModelResource modelResource;
-		modelResource.Load("res/char/char.beam");
+		modelResource.Map("res/char/char.beam");
 
-		_charMesh.Vertices = modelResource.Vertices;
-		_charMesh.Indices = modelResource.Indices;
+		_charMesh.View = modelResource.View;
+		_charMesh.Vertices = std::move(modelResource.Vertices);
+		_charMesh.Indices = std::move(modelResource.Indices);
+		_charMesh.ShortIndices = std::move(modelResource.ShortIndices);
+		_charMesh.Lods = modelResource.Lods;
 		_charMesh.Texture = &_charTexture;
 		_charMesh.Create(Vulkan);
 
@@ -470,33 +444,14 @@ public:
 
 	void SetupBall()
 	{
-		ModelResource modelResource;
-		modelResource.Load("res/ball/ball.bem");
-
-		_ballMesh.Vertices = modelResource.Vertices;
-		_ballMesh.Indices = modelResource.Indices;
-		_ballMesh.Create(Vulkan);
-
-		modelResource.Unload();
-
-		TextureResource textureResource;
-
-		textureResource.Load("res/ball/ballTexture.png", TEXTURE_CHANNELS_RGBA);
-		_ballTexture.Create(Vulkan, &textureResource, _modelPipeline.MaterialLayout);
-		textureResource.Unload();
-
-		textureResource.Load("res/ball/ballNormalMap.png", TEXTURE_CHANNELS_RGBA);
-		_ballNormalMap.Create(Vulkan, &textureResource, _modelPipeline.MaterialLayout);
-		textureResource.Unload();
-
-		_ballMaterial.ColorMap = &_ballTexture;
-		_ballMaterial.NormalMap = &_ballNormalMap;
-		_ballMaterial.Properties.Shininess = 1.0f;
-		_ballMaterial.Properties.UseNormalMap = 1.0f;
-		_ballMaterial.Create(Vulkan, _modelPipeline.MaterialPropertiesLayout);
+		_ballMesh = Resources->GetMeshAsync("res/ball/ball.bem");
 
-		_ballMeshMaterial.Material = &_ballMaterial;
-		_ballMeshMaterial.Mesh = &_ballMesh;
+		MaterialDesc materialDesc;
+		materialDesc.ColorMap = "res/ball/ballTexture.png";
+		materialDesc.NormalMap = "res/ball/ballNormalMap.png";
+		materialDesc.Properties.Shininess = 1.0f;
+		materialDesc.Properties.UseNormalMap = 1.0f;
+		_ballMaterial = Resources->GetMaterialAsync(materialDesc, _modelPipeline.MaterialLayout, _modelPipeline.MaterialPropertiesLayout);
 
 		for (int i = 0; i < MAX_BALLS; i++)
 		{
@@ -517,6 +472,7 @@ public:
 int main(int argc, char** argv)
 {	
 	SandboxApp app;
+	app.ParseArguments(argc, argv);
 	app.Run();
 
 	return 0;
@@ -71,6 +71,7 @@ public:
 
 		textureResource.Load("3d/brick_normal.png", TEXTURE_CHANNELS_RGBA);
 
+		_brickNormalMap.Srgb = false;
 		_brickNormalMap.Create(Vulkan, &textureResource, _modelPipeline.NormalMapLayout);
 
 		textureResource.Unload();
@@ -173,6 +174,7 @@ public:
 int main(int argc, char** argv)
 {	
 	SandboxApp app;
+	app.ParseArguments(argc, argv);
 	app.Run();
 
 	return 0;
@@ -74,6 +74,8 @@ public:
 		// create mesh material
 		_cubeMesh.Vertices = _cubeModelRes.Vertices;
 		_cubeMesh.Indices = _cubeModelRes.Indices;
+		_cubeMesh.ShortIndices = _cubeModelRes.ShortIndices;
+		_cubeMesh.Lods = _cubeModelRes.Lods;
 		_cubeMesh.Create(Vulkan);
 
 		_cubeMeshMat.Mesh = &_cubeMesh;
@@ -133,6 +135,7 @@ public:
 int main(int argc, char** argv)
 {	
 	SandboxApp app;
+	app.ParseArguments(argc, argv);
 	app.Run();
 
 	return 0;
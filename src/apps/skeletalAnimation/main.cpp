@@ -65,6 +65,8 @@ public:
 
 		_mesh.Vertices = _modelResource.Vertices;
 		_mesh.Indices = _modelResource.Indices;
+		_mesh.ShortIndices = _modelResource.ShortIndices;
+		_mesh.Lods = _modelResource.Lods;
 		_mesh.Texture = &_brickTexture;
 		_mesh.Create(Vulkan);
 
@@ -115,6 +117,7 @@ public:
 int main(int argc, char** argv)
 {	
 	SandboxApp app;
+	app.ParseArguments(argc, argv);
 	app.Run();
 
 	return 0;
@@ -2,6 +2,9 @@
 
 #include <iostream>
 #include <vector>
+#include <chrono>
+#include <string.h>
+#include <stdlib.h>
 
 #include "graphics/vulkan/Vulkan.h"
 #include "graphics/Vertex.h"
@@ -17,7 +20,9 @@
 #include "math/Matrices.h"
 #include "math/Math.h"
 #include "input/GLFWInputHandler.h"
+#include "input/NullInputHandler.h"
 #include "input/Input.h"
+#include "io/Utils.h"
 #include "util/CameraController.h"
 
 #define TINYOBJLOADER_IMPLEMENTATION
@@ -44,57 +49,148 @@ App::App()
 {
 }
 
+void App::ParseArguments(int argc, char** argv)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--headless") == 0)
+		{
+			Headless = true;
+		}
+		else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+		{
+			HeadlessFrameCount = (uint32_t)atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--readback") == 0 && i + 1 < argc)
+		{
+			ReadbackPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+		{
+			RecordingThreads = (uint32_t)atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--loader-threads") == 0 && i + 1 < argc)
+		{
+			LoaderThreads = (uint32_t)atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--frame-memory") == 0 && i + 1 < argc)
+		{
+			FrameMemory = (uint32_t)atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--compact-geometry") == 0)
+		{
+			CompactGeometry = true;
+		}
+	}
+}
+
 void App::Run()
 {
-	OnStart();
+	auto runStartTime = std::chrono::high_resolution_clock::now();
 
-	const int WIDTH = 1920;
-	const int HEIGHT = 1080;
+	OnStart();
 
-	glfwInit();
+	if (Headless)
+	{
+		// no window, input never reports any keys
+		Input::Init(new NullInputHandler());
+	}
+	else
+	{
+		glfwInit();
 
-	glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
-	glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
-	Window = glfwCreateWindow(WIDTH, HEIGHT, "Euler Engine", nullptr, nullptr);
+		glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+		glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
+		Window = glfwCreateWindow(Width, Height, "Euler Engine", nullptr, nullptr);
 
-	glfwSetWindowUserPointer(Window, this);
-	glfwSetFramebufferSizeCallback(Window, framebufferResized);
-	glfwSetInputMode(Window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+		glfwSetWindowUserPointer(Window, this);
+		glfwSetFramebufferSizeCallback(Window, framebufferResized);
+		glfwSetInputMode(Window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 
-	// init input
-	GLFWInputHandler* glfwInputHandler = new GLFWInputHandler(Window);
-	Input::Init(glfwInputHandler);
+		// init input
+		GLFWInputHandler* glfwInputHandler = new GLFWInputHandler(Window);
+		Input::Init(glfwInputHandler);
+	}
 
 	// create vulkan instance
 	std::vector<const char*> requiredInstanceExtensions;
 	std::vector<const char*> requiredInstanceLayers;
 
-	uint32_t glfwRequiredInstanceExtensions;
-	const char** instanceExtensions = glfwGetRequiredInstanceExtensions(&glfwRequiredInstanceExtensions);
-	for (int i = 0; i < glfwRequiredInstanceExtensions; i++)
+	if (!Headless)
 	{
-		requiredInstanceExtensions.push_back(instanceExtensions[i]);
+		uint32_t glfwRequiredInstanceExtensions;
+		const char** instanceExtensions = glfwGetRequiredInstanceExtensions(&glfwRequiredInstanceExtensions);
+		for (int i = 0; i < glfwRequiredInstanceExtensions; i++)
+		{
+			requiredInstanceExtensions.push_back(instanceExtensions[i]);
+		}
 	}
 
 	Graphics::Vulkan vulkan;
 	Vulkan = &vulkan;	// TODO: wtf?
 	vulkan.CreateInstance("Sandbox", VK_MAKE_VERSION(0, 1, 0), requiredInstanceLayers, requiredInstanceExtensions);
 
-	// create vulkan device
-	VkSurfaceKHR surface;
-	glfwCreateWindowSurface(vulkan.GetInstance(), Window, nullptr, &surface);
+	// create vulkan device, without a surface the device renders offscreen
+	VkSurfaceKHR surface = VK_NULL_HANDLE;
+	if (!Headless)
+	{
+		glfwCreateWindowSurface(vulkan.GetInstance(), Window, nullptr, &surface);
+	}
 	VkPhysicalDeviceFeatures physicalDeviceFeatures{};
 	std::vector<const char*> requiredDeviceLayers;
 	std::vector<const char*> requiredDeviceExtensions;
+	vulkan._frameAllocatorSize = (VkDeviceSize)FrameMemory * 1024 * 1024;
 	vulkan.CreateDevice(surface, &physicalDeviceFeatures, requiredDeviceLayers, requiredDeviceExtensions);
 
 	// init renderer
-	vulkan.InitRenderer(WIDTH, HEIGHT);
+	vulkan._recordingThreadCount = RecordingThreads;
+	vulkan._compactGeometry = CompactGeometry;
+	vulkan.InitRenderer(Width, Height);
+
+	Euler::Resources resources;
+	resources.Create(&vulkan, LoaderThreads);
+	Resources = &resources;
 
 	OnCreate();
 
+	// startup time covers everything up to the first frame, compare cold and warm pipeline cache runs with it
+	double startupMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - runStartTime).count();
+	std::cout << "Startup: " << startupMs << " ms, pipelines " << vulkan._pipelineCreationTime << " ms ("
+		<< (vulkan._pipelineCache.IsWarm() ? "warm" : "cold") << " pipeline cache)" << std::endl;
+
+	// headless loop, renders a fixed number of frames as fast as possible
+	if (Headless)
+	{
+		auto startTime = std::chrono::high_resolution_clock::now();
+
+		for (uint32_t frame = 0; frame < HeadlessFrameCount; frame++)
+		{
+			OnUpdate();
+
+			vulkan.BeginDrawFrame();
+			resources.Update();
+			OnDraw();
+			vulkan.EndDrawFrame();
+		}
+
+		vkDeviceWaitIdle(vulkan._device);
+		double totalMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+		std::cout << "Headless: " << HeadlessFrameCount << " frames in " << totalMs << " ms, "
+			<< (HeadlessFrameCount > 0 ? totalMs / HeadlessFrameCount : 0.0) << " ms/frame" << std::endl;
+
+		if (ReadbackPath != nullptr && HeadlessFrameCount > 0)
+		{
+			std::vector<uint8_t> pixels;
+			vulkan.ReadbackImage(pixels);
+			if (!WriteImagePPM(ReadbackPath, Width, Height, pixels))
+			{
+				std::cout << "Headless: failed to write " << ReadbackPath << std::endl;
+			}
+		}
+	}
+
 	// main loop
-	while (!glfwWindowShouldClose(Window)) {
+	while (!Headless && !glfwWindowShouldClose(Window)) {
 		while (WindowMinimized)
 		{
 			glfwWaitEvents();
@@ -103,19 +199,32 @@ void App::Run()
 		OnUpdate();
 
 		vulkan.BeginDrawFrame();
+		resources.Update();
 		OnDraw();
 		vulkan.EndDrawFrame();
 
 		glfwPollEvents();
 	}
 
-	vkDestroySurfaceKHR(vulkan.GetInstance(), surface, nullptr);
+	OnComplete();
+
+	vkDeviceWaitIdle(vulkan._device);
+	resources.Destroy();
+	Resources = nullptr;
+
+	if (!Headless)
+	{
+		vkDestroySurfaceKHR(vulkan.GetInstance(), surface, nullptr);
+	}
 	vulkan.Cleanup();
 
 	Input::Dispose();
 
 	//OnDestroy();
 
-	glfwDestroyWindow(Window);
-	glfwTerminate();
+	if (!Headless)
+	{
+		glfwDestroyWindow(Window);
+		glfwTerminate();
+	}
 }
\ No newline at end of file
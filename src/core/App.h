@@ -5,19 +5,44 @@
 
 #include "API.h"
 #include "graphics/vulkan/Vulkan.h"
+#include "resources/Resources.h"
 
 namespace Euler
 {
 	class EULER_API App
 	{
 	public:
-		GLFWwindow* Window;
+		GLFWwindow* Window = nullptr;
 		Graphics::Vulkan* Vulkan;
+		// meshes, textures and materials shared by path, valid from OnCreate to OnComplete
+		Euler::Resources* Resources = nullptr;
 
 		bool WindowMinimized = false;
 
+		uint32_t Width = 1920;
+		uint32_t Height = 1080;
+
+		// headless mode renders into offscreen images without a window, for benchmarks and automated tests
+		bool Headless = false;
+		uint32_t HeadlessFrameCount = 100;
+		const char* ReadbackPath = nullptr;		// if set, the last headless frame is written here as a PPM image
+
+		// number of worker threads recording secondary command buffers, 0 records on the main thread
+		uint32_t RecordingThreads = 0;
+		// number of threads reading and decoding asset files for Resources, 0 takes one less than the cores
+		uint32_t LoaderThreads = 0;
+		// megabytes of per-frame uniform and storage data (model matrices, instance data, indirect commands) of
+		// each frame in flight. Data that doesn't fit isn't drawn
+		uint32_t FrameMemory = 4;
+		// compacts fragmented geometry arenas one block per frame, those frames wait for the GPU to be idle
+		bool CompactGeometry = false;
+
 		App();
 
+		// reads --headless, --frames <count>, --readback <path>, --threads <count>, --loader-threads <count>, --frame-memory <megabytes>
+		// and --compact-geometry
+		void ParseArguments(int argc, char** argv);
+
 		void Run();
 
 		virtual void OnStart() {}
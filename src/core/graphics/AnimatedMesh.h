@@ -2,8 +2,12 @@
 
 #include "../API.h"
 #include "AnimatedVertex.h"
+#include "PackedVertex.h"
 #include "Texture.h"
 #include "vulkan/Vulkan.h"
+#include "MeshLod.h"
+#include "GeometryView.h"
+#include "../math/Bounds.h"
 
 #include <vector>
 
@@ -13,18 +17,40 @@ namespace Euler
 	{
 	public:
 		std::vector<AnimatedVertex> Vertices;
+		// uploaded instead of Vertices when not empty, for pipelines with UsePackedVertices
+		std::vector<PackedAnimatedVertex> PackedVertices;
 		std::vector<uint32_t> Indices;
+		// uploaded instead of Indices when not empty, halves the index memory of meshes with at most 65536 vertices
+		std::vector<uint16_t> ShortIndices;
+		// ranges of the indices from full to lowest detail, Create adds one covering all indices when it is empty
+		std::vector<MeshLod> Lods;
+		// uploaded instead of the vectors when not empty, e.g. straight from a mapped file. The data only has to
+		// stay valid until Create returns, which copies it to the staging memory and resets the view
+		GeometryView View;
 		// TODO: Material
 		Graphics::Texture* Texture;
 
-		// vulkan specific
-		Graphics::Buffer VertexBuffer;
-		Graphics::Buffer IndexBuffer;
+		// object space bounds of the bind pose, computed in Create
+		Math::BoundingSphere Sphere;
+
+		// vulkan specific, sub-allocated from the geometry arena for the vertex stride
+		Graphics::GeometryArena* Arena;
+		Graphics::GeometryAllocation* Geometry;
+		// becomes ready once the vertex and index data reached the device
+		Graphics::UploadHandle UploadHandle;
 
 		AnimatedMesh();
 
 		void Create(Graphics::Vulkan* vulkan);
 		void Destroy(Graphics::Vulkan* vulkan);
-		void RecordDrawCommands(Graphics::Vulkan* vulkan, VkCommandBuffer commandBuffer);
+		bool IsReady();
+
+		uint32_t GetLodCount();
+		// index range of the level in the arena's index buffer
+		uint32_t GetFirstIndex(uint32_t lod);
+		uint32_t GetIndexCount(uint32_t lod);
+
+		// boundBlock is the arena block bound in the command buffer, UINT32_MAX when none is
+		void RecordDrawCommands(VkCommandBuffer commandBuffer, uint32_t* boundBlock, uint32_t instanceCount = 1, uint32_t firstInstance = 0, uint32_t lod = 0);
 	};
 };
\ No newline at end of file
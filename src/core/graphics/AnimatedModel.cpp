@@ -1,7 +1,61 @@
 #include "AnimatedModel.h"
 
+#include <float.h>
+
 using namespace Euler;
 
 AnimatedModel::AnimatedModel()
 {
+}
+
+bool AnimatedModel::SelectLods(const LodSettings& settings, const Vec3& cameraPosition, float projectionScale)
+{
+	Lods.resize(Drawables.size(), UINT32_MAX);
+	ShadowLods.resize(Drawables.size(), UINT32_MAX);
+
+	Mat4 modelMatrix = Transform.GetModelMatrix();
+	bool changed = false;
+
+	for (uint32_t j = 0; j < Drawables.size(); j++)
+	{
+		AnimatedMesh* mesh = Drawables[j]->AnimatedMesh;
+		float pixelsPerUnit = GetLodPixelsPerUnit(mesh->Sphere, modelMatrix, cameraPosition, projectionScale);
+
+		uint32_t lod = SelectLod(mesh->Lods, pixelsPerUnit, settings.MaxError, settings.Hysteresis, Lods[j]);
+		uint32_t shadowLod = SelectLod(mesh->Lods, pixelsPerUnit, settings.MaxError * settings.ShadowBias, settings.Hysteresis, ShadowLods[j]);
+
+		changed = changed || lod != Lods[j] || shadowLod != ShadowLods[j];
+		Lods[j] = lod;
+		ShadowLods[j] = shadowLod;
+	}
+
+	return changed;
+}
+
+void AnimatedModel::ResetLods()
+{
+	Lods.clear();
+	ShadowLods.clear();
+}
+
+uint32_t AnimatedModel::GetLod(uint32_t drawable)
+{
+	return drawable < Lods.size() && Lods[drawable] != UINT32_MAX ? Lods[drawable] : 0;
+}
+
+uint32_t AnimatedModel::GetShadowLod(uint32_t drawable)
+{
+	return drawable < ShadowLods.size() && ShadowLods[drawable] != UINT32_MAX ? ShadowLods[drawable] : 0;
+}
+
+void AnimatedModel::RequestTextureSizes(const Vec3& cameraPosition, float projectionScale)
+{
+	Mat4 modelMatrix = Transform.GetModelMatrix();
+
+	for (auto drawable : Drawables)
+	{
+		AnimatedMesh* mesh = drawable->AnimatedMesh;
+		float pixelsPerUnit = GetLodPixelsPerUnit(mesh->Sphere, modelMatrix, cameraPosition, projectionScale);
+		drawable->RequestTextureSize(pixelsPerUnit == FLT_MAX ? FLT_MAX : pixelsPerUnit * mesh->Sphere.Radius * 2.0f);
+	}
 }
\ No newline at end of file
@@ -3,6 +3,8 @@
 #include "../io/Utils.h"
 #include "../math/Matrices.h"
 
+#include <iostream>
+
 using namespace Euler::Graphics;
 
 void AnimatedModelPipeline::Create(Vulkan* vulkan, float viewportWidth, float viewportHeight)
@@ -11,9 +13,16 @@ void AnimatedModelPipeline::Create(Vulkan* vulkan, float viewportWidth, float vi
 
 	/* === READ SHADER CODE === */
 
-	std::vector<char> vertexShaderCode = ReadFile("shaders/out/animated_vertex.spv");
+	std::vector<char> vertexShaderCode = ReadFile(GetVertexShaderPath("animated_vertex").c_str());
 	std::vector<char> fragmentShaderCode = ReadFile("shaders/out/animated_fragment.spv");
 
+	if (vertexShaderCode.empty() && UsePackedVertices)
+	{
+		std::cout << "AnimatedModelPipeline: shaders/out/animated_vertex_packed.spv not found, using full vertices" << std::endl;
+		UsePackedVertices = false;
+		vertexShaderCode = ReadFile("shaders/out/animated_vertex.spv");
+	}
+
 	/* === CREATE PIPELINE === */
 
 	PipelineInfo pipelineInfo{};
@@ -24,7 +33,7 @@ void AnimatedModelPipeline::Create(Vulkan* vulkan, float viewportWidth, float vi
 	pipelineInfo.FragmentShaderCode = fragmentShaderCode.data();
 	pipelineInfo.FragmentShaderCodeSize = fragmentShaderCode.size();
 
-	pipelineInfo.VertexStride = sizeof(AnimatedVertex);
+	pipelineInfo.VertexStride = GetVertexStride();
 	pipelineInfo.VertexAttributes = GetVertexAttributes();
 
 	pipelineInfo.Topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
@@ -49,11 +58,6 @@ void AnimatedModelPipeline::Destroy()
 {
 	_vulkan->DestroyDescriptorPool(_descriptorPool);
 
-	_viewProjBuffers.Destroy(_vulkan);
-	_modelBuffers.Destroy(_vulkan);
-	_directionalLightBuffers.Destroy(_vulkan);
-	_ambientLightBuffers.Destroy(_vulkan);
-
 	_vulkan->DestroyPipeline(_pipelineLayout, _pipeline);
 
 	_vulkan->DestroyDescriptorSetLayout(ViewProjLayout);
@@ -63,6 +67,43 @@ void AnimatedModelPipeline::Destroy()
 
 std::vector<VertexAttributeInfo> AnimatedModelPipeline::GetVertexAttributes()
 {
+	if (UsePackedVertices)
+	{
+		std::vector<VertexAttributeInfo> vec(6);
+
+		// position
+		vec[0].Location = 0;
+		vec[0].Offset = 0;
+		vec[0].Format = VK_FORMAT_R32G32B32_SFLOAT;
+
+		// octahedral normal
+		vec[1].Location = 1;
+		vec[1].Offset = offsetof(PackedAnimatedVertex, Normal);
+		vec[1].Format = VK_FORMAT_R16G16_SNORM;
+
+		// octahedral tangent, the bitangent is rebuilt in the shader
+		vec[2].Location = 2;
+		vec[2].Offset = offsetof(PackedAnimatedVertex, Tangent);
+		vec[2].Format = VK_FORMAT_R16G16_SNORM;
+
+		// uv
+		vec[3].Location = 4;
+		vec[3].Offset = offsetof(PackedAnimatedVertex, UV);
+		vec[3].Format = VK_FORMAT_R16G16_SFLOAT;
+
+		// bone ids
+		vec[4].Location = 5;
+		vec[4].Offset = offsetof(PackedAnimatedVertex, BoneIds);
+		vec[4].Format = VK_FORMAT_R8G8B8A8_UINT;
+
+		// bone weights
+		vec[5].Location = 6;
+		vec[5].Offset = offsetof(PackedAnimatedVertex, BoneWeights);
+		vec[5].Format = VK_FORMAT_R8G8B8A8_UNORM;
+
+		return vec;
+	}
+
 	std::vector<VertexAttributeInfo> vec(7);
 
 	// position
@@ -103,12 +144,27 @@ std::vector<VertexAttributeInfo> AnimatedModelPipeline::GetVertexAttributes()
 	return vec;
 }
 
+uint32_t AnimatedModelPipeline::GetVertexStride()
+{
+	return UsePackedVertices ? sizeof(PackedAnimatedVertex) : sizeof(AnimatedVertex);
+}
+
+Euler::VertexFormat AnimatedModelPipeline::GetVertexFormat()
+{
+	return UsePackedVertices ? Euler::VERTEX_FORMAT_PACKED : Euler::VERTEX_FORMAT_FULL;
+}
+
+std::string AnimatedModelPipeline::GetVertexShaderPath(const char* name)
+{
+	return std::string("shaders/out/") + name + (UsePackedVertices ? "_packed.spv" : ".spv");
+}
+
 void AnimatedModelPipeline::CreateDescriptorSetLayouts()
 {
 	/* === ViewProj DESCRIPTOR SET LAYOUT === */
 	std::vector<VkDescriptorSetLayoutBinding> viewProjBindings(1);
 	viewProjBindings[0].binding = 0;
-	viewProjBindings[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	viewProjBindings[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 	viewProjBindings[0].descriptorCount = 1;
 	viewProjBindings[0].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
 
@@ -140,12 +196,12 @@ void AnimatedModelPipeline::CreateDescriptorSetLayouts()
 	/* === DirectionalLight DESCRIPTOR SET LAYOUT === */
 	std::vector<VkDescriptorSetLayoutBinding> directionalLightBindings(3);
 	directionalLightBindings[0].binding = 0;
-	directionalLightBindings[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	directionalLightBindings[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 	directionalLightBindings[0].descriptorCount = 1;
 	directionalLightBindings[0].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
 
 	directionalLightBindings[1].binding = 1;
-	directionalLightBindings[1].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	directionalLightBindings[1].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 	directionalLightBindings[1].descriptorCount = 1;
 	directionalLightBindings[1].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
 
@@ -169,7 +225,7 @@ void AnimatedModelPipeline::CreateDescriptorSetLayouts()
 
 	std::vector<VkDescriptorSetLayoutBinding> lightViewProjBindings(1);
 	lightViewProjBindings[0].binding = 0;
-	lightViewProjBindings[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	lightViewProjBindings[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 	lightViewProjBindings[0].descriptorCount = 1;
 	lightViewProjBindings[0].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
 
@@ -182,15 +238,13 @@ void AnimatedModelPipeline::CreateDescriptorSets()
 
 	/* === CREATE DESCRIPTOR SET POOL === */
 
-	std::vector<VkDescriptorPoolSize> poolSizes(6);
-	poolSizes[0] = { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, imageCount * 2 };			// ViewProj
-	poolSizes[3] = { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, imageCount };	// Model
-	poolSizes[2] = { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, imageCount };			// DirectionalLight
-	poolSizes[3] = { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, imageCount };	// shadows
-	poolSizes[4] = { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, imageCount };			// LightViewProj
-	poolSizes[5] = { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, imageCount };			// BoneTransforms
+	// all per-frame data lives in the frame allocator and is bound with dynamic offsets:
+	// ViewProj, Model, DirectionalLight + AmbientLight, BoneTransforms, LightViewProj and the shadows' ViewProj
+	std::vector<VkDescriptorPoolSize> poolSizes(2);
+	poolSizes[0] = { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, imageCount * 7 };
+	poolSizes[1] = { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, imageCount };	// shadows
 
-	_vulkan->CreateDescriptorPool(poolSizes, poolSizes.size() * imageCount, &_descriptorPool);
+	_vulkan->CreateDescriptorPool(poolSizes, 6 * imageCount, &_descriptorPool);
 
 	/* === CREATE DESCRIPTOR SETS === */
 
@@ -205,16 +259,6 @@ void AnimatedModelPipeline::CreateViewProjDescriptorSets()
 {
 	uint32_t imageCount = _vulkan->GetSwapchainImageCount();
 
-	/* === CREATE ViewProj BUFFERS === */
-
-	_viewProjBuffers.Create(
-		_vulkan,
-		imageCount,
-		sizeof(ViewProj),
-		VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-	);
-
 	/* === ALLOCATE DESCRIPTOR SETS === */
 
 	_viewProjDescriptorSetGroup.Allocate(_vulkan, imageCount, ViewProjLayout, _descriptorPool);
@@ -223,7 +267,7 @@ void AnimatedModelPipeline::CreateViewProjDescriptorSets()
 
 	for (int i = 0; i < imageCount; i++)
 	{
-		_viewProjDescriptorSetGroup.UpdateUniformBuffer(_vulkan, i, _viewProjBuffers.Get(i)->Buffer, 0);
+		_viewProjDescriptorSetGroup.UpdateUniformBufferDynamic(_vulkan, i, _vulkan->_frameAllocator.GetBuffer(), 0, sizeof(ViewProj));
 	}
 }
 
@@ -231,21 +275,6 @@ void AnimatedModelPipeline::CreateModelDescriptorSets()
 {
 	uint32_t imageCount = _vulkan->GetSwapchainImageCount();
 
-	/* === CALCULATE THE MODEL MATRIX ALLIGNMENT IN THE UNIFORM BUFFER === */
-
-	auto minOffset = _vulkan->GetPhysicalDevice()->Properties.limits.minUniformBufferOffsetAlignment;
-	_modelMatrixAlignment = (sizeof(Mat4) + minOffset - 1) & ~(minOffset - 1);
-
-	/* === CREATE Model BUFFERS === */
-
-	_modelBuffers.Create(
-		_vulkan,
-		imageCount,
-		INITIAL_MODELS_FOR_BUFFER_SIZE * _modelMatrixAlignment,
-		VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-	);
-
 	/* === ALLOCATE DESCRIPTOR SETS === */
 
 	_modelDescriptorSetGroup.Allocate(_vulkan, imageCount, ModelLayout, _descriptorPool);
@@ -254,7 +283,7 @@ void AnimatedModelPipeline::CreateModelDescriptorSets()
 
 	for (int i = 0; i < imageCount; i++)
 	{
-		_modelDescriptorSetGroup.UpdateUniformBufferDynamic(_vulkan, i, _modelBuffers.Get(i)->Buffer, 0);
+		_modelDescriptorSetGroup.UpdateUniformBufferDynamic(_vulkan, i, _vulkan->_frameAllocator.GetBuffer(), 0, sizeof(Mat4));
 	}
 }
 
@@ -262,24 +291,6 @@ void AnimatedModelPipeline::CreateDirectionalLightDescriptorSets()
 {
 	uint32_t imageCount = _vulkan->GetSwapchainImageCount();
 
-	/* === CREATE DirectioanLight BUFFERS === */
-
-	_directionalLightBuffers.Create(
-		_vulkan,
-		imageCount,
-		sizeof(DirLight),
-		VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-	);
-
-	_ambientLightBuffers.Create(
-		_vulkan,
-		imageCount,
-		sizeof(AmbLight),
-		VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-	);
-
 	/* === ALLOCATE DESCRIPTOR SETS === */
 
 	_lightDescriptorSetGroup.Allocate(_vulkan, imageCount, DirectionalLightLayout, _descriptorPool);
@@ -288,8 +299,8 @@ void AnimatedModelPipeline::CreateDirectionalLightDescriptorSets()
 
 	for (int i = 0; i < imageCount; i++)
 	{
-		_lightDescriptorSetGroup.UpdateUniformBuffer(_vulkan, i, _directionalLightBuffers.Get(i)->Buffer, 0);
-		_lightDescriptorSetGroup.UpdateUniformBuffer(_vulkan, i, _ambientLightBuffers.Get(i)->Buffer, 1);
+		_lightDescriptorSetGroup.UpdateUniformBufferDynamic(_vulkan, i, _vulkan->_frameAllocator.GetBuffer(), 0, sizeof(DirectionalLight));
+		_lightDescriptorSetGroup.UpdateUniformBufferDynamic(_vulkan, i, _vulkan->_frameAllocator.GetBuffer(), 1, sizeof(AmbientLight));
 	}
 }
 
@@ -297,22 +308,6 @@ void AnimatedModelPipeline::CreateBoneTransformDescriptorSets()
 {
 	uint32_t imageCount = _vulkan->GetSwapchainImageCount();
 
-	/* === CALCULATE ALLIGNMENT IN THE UNIFORM BUFFER === */
-
-	uint64_t boneTransformsSize = sizeof(Mat4) * 32;		// TODO: 32 is the maximum number of bones per mesh. Extract constant from this.
-	auto minOffset = _vulkan->GetPhysicalDevice()->Properties.limits.minUniformBufferOffsetAlignment;
-	_boneTransformMatrixAlignment = (boneTransformsSize + minOffset - 1) & ~(minOffset - 1);
-
-	/* === CREATE Model BUFFERS === */
-
-	_boneTransformBuffers.Create(
-		_vulkan,
-		imageCount,
-		INITIAL_MODELS_FOR_BUFFER_SIZE * boneTransformsSize,
-		VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-	);
-
 	/* === ALLOCATE DESCRIPTOR SETS === */
 
 	_boneTransformDescriptorSetGroup.Allocate(_vulkan, imageCount, BoneTransformsLayout, _descriptorPool);
@@ -321,7 +316,7 @@ void AnimatedModelPipeline::CreateBoneTransformDescriptorSets()
 
 	for (int i = 0; i < imageCount; i++)
 	{
-		_boneTransformDescriptorSetGroup.UpdateUniformBufferDynamic(_vulkan, i, _boneTransformBuffers.Get(i)->Buffer, 0);
+		_boneTransformDescriptorSetGroup.UpdateUniformBufferDynamic(_vulkan, i, _vulkan->_frameAllocator.GetBuffer(), 0, sizeof(Mat4) * MAX_BONE_TRANSFORMS);
 	}
 }
 
@@ -329,16 +324,6 @@ void AnimatedModelPipeline::CreateLightViewProjDescriptorSets()
 {
 	uint32_t imageCount = _vulkan->GetSwapchainImageCount();
 
-	/* === CREATE LightViewProj BUFFERS === */
-
-	_lightViewProjBuffers.Create(
-		_vulkan,
-		imageCount,
-		sizeof(ViewProj),
-		VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-	);
-
 	/* === ALLOCATE DESCRIPTOR SETS === */
 
 	_lightViewProjDescriptorSetGroup.Allocate(_vulkan, imageCount, LightViewProjLayout, _descriptorPool);
@@ -347,34 +332,33 @@ void AnimatedModelPipeline::CreateLightViewProjDescriptorSets()
 
 	for (int i = 0; i < imageCount; i++)
 	{
-		_lightViewProjDescriptorSetGroup.UpdateUniformBuffer(_vulkan, i, _lightViewProjBuffers.Get(i)->Buffer, 0);
+		_lightViewProjDescriptorSetGroup.UpdateUniformBufferDynamic(_vulkan, i, _vulkan->_frameAllocator.GetBuffer(), 0, sizeof(ViewProj));
 	}
 }
 
 void AnimatedModelPipeline::Update(Camera* camera, ViewProj viewProjMatrix, std::vector<Mat4> boneMatrices)
 {
-	for (int i = 0; i < Models.size(); i++)
-	{
-		AnimatedModel* model = Models[i];
+	WriteFrameData(viewProjMatrix, boneMatrices);
 
-		// set model matrix
-		uint32_t offset = _modelMatrixAlignment * i;
-		vkCmdBindDescriptorSets(
-			*_vulkan->GetMainCommandBuffer(),
-			VK_PIPELINE_BIND_POINT_GRAPHICS,
-			_pipelineLayout,
-			1,
-			1,
-			&_modelDescriptorSetGroup.DescriptorSets[_vulkan->_currentImage],
-			1,
-			&offset
-		);
+	// the shadows read the levels picked here too
+	Vec3 cameraPosition = camera->Transform.GetPosition();
+	float projectionScale = camera->GetProjectionScale();
+	bool streaming = _vulkan->_textureStreamer.HasTextures();
+	for (auto model : Models)
+	{
+		if (UseLods)
+		{
+			model->SelectLods(Lod, cameraPosition, projectionScale);
+		}
+		else
+		{
+			model->ResetLods();
+		}
 
-		// bind bone transforms descriptor set
-		void* boneTransformsData;
-		_vulkan->MapMemory(_boneTransformBuffers.Get(_vulkan->_currentImage)->Memory, i * _boneTransformMatrixAlignment, _boneTransformMatrixAlignment, &boneTransformsData);
-		memcpy(boneTransformsData, boneMatrices.data(), sizeof(Mat4) * 32);
-		_vulkan->UnmapMemory(_boneTransformBuffers.Get(_vulkan->_currentImage)->Memory);
+		if (streaming)
+		{
+			model->RequestTextureSizes(cameraPosition, projectionScale);
+		}
 	}
 
 	// update light viewproj
@@ -416,7 +400,33 @@ void AnimatedModelPipeline::Update(Camera* camera, ViewProj viewProjMatrix, std:
 	camViewProj.View = view;
 	camViewProj.Projection = proj;
 
-	_vulkan->CopyToMemory(_lightViewProjBuffers.Get(_vulkan->_currentImage)->Memory, 0, sizeof(camViewProj), &camViewProj);
+	_lightViewProjOffset = _vulkan->_frameAllocator.Push(&camViewProj, sizeof(camViewProj));
+}
+
+void AnimatedModelPipeline::WriteFrameData(const ViewProj& viewProjMatrix, const std::vector<Mat4>& boneMatrices)
+{
+	FrameAllocator* frameAllocator = &_vulkan->_frameAllocator;
+
+	// update viewproj
+	_viewProjOffset = frameAllocator->Push(&viewProjMatrix, sizeof(viewProjMatrix));
+
+	// update directional and ambient light
+	_directionalLightOffset = frameAllocator->Push(DirLight, sizeof(DirectionalLight));
+	_ambientLightOffset = frameAllocator->Push(&AmbLight, sizeof(AmbientLight));
+
+	// update model matrices and bone transforms
+	_modelOffsets.resize(Models.size());
+	_boneTransformOffsets.resize(Models.size());
+	for (int i = 0; i < Models.size(); i++)
+	{
+		Mat4 modelMatrix = Models[i]->Transform.GetModelMatrix();
+		modelMatrix.Transpose();
+
+		_modelOffsets[i] = frameAllocator->Push(&modelMatrix, sizeof(modelMatrix));
+		_boneTransformOffsets[i] = frameAllocator->Push(boneMatrices.data(), sizeof(Mat4) * MAX_BONE_TRANSFORMS);
+	}
+
+	_frameDataNumber = frameAllocator->GetFrameNumber();
 }
 
 void AnimatedModelPipeline::RecordCommands(ViewProj viewProjMatrix, std::vector<Mat4> boneMatrices)
@@ -438,63 +448,73 @@ void AnimatedModelPipeline::RecordCommands(ViewProj viewProjMatrix, std::vector<
 		renderPassBeginInfo.clearValueCount = 2;
 		renderPassBeginInfo.pClearValues = clearValues;
 
-		vkCmdBeginRenderPass(*_vulkan->GetMainCommandBuffer(), &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+		vkCmdBeginRenderPass(*_vulkan->GetMainCommandBuffer(), &renderPassBeginInfo, _vulkan->_commandRecorder.GetSubpassContents());
 	}
 
-	vkCmdBindPipeline(*_vulkan->GetMainCommandBuffer(), VK_PIPELINE_BIND_POINT_GRAPHICS, _pipeline);
+	// write the frame data unless Update already did it this frame
+	if (_frameDataNumber != _vulkan->_frameAllocator.GetFrameNumber())
+	{
+		WriteFrameData(viewProjMatrix, boneMatrices);
+	}
 
-	// update viewproj
-	_vulkan->CopyToMemory(_viewProjBuffers.Get(_vulkan->_currentImage)->Memory, 0, sizeof(viewProjMatrix), &viewProjMatrix);
+	_vulkan->_commandRecorder.Record(_vulkan->_renderPass, Models.size(), [this](VkCommandBuffer commandBuffer, uint32_t first, uint32_t last) {
+		RecordModels(commandBuffer, first, last);
+	});
+
+	if (endRenderPass)
+	{
+		vkCmdEndRenderPass(*_vulkan->GetMainCommandBuffer());
+	}
+}
+
+void AnimatedModelPipeline::RecordModels(VkCommandBuffer commandBuffer, uint32_t first, uint32_t last)
+{
+	// the frame allocator ran out before the data all models share
+	if (_viewProjOffset == FrameAllocator::INVALID_OFFSET || _directionalLightOffset == FrameAllocator::INVALID_OFFSET
+		|| _ambientLightOffset == FrameAllocator::INVALID_OFFSET)
+	{
+		return;
+	}
+
+	uint32_t boundBlock = UINT32_MAX;
+
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, _pipeline);
 
 	vkCmdBindDescriptorSets(
-		*_vulkan->GetMainCommandBuffer(),
+		commandBuffer,
 		VK_PIPELINE_BIND_POINT_GRAPHICS,
 		_pipelineLayout,
 		0,
 		1,
 		&_viewProjDescriptorSetGroup.DescriptorSets[_vulkan->_currentImage],
-		0,
-		nullptr
+		1,
+		&_viewProjOffset
 	);
 
-	// update directional light
-	_vulkan->CopyToMemory(_directionalLightBuffers.Get(_vulkan->_currentImage)->Memory, 0, sizeof(DirectionalLight), DirLight);
-
-	// update ambient light
-	_vulkan->CopyToMemory(_ambientLightBuffers.Get(_vulkan->_currentImage)->Memory, 0, sizeof(AmbientLight), &AmbLight);
-
+	uint32_t lightOffsets[] = { _directionalLightOffset, _ambientLightOffset };
 	vkCmdBindDescriptorSets(
-		*_vulkan->GetMainCommandBuffer(),
+		commandBuffer,
 		VK_PIPELINE_BIND_POINT_GRAPHICS,
 		_pipelineLayout,
 		3,
 		1,
 		&_lightDescriptorSetGroup.DescriptorSets[_vulkan->_currentImage],
-		0,
-		nullptr
+		2,
+		lightOffsets
 	);
 
-	void* modelsData;
-	_vulkan->MapMemory(_modelBuffers.Get(_vulkan->_currentImage)->Memory, 0, Models.size() * _modelMatrixAlignment, &modelsData);
-	for (int i = 0; i < Models.size(); i++)
-	{
-		Mat4 modelMatrix = Models[i]->Transform.GetModelMatrix();
-		modelMatrix.Transpose();
-
-		size_t dataOffset = _modelMatrixAlignment * i;
-		memcpy(dataOffset + static_cast<char*>(modelsData), &modelMatrix, sizeof(modelMatrix));
-		memset(dataOffset + static_cast<char*>(modelsData) + sizeof(modelMatrix) + 1, 0, _modelMatrixAlignment - sizeof(modelMatrix));
-	}
-	_vulkan->UnmapMemory(_modelBuffers.Get(_vulkan->_currentImage)->Memory);
-
-	for (int i = 0; i < Models.size(); i++)
+	for (uint32_t i = first; i < last; i++)
 	{
 		AnimatedModel* model = Models[i];
+		if (_modelOffsets[i] == FrameAllocator::INVALID_OFFSET || _boneTransformOffsets[i] == FrameAllocator::INVALID_OFFSET)
+		{
+			continue;
+		}
 
 		// set model matrix
-		uint32_t offset = _modelMatrixAlignment * i;
+		uint32_t offset = _modelOffsets[i];
 		vkCmdBindDescriptorSets(
-			*_vulkan->GetMainCommandBuffer(),
+			commandBuffer,
 			VK_PIPELINE_BIND_POINT_GRAPHICS,
 			_pipelineLayout,
 			1,
@@ -505,14 +525,9 @@ void AnimatedModelPipeline::RecordCommands(ViewProj viewProjMatrix, std::vector<
 		);
 
 		// bind bone transforms descriptor set
-		void* boneTransformsData;
-		_vulkan->MapMemory(_boneTransformBuffers.Get(_vulkan->_currentImage)->Memory, i * _boneTransformMatrixAlignment, _boneTransformMatrixAlignment, &boneTransformsData);
-		memcpy(boneTransformsData, boneMatrices.data(), sizeof(Mat4) * 32);
-		_vulkan->UnmapMemory(_boneTransformBuffers.Get(_vulkan->_currentImage)->Memory);
-
-		uint32_t boneTransformsOffset = _boneTransformMatrixAlignment * i;
+		uint32_t boneTransformsOffset = _boneTransformOffsets[i];
 		vkCmdBindDescriptorSets(
-			*_vulkan->GetMainCommandBuffer(),
+			commandBuffer,
 			VK_PIPELINE_BIND_POINT_GRAPHICS,
 			_pipelineLayout,
 			4,
@@ -523,21 +538,27 @@ void AnimatedModelPipeline::RecordCommands(ViewProj viewProjMatrix, std::vector<
 		);
 
 		vkCmdBindDescriptorSets(
-			*_vulkan->GetMainCommandBuffer(),
+			commandBuffer,
 			VK_PIPELINE_BIND_POINT_GRAPHICS,
 			_pipelineLayout,
 			3,
 			1,
 			&_lightDescriptorSetGroup.DescriptorSets[_vulkan->_currentImage],
-			0,
-			nullptr
+			2,
+			lightOffsets
 		);
 
 		// draw model meshes
 		for (int j = 0; j < model->Drawables.size(); j++)
 		{
+			// skip drawables that are still uploading
+			if (!model->Drawables[j]->IsReady())
+			{
+				continue;
+			}
+
 			vkCmdBindDescriptorSets(
-				*_vulkan->GetMainCommandBuffer(),
+				commandBuffer,
 				VK_PIPELINE_BIND_POINT_GRAPHICS,
 				_pipelineLayout,
 				2,
@@ -547,17 +568,7 @@ void AnimatedModelPipeline::RecordCommands(ViewProj viewProjMatrix, std::vector<
 				nullptr
 			);
 
-			_vulkan->DrawMesh(
-				*_vulkan->GetMainCommandBuffer(),
-				&model->Drawables[j]->AnimatedMesh->VertexBuffer,
-				&model->Drawables[j]->AnimatedMesh->IndexBuffer,
-				model->Drawables[j]->AnimatedMesh->Indices.size()
-			);
-		}
-
-		if (endRenderPass)
-		{
-			vkCmdEndRenderPass(*_vulkan->GetMainCommandBuffer());
+			model->Drawables[j]->AnimatedMesh->RecordDrawCommands(commandBuffer, &boundBlock, 1, 0, model->GetLod(j));
 		}
 	}
-}
\ No newline at end of file
+}
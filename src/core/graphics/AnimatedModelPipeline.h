@@ -4,6 +4,7 @@
 #include "vulkan/Vulkan.h"
 #include "Common.h"
 #include "Vertex.h"
+#include "PackedVertex.h"
 #include "AnimatedModel.h"
 #include "DirectionalLight.h"
 #include "AmbientLight.h"
@@ -14,6 +15,7 @@
 
 #include <vulkan/vulkan.h>
 #include <vector>
+#include <string>
 
 namespace Euler
 {
@@ -22,11 +24,8 @@ namespace Euler
 		class EULER_API AnimatedModelPipeline
 		{
 		public:
-			/// <summary>
-			/// This constant will be used when calculating the initial size of the dynamic uniform buffer which contains
-			/// the model matrices. The size of the buffer will be INITIAL_MODELS_FOR_BUFFER_SIZE * sizeof(model_matrix).
-			/// </summary>
-			const uint32_t INITIAL_MODELS_FOR_BUFFER_SIZE = 8;
+			// TODO: 32 is the maximum number of bones per mesh, this should come from the resources
+			static const uint32_t MAX_BONE_TRANSFORMS = 32;
 
 			Vulkan* _vulkan;
 
@@ -40,21 +39,27 @@ namespace Euler
 			DescriptorSetGroup _boneTransformDescriptorSetGroup;
 			DescriptorSetGroup _lightViewProjDescriptorSetGroup;
 
-			BufferGroup _viewProjBuffers;
-			BufferGroup _modelBuffers;
-			BufferGroup _directionalLightBuffers;
-			BufferGroup _ambientLightBuffers;
-			BufferGroup _boneTransformBuffers;
-			BufferGroup _lightViewProjBuffers;
-
-			uint64_t _modelMatrixAlignment;
-			uint64_t _boneTransformMatrixAlignment;
+			// offsets of this frame's data in the vulkan frame allocator
+			uint32_t _viewProjOffset;
+			uint32_t _directionalLightOffset;
+			uint32_t _ambientLightOffset;
+			uint32_t _lightViewProjOffset;
+			std::vector<uint32_t> _modelOffsets;
+			std::vector<uint32_t> _boneTransformOffsets;
+			uint64_t _frameDataNumber = 0;
 
 		public:
 			std::vector<AnimatedModel*> Models;
 			DirectionalLight* DirLight;
 			AmbientLight AmbLight;
 
+			// draws meshes at the level of detail that keeps their error on screen below Lod.MaxError, in both passes
+			bool UseLods = true;
+			LodSettings Lod;
+			// reads PackedAnimatedVertex meshes, see ModelPipeline::UsePackedVertices. Falls back to full vertices
+			// when shaders/out/animated_vertex_packed.spv is missing
+			bool UsePackedVertices = false;
+
 			VkDescriptorSetLayout ViewProjLayout;
 			VkDescriptorSetLayout ModelLayout;
 			VkDescriptorSetLayout MaterialLayout;
@@ -70,6 +75,9 @@ namespace Euler
 
 		public:
 			std::vector<VertexAttributeInfo> GetVertexAttributes();
+			uint32_t GetVertexStride();
+			VertexFormat GetVertexFormat();
+			std::string GetVertexShaderPath(const char* name);
 			void CreateDescriptorSetLayouts();
 			void CreateDescriptorSets();
 
@@ -78,6 +86,11 @@ namespace Euler
 			void CreateDirectionalLightDescriptorSets();
 			void CreateBoneTransformDescriptorSets();
 			void CreateLightViewProjDescriptorSets();
+
+			void WriteFrameData(const ViewProj& viewProjMatrix, const std::vector<Mat4>& boneMatrices);
+
+			// records models [first, last), called by the command recorder on a worker thread
+			void RecordModels(VkCommandBuffer commandBuffer, uint32_t first, uint32_t last);
 		};
 	}
 }
\ No newline at end of file
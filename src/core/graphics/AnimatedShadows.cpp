@@ -18,7 +18,7 @@ void AnimatedShadows::Create(Vulkan* vulkan, AnimatedModelPipeline* modelPipelin
 
 	/* === READ SHADER CODE === */
 
-	std::vector<char> vertexShaderCode = ReadFile("shaders/out/shadow_animated_vertex.spv");
+	std::vector<char> vertexShaderCode = ReadFile(_animatedModelPipeline->GetVertexShaderPath("shadow_animated_vertex").c_str());
 	std::vector<char> fragmentShaderCode = ReadFile("shaders/out/shadow_animated_fragment.spv");
 
 	/* === CREATE PIPELINE === */
@@ -31,7 +31,7 @@ void AnimatedShadows::Create(Vulkan* vulkan, AnimatedModelPipeline* modelPipelin
 	pipelineInfo.FragmentShaderCode = fragmentShaderCode.data();
 	pipelineInfo.FragmentShaderCodeSize = fragmentShaderCode.size();
 
-	pipelineInfo.VertexStride = sizeof(AnimatedVertex);
+	pipelineInfo.VertexStride = _animatedModelPipeline->GetVertexStride();
 	pipelineInfo.VertexAttributes = _animatedModelPipeline->GetVertexAttributes();
 
 	pipelineInfo.Topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
@@ -66,7 +66,14 @@ void AnimatedShadows::Create(Vulkan* vulkan, AnimatedModelPipeline* modelPipelin
 
 void AnimatedShadows::Destroy()
 {
-	_vulkan->DestroySampler(_sampler);
+	for (int i = 0; i < _depthImages.size(); i++)
+	{
+		vkDestroyFramebuffer(_vulkan->_device, _framebuffers[i], nullptr);
+		_vulkan->DestroyImageView(_depthImageViews[i]);
+		_vulkan->DestroyImage(_depthImages[i], _depthImageMemories[i]);
+	}
+
+	_vulkan->ReleaseSampler(_sampler);
 	_vulkan->DestroyPipeline(_pipelineLayout, _pipeline);
 	vkDestroyRenderPass(_vulkan->_device, _shadowRenderPass, nullptr);
 }
@@ -136,7 +143,7 @@ void AnimatedShadows::CreateDescriptorSetLayouts()
 	/* === ViewProj DESCRIPTOR SET LAYOUT === */
 	std::vector<VkDescriptorSetLayoutBinding> viewProjBindings(1);
 	viewProjBindings[0].binding = 0;
-	viewProjBindings[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	viewProjBindings[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 	viewProjBindings[0].descriptorCount = 1;
 	viewProjBindings[0].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
 
@@ -162,17 +169,19 @@ void AnimatedShadows::UpdateDescriptorSets()
 
 	for (int i = 0; i < imageCount; i++)
 	{
-		_viewProjDescriptorSetGroup.UpdateUniformBuffer(
+		_viewProjDescriptorSetGroup.UpdateUniformBufferDynamic(
 			_vulkan, 
 			i,
-			_animatedModelPipeline->_lightViewProjBuffers.Get(i)->Buffer,
-			0
+			_vulkan->_frameAllocator.GetBuffer(),
+			0,
+			sizeof(ViewProj)
 		);
 	}
 
 	/* === UPDATE SHADOW MAP === */
 
-	_vulkan->CreateSampler(&_sampler);
+	// the same state as the textures, so it's their sampler
+	_sampler = _vulkan->AcquireSampler(SamplerDesc());
 
 	for (int i = 0; i < _vulkan->GetSwapchainImageCount(); i++)
 	{
@@ -201,28 +210,48 @@ void AnimatedShadows::RecordCommands(Camera camera)
 
 	//vkCmdBeginRenderPass(*_vulkan->GetMainCommandBuffer(), &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
 
-	vkCmdBindPipeline(*_vulkan->GetMainCommandBuffer(), VK_PIPELINE_BIND_POINT_GRAPHICS, _pipeline);
+	_vulkan->_commandRecorder.Record(_shadowRenderPass, _animatedModelPipeline->Models.size(), [this](VkCommandBuffer commandBuffer, uint32_t first, uint32_t last) {
+		RecordModels(commandBuffer, first, last);
+	});
+
+	vkCmdEndRenderPass(*_vulkan->GetMainCommandBuffer());
+}
+
+void AnimatedShadows::RecordModels(VkCommandBuffer commandBuffer, uint32_t first, uint32_t last)
+{
+	if (_animatedModelPipeline->_lightViewProjOffset == FrameAllocator::INVALID_OFFSET)
+	{
+		return;
+	}
+
+	uint32_t boundBlock = UINT32_MAX;
+
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, _pipeline);
 
 	vkCmdBindDescriptorSets(
-		*_vulkan->GetMainCommandBuffer(),
+		commandBuffer,
 		VK_PIPELINE_BIND_POINT_GRAPHICS,
 		_pipelineLayout,
 		0,
 		1,
 		&_viewProjDescriptorSetGroup.DescriptorSets[_vulkan->_currentImage],
-		0,
-		nullptr
+		1,
+		&_animatedModelPipeline->_lightViewProjOffset
 	);
 	
 	// render models
-	for (int i = 0; i < _animatedModelPipeline->Models.size(); i++)
+	for (uint32_t i = first; i < last; i++)
 	{
 		AnimatedModel* model = _animatedModelPipeline->Models[i];
+		if (_animatedModelPipeline->_modelOffsets[i] == FrameAllocator::INVALID_OFFSET || _animatedModelPipeline->_boneTransformOffsets[i] == FrameAllocator::INVALID_OFFSET)
+		{
+			continue;
+		}
 
 		// set model matrix
-		uint32_t offset = _animatedModelPipeline->_modelMatrixAlignment * i;
+		uint32_t offset = _animatedModelPipeline->_modelOffsets[i];
 		vkCmdBindDescriptorSets(
-			*_vulkan->GetMainCommandBuffer(),
+			commandBuffer,
 			VK_PIPELINE_BIND_POINT_GRAPHICS,
 			_pipelineLayout,
 			1,
@@ -232,17 +261,29 @@ void AnimatedShadows::RecordCommands(Camera camera)
 			&offset
 		);
 
+		// set bone transforms
+		uint32_t boneTransformsOffset = _animatedModelPipeline->_boneTransformOffsets[i];
+		vkCmdBindDescriptorSets(
+			commandBuffer,
+			VK_PIPELINE_BIND_POINT_GRAPHICS,
+			_pipelineLayout,
+			2,
+			1,
+			&_animatedModelPipeline->_boneTransformDescriptorSetGroup.DescriptorSets[_vulkan->_currentImage],
+			1,
+			&boneTransformsOffset
+		);
+
 		// draw model meshes
 		for (int j = 0; j < model->Drawables.size(); j++)
 		{
-			_vulkan->DrawMesh(
-				*_vulkan->GetMainCommandBuffer(),
-				&model->Drawables[j]->AnimatedMesh->VertexBuffer,
-				&model->Drawables[j]->AnimatedMesh->IndexBuffer,
-				model->Drawables[j]->AnimatedMesh->Indices.size()
-			);
+			// skip drawables that are still uploading
+			if (!model->Drawables[j]->AnimatedMesh->IsReady())
+			{
+				continue;
+			}
+
+			model->Drawables[j]->AnimatedMesh->RecordDrawCommands(commandBuffer, &boundBlock, 1, 0, model->GetShadowLod(j));
 		}
 	}
-
-	vkCmdEndRenderPass(*_vulkan->GetMainCommandBuffer());
-}
\ No newline at end of file
+}
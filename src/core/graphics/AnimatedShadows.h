@@ -31,7 +31,7 @@ namespace Euler
 			float _viewportHeight;
 
 			std::vector<VkImage> _depthImages;
-			std::vector<VkDeviceMemory> _depthImageMemories;
+			std::vector<MemoryAllocation> _depthImageMemories;
 			std::vector<VkImageView> _depthImageViews;
 
 			std::vector<VkFramebuffer> _framebuffers;
@@ -53,6 +53,10 @@ namespace Euler
 			void UpdateDescriptorSets();
 
 			void RecordCommands(Camera camera);
+
+		private:
+			// records models [first, last), called by the command recorder on a worker thread
+			void RecordModels(VkCommandBuffer commandBuffer, uint32_t first, uint32_t last);
 		};
 	}
 }
\ No newline at end of file
@@ -1,6 +1,9 @@
 #include "Camera.h"
 
 #include "../math/Matrices.h"
+#include "../math/Math.h"
+
+#include <math.h>
 
 using namespace Euler;
 using namespace Euler::Math;
@@ -32,4 +35,19 @@ ViewProj Camera::GetViewProj()
 	viewProj.Projection.Transpose();
 
 	return viewProj;
-}
\ No newline at end of file
+}
+
+float Camera::GetNearZ()
+{
+	return _nearZ;
+}
+
+float Camera::GetFarZ()
+{
+	return _farZ;
+}
+
+float Camera::GetProjectionScale()
+{
+	return _height / (2.0f * tanf(_fieldOfView * Deg2Rad * 0.5f));
+}
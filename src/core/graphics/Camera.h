@@ -21,5 +21,9 @@ namespace Euler
 
 		void Init(uint32_t width, uint32_t height, float fieldOfView, float nearZ, float farZ);
 		ViewProj GetViewProj();
+		float GetNearZ();
+		float GetFarZ();
+		// pixels covered by a unit at distance 1 in front of the camera
+		float GetProjectionScale();
 	};
 }
\ No newline at end of file
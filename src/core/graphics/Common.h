@@ -43,9 +43,32 @@ public:
 	VkFrontFace FrontFace = VK_FRONT_FACE_CLOCKWISE;
 };
 
+class EULER_API ComputePipelineInfo
+{
+public:
+	const char* ShaderCode;
+	size_t ShaderCodeSize;
+
+	std::vector<VkDescriptorSetLayout> DescriptorSetLayouts;
+
+	// size of the push constant block, 0 when the shader has none
+	uint32_t PushConstantSize = 0;
+};
+
 class EULER_API ViewProj
 {
 public:
 	Mat4 View;
 	Mat4 Projection;
+};
+
+// per-object data read by the indirect draw shaders through gl_InstanceIndex, laid out as std430
+class EULER_API ObjectData
+{
+public:
+	Mat4 Model;
+	uint32_t MaterialIndex;
+	uint32_t FirstIndex;
+	int32_t VertexOffset;
+	uint32_t IndexCount;
 };
\ No newline at end of file
@@ -44,12 +44,13 @@ void DescriptorSetGroup::UpdateUniformBuffer(Vulkan* vulkan, uint32_t descriptor
 	vkUpdateDescriptorSets(vulkan->_device, 1, &write, 0, nullptr);
 }
 
-void DescriptorSetGroup::UpdateUniformBufferDynamic(Vulkan* vulkan, uint32_t descriptorSetIndex, VkBuffer buffer, uint32_t dstBinding)
+void DescriptorSetGroup::UpdateUniformBufferDynamic(Vulkan* vulkan, uint32_t descriptorSetIndex, VkBuffer buffer, uint32_t dstBinding, VkDeviceSize range)
 {
+	// the range has to be set when the buffer is bigger than one element, the dynamic offset is added to it
 	VkDescriptorBufferInfo bufferInfo{};
 	bufferInfo.buffer = buffer;
 	bufferInfo.offset = 0;
-	bufferInfo.range = VK_WHOLE_SIZE;
+	bufferInfo.range = range;
 
 	VkWriteDescriptorSet write{};
 	write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
@@ -63,6 +64,25 @@ void DescriptorSetGroup::UpdateUniformBufferDynamic(Vulkan* vulkan, uint32_t des
 	vkUpdateDescriptorSets(vulkan->_device, 1, &write, 0, nullptr);
 }
 
+void DescriptorSetGroup::UpdateStorageBufferDynamic(Vulkan* vulkan, uint32_t descriptorSetIndex, VkBuffer buffer, uint32_t dstBinding, VkDeviceSize range)
+{
+	VkDescriptorBufferInfo bufferInfo{};
+	bufferInfo.buffer = buffer;
+	bufferInfo.offset = 0;
+	bufferInfo.range = range;
+
+	VkWriteDescriptorSet write{};
+	write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	write.dstSet = DescriptorSets[descriptorSetIndex];
+	write.dstBinding = dstBinding;
+	write.dstArrayElement = 0;
+	write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+	write.descriptorCount = 1;
+	write.pBufferInfo = &bufferInfo;
+
+	vkUpdateDescriptorSets(vulkan->_device, 1, &write, 0, nullptr);
+}
+
 void DescriptorSetGroup::UpdateSampler(Vulkan* vulkan, uint32_t descriptorSetIndex, VkImageView imageView, VkSampler sampler, uint32_t dstBinding)
 {
 	VkDescriptorImageInfo imageInfo{};
@@ -22,7 +22,8 @@ namespace Euler
 			void Free(Vulkan* vulkan);
 
 			void UpdateUniformBuffer(Vulkan* vulkan, uint32_t descriptorSetIndex, VkBuffer buffer, uint32_t dstBinding);
-			void UpdateUniformBufferDynamic(Vulkan* vulkan, uint32_t descriptorSetIndex, VkBuffer buffer, uint32_t dstBinding);
+			void UpdateUniformBufferDynamic(Vulkan* vulkan, uint32_t descriptorSetIndex, VkBuffer buffer, uint32_t dstBinding, VkDeviceSize range = VK_WHOLE_SIZE);
+			void UpdateStorageBufferDynamic(Vulkan* vulkan, uint32_t descriptorSetIndex, VkBuffer buffer, uint32_t dstBinding, VkDeviceSize range = VK_WHOLE_SIZE);
 			void UpdateSampler(Vulkan* vulkan, uint32_t descriptorSetIndex, VkImageView imageView, VkSampler sampler, uint32_t dstBinding);
 		};
 	}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "../API.h"
+
+#include <stdint.h>
+
+namespace Euler
+{
+	// vertices and indices owned by someone else, e.g. a mapped model file. Vertices are in one of the
+	// vertex formats and start with their position
+	struct EULER_API GeometryView
+	{
+		const void* Vertices = nullptr;
+		uint32_t VertexCount = 0;
+		uint32_t VertexStride = 0;
+		const void* Indices = nullptr;
+		uint32_t IndexCount = 0;
+		// 2 or 4 bytes
+		uint32_t IndexSize = sizeof(uint32_t);
+
+		bool IsEmpty() const
+		{
+			return Vertices == nullptr;
+		}
+
+		uint64_t GetSize() const
+		{
+			return (uint64_t)VertexCount * VertexStride + (uint64_t)IndexCount * IndexSize;
+		}
+	};
+}
@@ -0,0 +1,673 @@
+#include "GpuCulling.h"
+
+#include "../io/Utils.h"
+
+#include <assert.h>
+#include <string.h>
+#include <iostream>
+
+using namespace Euler::Graphics;
+
+const uint32_t GpuCulling::CAMERA_PASS;
+const uint32_t GpuCulling::LIGHT_PASS;
+const uint32_t GpuCulling::LATE_PASS;
+const uint32_t GpuCulling::PASS_COUNT;
+const uint32_t GpuCulling::STAT_COUNT;
+const uint32_t GpuCulling::GROUP_SIZE;
+
+bool GpuCulling::Create(Vulkan* vulkan, VkDescriptorSetLayout objectsLayout, uint32_t maxObjects, uint32_t maxBatches, uint32_t maxGroups)
+{
+	_vulkan = vulkan;
+
+	if (!_vulkan->_drawIndirectCount || !_vulkan->_multiDrawIndirect || !_vulkan->_drawIndirectFirstInstance)
+	{
+		std::cout << "GpuCulling: indirect count draws not supported" << std::endl;
+		return false;
+	}
+
+	// the visible objects of each pass start at a dynamic offset, which has to be aligned to at most 256 bytes
+	_maxObjects = (maxObjects + 255) / 256 * 256;
+	_maxBatches = maxBatches;
+	_maxGroups = maxGroups;
+
+	/* === DESCRIPTOR SET LAYOUT === */
+
+	std::vector<VkDescriptorSetLayoutBinding> bindings(8);
+	for (uint32_t i = 0; i < bindings.size(); i++)
+	{
+		bindings[i].binding = i;
+		bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		bindings[i].descriptorCount = 1;
+		bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	}
+	// the hi-z pyramid
+	bindings[6].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	_vulkan->CreateDescriptorSetLayout(bindings, &_layout);
+
+	if (!CreatePipelines())
+	{
+		_vulkan->DestroyDescriptorSetLayout(_layout);
+		_layout = VK_NULL_HANDLE;
+		return false;
+	}
+
+	CreateBuffers();
+	CreateDescriptorSets(objectsLayout);
+
+	_occlusionSupported = _pyramid.Create(_vulkan);
+	if (_occlusionSupported)
+	{
+		WritePyramidDescriptor();
+	}
+
+	_stagingBuffers.resize(_vulkan->_framesInFlight, VK_NULL_HANDLE);
+	_stagingMemories.resize(_vulkan->_framesInFlight);
+	_stagingSizes.resize(_vulkan->_framesInFlight, 0);
+
+	_statsBuffers.resize(_vulkan->_framesInFlight);
+	_statsMemories.resize(_vulkan->_framesInFlight);
+	_statsObjectCounts.resize(_vulkan->_framesInFlight, UINT32_MAX);
+	for (uint32_t i = 0; i < _statsBuffers.size(); i++)
+	{
+		_vulkan->CreateBuffer(
+			STAT_COUNT * sizeof(uint32_t),
+			VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			_statsBuffers[i],
+			_statsMemories[i]
+		);
+		assert(_statsMemories[i].MappedData != nullptr);
+	}
+
+	return true;
+}
+
+void GpuCulling::Destroy()
+{
+	if (_layout == VK_NULL_HANDLE)
+	{
+		return;
+	}
+
+	for (uint32_t i = 0; i < _stagingBuffers.size(); i++)
+	{
+		if (_stagingBuffers[i] != VK_NULL_HANDLE)
+		{
+			_vulkan->DestroyBuffer(_stagingBuffers[i], _stagingMemories[i]);
+		}
+	}
+	_stagingBuffers.clear();
+	_stagingMemories.clear();
+	_stagingSizes.clear();
+
+	for (uint32_t i = 0; i < _statsBuffers.size(); i++)
+	{
+		_vulkan->DestroyBuffer(_statsBuffers[i], _statsMemories[i]);
+	}
+	_statsBuffers.clear();
+	_statsMemories.clear();
+	_statsObjectCounts.clear();
+
+	_pyramid.Destroy();
+
+	_vulkan->DestroyBuffer(_objectBuffer, _objectMemory);
+	_vulkan->DestroyBuffer(_batchBuffer, _batchMemory);
+	_vulkan->DestroyBuffer(_frustumBuffer, _frustumMemory);
+	_vulkan->DestroyBuffer(_countBuffer, _countMemory);
+	_vulkan->DestroyBuffer(_commandBuffer, _commandMemory);
+	_vulkan->DestroyBuffer(_visibleBuffer, _visibleMemory);
+	_vulkan->DestroyBuffer(_occludedBuffer, _occludedMemory);
+
+	_vulkan->DestroyPipeline(_cullPipelineLayout, _cullPipeline);
+	_vulkan->DestroyPipeline(_compactPipelineLayout, _compactPipeline);
+
+	_vulkan->DestroyDescriptorPool(_descriptorPool);
+	_vulkan->DestroyDescriptorSetLayout(_layout);
+	_layout = VK_NULL_HANDLE;
+}
+
+bool GpuCulling::CreatePipelines()
+{
+	std::vector<char> cullShaderCode = ReadFile("shaders/out/cull_compute.spv");
+	std::vector<char> compactShaderCode = ReadFile("shaders/out/cull_compact_compute.spv");
+	if (cullShaderCode.empty() || compactShaderCode.empty())
+	{
+		std::cout << "GpuCulling: culling shaders not found" << std::endl;
+		return false;
+	}
+
+	ComputePipelineInfo pipelineInfo{};
+	pipelineInfo.DescriptorSetLayouts = { _layout };
+	pipelineInfo.PushConstantSize = sizeof(PushConstants);
+
+	pipelineInfo.ShaderCode = cullShaderCode.data();
+	pipelineInfo.ShaderCodeSize = cullShaderCode.size();
+	_vulkan->CreateComputePipeline(&pipelineInfo, &_cullPipelineLayout, &_cullPipeline);
+
+	pipelineInfo.ShaderCode = compactShaderCode.data();
+	pipelineInfo.ShaderCodeSize = compactShaderCode.size();
+	_vulkan->CreateComputePipeline(&pipelineInfo, &_compactPipelineLayout, &_compactPipeline);
+
+	return true;
+}
+
+void GpuCulling::CreateBuffers()
+{
+	VkMemoryPropertyFlags deviceLocal = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+
+	_vulkan->CreateBuffer(_maxObjects * sizeof(CullObject), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, deviceLocal, _objectBuffer, _objectMemory);
+	_vulkan->CreateBuffer(_maxBatches * sizeof(CullBatch), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, deviceLocal, _batchBuffer, _batchMemory);
+	_vulkan->CreateBuffer(sizeof(FrustumData), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, deviceLocal, _frustumBuffer, _frustumMemory);
+
+	_vulkan->CreateBuffer(
+		(PASS_COUNT * (_maxBatches + _maxGroups) + STAT_COUNT) * sizeof(uint32_t),
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		deviceLocal,
+		_countBuffer,
+		_countMemory
+	);
+	_vulkan->CreateBuffer(
+		PASS_COUNT * _maxBatches * sizeof(VkDrawIndexedIndirectCommand),
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+		deviceLocal,
+		_commandBuffer,
+		_commandMemory
+	);
+	_vulkan->CreateBuffer(PASS_COUNT * _maxObjects * sizeof(ObjectData), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, deviceLocal, _visibleBuffer, _visibleMemory);
+	_vulkan->CreateBuffer(_maxObjects * sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, deviceLocal, _occludedBuffer, _occludedMemory);
+}
+
+void GpuCulling::CreateDescriptorSets(VkDescriptorSetLayout objectsLayout)
+{
+	std::vector<VkDescriptorPoolSize> poolSizes = {
+		{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 7 },
+		{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1 },
+		{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 1 }
+	};
+	_vulkan->CreateDescriptorPool(poolSizes, 2, &_descriptorPool);
+
+	VkDescriptorSetLayout layouts[] = { _layout, objectsLayout };
+	VkDescriptorSet sets[2];
+
+	VkDescriptorSetAllocateInfo allocateInfo{};
+	allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocateInfo.descriptorPool = _descriptorPool;
+	allocateInfo.descriptorSetCount = 2;
+	allocateInfo.pSetLayouts = layouts;
+
+	vkAllocateDescriptorSets(_vulkan->_device, &allocateInfo, sets);
+	_descriptorSet = sets[0];
+	_objectsSet = sets[1];
+
+	// binding order matches the shaders: objects, batches, frustums, counts, commands, visible objects, pyramid, occluded flags
+	VkBuffer buffers[] = { _objectBuffer, _batchBuffer, _frustumBuffer, _countBuffer, _commandBuffer, _visibleBuffer, VK_NULL_HANDLE, _occludedBuffer };
+
+	VkDescriptorBufferInfo bufferInfos[8];
+	VkWriteDescriptorSet writes[8] = {};
+	uint32_t writeCount = 0;
+	for (uint32_t i = 0; i < 8; i++)
+	{
+		if (buffers[i] == VK_NULL_HANDLE)
+		{
+			continue;
+		}
+
+		bufferInfos[writeCount].buffer = buffers[i];
+		bufferInfos[writeCount].offset = 0;
+		bufferInfos[writeCount].range = VK_WHOLE_SIZE;
+
+		writes[writeCount].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		writes[writeCount].dstSet = _descriptorSet;
+		writes[writeCount].dstBinding = i;
+		writes[writeCount].descriptorCount = 1;
+		writes[writeCount].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		writes[writeCount].pBufferInfo = &bufferInfos[writeCount];
+		writeCount++;
+	}
+
+	// the draw shaders see one pass of the visible objects at a time
+	bufferInfos[writeCount].buffer = _visibleBuffer;
+	bufferInfos[writeCount].offset = 0;
+	bufferInfos[writeCount].range = _maxObjects * sizeof(ObjectData);
+
+	writes[writeCount].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	writes[writeCount].dstSet = _objectsSet;
+	writes[writeCount].dstBinding = 0;
+	writes[writeCount].descriptorCount = 1;
+	writes[writeCount].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+	writes[writeCount].pBufferInfo = &bufferInfos[writeCount];
+	writeCount++;
+
+	vkUpdateDescriptorSets(_vulkan->_device, writeCount, writes, 0, nullptr);
+}
+
+void GpuCulling::WritePyramidDescriptor()
+{
+	VkDescriptorImageInfo imageInfo{};
+	imageInfo.sampler = _pyramid.GetSampler();
+	imageInfo.imageView = _pyramid.GetView();
+	imageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+	VkWriteDescriptorSet write{};
+	write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	write.dstSet = _descriptorSet;
+	write.dstBinding = 6;
+	write.descriptorCount = 1;
+	write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	write.pImageInfo = &imageInfo;
+
+	vkUpdateDescriptorSets(_vulkan->_device, 1, &write, 0, nullptr);
+}
+
+void GpuCulling::Clear()
+{
+	_objects.clear();
+	_batches.clear();
+	_groups.clear();
+	_batchObjectCounts.clear();
+	_shadowBatchObjectCounts.clear();
+	_dirtyObjects.clear();
+	_objectDirty.clear();
+	_rebuilt = true;
+}
+
+void GpuCulling::BeginGroup(GeometryArena* arena)
+{
+	assert(_groups.size() < _maxGroups);
+
+	Group group;
+	group.Arena = arena;
+	group.Geometry = nullptr;
+	group.CommandBase = _batches.size();
+	group.BatchCount = 0;
+	_groups.push_back(group);
+}
+
+uint32_t GpuCulling::AddBatch(const GeometryAllocation* geometry, uint32_t firstIndex, uint32_t indexCount)
+{
+	assert(!_groups.empty());
+	assert(_batches.size() < _maxBatches);
+
+	Group& group = _groups.back();
+	if (group.Geometry == nullptr)
+	{
+		group.Geometry = geometry;
+	}
+	group.BatchCount++;
+
+	CullBatch batch{};
+	batch.IndexCount = indexCount;
+	batch.FirstIndex = firstIndex;
+	batch.VertexOffset = geometry->VertexOffset;
+	batch.CommandBase = group.CommandBase;
+	batch.Group = _groups.size() - 1;
+	_batches.push_back(batch);
+
+	_batchObjectCounts.push_back(0);
+	_shadowBatchObjectCounts.push_back(0);
+
+	_rebuilt = true;
+	return _batches.size() - 1;
+}
+
+uint32_t GpuCulling::AddObject(const ObjectData& object, const Math::BoundingSphere& sphere, uint32_t batch, uint32_t shadowBatch)
+{
+	assert(batch < _batches.size() && shadowBatch < _batches.size());
+	assert(_objects.size() < _maxObjects);
+
+	CullObject cullObject{};
+	cullObject.Object = object;
+	cullObject.Sphere = Vec4(sphere.Center.x, sphere.Center.y, sphere.Center.z, sphere.Radius);
+	cullObject.Batch = batch;
+	cullObject.ShadowBatch = shadowBatch;
+	_objects.push_back(cullObject);
+	_objectDirty.push_back(0);
+
+	_batchObjectCounts[batch]++;
+	_shadowBatchObjectCounts[shadowBatch]++;
+
+	_rebuilt = true;
+	return _objects.size() - 1;
+}
+
+void GpuCulling::UpdateObject(uint32_t index, const Mat4& model)
+{
+	_objects[index].Object.Model = model;
+	MarkDirty(index);
+}
+
+void GpuCulling::SetObjectBatches(uint32_t index, uint32_t batch, uint32_t shadowBatch)
+{
+	CullObject& object = _objects[index];
+	if (object.Batch == batch && object.ShadowBatch == shadowBatch)
+	{
+		return;
+	}
+
+	_batchObjectCounts[object.Batch]--;
+	_shadowBatchObjectCounts[object.ShadowBatch]--;
+	_batchObjectCounts[batch]++;
+	_shadowBatchObjectCounts[shadowBatch]++;
+
+	object.Batch = batch;
+	object.ShadowBatch = shadowBatch;
+	_batchesDirty = true;
+	MarkDirty(index);
+}
+
+void GpuCulling::MarkDirty(uint32_t index)
+{
+	// a rebuild copies all objects anyway
+	if (!_rebuilt && !_objectDirty[index])
+	{
+		_objectDirty[index] = 1;
+		_dirtyObjects.push_back(index);
+	}
+}
+
+void GpuCulling::UpdateFirstInstances()
+{
+	uint32_t firstInstance = 0;
+	uint32_t shadowFirstInstance = 0;
+	for (uint32_t i = 0; i < _batches.size(); i++)
+	{
+		_batches[i].FirstInstance = firstInstance;
+		_batches[i].ShadowFirstInstance = shadowFirstInstance;
+		firstInstance += _batchObjectCounts[i];
+		shadowFirstInstance += _shadowBatchObjectCounts[i];
+	}
+}
+
+void* GpuCulling::GetStaging(int frame, VkDeviceSize size)
+{
+	// the frame's fence was waited on, so its old staging buffer is no longer read
+	if (_stagingSizes[frame] < size)
+	{
+		if (_stagingBuffers[frame] != VK_NULL_HANDLE)
+		{
+			_vulkan->DestroyBuffer(_stagingBuffers[frame], _stagingMemories[frame]);
+		}
+
+		VkDeviceSize newSize = _stagingSizes[frame] * 2 > size ? _stagingSizes[frame] * 2 : size;
+		_vulkan->CreateBuffer(
+			newSize,
+			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			_stagingBuffers[frame],
+			_stagingMemories[frame]
+		);
+		assert(_stagingMemories[frame].MappedData != nullptr);
+		_stagingSizes[frame] = newSize;
+	}
+
+	return _stagingMemories[frame].MappedData;
+}
+
+GpuCulling::PushConstants GpuCulling::GetPushConstants(uint32_t phase)
+{
+	PushConstants constants;
+	constants.ObjectCount = _objects.size();
+	constants.BatchCount = _batches.size();
+	constants.MaxObjects = _maxObjects;
+	constants.MaxBatches = _maxBatches;
+	constants.MaxGroups = _maxGroups;
+	constants.Phase = phase;
+	// the first phase needs a pyramid from an earlier frame
+	constants.Occlusion = _occlusion && _pyramid.IsBuilt() ? 1 : 0;
+	constants.DepthWidth = _vulkan->_extent.width;
+	constants.DepthHeight = _vulkan->_extent.height;
+	return constants;
+}
+
+void GpuCulling::CopyStats(VkCommandBuffer commandBuffer)
+{
+	int frame = _vulkan->_currentFrame;
+
+	_vulkan->PipelineBarrier(
+		commandBuffer,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		VK_ACCESS_SHADER_WRITE_BIT,
+		VK_PIPELINE_STAGE_TRANSFER_BIT,
+		VK_ACCESS_TRANSFER_READ_BIT
+	);
+
+	VkBufferCopy region = { (PASS_COUNT * (_maxBatches + _maxGroups)) * sizeof(uint32_t), 0, STAT_COUNT * sizeof(uint32_t) };
+	vkCmdCopyBuffer(commandBuffer, _countBuffer, _statsBuffers[frame], 1, &region);
+
+	_vulkan->PipelineBarrier(
+		commandBuffer,
+		VK_PIPELINE_STAGE_TRANSFER_BIT,
+		VK_ACCESS_TRANSFER_WRITE_BIT,
+		VK_PIPELINE_STAGE_HOST_BIT,
+		VK_ACCESS_HOST_READ_BIT
+	);
+
+	_statsObjectCounts[frame] = _objects.size();
+}
+
+void GpuCulling::Dispatch(const Math::Frustum& cameraFrustum, const Math::Frustum& lightFrustum, const Mat4* cameraViewProj)
+{
+	VkCommandBuffer commandBuffer = *_vulkan->GetMainCommandBuffer();
+	int frame = _vulkan->_currentFrame;
+
+	// the frame's fence was waited on, so its statistics are complete
+	if (_statsObjectCounts[frame] != UINT32_MAX)
+	{
+		const uint32_t* stats = (const uint32_t*)_statsMemories[frame].MappedData;
+		_stats.Objects = _statsObjectCounts[frame];
+		_stats.FrustumCulled = stats[0];
+		_stats.LateVisible = stats[2];
+		_stats.Occluded = stats[1] - stats[2];
+	}
+
+	_occlusion = cameraViewProj != nullptr && _occlusionSupported;
+	if (_occlusion)
+	{
+		_viewProj = *cameraViewProj;
+		_viewProj.Transpose();
+
+		// the depth buffer only changes while the device is idle, when the swapchain is recreated
+		if (_pyramid.Resize())
+		{
+			WritePyramidDescriptor();
+		}
+	}
+
+	// the previous frames may still be culling, drawing or copying statistics with the buffers written below
+	_vulkan->PipelineBarrier(
+		commandBuffer,
+		VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+		VK_ACCESS_SHADER_WRITE_BIT,
+		VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT
+	);
+
+	/* === COPY CHANGED OBJECTS === */
+
+	if (_rebuilt || _batchesDirty)
+	{
+		UpdateFirstInstances();
+	}
+
+	// a rebuild copies everything, otherwise only the changed objects and the batches when objects switched them
+	uint32_t objectCount = _rebuilt ? _objects.size() : _dirtyObjects.size();
+	VkDeviceSize objectsSize = objectCount * sizeof(CullObject);
+	VkDeviceSize batchesSize = _rebuilt || _batchesDirty ? _batches.size() * sizeof(CullBatch) : 0;
+
+	if (objectsSize + batchesSize > 0)
+	{
+		uint8_t* staging = (uint8_t*)GetStaging(frame, objectsSize + batchesSize);
+
+		if (_rebuilt)
+		{
+			memcpy(staging, _objects.data(), objectsSize);
+
+			VkBufferCopy region = { 0, 0, objectsSize };
+			vkCmdCopyBuffer(commandBuffer, _stagingBuffers[frame], _objectBuffer, 1, &region);
+		}
+		else if (objectCount > 0)
+		{
+			CullObject* stagingObjects = (CullObject*)staging;
+
+			std::vector<VkBufferCopy> regions(objectCount);
+			for (uint32_t i = 0; i < objectCount; i++)
+			{
+				stagingObjects[i] = _objects[_dirtyObjects[i]];
+				_objectDirty[_dirtyObjects[i]] = 0;
+
+				regions[i].srcOffset = i * sizeof(CullObject);
+				regions[i].dstOffset = _dirtyObjects[i] * sizeof(CullObject);
+				regions[i].size = sizeof(CullObject);
+			}
+
+			vkCmdCopyBuffer(commandBuffer, _stagingBuffers[frame], _objectBuffer, regions.size(), regions.data());
+		}
+
+		if (batchesSize > 0)
+		{
+			memcpy(staging + objectsSize, _batches.data(), batchesSize);
+
+			VkBufferCopy region = { objectsSize, 0, batchesSize };
+			vkCmdCopyBuffer(commandBuffer, _stagingBuffers[frame], _batchBuffer, 1, &region);
+		}
+	}
+
+	_rebuilt = false;
+	_batchesDirty = false;
+	_dirtyObjects.clear();
+
+	/* === FRUSTUMS AND COUNTERS === */
+
+	FrustumData frustums;
+	for (uint32_t i = 0; i < Math::Frustum::PLANE_COUNT; i++)
+	{
+		frustums.Planes[CAMERA_PASS * Math::Frustum::PLANE_COUNT + i] = cameraFrustum.Planes[i];
+		frustums.Planes[LIGHT_PASS * Math::Frustum::PLANE_COUNT + i] = lightFrustum.Planes[i];
+	}
+	frustums.OcclusionViewProjs[0] = _pyramidViewProj;
+	frustums.OcclusionViewProjs[1] = _viewProj;
+	vkCmdUpdateBuffer(commandBuffer, _frustumBuffer, 0, sizeof(frustums), &frustums);
+
+	vkCmdFillBuffer(commandBuffer, _countBuffer, 0, VK_WHOLE_SIZE, 0);
+
+	_vulkan->PipelineBarrier(
+		commandBuffer,
+		VK_PIPELINE_STAGE_TRANSFER_BIT,
+		VK_ACCESS_TRANSFER_WRITE_BIT,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT
+	);
+
+	/* === CULL AND COMPACT === */
+
+	PushConstants constants = GetPushConstants(0);
+
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, _cullPipelineLayout, 0, 1, &_descriptorSet, 0, nullptr);
+
+	// one thread per object, counts the visible instances of every batch
+	_vulkan->Dispatch(commandBuffer, _cullPipeline, _cullPipelineLayout, &constants, sizeof(constants), _objects.size(), GROUP_SIZE);
+
+	_vulkan->PipelineBarrier(
+		commandBuffer,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		VK_ACCESS_SHADER_WRITE_BIT,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT
+	);
+
+	// one thread per batch, appends a command for every batch with visible instances
+	_vulkan->Dispatch(commandBuffer, _compactPipeline, _compactPipelineLayout, &constants, sizeof(constants), _batches.size(), GROUP_SIZE);
+
+	_vulkan->PipelineBarrier(
+		commandBuffer,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		VK_ACCESS_SHADER_WRITE_BIT,
+		VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,
+		VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT
+	);
+
+	// otherwise the late phase adds its count first
+	if (!_occlusion)
+	{
+		CopyStats(commandBuffer);
+	}
+}
+
+void GpuCulling::DispatchLate()
+{
+	assert(_occlusion);
+
+	VkCommandBuffer commandBuffer = *_vulkan->GetMainCommandBuffer();
+
+	// ends with the pyramid and the first phase's flags visible to the culling
+	_pyramid.Build(commandBuffer);
+	_pyramidViewProj = _viewProj;
+
+	PushConstants constants = GetPushConstants(1);
+
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, _cullPipelineLayout, 0, 1, &_descriptorSet, 0, nullptr);
+
+	// one thread per object, only the ones flagged as occluded test again
+	_vulkan->Dispatch(commandBuffer, _cullPipeline, _cullPipelineLayout, &constants, sizeof(constants), _objects.size(), GROUP_SIZE);
+
+	_vulkan->PipelineBarrier(
+		commandBuffer,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		VK_ACCESS_SHADER_WRITE_BIT,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT
+	);
+
+	_vulkan->Dispatch(commandBuffer, _compactPipeline, _compactPipelineLayout, &constants, sizeof(constants), _batches.size(), GROUP_SIZE);
+
+	_vulkan->PipelineBarrier(
+		commandBuffer,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		VK_ACCESS_SHADER_WRITE_BIT,
+		VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,
+		VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT
+	);
+
+	CopyStats(commandBuffer);
+}
+
+bool GpuCulling::SupportsOcclusion()
+{
+	return _occlusionSupported;
+}
+
+GpuCullingStats GpuCulling::GetStats()
+{
+	return _stats;
+}
+
+uint32_t GpuCulling::GetObjectCount()
+{
+	return _objects.size();
+}
+
+uint32_t GpuCulling::GetGroupCount()
+{
+	return _groups.size();
+}
+
+VkDescriptorSet GpuCulling::GetObjectsSet()
+{
+	return _objectsSet;
+}
+
+uint32_t GpuCulling::GetObjectsOffset(uint32_t pass)
+{
+	return pass * _maxObjects * sizeof(ObjectData);
+}
+
+void GpuCulling::DrawGroup(VkCommandBuffer commandBuffer, uint32_t pass, uint32_t group, uint32_t* boundBlock)
+{
+	const Group& drawGroup = _groups[group];
+	drawGroup.Arena->Bind(commandBuffer, drawGroup.Geometry, boundBlock);
+
+	VkDeviceSize commandOffset = ((VkDeviceSize)pass * _maxBatches + drawGroup.CommandBase) * sizeof(VkDrawIndexedIndirectCommand);
+	VkDeviceSize countOffset = ((VkDeviceSize)PASS_COUNT * _maxBatches + pass * _maxGroups + group) * sizeof(uint32_t);
+
+	_vulkan->DrawIndexedIndirect(commandBuffer, _commandBuffer, commandOffset, _countBuffer, countOffset, drawGroup.BatchCount);
+}
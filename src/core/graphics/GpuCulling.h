@@ -0,0 +1,212 @@
+#pragma once
+
+#include "../API.h"
+#include "vulkan/Vulkan.h"
+#include "Common.h"
+#include "HiZPyramid.h"
+#include "../math/Vec4.h"
+#include "../math/Mat4.h"
+#include "../math/Bounds.h"
+#include "../math/Frustum.h"
+
+#include <vulkan/vulkan.h>
+#include <vector>
+
+namespace Euler
+{
+	namespace Graphics
+	{
+		// std430 layouts shared with shaders/cull.comp and shaders/cull_compact.comp
+		struct EULER_API CullObject
+		{
+			ObjectData Object;
+			Vec4 Sphere;			// object space center and radius
+			uint32_t Batch;			// of the camera passes
+			uint32_t ShadowBatch;	// of the light pass
+			uint32_t Padding[2];
+		};
+
+		struct EULER_API CullBatch
+		{
+			uint32_t IndexCount;
+			uint32_t FirstIndex;
+			int32_t VertexOffset;
+			uint32_t FirstInstance;			// first slot of the batch's visible objects in the camera passes
+			uint32_t CommandBase;			// first command of the batch's group
+			uint32_t Group;
+			uint32_t ShadowFirstInstance;	// and in the light pass
+			uint32_t Padding;
+		};
+
+		// read back from the GPU, a few frames late
+		struct EULER_API GpuCullingStats
+		{
+			uint32_t Objects;
+			uint32_t FrustumCulled;		// outside the camera frustum
+			uint32_t Occluded;			// behind last frame's depth and still hidden in the late phase
+			uint32_t LateVisible;		// behind last frame's depth but visible this frame
+		};
+
+		/// <summary>
+		/// Culls objects on the GPU. Objects and their bounds stay in device local buffers and only the changed
+		/// ones are copied each frame. A compute pass tests every object against the camera and the light frustum,
+		/// copies the visible ones into per-batch slots and a second pass writes one indirect command per batch
+		/// that has any, compacted per group with a draw count. Batches are added group by group: a batch is an index
+		/// range of a mesh (one of its levels of detail), a group is the batches sharing an arena block that are drawn
+		/// with one indirect count call. Every object is drawn with one batch in the camera passes and one in the
+		/// light pass, they can be switched without laying the objects out again.
+		/// With occlusion the camera pass also skips objects hidden behind the hi-z pyramid of the previous frame.
+		/// DispatchLate then builds the pyramid from what was drawn so far and re-tests those objects against it,
+		/// the ones that turn out visible are drawn in the late pass.
+		/// </summary>
+		class EULER_API GpuCulling
+		{
+		public:
+			static const uint32_t CAMERA_PASS = 0;
+			static const uint32_t LIGHT_PASS = 1;
+			static const uint32_t LATE_PASS = 2;
+			static const uint32_t PASS_COUNT = 3;
+			static const uint32_t STAT_COUNT = 3;
+			static const uint32_t GROUP_SIZE = 64;
+
+		private:
+			struct Group
+			{
+				GeometryArena* Arena;
+				const GeometryAllocation* Geometry;		// any allocation in the group's block, used to bind it
+				uint32_t CommandBase;
+				uint32_t BatchCount;
+			};
+
+			struct PushConstants
+			{
+				uint32_t ObjectCount;
+				uint32_t BatchCount;
+				uint32_t MaxObjects;
+				uint32_t MaxBatches;
+				uint32_t MaxGroups;
+				uint32_t Phase;
+				uint32_t Occlusion;
+				uint32_t DepthWidth;
+				uint32_t DepthHeight;
+			};
+
+			struct FrustumData
+			{
+				Vec4 Planes[(LIGHT_PASS + 1) * Math::Frustum::PLANE_COUNT];
+				Mat4 OcclusionViewProjs[2];		// transposed, the previous pyramid's and the current one
+			};
+
+			Vulkan* _vulkan = nullptr;
+
+			uint32_t _maxObjects = 0;
+			uint32_t _maxBatches = 0;
+			uint32_t _maxGroups = 0;
+
+			// inputs, written by copies from the staging buffers
+			VkBuffer _objectBuffer = VK_NULL_HANDLE;
+			MemoryAllocation _objectMemory;
+			VkBuffer _batchBuffer = VK_NULL_HANDLE;
+			MemoryAllocation _batchMemory;
+			VkBuffer _frustumBuffer = VK_NULL_HANDLE;
+			MemoryAllocation _frustumMemory;
+
+			// outputs, one part per pass. Counts holds the instance counts of all batches, then the draw counts of all groups,
+			// then the statistics
+			VkBuffer _countBuffer = VK_NULL_HANDLE;
+			MemoryAllocation _countMemory;
+			VkBuffer _commandBuffer = VK_NULL_HANDLE;
+			MemoryAllocation _commandMemory;
+			VkBuffer _visibleBuffer = VK_NULL_HANDLE;
+			MemoryAllocation _visibleMemory;
+			VkBuffer _occludedBuffer = VK_NULL_HANDLE;
+			MemoryAllocation _occludedMemory;
+
+			// host visible, one per frame in flight, grown when a rebuild doesn't fit
+			std::vector<VkBuffer> _stagingBuffers;
+			std::vector<MemoryAllocation> _stagingMemories;
+			std::vector<VkDeviceSize> _stagingSizes;
+
+			// host visible, one per frame in flight, read after the frame's fence was waited on
+			std::vector<VkBuffer> _statsBuffers;
+			std::vector<MemoryAllocation> _statsMemories;
+			std::vector<uint32_t> _statsObjectCounts;
+			GpuCullingStats _stats{};
+
+			HiZPyramid _pyramid;
+			bool _occlusionSupported = false;
+			bool _occlusion = false;
+			Mat4 _viewProj;
+			Mat4 _pyramidViewProj;
+
+			VkDescriptorSetLayout _layout = VK_NULL_HANDLE;
+			VkDescriptorPool _descriptorPool = VK_NULL_HANDLE;
+			VkDescriptorSet _descriptorSet = VK_NULL_HANDLE;
+			VkDescriptorSet _objectsSet = VK_NULL_HANDLE;
+
+			VkPipelineLayout _cullPipelineLayout = VK_NULL_HANDLE;
+			VkPipeline _cullPipeline = VK_NULL_HANDLE;
+			VkPipelineLayout _compactPipelineLayout = VK_NULL_HANDLE;
+			VkPipeline _compactPipeline = VK_NULL_HANDLE;
+
+			std::vector<CullObject> _objects;
+			std::vector<CullBatch> _batches;
+			std::vector<Group> _groups;
+
+			// objects per batch in the camera and the light passes, the batches' first slots are their prefix sums
+			std::vector<uint32_t> _batchObjectCounts;
+			std::vector<uint32_t> _shadowBatchObjectCounts;
+
+			bool _rebuilt = false;
+			bool _batchesDirty = false;
+			std::vector<uint32_t> _dirtyObjects;
+			std::vector<uint8_t> _objectDirty;
+
+		public:
+			// objectsLayout is the layout the draw shaders read the visible objects through (one dynamic storage buffer).
+			// Returns false when the device or the shaders don't support it
+			bool Create(Vulkan* vulkan, VkDescriptorSetLayout objectsLayout, uint32_t maxObjects = 131072, uint32_t maxBatches = 4096, uint32_t maxGroups = 64);
+			void Destroy();
+
+			// removes all objects and batches, they are added again with BeginGroup, AddBatch and AddObject
+			void Clear();
+			void BeginGroup(GeometryArena* arena);
+			// adds a batch to the last group drawing indexCount indices of geometry's block from firstIndex, returns its index
+			uint32_t AddBatch(const GeometryAllocation* geometry, uint32_t firstIndex, uint32_t indexCount);
+			uint32_t AddObject(const ObjectData& object, const Math::BoundingSphere& sphere, uint32_t batch, uint32_t shadowBatch);
+			// model is transposed for the upload like ObjectData::Model
+			void UpdateObject(uint32_t index, const Mat4& model);
+			void SetObjectBatches(uint32_t index, uint32_t batch, uint32_t shadowBatch);
+
+			// records the copies and the culling passes in the main command buffer, outside of any render pass.
+			// cameraViewProj enables occlusion culling, DispatchLate has to be called in the same frame then
+			void Dispatch(const Math::Frustum& cameraFrustum, const Math::Frustum& lightFrustum, const Mat4* cameraViewProj = nullptr);
+			// builds the pyramid from the depth buffer and culls the late pass, outside of any render pass
+			// and after the camera pass was drawn
+			void DispatchLate();
+
+			// false when the pyramid shader is missing
+			bool SupportsOcclusion();
+			GpuCullingStats GetStats();
+
+			uint32_t GetObjectCount();
+			uint32_t GetGroupCount();
+			// set of the objects layout with the visible objects, bound with GetObjectsOffset of the pass
+			VkDescriptorSet GetObjectsSet();
+			uint32_t GetObjectsOffset(uint32_t pass);
+			// binds the group's block and draws its compacted commands
+			void DrawGroup(VkCommandBuffer commandBuffer, uint32_t pass, uint32_t group, uint32_t* boundBlock);
+
+		private:
+			void CreateBuffers();
+			void CreateDescriptorSets(VkDescriptorSetLayout objectsLayout);
+			void WritePyramidDescriptor();
+			bool CreatePipelines();
+			void* GetStaging(int frame, VkDeviceSize size);
+			void MarkDirty(uint32_t index);
+			void UpdateFirstInstances();
+			PushConstants GetPushConstants(uint32_t phase);
+			void CopyStats(VkCommandBuffer commandBuffer);
+		};
+	}
+}
@@ -0,0 +1,353 @@
+#include "HiZPyramid.h"
+
+#include "../io/Utils.h"
+
+#include <iostream>
+
+using namespace Euler::Graphics;
+
+const uint32_t HiZPyramid::GROUP_SIZE;
+
+bool HiZPyramid::Create(Vulkan* vulkan)
+{
+	_vulkan = vulkan;
+
+	std::vector<char> shaderCode = ReadFile("shaders/out/hiz_compute.spv");
+	if (shaderCode.empty())
+	{
+		std::cout << "HiZPyramid: shaders/out/hiz_compute.spv not found" << std::endl;
+		return false;
+	}
+
+	/* === DESCRIPTOR SET LAYOUT AND PIPELINE === */
+
+	std::vector<VkDescriptorSetLayoutBinding> bindings(2);
+	bindings[0].binding = 0;
+	bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	bindings[0].descriptorCount = 1;
+	bindings[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+	bindings[1].binding = 1;
+	bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+	bindings[1].descriptorCount = 1;
+	bindings[1].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+	_vulkan->CreateDescriptorSetLayout(bindings, &_layout);
+
+	ComputePipelineInfo pipelineInfo{};
+	pipelineInfo.ShaderCode = shaderCode.data();
+	pipelineInfo.ShaderCodeSize = shaderCode.size();
+	pipelineInfo.DescriptorSetLayouts = { _layout };
+	pipelineInfo.PushConstantSize = sizeof(PushConstants);
+
+	_vulkan->CreateComputePipeline(&pipelineInfo, &_pipelineLayout, &_pipeline);
+
+	/* === SAMPLER === */
+
+	// texels are read exactly, the culling picks the level
+	SamplerDesc samplerDesc;
+	samplerDesc.MagFilter = VK_FILTER_NEAREST;
+	samplerDesc.MinFilter = VK_FILTER_NEAREST;
+	samplerDesc.MipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	samplerDesc.AddressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerDesc.AddressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerDesc.AddressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerDesc.MaxAnisotropy = 1.0f;
+
+	_sampler = _vulkan->AcquireSampler(samplerDesc);
+
+	CreateImage();
+
+	return true;
+}
+
+void HiZPyramid::Destroy()
+{
+	if (_pipeline == VK_NULL_HANDLE)
+	{
+		return;
+	}
+
+	DestroyImage();
+
+	_vulkan->ReleaseSampler(_sampler);
+	_vulkan->DestroyPipeline(_pipelineLayout, _pipeline);
+	_vulkan->DestroyDescriptorSetLayout(_layout);
+	_pipeline = VK_NULL_HANDLE;
+}
+
+void HiZPyramid::CreateImage()
+{
+	_depthView = _vulkan->_depthImageView;
+
+	// power of two sizes, so every texel of level n covers exactly 2^(n+1) depth texels on each side
+	_width = 1;
+	while (_width * 2 < _vulkan->_extent.width)
+	{
+		_width *= 2;
+	}
+	_height = 1;
+	while (_height * 2 < _vulkan->_extent.height)
+	{
+		_height *= 2;
+	}
+
+	_mipCount = 1;
+	while ((_width >> _mipCount) > 0 || (_height >> _mipCount) > 0)
+	{
+		_mipCount++;
+	}
+
+	_vulkan->CreateImage(
+		_width,
+		_height,
+		VK_FORMAT_R32_SFLOAT,
+		VK_IMAGE_TILING_OPTIMAL,
+		VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		_image,
+		_memory,
+		_mipCount
+	);
+
+	/* === IMAGE VIEWS === */
+
+	VkImageViewCreateInfo viewCreateInfo{};
+	viewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+	viewCreateInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+	viewCreateInfo.format = VK_FORMAT_R32_SFLOAT;
+	viewCreateInfo.image = _image;
+	viewCreateInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	viewCreateInfo.subresourceRange.baseArrayLayer = 0;
+	viewCreateInfo.subresourceRange.layerCount = 1;
+	viewCreateInfo.subresourceRange.baseMipLevel = 0;
+	viewCreateInfo.subresourceRange.levelCount = _mipCount;
+
+	vkCreateImageView(_vulkan->_device, &viewCreateInfo, nullptr, &_view);
+
+	_mipViews.resize(_mipCount);
+	for (uint32_t i = 0; i < _mipCount; i++)
+	{
+		viewCreateInfo.subresourceRange.baseMipLevel = i;
+		viewCreateInfo.subresourceRange.levelCount = 1;
+		vkCreateImageView(_vulkan->_device, &viewCreateInfo, nullptr, &_mipViews[i]);
+	}
+
+	/* === DESCRIPTOR SETS === */
+
+	std::vector<VkDescriptorPoolSize> poolSizes = {
+		{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, _mipCount },
+		{ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, _mipCount }
+	};
+	_vulkan->CreateDescriptorPool(poolSizes, _mipCount, &_descriptorPool);
+
+	std::vector<VkDescriptorSetLayout> layouts(_mipCount, _layout);
+	_descriptorSets.resize(_mipCount);
+
+	VkDescriptorSetAllocateInfo allocateInfo{};
+	allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocateInfo.descriptorPool = _descriptorPool;
+	allocateInfo.descriptorSetCount = _mipCount;
+	allocateInfo.pSetLayouts = layouts.data();
+
+	vkAllocateDescriptorSets(_vulkan->_device, &allocateInfo, _descriptorSets.data());
+
+	for (uint32_t i = 0; i < _mipCount; i++)
+	{
+		VkDescriptorImageInfo sourceInfo{};
+		sourceInfo.sampler = _sampler;
+		sourceInfo.imageView = i == 0 ? _depthView : _mipViews[i - 1];
+		sourceInfo.imageLayout = i == 0 ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_GENERAL;
+
+		VkDescriptorImageInfo destinationInfo{};
+		destinationInfo.imageView = _mipViews[i];
+		destinationInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+		VkWriteDescriptorSet writes[2] = {};
+		writes[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		writes[0].dstSet = _descriptorSets[i];
+		writes[0].dstBinding = 0;
+		writes[0].descriptorCount = 1;
+		writes[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		writes[0].pImageInfo = &sourceInfo;
+
+		writes[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		writes[1].dstSet = _descriptorSets[i];
+		writes[1].dstBinding = 1;
+		writes[1].descriptorCount = 1;
+		writes[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+		writes[1].pImageInfo = &destinationInfo;
+
+		vkUpdateDescriptorSets(_vulkan->_device, 2, writes, 0, nullptr);
+	}
+
+	/* === LAYOUT === */
+
+	// the pyramid stays in GENERAL, it is written and sampled by compute shaders only
+	VkCommandBuffer commandBuffer = _vulkan->BeginSingleUseCommandBuffer();
+
+	VkImageMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = _image;
+	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	barrier.subresourceRange.baseMipLevel = 0;
+	barrier.subresourceRange.levelCount = _mipCount;
+	barrier.subresourceRange.baseArrayLayer = 0;
+	barrier.subresourceRange.layerCount = 1;
+	barrier.srcAccessMask = 0;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+	_vulkan->EndSingleUseCommandBuffer(commandBuffer);
+
+	_built = false;
+}
+
+void HiZPyramid::DestroyImage()
+{
+	_vulkan->DestroyDescriptorPool(_descriptorPool);
+	_descriptorSets.clear();
+
+	for (auto view : _mipViews)
+	{
+		_vulkan->DestroyImageView(view);
+	}
+	_mipViews.clear();
+	_vulkan->DestroyImageView(_view);
+
+	_vulkan->DestroyImage(_image, _memory);
+}
+
+bool HiZPyramid::Resize()
+{
+	if (_depthView == _vulkan->_depthImageView)
+	{
+		return false;
+	}
+
+	DestroyImage();
+	CreateImage();
+	return true;
+}
+
+void HiZPyramid::Build(VkCommandBuffer commandBuffer)
+{
+	VkImageMemoryBarrier depthBarrier{};
+	depthBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	depthBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	depthBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	depthBarrier.image = _vulkan->_depthImage;
+	depthBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+	depthBarrier.subresourceRange.baseMipLevel = 0;
+	depthBarrier.subresourceRange.levelCount = 1;
+	depthBarrier.subresourceRange.baseArrayLayer = 0;
+	depthBarrier.subresourceRange.layerCount = 1;
+
+	// depth writes have to land before it is read, earlier reads of the pyramid before it is overwritten
+	depthBarrier.oldLayout = VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL;
+	depthBarrier.newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+	depthBarrier.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+	depthBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+	vkCmdPipelineBarrier(
+		commandBuffer,
+		VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		0,
+		0,
+		nullptr,
+		0,
+		nullptr,
+		1,
+		&depthBarrier
+	);
+
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, _pipeline);
+
+	uint32_t sourceWidth = _vulkan->_extent.width;
+	uint32_t sourceHeight = _vulkan->_extent.height;
+
+	for (uint32_t i = 0; i < _mipCount; i++)
+	{
+		uint32_t width = (_width >> i) > 0 ? _width >> i : 1;
+		uint32_t height = (_height >> i) > 0 ? _height >> i : 1;
+
+		PushConstants constants;
+		constants.SourceWidth = sourceWidth;
+		constants.SourceHeight = sourceHeight;
+		constants.Width = width;
+		constants.Height = height;
+
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, _pipelineLayout, 0, 1, &_descriptorSets[i], 0, nullptr);
+		vkCmdPushConstants(commandBuffer, _pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+		vkCmdDispatch(commandBuffer, (width + GROUP_SIZE - 1) / GROUP_SIZE, (height + GROUP_SIZE - 1) / GROUP_SIZE, 1);
+
+		// the next level reads this one, the culling reads all of them
+		_vulkan->PipelineBarrier(
+			commandBuffer,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			VK_ACCESS_SHADER_WRITE_BIT,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT
+		);
+
+		sourceWidth = width;
+		sourceHeight = height;
+	}
+
+	// back for the rest of the frame's depth testing
+	depthBarrier.oldLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+	depthBarrier.newLayout = VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL;
+	depthBarrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	depthBarrier.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+	vkCmdPipelineBarrier(
+		commandBuffer,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+		0,
+		0,
+		nullptr,
+		0,
+		nullptr,
+		1,
+		&depthBarrier
+	);
+
+	_built = true;
+}
+
+bool HiZPyramid::IsBuilt()
+{
+	return _built;
+}
+
+VkImageView HiZPyramid::GetView()
+{
+	return _view;
+}
+
+VkSampler HiZPyramid::GetSampler()
+{
+	return _sampler;
+}
+
+uint32_t HiZPyramid::GetWidth()
+{
+	return _width;
+}
+
+uint32_t HiZPyramid::GetHeight()
+{
+	return _height;
+}
+
+uint32_t HiZPyramid::GetMipCount()
+{
+	return _mipCount;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "../API.h"
+#include "vulkan/Vulkan.h"
+
+#include <vulkan/vulkan.h>
+#include <vector>
+
+namespace Euler
+{
+	namespace Graphics
+	{
+		/// <summary>
+		/// Mip chain of the depth buffer where every texel holds the farthest depth of the texels it covers,
+		/// so a bounding rectangle can be tested for occlusion with four reads from one level. Level 0 is half the
+		/// size of the depth buffer rounded up to a power of two and the chain is rebuilt with compute downsampling
+		/// (shaders/hiz.comp).
+		/// </summary>
+		class EULER_API HiZPyramid
+		{
+		public:
+			static const uint32_t GROUP_SIZE = 8;
+
+		private:
+			struct PushConstants
+			{
+				int32_t SourceWidth;
+				int32_t SourceHeight;
+				int32_t Width;
+				int32_t Height;
+			};
+
+			Vulkan* _vulkan = nullptr;
+
+			uint32_t _width = 0;
+			uint32_t _height = 0;
+			uint32_t _mipCount = 0;
+
+			VkImage _image = VK_NULL_HANDLE;
+			MemoryAllocation _memory;
+			VkImageView _view = VK_NULL_HANDLE;
+			std::vector<VkImageView> _mipViews;
+			VkSampler _sampler = VK_NULL_HANDLE;
+
+			// one set per level, reading the level above (the depth buffer for level 0) and writing the level
+			VkDescriptorSetLayout _layout = VK_NULL_HANDLE;
+			VkDescriptorPool _descriptorPool = VK_NULL_HANDLE;
+			std::vector<VkDescriptorSet> _descriptorSets;
+
+			VkPipelineLayout _pipelineLayout = VK_NULL_HANDLE;
+			VkPipeline _pipeline = VK_NULL_HANDLE;
+
+			// depth view the pyramid was created for, it changes when the swapchain is recreated
+			VkImageView _depthView = VK_NULL_HANDLE;
+			bool _built = false;
+
+		public:
+			// returns false when shaders/out/hiz_compute.spv is missing
+			bool Create(Vulkan* vulkan);
+			void Destroy();
+
+			// recreates the pyramid when the depth buffer changed, returns true if it did.
+			// Only call it while the device is idle or before the pyramid is used in the frame
+			bool Resize();
+
+			// records the downsampling in the main command buffer, outside of any render pass. The depth buffer
+			// has to be in DEPTH_ATTACHMENT_OPTIMAL with its writes done and is left in that layout
+			void Build(VkCommandBuffer commandBuffer);
+
+			// false until Build was called for the current size
+			bool IsBuilt();
+			VkImageView GetView();
+			VkSampler GetSampler();
+			uint32_t GetWidth();
+			uint32_t GetHeight();
+			uint32_t GetMipCount();
+
+		private:
+			void CreateImage();
+			void DestroyImage();
+		};
+	}
+}
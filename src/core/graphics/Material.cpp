@@ -4,6 +4,8 @@ using namespace Euler::Graphics;
 
 bool Material::DescriptorPoolCreated = false;
 VkDescriptorPool Material::DescriptorPool = VK_NULL_HANDLE;
+uint32_t Material::MaterialCount = 0;
+const uint32_t Material::MAX_DESCRIPTOR_SETS;
 
 void Material::Create(Vulkan* vulkan, VkDescriptorSetLayout layout)
 {
@@ -38,11 +40,18 @@ void Material::Create(Vulkan* vulkan, VkDescriptorSetLayout layout)
 		layout,
 		DescriptorPool
 	);
+	MaterialCount++;
 
 	for (int i = 0; i < _vulkan->GetSwapchainImageCount(); i++) 
 	{
 		MaterialPropertiesDescriptorSetGroup.UpdateUniformBuffer(_vulkan, i, MaterialPropertiesBuffers.Get(i)->Buffer, 0);
 	}
+
+	if (_vulkan->_bindless.IsEnabled())
+	{
+		_bindlessMaterial = GetBindlessMaterial();
+		BindlessIndex = _vulkan->_bindless.RegisterMaterial(_bindlessMaterial);
+	}
 }
 
 void Material::Destroy()
@@ -50,15 +59,72 @@ void Material::Destroy()
 	MaterialPropertiesDescriptorSetGroup.Free(_vulkan);
 	MaterialPropertiesBuffers.Destroy(_vulkan);
 
-	_vulkan->DestroyDescriptorPool(Material::DescriptorPool);
+	_vulkan->_bindless.UnregisterMaterial(BindlessIndex);
+	BindlessIndex = BindlessTable::INVALID_INDEX;
+
+	if (--MaterialCount == 0)
+	{
+		_vulkan->DestroyDescriptorPool(Material::DescriptorPool);
+		Material::DescriptorPool = VK_NULL_HANDLE;
+		Material::DescriptorPoolCreated = false;
+	}
+}
+
+bool Material::IsReady()
+{
+	return (ColorMap == nullptr || ColorMap->IsReady())
+		&& (NormalMap == nullptr || NormalMap->IsReady())
+		&& (SpecularMap == nullptr || SpecularMap->IsReady());
+}
+
+void Material::UpdateBindless()
+{
+	if (BindlessIndex == BindlessTable::INVALID_INDEX)
+	{
+		return;
+	}
+
+	BindlessMaterial material = GetBindlessMaterial();
+	if (material.ColorMap != _bindlessMaterial.ColorMap || material.NormalMap != _bindlessMaterial.NormalMap || material.SpecularMap != _bindlessMaterial.SpecularMap)
+	{
+		_bindlessMaterial = material;
+		_vulkan->_bindless.UpdateMaterial(BindlessIndex, _bindlessMaterial);
+	}
+}
+
+void Material::RequestSize(float screenSize)
+{
+	Texture* textures[] = { ColorMap, NormalMap, SpecularMap };
+	for (Texture* texture : textures)
+	{
+		if (texture != nullptr)
+		{
+			texture->RequestSize(screenSize);
+		}
+	}
+
+	UpdateBindless();
 }
 
 void Material::CreateDescriptorPool()
 {
 	std::vector<VkDescriptorPoolSize> poolSizes(1);
-	poolSizes[0] = { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 50 };
+	poolSizes[0] = { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, MAX_DESCRIPTOR_SETS };
 
-	_vulkan->CreateDescriptorPool(poolSizes, 50, &Material::DescriptorPool);
+	// the sets are freed one material at a time
+	_vulkan->CreateDescriptorPool(poolSizes, MAX_DESCRIPTOR_SETS, &Material::DescriptorPool, VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT);
 
 	DescriptorPoolCreated = true;
+}
+
+BindlessMaterial Material::GetBindlessMaterial()
+{
+	BindlessMaterial material{};
+	material.ColorMap = ColorMap != nullptr ? ColorMap->BindlessIndex : BindlessTable::INVALID_INDEX;
+	material.NormalMap = NormalMap != nullptr ? NormalMap->BindlessIndex : BindlessTable::INVALID_INDEX;
+	material.SpecularMap = SpecularMap != nullptr ? SpecularMap->BindlessIndex : BindlessTable::INVALID_INDEX;
+	material.Shininess = Properties.Shininess;
+	material.UseNormalMap = Properties.UseNormalMap;
+	material.UseSpecularMap = Properties.UseSpecularMap;
+	return material;
 }
\ No newline at end of file
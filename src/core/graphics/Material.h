@@ -21,6 +21,9 @@ namespace Euler
 		private:
 			Vulkan* _vulkan;
 
+			// what the bindless table holds for the material
+			BindlessMaterial _bindlessMaterial;
+
 		public:
 			Texture* ColorMap = nullptr;
 			Texture* NormalMap = nullptr;
@@ -28,16 +31,32 @@ namespace Euler
 
 			MaterialProperties Properties;
 
+			// index in the vulkan's bindless table, INVALID_INDEX when bindless isn't supported
+			uint32_t BindlessIndex = BindlessTable::INVALID_INDEX;
+
 			BufferGroup MaterialPropertiesBuffers;
 			DescriptorSetGroup MaterialPropertiesDescriptorSetGroup;
 
+			static const uint32_t MAX_DESCRIPTOR_SETS = 1024;
+
+			// shared by all materials, destroyed with the last material
 			static bool DescriptorPoolCreated;
 			static VkDescriptorPool DescriptorPool;
+			static uint32_t MaterialCount;
 
 			void Create(Vulkan* vulkan, VkDescriptorSetLayout layout);
 			void Destroy();
+			bool IsReady();
+
+			// streamed textures move to a new bindless index when their levels change, this rewrites the material's entry then
+			void UpdateBindless();
+			// asks the streamer for the texture levels the material needs at screenSize pixels and picks up moved textures
+			void RequestSize(float screenSize);
 
 			void CreateDescriptorPool();
+
+		private:
+			BindlessMaterial GetBindlessMaterial();
 		};
 	}
 }
\ No newline at end of file
@@ -4,23 +4,92 @@ using namespace Euler;
 
 Mesh::Mesh()
 {
-
+	Arena = nullptr;
+	Geometry = nullptr;
 }
 
 void Mesh::Create(Graphics::Vulkan* vulkan)
 {
-	vulkan->CreateVertexBuffer(sizeof(Vertices[0]), Vertices.size(), Vertices.data(), &VertexBuffer);
-	vulkan->CreateIndexBuffer(sizeof(Indices[0]), Indices.size(), Indices.data(), &IndexBuffer);
+	// the vectors are uploaded through a view of them
+	if (View.IsEmpty())
+	{
+		if (!PackedVertices.empty())
+		{
+			View.Vertices = PackedVertices.data();
+			View.VertexCount = PackedVertices.size();
+			View.VertexStride = sizeof(PackedVertices[0]);
+		}
+		else
+		{
+			View.Vertices = Vertices.data();
+			View.VertexCount = Vertices.size();
+			View.VertexStride = sizeof(Vertices[0]);
+		}
+
+		if (!ShortIndices.empty())
+		{
+			View.Indices = ShortIndices.data();
+			View.IndexCount = ShortIndices.size();
+			View.IndexSize = sizeof(uint16_t);
+		}
+		else
+		{
+			View.Indices = Indices.data();
+			View.IndexCount = Indices.size();
+			View.IndexSize = sizeof(uint32_t);
+		}
+	}
+
+	// every vertex format starts with the position
+	const Vec3* positions = (const Vec3*)View.Vertices;
+	Bounds = Math::BoundingBox::FromPoints(positions, View.VertexCount, View.VertexStride);
+	Sphere = Math::BoundingSphere::FromPoints(positions, View.VertexCount, View.VertexStride);
+
+	if (Lods.empty())
+	{
+		Lods.push_back({ 0, View.IndexCount, 0.0f });
+	}
+
+	// each index type has arenas of its own
+	VkIndexType indexType = View.IndexSize == sizeof(uint16_t) ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+	Arena = vulkan->GetGeometryArena(View.VertexStride, indexType);
+	Geometry = Arena->Allocate(View.Vertices, View.VertexCount, View.Indices, View.IndexCount, &UploadHandle);
+
+	// the data is in the staging memory now
+	View = GeometryView();
 }
 
 void Mesh::Destroy(Graphics::Vulkan* vulkan)
 {
-	vulkan->DestroyBuffer(VertexBuffer.Buffer, VertexBuffer.Memory);
-	vulkan->DestroyBuffer(IndexBuffer.Buffer, IndexBuffer.Memory);
+	vulkan->_uploader.Wait(UploadHandle);
+
+	Arena->Free(Geometry);
+	Geometry = nullptr;
+}
+
+bool Mesh::IsReady()
+{
+	return UploadHandle.IsReady();
+}
+
+uint32_t Mesh::GetLodCount()
+{
+	return Lods.size();
+}
+
+uint32_t Mesh::GetFirstIndex(uint32_t lod)
+{
+	return Geometry->FirstIndex + Lods[lod].FirstIndex;
+}
+
+uint32_t Mesh::GetIndexCount(uint32_t lod)
+{
+	return Lods[lod].IndexCount;
 }
 
-void Mesh::RecordDrawCommands(Graphics::Vulkan* vulkan, VkCommandBuffer commandBuffer)
+void Mesh::RecordDrawCommands(VkCommandBuffer commandBuffer, uint32_t* boundBlock, uint32_t instanceCount, uint32_t firstInstance, uint32_t lod)
 {
-	vulkan->DrawMesh(commandBuffer, &VertexBuffer, &IndexBuffer, Indices.size());
+	Arena->Bind(commandBuffer, Geometry, boundBlock);
+	vkCmdDrawIndexed(commandBuffer, GetIndexCount(lod), instanceCount, GetFirstIndex(lod), Geometry->VertexOffset, firstInstance);
 }
 
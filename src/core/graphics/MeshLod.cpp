@@ -0,0 +1,55 @@
+#include "MeshLod.h"
+
+#include <float.h>
+#include <math.h>
+
+using namespace Euler;
+
+static uint32_t GetCoarsestLod(const std::vector<MeshLod>& lods, float pixelsPerUnit, float maxError)
+{
+	// errors grow with every level, level 0 is always allowed
+	uint32_t lod = 0;
+	while (lod + 1 < lods.size() && lods[lod + 1].Error * pixelsPerUnit <= maxError)
+	{
+		lod++;
+	}
+	return lod;
+}
+
+uint32_t Euler::SelectLod(const std::vector<MeshLod>& lods, float pixelsPerUnit, float maxError, float hysteresis, uint32_t current)
+{
+	uint32_t target = GetCoarsestLod(lods, pixelsPerUnit, maxError);
+	if (current >= lods.size())
+	{
+		return target;
+	}
+
+	// coarser only with some margin below the limit, finer only once the current level is clearly over it
+	uint32_t coarser = GetCoarsestLod(lods, pixelsPerUnit, maxError * (1.0f - hysteresis));
+	uint32_t finer = GetCoarsestLod(lods, pixelsPerUnit, maxError * (1.0f + hysteresis));
+
+	if (current < coarser)
+	{
+		return coarser;
+	}
+	if (current > finer)
+	{
+		return target;
+	}
+	return current;
+}
+
+float Euler::GetLodPixelsPerUnit(const Math::BoundingSphere& sphere, const Mat4& modelMatrix, const Vec3& cameraPosition, float projectionScale)
+{
+	Math::BoundingSphere worldSphere = sphere.Transform(modelMatrix);
+
+	float distance = (worldSphere.Center - cameraPosition).Length() - worldSphere.Radius;
+	if (distance <= 0.0f || sphere.Radius <= 0.0f)
+	{
+		return FLT_MAX;
+	}
+
+	// the errors are in object space, the largest axis scale converts them like it does the radius
+	float scale = worldSphere.Radius / sphere.Radius;
+	return projectionScale * scale / distance;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "../API.h"
+#include "../math/Vec3.h"
+#include "../math/Mat4.h"
+#include "../math/Bounds.h"
+
+#include <stdint.h>
+#include <vector>
+
+namespace Euler
+{
+	// a range of a mesh's indices drawing the mesh at a lower detail, the vertices are shared by all levels
+	struct EULER_API MeshLod
+	{
+		uint32_t FirstIndex;		// relative to the mesh's indices
+		uint32_t IndexCount;
+		float Error;				// how far the surface moved from the full detail mesh, in object space
+	};
+
+	struct EULER_API LodSettings
+	{
+		// largest error allowed on screen, in pixels
+		float MaxError = 1.0f;
+		// the shadow pass allows this many times the error, shadow maps hide the detail anyway
+		float ShadowBias = 4.0f;
+		// a level is only left once its error is this fraction above (or below) MaxError, so it doesn't flicker at the boundary
+		float Hysteresis = 0.25f;
+	};
+
+	// returns the coarsest level whose error stays below maxError pixels, levels go from fine to coarse.
+	// current is the level selected last frame, UINT32_MAX when there is none
+	EULER_API uint32_t SelectLod(const std::vector<MeshLod>& lods, float pixelsPerUnit, float maxError, float hysteresis, uint32_t current);
+
+	// pixels an object space unit of the mesh covers at the nearest point of its bounding sphere, FLT_MAX when the
+	// camera is inside it. projectionScale is Camera::GetProjectionScale
+	EULER_API float GetLodPixelsPerUnit(const Math::BoundingSphere& sphere, const Mat4& modelMatrix, const Vec3& cameraPosition, float projectionScale);
+}
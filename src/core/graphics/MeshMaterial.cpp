@@ -24,4 +24,29 @@ MeshMaterial::MeshMaterial(Euler::AnimatedMesh* mesh, Euler::Graphics::Texture*
 {
 	AnimatedMesh = mesh;
 	ColorTexture = texture;
+}
+
+bool MeshMaterial::IsReady()
+{
+	return (Mesh == nullptr || Mesh->IsReady())
+		&& (AnimatedMesh == nullptr || AnimatedMesh->IsReady())
+		&& (NormalMap == nullptr || NormalMap->IsReady())
+		&& (ColorTexture == nullptr || ColorTexture->IsReady())
+		&& (Material == nullptr || Material->IsReady());
+}
+
+void MeshMaterial::RequestTextureSize(float screenSize)
+{
+	if (NormalMap != nullptr)
+	{
+		NormalMap->RequestSize(screenSize);
+	}
+	if (ColorTexture != nullptr)
+	{
+		ColorTexture->RequestSize(screenSize);
+	}
+	if (Material != nullptr)
+	{
+		Material->RequestSize(screenSize);
+	}
 }
\ No newline at end of file
@@ -24,6 +24,11 @@ namespace Euler
 			MeshMaterial(Euler::Mesh* mesh, Euler::Graphics::Material* material);
 			MeshMaterial(Euler::Mesh* mesh, Euler::Graphics::Texture* texture);
 			MeshMaterial(Euler::AnimatedMesh* mesh, Euler::Graphics::Texture* texture);
+
+			// true once the mesh and all textures finished uploading
+			bool IsReady();
+			// feedback for the texture streamer, the drawable covers about screenSize pixels this frame
+			void RequestTextureSize(float screenSize);
 		};
 	}
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include "../API.h"
 #include "MeshMaterial.h"
+#include "MeshLod.h"
 #include "../math/Vec3.h"
 #include "../math/Vec2.h"
 #include "../math/Transform.h"
@@ -17,6 +18,20 @@ namespace Euler
 
 		std::vector<Graphics::MeshMaterial*> Drawables;
 
+		// level of every drawable's mesh in the main and the shadow pass, written by SelectLods
+		std::vector<uint32_t> Lods;
+		std::vector<uint32_t> ShadowLods;
+
 		Model();
+
+		// picks the levels from the screen space error of the meshes' bounding spheres, returns true if any changed
+		bool SelectLods(const LodSettings& settings, const Vec3& cameraPosition, float projectionScale);
+		// full detail everywhere
+		void ResetLods();
+		uint32_t GetLod(uint32_t drawable);
+		uint32_t GetShadowLod(uint32_t drawable);
+
+		// tells the texture streamer how big the drawables' bounding spheres are on screen
+		void RequestTextureSizes(const Vec3& cameraPosition, float projectionScale);
 	};
 };
\ No newline at end of file
@@ -3,6 +3,9 @@
 #include "../io/Utils.h"
 #include "../math/Matrices.h"
 
+#include <algorithm>
+#include <iostream>
+
 using namespace Euler::Graphics;
 
 void ModelPipeline::Create(Vulkan* vulkan, float viewportWidth, float viewportHeight)
@@ -11,9 +14,16 @@ void ModelPipeline::Create(Vulkan* vulkan, float viewportWidth, float viewportHe
 
 	/* === READ SHADER CODE === */
 
-	std::vector<char> vertexShaderCode = ReadFile("shaders/out/vertex.spv");
+	std::vector<char> vertexShaderCode = ReadFile(GetVertexShaderPath("vertex").c_str());
 	std::vector<char> fragmentShaderCode = ReadFile("shaders/out/fragment.spv");
 
+	if (vertexShaderCode.empty() && UsePackedVertices)
+	{
+		std::cout << "ModelPipeline: shaders/out/vertex_packed.spv not found, using full vertices" << std::endl;
+		UsePackedVertices = false;
+		vertexShaderCode = ReadFile("shaders/out/vertex.spv");
+	}
+
 	/* === CREATE PIPELINE === */
 
 	PipelineInfo pipelineInfo{};
@@ -24,7 +34,7 @@ void ModelPipeline::Create(Vulkan* vulkan, float viewportWidth, float viewportHe
 	pipelineInfo.FragmentShaderCode = fragmentShaderCode.data();
 	pipelineInfo.FragmentShaderCodeSize = fragmentShaderCode.size();
 
-	pipelineInfo.VertexStride = sizeof(Vertex);
+	pipelineInfo.VertexStride = GetVertexStride();
 	pipelineInfo.VertexAttributes = GetVertexAttributes();
 
 	pipelineInfo.Topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
@@ -42,27 +52,147 @@ void ModelPipeline::Create(Vulkan* vulkan, float viewportWidth, float viewportHe
 
 	_vulkan->CreatePipeline(&pipelineInfo, &_pipelineLayout, &_pipeline);
 
+	if (UseInstancing || UseIndirectDraws || UseBindless)
+	{
+		CreateInstancedPipeline(viewportWidth, viewportHeight);
+	}
+
+	// the culling pass writes the objects the bindless shaders read
+	if (UseGpuCulling && (!UseBindless || !_gpuCulling.Create(_vulkan, ObjectsLayout)))
+	{
+		std::cout << "ModelPipeline: GPU culling needs bindless materials, indirect count draws and the culling shaders, culling on the CPU" << std::endl;
+		UseGpuCulling = false;
+	}
+
+	if (UseOcclusionCulling && (!UseGpuCulling || !_gpuCulling.SupportsOcclusion()))
+	{
+		std::cout << "ModelPipeline: occlusion culling needs GPU culling and shaders/out/hiz_compute.spv, disabled" << std::endl;
+		UseOcclusionCulling = false;
+	}
+
 	CreateDescriptorSets();
 }
 
+void ModelPipeline::CreateInstancedPipeline(float viewportWidth, float viewportHeight)
+{
+	std::string vertexShaderPath = GetVertexShaderPath("instanced_vertex");
+	std::vector<char> vertexShaderCode = ReadFile(vertexShaderPath.c_str());
+	if (vertexShaderCode.empty())
+	{
+		std::cout << "ModelPipeline: " << vertexShaderPath << " not found, drawing models one by one" << std::endl;
+		UseInstancing = false;
+		UseIndirectDraws = false;
+		UseBindless = false;
+		return;
+	}
+
+	// firstInstance is the first object index, indirect commands can't set it without this feature
+	if (UseIndirectDraws && !_vulkan->_drawIndirectFirstInstance)
+	{
+		std::cout << "ModelPipeline: drawIndirectFirstInstance not supported, using direct instanced draws" << std::endl;
+		UseIndirectDraws = false;
+	}
+
+	std::vector<char> fragmentShaderCode = ReadFile("shaders/out/fragment.spv");
+
+	// same as the regular pipeline except the model matrices come from the objects storage buffer
+	std::vector<VkDescriptorSetLayout> layouts = { ViewProjLayout, ObjectsLayout, MaterialLayout, DirectionalLightLayout, LightViewProjLayout, NormalMapLayout, MaterialPropertiesLayout };
+
+	if (UseBindless)
+	{
+		std::vector<char> bindlessVertexShaderCode = ReadFile(GetVertexShaderPath("bindless_vertex").c_str());
+		std::vector<char> bindlessFragmentShaderCode = ReadFile("shaders/out/bindless_fragment.spv");
+
+		if (!_vulkan->_bindless.IsEnabled())
+		{
+			std::cout << "ModelPipeline: descriptor indexing not supported, binding materials per draw" << std::endl;
+			UseBindless = false;
+		}
+		else if (bindlessVertexShaderCode.empty() || bindlessFragmentShaderCode.empty())
+		{
+			std::cout << "ModelPipeline: bindless shaders not found, binding materials per draw" << std::endl;
+			UseBindless = false;
+		}
+		else
+		{
+			// textures and material parameters all come from the bindless set
+			vertexShaderCode = bindlessVertexShaderCode;
+			fragmentShaderCode = bindlessFragmentShaderCode;
+			layouts = { ViewProjLayout, ObjectsLayout, _vulkan->_bindless.Layout, DirectionalLightLayout, LightViewProjLayout };
+		}
+	}
+
+	PipelineInfo pipelineInfo{};
+
+	pipelineInfo.VertexShaderCode = vertexShaderCode.data();
+	pipelineInfo.VertexShaderCodeSize = vertexShaderCode.size();
+
+	pipelineInfo.FragmentShaderCode = fragmentShaderCode.data();
+	pipelineInfo.FragmentShaderCodeSize = fragmentShaderCode.size();
+
+	pipelineInfo.VertexStride = GetVertexStride();
+	pipelineInfo.VertexAttributes = GetVertexAttributes();
+
+	pipelineInfo.Topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+	pipelineInfo.DepthTestEnabled = true;
+
+	pipelineInfo.ViewportWidth = viewportWidth;
+	pipelineInfo.ViewportHeight = viewportHeight;
+
+	pipelineInfo.DescriptorSetLayouts = layouts;
+
+	pipelineInfo.RenderPass = _vulkan->_renderPass;
+
+	_vulkan->CreatePipeline(&pipelineInfo, &_instancedPipelineLayout, &_instancedPipeline);
+}
+
 void ModelPipeline::Destroy()
 {
+	_gpuCulling.Destroy();
 	_vulkan->DestroyDescriptorPool(_descriptorPool);
 
-	_viewProjBuffers.Destroy(_vulkan);
-	_modelBuffers.Destroy(_vulkan);
-	_directionalLightBuffers.Destroy(_vulkan);
-	_ambientLightBuffers.Destroy(_vulkan);
-
 	_vulkan->DestroyPipeline(_pipelineLayout, _pipeline);
+	if (_instancedPipeline != VK_NULL_HANDLE)
+	{
+		_vulkan->DestroyPipeline(_instancedPipelineLayout, _instancedPipeline);
+	}
 
 	_vulkan->DestroyDescriptorSetLayout(ViewProjLayout);
 	_vulkan->DestroyDescriptorSetLayout(ModelLayout);
 	_vulkan->DestroyDescriptorSetLayout(DirectionalLightLayout);
+	_vulkan->DestroyDescriptorSetLayout(ObjectsLayout);
 }
 
 std::vector<VertexAttributeInfo> ModelPipeline::GetVertexAttributes()
 {
+	if (UsePackedVertices)
+	{
+		std::vector<VertexAttributeInfo> vec(4);
+
+		// position
+		vec[0].Location = 0;
+		vec[0].Offset = 0;
+		vec[0].Format = VK_FORMAT_R32G32B32_SFLOAT;
+
+		// octahedral normal
+		vec[1].Location = 1;
+		vec[1].Offset = offsetof(PackedVertex, Normal);
+		vec[1].Format = VK_FORMAT_R16G16_SNORM;
+
+		// octahedral tangent, the bitangent is rebuilt in the shader
+		vec[2].Location = 2;
+		vec[2].Offset = offsetof(PackedVertex, Tangent);
+		vec[2].Format = VK_FORMAT_R16G16_SNORM;
+
+		// uv
+		vec[3].Location = 4;
+		vec[3].Offset = offsetof(PackedVertex, UV);
+		vec[3].Format = VK_FORMAT_R16G16_SFLOAT;
+
+		return vec;
+	}
+
 	std::vector<VertexAttributeInfo> vec(5);
 
 	// position
@@ -93,12 +223,27 @@ std::vector<VertexAttributeInfo> ModelPipeline::GetVertexAttributes()
 	return vec;
 }
 
+uint32_t ModelPipeline::GetVertexStride()
+{
+	return UsePackedVertices ? sizeof(PackedVertex) : sizeof(Vertex);
+}
+
+Euler::VertexFormat ModelPipeline::GetVertexFormat()
+{
+	return UsePackedVertices ? Euler::VERTEX_FORMAT_PACKED : Euler::VERTEX_FORMAT_FULL;
+}
+
+std::string ModelPipeline::GetVertexShaderPath(const char* name)
+{
+	return std::string("shaders/out/") + name + (UsePackedVertices ? "_packed.spv" : ".spv");
+}
+
 void ModelPipeline::CreateDescriptorSetLayouts()
 {
 	/* === ViewProj DESCRIPTOR SET LAYOUT === */
 	std::vector<VkDescriptorSetLayoutBinding> viewProjBindings(1);
 	viewProjBindings[0].binding = 0;
-	viewProjBindings[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	viewProjBindings[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 	viewProjBindings[0].descriptorCount = 1;
 	viewProjBindings[0].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
 
@@ -145,12 +290,12 @@ void ModelPipeline::CreateDescriptorSetLayouts()
 	/* === DirectionalLight DESCRIPTOR SET LAYOUT === */
 	std::vector<VkDescriptorSetLayoutBinding> directionalLightBindings(3);
 	directionalLightBindings[0].binding = 0;
-	directionalLightBindings[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	directionalLightBindings[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 	directionalLightBindings[0].descriptorCount = 1;
 	directionalLightBindings[0].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
 
 	directionalLightBindings[1].binding = 1;
-	directionalLightBindings[1].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	directionalLightBindings[1].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 	directionalLightBindings[1].descriptorCount = 1;
 	directionalLightBindings[1].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
 
@@ -165,11 +310,21 @@ void ModelPipeline::CreateDescriptorSetLayouts()
 
 	std::vector<VkDescriptorSetLayoutBinding> lightViewProjBindings(1);
 	lightViewProjBindings[0].binding = 0;
-	lightViewProjBindings[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	lightViewProjBindings[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 	lightViewProjBindings[0].descriptorCount = 1;
 	lightViewProjBindings[0].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
 
 	_vulkan->CreateDescriptorSetLayout(lightViewProjBindings, &LightViewProjLayout);
+
+	/* === Objects DESCRIPTOR SET LAYOUT === */
+
+	std::vector<VkDescriptorSetLayoutBinding> objectsBindings(1);
+	objectsBindings[0].binding = 0;
+	objectsBindings[0].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+	objectsBindings[0].descriptorCount = 1;
+	objectsBindings[0].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+
+	_vulkan->CreateDescriptorSetLayout(objectsBindings, &ObjectsLayout);
 }
 
 void ModelPipeline::CreateDescriptorSets()
@@ -178,14 +333,14 @@ void ModelPipeline::CreateDescriptorSets()
 
 	/* === CREATE DESCRIPTOR SET POOL === */
 
-	std::vector<VkDescriptorPoolSize> poolSizes(5);
-	poolSizes[0] = { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, imageCount*2 };			// ViewProj
-	poolSizes[3] = { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, imageCount };	// Model
-	poolSizes[2] = { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, imageCount };			// DirectionalLight
-	poolSizes[3] = { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, imageCount };	// shadows
-	poolSizes[4] = { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, imageCount };			// LightViewProj
+	// all per-frame data lives in the frame allocator and is bound with dynamic offsets:
+	// ViewProj, Model, DirectionalLight + AmbientLight, LightViewProj, the shadows' ViewProj and Objects
+	std::vector<VkDescriptorPoolSize> poolSizes(3);
+	poolSizes[0] = { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, imageCount * 6 };
+	poolSizes[1] = { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, imageCount };	// shadows
+	poolSizes[2] = { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, imageCount };
 
-	_vulkan->CreateDescriptorPool(poolSizes, poolSizes.size() * imageCount, &_descriptorPool);
+	_vulkan->CreateDescriptorPool(poolSizes, 6 * imageCount, &_descriptorPool);
 
 	/* === CREATE DESCRIPTOR SETS === */
 
@@ -193,21 +348,12 @@ void ModelPipeline::CreateDescriptorSets()
 	CreateModelDescriptorSets();
 	CreateDirectionalLightDescriptorSets();
 	CreateLightViewProjDescriptorSets();
+	CreateObjectsDescriptorSets();
 }
 
 void ModelPipeline::CreateViewProjDescriptorSets()
 {
 	uint32_t imageCount = _vulkan->GetSwapchainImageCount();
-	
-	/* === CREATE ViewProj BUFFERS === */
-
-	_viewProjBuffers.Create(
-		_vulkan,
-		imageCount,
-		sizeof(ViewProj),
-		VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-	);
 
 	/* === ALLOCATE DESCRIPTOR SETS === */
 
@@ -217,7 +363,7 @@ void ModelPipeline::CreateViewProjDescriptorSets()
 
 	for (int i = 0; i < imageCount; i++)
 	{
-		_viewProjDescriptorSetGroup.UpdateUniformBuffer(_vulkan, i, _viewProjBuffers.Get(i)->Buffer, 0);
+		_viewProjDescriptorSetGroup.UpdateUniformBufferDynamic(_vulkan, i, _vulkan->_frameAllocator.GetBuffer(), 0, sizeof(ViewProj));
 	}
 }
 
@@ -225,21 +371,6 @@ void ModelPipeline::CreateModelDescriptorSets()
 {
 	uint32_t imageCount = _vulkan->GetSwapchainImageCount();
 
-	/* === CALCULATE THE MODEL MATRIX ALLIGNMENT IN THE UNIFORM BUFFER === */
-
-	auto minOffset = _vulkan->GetPhysicalDevice()->Properties.limits.minUniformBufferOffsetAlignment;
-	_modelMatrixAlignment = (sizeof(Mat4) + minOffset - 1) & ~(minOffset - 1);
-
-	/* === CREATE Model BUFFERS === */
-
-	_modelBuffers.Create(
-		_vulkan,
-		imageCount,
-		INITIAL_MODELS_FOR_BUFFER_SIZE * _modelMatrixAlignment,
-		VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-	);
-
 	/* === ALLOCATE DESCRIPTOR SETS === */
 
 	_modelDescriptorSetGroup.Allocate(_vulkan, imageCount, ModelLayout, _descriptorPool);
@@ -248,7 +379,7 @@ void ModelPipeline::CreateModelDescriptorSets()
 
 	for (int i = 0; i < imageCount; i++)
 	{
-		_modelDescriptorSetGroup.UpdateUniformBufferDynamic(_vulkan, i, _modelBuffers.Get(i)->Buffer, 0);
+		_modelDescriptorSetGroup.UpdateUniformBufferDynamic(_vulkan, i, _vulkan->_frameAllocator.GetBuffer(), 0, sizeof(Mat4));
 	}
 }
 
@@ -256,24 +387,6 @@ void ModelPipeline::CreateDirectionalLightDescriptorSets()
 {
 	uint32_t imageCount = _vulkan->GetSwapchainImageCount();
 
-	/* === CREATE DirectioanLight BUFFERS === */
-
-	_directionalLightBuffers.Create(
-		_vulkan,
-		imageCount,
-		sizeof(DirLight),
-		VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-	);
-
-	_ambientLightBuffers.Create(
-		_vulkan,
-		imageCount,
-		sizeof(AmbLight),
-		VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-	);
-
 	/* === ALLOCATE DESCRIPTOR SETS === */
 
 	_lightDescriptorSetGroup.Allocate(_vulkan, imageCount, DirectionalLightLayout, _descriptorPool);
@@ -282,8 +395,8 @@ void ModelPipeline::CreateDirectionalLightDescriptorSets()
 
 	for (int i = 0; i < imageCount; i++)
 	{
-		_lightDescriptorSetGroup.UpdateUniformBuffer(_vulkan, i, _directionalLightBuffers.Get(i)->Buffer, 0);
-		_lightDescriptorSetGroup.UpdateUniformBuffer(_vulkan, i, _ambientLightBuffers.Get(i)->Buffer, 1);
+		_lightDescriptorSetGroup.UpdateUniformBufferDynamic(_vulkan, i, _vulkan->_frameAllocator.GetBuffer(), 0, sizeof(DirectionalLight));
+		_lightDescriptorSetGroup.UpdateUniformBufferDynamic(_vulkan, i, _vulkan->_frameAllocator.GetBuffer(), 1, sizeof(AmbientLight));
 	}
 }
 
@@ -291,52 +404,82 @@ void ModelPipeline::CreateLightViewProjDescriptorSets()
 {
 	uint32_t imageCount = _vulkan->GetSwapchainImageCount();
 
-	/* === CREATE LightViewProj BUFFERS === */
+	/* === ALLOCATE DESCRIPTOR SETS === */
+
+	_lightViewProjDescriptorSetGroup.Allocate(_vulkan, imageCount, LightViewProjLayout, _descriptorPool);
 
-	_lightViewProjBuffers.Create(
-		_vulkan,
-		imageCount,
-		sizeof(ViewProj),
-		VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-	);
+	/* === WRITE DESCRIPTOR SETS === */
+
+	for (int i = 0; i < imageCount; i++)
+	{
+		_lightViewProjDescriptorSetGroup.UpdateUniformBufferDynamic(_vulkan, i, _vulkan->_frameAllocator.GetBuffer(), 0, sizeof(ViewProj));
+	}
+}
+
+void ModelPipeline::CreateObjectsDescriptorSets()
+{
+	uint32_t imageCount = _vulkan->GetSwapchainImageCount();
 
 	/* === ALLOCATE DESCRIPTOR SETS === */
 
-	_lightViewProjDescriptorSetGroup.Allocate(_vulkan, imageCount, LightViewProjLayout, _descriptorPool);
+	_objectsDescriptorSetGroup.Allocate(_vulkan, imageCount, ObjectsLayout, _descriptorPool);
 
 	/* === WRITE DESCRIPTOR SETS === */
 
+	// the array is unsized, the range covers the most objects a frame can hold. The frame allocator's
+	// padding keeps it inside the buffer at any dynamic offset
+	VkDeviceSize maxRange = _vulkan->GetPhysicalDevice()->Properties.limits.maxStorageBufferRange;
+	_objectsRange = _vulkan->_frameAllocator.GetFrameSize() < maxRange ? _vulkan->_frameAllocator.GetFrameSize() : maxRange;
 	for (int i = 0; i < imageCount; i++)
 	{
-		_lightViewProjDescriptorSetGroup.UpdateUniformBuffer(_vulkan, i, _lightViewProjBuffers.Get(i)->Buffer, 0);
+		_objectsDescriptorSetGroup.UpdateStorageBufferDynamic(_vulkan, i, _vulkan->_frameAllocator.GetBuffer(), 0, _objectsRange);
 	}
 }
 
 void ModelPipeline::Update(Camera* camera, ViewProj viewProjMatrix)
 {
+	FrameAllocator* frameAllocator = &_vulkan->_frameAllocator;
+
 	// update viewproj
-	_vulkan->CopyToMemory(_viewProjBuffers.Get(_vulkan->_currentImage)->Memory, 0, sizeof(viewProjMatrix), &viewProjMatrix);
+	_viewProjOffset = frameAllocator->Push(&viewProjMatrix, sizeof(viewProjMatrix));
 
 	// update directional light
-	_vulkan->CopyToMemory(_directionalLightBuffers.Get(_vulkan->_currentImage)->Memory, 0, sizeof(DirectionalLight), DirLight);
+	_directionalLightOffset = frameAllocator->Push(DirLight, sizeof(DirectionalLight));
 
 	// update ambient light
 	AmbLight.CameraPosition = camera->Transform.GetPosition();
-	_vulkan->CopyToMemory(_ambientLightBuffers.Get(_vulkan->_currentImage)->Memory, 0, sizeof(AmbientLight), &AmbLight);
+	_ambientLightOffset = frameAllocator->Push(&AmbLight, sizeof(AmbientLight));
+
+	// the shadows read the levels picked here too
+	Vec3 cameraPosition = camera->Transform.GetPosition();
+	float projectionScale = camera->GetProjectionScale();
+	bool streaming = _vulkan->_textureStreamer.HasTextures();
+	for (auto model : Models)
+	{
+		if (UseLods)
+		{
+			model->SelectLods(Lod, cameraPosition, projectionScale);
+		}
+		else
+		{
+			model->ResetLods();
+		}
+
+		if (streaming)
+		{
+			model->RequestTextureSizes(cameraPosition, projectionScale);
+		}
+	}
 
-	void* modelsData;
-	_vulkan->MapMemory(_modelBuffers.Get(_vulkan->_currentImage)->Memory, 0, Models.size() * _modelMatrixAlignment, &modelsData);
-	for (int i = 0; i < Models.size(); i++)
+	// update model matrices, the GPU culling keeps its own copy
+	_modelOffsets.resize(UseGpuCulling ? 0 : Models.size());
+	for (int i = 0; i < _modelOffsets.size(); i++)
 	{
 		Mat4 modelMatrix = Models[i]->Transform.GetModelMatrix();
 		modelMatrix.Transpose();
 
-		size_t dataOffset = _modelMatrixAlignment * i;
-		memcpy(dataOffset + static_cast<char*>(modelsData), &modelMatrix, sizeof(modelMatrix));
-		memset(dataOffset + static_cast<char*>(modelsData) + sizeof(modelMatrix) + 1, 0, _modelMatrixAlignment - sizeof(modelMatrix));
+		_modelOffsets[i] = frameAllocator->Push(&modelMatrix, sizeof(modelMatrix));
 	}
-	_vulkan->UnmapMemory(_modelBuffers.Get(_vulkan->_currentImage)->Memory);
 
 	// update light viewproj
 	Vec3 X = Vec3(0, 1, 0).Cross(DirLight->Direction).Normalized();
@@ -367,17 +510,478 @@ void ModelPipeline::Update(Camera* camera, ViewProj viewProjMatrix)
 	Mat4 view = Math::Matrices::Translate(0, 0, 0);
 	view = q.GetMatrix().Multiply(view);
 	//view = Math::Matrices::Identity();
-	view.Transpose();
 
 	Mat4 proj = Math::Matrices::Orthographic(4096, 4096, 6.0f);
 	//Mat4 proj = Math::Matrices::Perspective(1920, 1080, 60.0f, 0.01f, 100.0f);
+
+	Mat4 lightViewProj = proj.Multiply(view);
+
+	view.Transpose();
 	proj.Transpose();
 
 	ViewProj camViewProj;
 	camViewProj.View = view;
 	camViewProj.Projection = proj;
 
-	_vulkan->CopyToMemory(_lightViewProjBuffers.Get(_vulkan->_currentImage)->Memory, 0, sizeof(camViewProj), &camViewProj);
+	_lightViewProjOffset = frameAllocator->Push(&camViewProj, sizeof(camViewProj));
+
+	_frameDataValid = _viewProjOffset != FrameAllocator::INVALID_OFFSET && _directionalLightOffset != FrameAllocator::INVALID_OFFSET
+		&& _ambientLightOffset != FrameAllocator::INVALID_OFFSET && _lightViewProjOffset != FrameAllocator::INVALID_OFFSET;
+	if (!_frameDataValid)
+	{
+		_instanceBatches.clear();
+		_renderQueue.Clear();
+		return;
+	}
+
+	// the camera matrices are already transposed for the upload
+	Mat4 cameraView = viewProjMatrix.View;
+	cameraView.Transpose();
+	Mat4 cameraProj = viewProjMatrix.Projection;
+	cameraProj.Transpose();
+
+	Mat4 cameraViewProj = cameraProj.Multiply(cameraView);
+
+	if (UseGpuCulling)
+	{
+		UpdateGpuObjects();
+		_gpuCulling.Dispatch(Math::Frustum::FromMatrix(cameraViewProj), Math::Frustum::FromMatrix(lightViewProj), UseOcclusionCulling ? &cameraViewProj : nullptr);
+		return;
+	}
+
+	CullDrawables(cameraViewProj, lightViewProj);
+
+	if (_instancedPipeline != VK_NULL_HANDLE)
+	{
+		WriteInstances();
+	}
+	else
+	{
+		BuildRenderQueue(camera);
+	}
+}
+
+void ModelPipeline::CullDrawables(const Mat4& cameraViewProj, const Mat4& lightViewProj)
+{
+	uint32_t drawableCount = 0;
+	_drawableOffsets.resize(Models.size());
+	for (uint32_t i = 0; i < Models.size(); i++)
+	{
+		_drawableOffsets[i] = drawableCount;
+		drawableCount += Models[i]->Drawables.size();
+	}
+
+	_cameraVisibility.resize(drawableCount);
+	_lightVisibility.resize(drawableCount);
+
+	if (!UseFrustumCulling)
+	{
+		std::fill(_cameraVisibility.begin(), _cameraVisibility.end(), 1);
+		std::fill(_lightVisibility.begin(), _lightVisibility.end(), 1);
+		return;
+	}
+
+	_cullX.resize(drawableCount);
+	_cullY.resize(drawableCount);
+	_cullZ.resize(drawableCount);
+	_cullRadius.resize(drawableCount);
+
+	for (uint32_t i = 0; i < Models.size(); i++)
+	{
+		Mat4 modelMatrix = Models[i]->Transform.GetModelMatrix();
+
+		for (uint32_t j = 0; j < Models[i]->Drawables.size(); j++)
+		{
+			Math::BoundingSphere sphere = Models[i]->Drawables[j]->Mesh->Sphere.Transform(modelMatrix);
+
+			uint32_t index = _drawableOffsets[i] + j;
+			_cullX[index] = sphere.Center.x;
+			_cullY[index] = sphere.Center.y;
+			_cullZ[index] = sphere.Center.z;
+			_cullRadius[index] = sphere.Radius;
+		}
+	}
+
+	Math::Frustum cameraFrustum = Math::Frustum::FromMatrix(cameraViewProj);
+	cameraFrustum.CullSpheres(_cullX.data(), _cullY.data(), _cullZ.data(), _cullRadius.data(), drawableCount, _cameraVisibility.data());
+
+	Math::Frustum lightFrustum = Math::Frustum::FromMatrix(lightViewProj);
+	lightFrustum.CullSpheres(_cullX.data(), _cullY.data(), _cullZ.data(), _cullRadius.data(), drawableCount, _lightVisibility.data());
+}
+
+void ModelPipeline::InvalidateGpuObjects()
+{
+	_gpuObjectsDirty = true;
+}
+
+void ModelPipeline::UpdateGpuObjects()
+{
+	// the objects are laid out again when models or drawables are added, removed, swapped or finish uploading,
+	// or when their geometry was moved by a compaction
+	bool changed = _gpuObjectsDirty || Models != _gpuModels || _vulkan->_geometryVersion != _gpuGeometryVersion;
+	uint32_t checked = 0;
+	for (uint32_t i = 0; i < Models.size() && !changed; i++)
+	{
+		for (uint32_t j = 0; j < Models[i]->Drawables.size() && !changed; j++, checked++)
+		{
+			MeshMaterial* drawable = Models[i]->Drawables[j];
+			changed = checked >= _gpuSlots.size() || drawable != _gpuSlots[checked].Drawable || drawable->Mesh != _gpuSlots[checked].Mesh ||
+				drawable->Material != _gpuSlots[checked].Material || drawable->IsReady() != _gpuSlots[checked].Ready;
+		}
+	}
+
+	if (changed || checked != _gpuSlots.size())
+	{
+		RebuildGpuObjects();
+		return;
+	}
+
+	// otherwise only the models that moved or switched levels are copied
+	for (uint32_t i = 0; i < Models.size(); i++)
+	{
+		for (uint32_t j = 0; j < Models[i]->Drawables.size(); j++)
+		{
+			uint32_t slot = _drawableOffsets[i] + j;
+			if (_gpuObjectIndices[slot] != UINT32_MAX)
+			{
+				_gpuCulling.SetObjectBatches(_gpuObjectIndices[slot], _gpuFirstBatches[slot] + Models[i]->GetLod(j), _gpuFirstBatches[slot] + Models[i]->GetShadowLod(j));
+			}
+		}
+
+		uint32_t version = Models[i]->Transform.GetVersion();
+		if (version == _gpuModelVersions[i])
+		{
+			continue;
+		}
+		_gpuModelVersions[i] = version;
+
+		Mat4 modelMatrix = Models[i]->Transform.GetModelMatrix();
+		modelMatrix.Transpose();
+
+		for (uint32_t j = 0; j < Models[i]->Drawables.size(); j++)
+		{
+			uint32_t object = _gpuObjectIndices[_drawableOffsets[i] + j];
+			if (object != UINT32_MAX)
+			{
+				_gpuCulling.UpdateObject(object, modelMatrix);
+			}
+		}
+	}
+}
+
+void ModelPipeline::RebuildGpuObjects()
+{
+	struct GpuDrawable
+	{
+		MeshMaterial* Drawable;
+		uint32_t Model;
+		uint32_t Slot;
+	};
+
+	std::vector<GpuDrawable> drawables;
+	_drawableOffsets.resize(Models.size());
+	_gpuModelVersions.resize(Models.size());
+	_gpuModels = Models;
+	_gpuSlots.clear();
+	_gpuObjectsDirty = false;
+	_gpuGeometryVersion = _vulkan->_geometryVersion;
+
+	uint32_t drawableCount = 0;
+	for (uint32_t i = 0; i < Models.size(); i++)
+	{
+		_drawableOffsets[i] = drawableCount;
+		_gpuModelVersions[i] = Models[i]->Transform.GetVersion();
+
+		for (uint32_t j = 0; j < Models[i]->Drawables.size(); j++)
+		{
+			MeshMaterial* drawable = Models[i]->Drawables[j];
+			_gpuSlots.push_back({ drawable, drawable->Mesh, drawable->Material, drawable->IsReady() });
+			if (drawable->IsReady())
+			{
+				drawables.push_back({ drawable, i, drawableCount + j });
+			}
+		}
+		drawableCount += Models[i]->Drawables.size();
+	}
+	_gpuObjectIndices.assign(drawableCount, UINT32_MAX);
+	_gpuFirstBatches.assign(drawableCount, UINT32_MAX);
+
+	// a group per arena block and a batch per mesh level, materials come from the bindless table
+	std::sort(drawables.begin(), drawables.end(), [](const GpuDrawable& a, const GpuDrawable& b) {
+		if (a.Drawable->Mesh->Arena != b.Drawable->Mesh->Arena)
+			return std::less<GeometryArena*>()(a.Drawable->Mesh->Arena, b.Drawable->Mesh->Arena);
+		if (a.Drawable->Mesh->Geometry->Block != b.Drawable->Mesh->Geometry->Block)
+			return a.Drawable->Mesh->Geometry->Block < b.Drawable->Mesh->Geometry->Block;
+		if (a.Drawable->Mesh != b.Drawable->Mesh)
+			return std::less<Mesh*>()(a.Drawable->Mesh, b.Drawable->Mesh);
+		return a.Slot < b.Slot;
+	});
+
+	_gpuCulling.Clear();
+
+	Mesh* previous = nullptr;
+	uint32_t firstBatch = 0;
+	for (auto& entry : drawables)
+	{
+		Mesh* mesh = entry.Drawable->Mesh;
+		if (previous == nullptr || mesh->Arena != previous->Arena || mesh->Geometry->Block != previous->Geometry->Block)
+		{
+			_gpuCulling.BeginGroup(mesh->Arena);
+		}
+		if (mesh != previous)
+		{
+			for (uint32_t lod = 0; lod < mesh->GetLodCount(); lod++)
+			{
+				uint32_t batch = _gpuCulling.AddBatch(mesh->Geometry, mesh->GetFirstIndex(lod), mesh->GetIndexCount(lod));
+				firstBatch = lod == 0 ? batch : firstBatch;
+			}
+		}
+		previous = mesh;
+
+		Model* model = Models[entry.Model];
+		uint32_t drawable = entry.Slot - _drawableOffsets[entry.Model];
+		uint32_t lod = model->GetLod(drawable);
+
+		ObjectData object;
+		object.Model = model->Transform.GetModelMatrix();
+		object.Model.Transpose();
+		object.MaterialIndex = entry.Drawable->Material->BindlessIndex;
+		object.FirstIndex = mesh->GetFirstIndex(lod);
+		object.VertexOffset = mesh->Geometry->VertexOffset;
+		object.IndexCount = mesh->GetIndexCount(lod);
+
+		_gpuFirstBatches[entry.Slot] = firstBatch;
+		_gpuObjectIndices[entry.Slot] = _gpuCulling.AddObject(object, mesh->Sphere, firstBatch + lod, firstBatch + model->GetShadowLod(drawable));
+	}
+}
+
+void ModelPipeline::BuildRenderQueue(Camera* camera)
+{
+	_renderQueue.Clear();
+
+	Vec3 cameraPosition = camera->Transform.GetPosition();
+	float farZ = camera->GetFarZ();
+	uint32_t pipelineId = _renderQueue.GetId(_pipeline);
+
+	DrawPacket packet;
+	packet.Pipeline = _pipeline;
+	packet.PipelineLayout = _pipelineLayout;
+
+	packet.Sets[0].Set = _viewProjDescriptorSetGroup.DescriptorSets[_vulkan->_currentImage];
+	packet.Sets[0].DynamicOffsetCount = 1;
+	packet.Sets[0].DynamicOffsets[0] = _viewProjOffset;
+
+	packet.Sets[3].Set = _lightDescriptorSetGroup.DescriptorSets[_vulkan->_currentImage];
+	packet.Sets[3].DynamicOffsetCount = 2;
+	packet.Sets[3].DynamicOffsets[0] = _directionalLightOffset;
+	packet.Sets[3].DynamicOffsets[1] = _ambientLightOffset;
+
+	packet.Sets[4].Set = _lightViewProjDescriptorSetGroup.DescriptorSets[_vulkan->_currentImage];
+	packet.Sets[4].DynamicOffsetCount = 1;
+	packet.Sets[4].DynamicOffsets[0] = _lightViewProjOffset;
+
+	for (uint32_t i = 0; i < Models.size(); i++)
+	{
+		Model* model = Models[i];
+
+		// its matrix didn't fit in the frame allocator
+		if (_modelOffsets[i] == FrameAllocator::INVALID_OFFSET)
+		{
+			continue;
+		}
+
+		// front to back inside the same material and mesh
+		float depth = (model->Transform.GetPosition() - cameraPosition).Length() / farZ;
+
+		packet.Sets[1].Set = _modelDescriptorSetGroup.DescriptorSets[_vulkan->_currentImage];
+		packet.Sets[1].DynamicOffsetCount = 1;
+		packet.Sets[1].DynamicOffsets[0] = _modelOffsets[i];
+
+		for (uint32_t j = 0; j < model->Drawables.size(); j++)
+		{
+			MeshMaterial* drawable = model->Drawables[j];
+
+			// skip drawables that are still uploading or outside the camera frustum
+			if (!drawable->IsReady() || !_cameraVisibility[_drawableOffsets[i] + j])
+			{
+				continue;
+			}
+
+			Material* material = drawable->Material;
+			packet.Sets[2].Set = material->ColorMap->DescriptorSetGroup.DescriptorSets[_vulkan->_currentImage];
+			packet.Sets[5].Set = material->NormalMap != nullptr ? material->NormalMap->DescriptorSetGroup.DescriptorSets[_vulkan->_currentImage] : VK_NULL_HANDLE;
+			packet.Sets[6].Set = material->MaterialPropertiesDescriptorSetGroup.DescriptorSets[_vulkan->_currentImage];
+
+			Mesh* mesh = drawable->Mesh;
+			uint32_t lod = model->GetLod(j);
+			packet.VertexBuffer = mesh->Arena->GetVertexBuffer(mesh->Geometry->Block);
+			packet.IndexBuffer = mesh->Arena->GetIndexBuffer(mesh->Geometry->Block);
+			packet.IndexType = mesh->Arena->GetIndexType();
+			packet.IndexCount = mesh->GetIndexCount(lod);
+			packet.FirstIndex = mesh->GetFirstIndex(lod);
+			packet.VertexOffset = mesh->Geometry->VertexOffset;
+
+			packet.SortKey = RenderQueue::MakeSortKey(1, pipelineId, _renderQueue.GetId(material), _renderQueue.GetId(mesh), depth);
+			_renderQueue.Submit(packet);
+		}
+	}
+
+	_renderQueue.Sort();
+}
+
+void ModelPipeline::WriteInstances()
+{
+	FrameAllocator* frameAllocator = &_vulkan->_frameAllocator;
+
+	// collect the visible drawables that finished uploading and sort them so draws sharing a material, arena block and mesh are adjacent
+	_instanceDrawables.clear();
+	for (uint32_t i = 0; i < Models.size(); i++)
+	{
+		for (uint32_t j = 0; j < Models[i]->Drawables.size(); j++)
+		{
+			MeshMaterial* drawable = Models[i]->Drawables[j];
+			if (drawable->IsReady() && _cameraVisibility[_drawableOffsets[i] + j])
+			{
+				_instanceDrawables.push_back({ drawable, i, Models[i]->GetLod(j) });
+			}
+		}
+	}
+
+	// materials don't split multi-draws when they are read from the bindless table
+	bool materialFirst = !UseBindless;
+	std::sort(_instanceDrawables.begin(), _instanceDrawables.end(), [materialFirst](const InstanceDrawable& a, const InstanceDrawable& b) {
+		if (materialFirst && a.Drawable->Material != b.Drawable->Material)
+			return std::less<Material*>()(a.Drawable->Material, b.Drawable->Material);
+		if (a.Drawable->Mesh->Arena != b.Drawable->Mesh->Arena)
+			return std::less<GeometryArena*>()(a.Drawable->Mesh->Arena, b.Drawable->Mesh->Arena);
+		if (a.Drawable->Mesh->Geometry->Block != b.Drawable->Mesh->Geometry->Block)
+			return a.Drawable->Mesh->Geometry->Block < b.Drawable->Mesh->Geometry->Block;
+		if (a.Drawable->Mesh != b.Drawable->Mesh)
+			return std::less<Mesh*>()(a.Drawable->Mesh, b.Drawable->Mesh);
+		if (a.Lod != b.Lod)
+			return a.Lod < b.Lod;
+		if (a.Drawable->Material != b.Drawable->Material)
+			return std::less<Material*>()(a.Drawable->Material, b.Drawable->Material);
+		return a.Model < b.Model;
+	});
+
+	_instanceBatches.clear();
+	_materialIndices.clear();
+	if (_instanceDrawables.empty())
+	{
+		return;
+	}
+
+	// one object per drawable, the instances of a batch are its consecutive objects
+	uint32_t objectCount = _instanceDrawables.size();
+	if ((VkDeviceSize)objectCount * sizeof(ObjectData) > _objectsRange)
+	{
+		std::cout << "ModelPipeline: " << objectCount << " objects don't fit in the objects buffer range of " << _objectsRange << " bytes" << std::endl;
+		return;
+	}
+	FrameAllocation objects = frameAllocator->Allocate(objectCount * sizeof(ObjectData));
+	_objectsOffset = objects.Offset;
+	if (objects.Data == nullptr)
+	{
+		// the frame allocator reports it, there is nothing to draw the instances from
+		return;
+	}
+
+	ObjectData* objectData = static_cast<ObjectData*>(objects.Data);
+
+	for (uint32_t i = 0; i < objectCount; i++)
+	{
+		MeshMaterial* drawable = _instanceDrawables[i].Drawable;
+		Model* model = Models[_instanceDrawables[i].Model];
+		uint32_t lod = _instanceDrawables[i].Lod;
+
+		InstanceBatch* last = _instanceBatches.empty() ? nullptr : &_instanceBatches.back();
+		if (last == nullptr || last->Mesh != drawable->Mesh || last->Material != drawable->Material || last->Lod != lod)
+		{
+			InstanceBatch batch{};
+			batch.Mesh = drawable->Mesh;
+			batch.Material = drawable->Material;
+			batch.Lod = lod;
+			batch.FirstInstance = i;
+			batch.InstanceCount = 0;
+			_instanceBatches.push_back(batch);
+		}
+		_instanceBatches.back().InstanceCount++;
+
+		uint32_t materialIndex = drawable->Material->BindlessIndex;
+		if (!UseBindless)
+		{
+			auto localIndex = _materialIndices.find(drawable->Material);
+			if (localIndex == _materialIndices.end())
+			{
+				localIndex = _materialIndices.insert(std::make_pair(drawable->Material, (uint32_t)_materialIndices.size())).first;
+			}
+			materialIndex = localIndex->second;
+		}
+
+		ObjectData object;
+		object.Model = model->Transform.GetModelMatrix();
+		object.Model.Transpose();
+		object.MaterialIndex = materialIndex;
+		object.FirstIndex = drawable->Mesh->GetFirstIndex(lod);
+		object.VertexOffset = drawable->Mesh->Geometry->VertexOffset;
+		object.IndexCount = drawable->Mesh->GetIndexCount(lod);
+		objectData[i] = object;
+	}
+
+	if (!UseIndirectDraws)
+	{
+		return;
+	}
+
+	// one indirect command per batch, batches sharing a material and arena block are drawn with one multi-draw
+	FrameAllocation commands = frameAllocator->Allocate(_instanceBatches.size() * sizeof(VkDrawIndexedIndirectCommand));
+	VkDrawIndexedIndirectCommand* commandData = static_cast<VkDrawIndexedIndirectCommand*>(commands.Data);
+	if (commandData == nullptr)
+	{
+		// the batches are drawn directly this frame
+		for (auto& batch : _instanceBatches)
+		{
+			batch.CommandOffset = FrameAllocator::INVALID_OFFSET;
+		}
+		return;
+	}
+
+	for (uint32_t i = 0; i < _instanceBatches.size(); i++)
+	{
+		InstanceBatch& batch = _instanceBatches[i];
+
+		VkDrawIndexedIndirectCommand command;
+		command.indexCount = batch.Mesh->GetIndexCount(batch.Lod);
+		command.instanceCount = batch.InstanceCount;
+		command.firstIndex = batch.Mesh->GetFirstIndex(batch.Lod);
+		command.vertexOffset = batch.Mesh->Geometry->VertexOffset;
+		command.firstInstance = batch.FirstInstance;
+		commandData[i] = command;
+
+		batch.CommandOffset = commands.Offset + i * sizeof(VkDrawIndexedIndirectCommand);
+	}
+
+	// draw counts for vkCmdDrawIndexedIndirectCount, the number of commands left in the batch's multi-draw.
+	// A recording thread may get only part of a multi-draw, maxDrawCount clamps it then
+	if (_vulkan->_drawIndirectCount)
+	{
+		FrameAllocation counts = frameAllocator->Allocate(_instanceBatches.size() * sizeof(uint32_t));
+		uint32_t* countData = static_cast<uint32_t*>(counts.Data);
+		for (int i = _instanceBatches.size() - 1; i >= 0; i--)
+		{
+			// without counts the multi-draws are issued with their exact draw count
+			if (countData == nullptr)
+			{
+				_instanceBatches[i].CountOffset = FrameAllocator::INVALID_OFFSET;
+				continue;
+			}
+
+			bool continues = i + 1 < _instanceBatches.size() && IsSameMultiDraw(_instanceBatches[i], _instanceBatches[i + 1]);
+			countData[i] = continues ? countData[i + 1] + 1 : 1;
+			_instanceBatches[i].CountOffset = counts.Offset + i * sizeof(uint32_t);
+		}
+	}
 }
 
 void ModelPipeline::RecordCommands(ViewProj viewProjMatrix)
@@ -399,114 +1003,221 @@ void ModelPipeline::RecordCommands(ViewProj viewProjMatrix)
 		renderPassBeginInfo.clearValueCount = 2;
 		renderPassBeginInfo.pClearValues = clearValues;
 
-		vkCmdBeginRenderPass(*_vulkan->GetMainCommandBuffer(), &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+		vkCmdBeginRenderPass(*_vulkan->GetMainCommandBuffer(), &renderPassBeginInfo, _vulkan->_commandRecorder.GetSubpassContents());
+	}
+
+	if (_instancedPipeline != VK_NULL_HANDLE)
+	{
+		uint32_t count = !_frameDataValid ? 0 : UseGpuCulling ? _gpuCulling.GetGroupCount() : _instanceBatches.size();
+		_vulkan->_commandRecorder.Record(_vulkan->_renderPass, count, [this](VkCommandBuffer commandBuffer, uint32_t first, uint32_t last) {
+			RecordInstanceBatches(commandBuffer, GpuCulling::CAMERA_PASS, first, last);
+		});
+	}
+	else
+	{
+		_vulkan->_commandRecorder.Record(_vulkan->_renderPass, _renderQueue.GetPacketCount(), [this](VkCommandBuffer commandBuffer, uint32_t first, uint32_t last) {
+			_renderQueue.Record(commandBuffer, first, last);
+		});
+	}
+
+	// the depth so far builds the pyramid, the objects the first phase wrongly hid are drawn on top of it
+	if (UseGpuCulling && UseOcclusionCulling && _frameDataValid)
+	{
+		vkCmdEndRenderPass(*_vulkan->GetMainCommandBuffer());
+
+		_gpuCulling.DispatchLate();
+
+		VkRenderPassBeginInfo renderPassBeginInfo{};
+		renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+		renderPassBeginInfo.renderPass = _vulkan->_loadRenderPass;
+		renderPassBeginInfo.framebuffer = _vulkan->_swapchainFramebuffers[_vulkan->_currentImage];
+		renderPassBeginInfo.renderArea.extent = _vulkan->_extent;
+		renderPassBeginInfo.renderArea.offset = { 0, 0 };
+
+		vkCmdBeginRenderPass(*_vulkan->GetMainCommandBuffer(), &renderPassBeginInfo, _vulkan->_commandRecorder.GetSubpassContents());
+
+		_vulkan->_commandRecorder.Record(_vulkan->_loadRenderPass, _gpuCulling.GetGroupCount(), [this](VkCommandBuffer commandBuffer, uint32_t first, uint32_t last) {
+			RecordInstanceBatches(commandBuffer, GpuCulling::LATE_PASS, first, last);
+		});
 	}
 
-	vkCmdBindPipeline(*_vulkan->GetMainCommandBuffer(), VK_PIPELINE_BIND_POINT_GRAPHICS, _pipeline);
+	if (endRenderPass)
+	{
+		vkCmdEndRenderPass(*_vulkan->GetMainCommandBuffer());
+	}
+}
+
+void ModelPipeline::RecordInstanceBatches(VkCommandBuffer commandBuffer, uint32_t pass, uint32_t first, uint32_t last)
+{
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, _instancedPipeline);
 
 	vkCmdBindDescriptorSets(
-		*_vulkan->GetMainCommandBuffer(),
+		commandBuffer,
 		VK_PIPELINE_BIND_POINT_GRAPHICS,
-		_pipelineLayout,
+		_instancedPipelineLayout,
 		0,
 		1,
 		&_viewProjDescriptorSetGroup.DescriptorSets[_vulkan->_currentImage],
-		0,
-		nullptr
+		1,
+		&_viewProjOffset
 	);
 
+	// the culling pass wrote the visible objects to its own buffer
+	VkDescriptorSet objectsSet = _objectsDescriptorSetGroup.DescriptorSets[_vulkan->_currentImage];
+	uint32_t objectsOffset = _objectsOffset;
+	if (UseGpuCulling)
+	{
+		objectsSet = _gpuCulling.GetObjectsSet();
+		objectsOffset = _gpuCulling.GetObjectsOffset(pass);
+	}
+
 	vkCmdBindDescriptorSets(
-		*_vulkan->GetMainCommandBuffer(),
+		commandBuffer,
 		VK_PIPELINE_BIND_POINT_GRAPHICS,
-		_pipelineLayout,
+		_instancedPipelineLayout,
+		1,
+		1,
+		&objectsSet,
+		1,
+		&objectsOffset
+	);
+
+	uint32_t lightOffsets[] = { _directionalLightOffset, _ambientLightOffset };
+	vkCmdBindDescriptorSets(
+		commandBuffer,
+		VK_PIPELINE_BIND_POINT_GRAPHICS,
+		_instancedPipelineLayout,
 		3,
 		1,
 		&_lightDescriptorSetGroup.DescriptorSets[_vulkan->_currentImage],
-		0,
-		nullptr
+		2,
+		lightOffsets
 	);
 
 	vkCmdBindDescriptorSets(
-		*_vulkan->GetMainCommandBuffer(),
+		commandBuffer,
 		VK_PIPELINE_BIND_POINT_GRAPHICS,
-		_pipelineLayout,
+		_instancedPipelineLayout,
 		4,
 		1,
 		&_lightViewProjDescriptorSetGroup.DescriptorSets[_vulkan->_currentImage],
-		0,
-		nullptr
+		1,
+		&_lightViewProjOffset
 	);
 
-	for (int i = 0; i < Models.size(); i++)
+	// all textures and material parameters
+	if (UseBindless)
 	{
-		Model* model = Models[i];
-		
-		// set model matrix
-		uint32_t offset = _modelMatrixAlignment * i;
 		vkCmdBindDescriptorSets(
-			*_vulkan->GetMainCommandBuffer(),
+			commandBuffer,
 			VK_PIPELINE_BIND_POINT_GRAPHICS,
-			_pipelineLayout,
-			1,
+			_instancedPipelineLayout,
+			2,
 			1,
-			&_modelDescriptorSetGroup.DescriptorSets[_vulkan->_currentImage],
-			1,
-			&offset
+			&_vulkan->_bindless.DescriptorSet,
+			0,
+			nullptr
 		);
+	}
+
+	uint32_t boundBlock = UINT32_MAX;
 
-		// draw model meshes
-		for (int j = 0; j < model->Drawables.size(); j++)
+	// first and last are groups of the culling pass here
+	if (UseGpuCulling)
+	{
+		for (uint32_t group = first; group < last; group++)
+		{
+			_gpuCulling.DrawGroup(commandBuffer, pass, group, &boundBlock);
+		}
+		return;
+	}
+
+	VkBuffer frameBuffer = _vulkan->_frameAllocator.GetBuffer();
+	Material* boundMaterial = nullptr;
+
+	uint32_t i = first;
+	while (i < last)
+	{
+		InstanceBatch& batch = _instanceBatches[i];
+
+		// batches are sorted by material, only bind it when it changes
+		if (!UseBindless && batch.Material != boundMaterial)
 		{
 			// bind material properties
 			vkCmdBindDescriptorSets(
-				*_vulkan->GetMainCommandBuffer(),
+				commandBuffer,
 				VK_PIPELINE_BIND_POINT_GRAPHICS,
-				_pipelineLayout,
+				_instancedPipelineLayout,
 				6,
 				1,
-				&model->Drawables[j]->Material->MaterialPropertiesDescriptorSetGroup.DescriptorSets[_vulkan->_currentImage],
+				&batch.Material->MaterialPropertiesDescriptorSetGroup.DescriptorSets[_vulkan->_currentImage],
 				0,
 				nullptr
 			);
 
 			// bind color map
 			vkCmdBindDescriptorSets(
-				*_vulkan->GetMainCommandBuffer(),
+				commandBuffer,
 				VK_PIPELINE_BIND_POINT_GRAPHICS,
-				_pipelineLayout,
+				_instancedPipelineLayout,
 				2,
 				1,
-				&model->Drawables[j]->Material->ColorMap->DescriptorSetGroup.DescriptorSets[_vulkan->_currentImage],
+				&batch.Material->ColorMap->DescriptorSetGroup.DescriptorSets[_vulkan->_currentImage],
 				0,
 				nullptr
 			);
-			
+
 			// bind normal map
-			if (model->Drawables[j]->Material->NormalMap != nullptr)
+			if (batch.Material->NormalMap != nullptr)
 			{
 				vkCmdBindDescriptorSets(
-					*_vulkan->GetMainCommandBuffer(),
+					commandBuffer,
 					VK_PIPELINE_BIND_POINT_GRAPHICS,
-					_pipelineLayout,
+					_instancedPipelineLayout,
 					5,
 					1,
-					&model->Drawables[j]->Material->NormalMap->DescriptorSetGroup.DescriptorSets[_vulkan->_currentImage],
+					&batch.Material->NormalMap->DescriptorSetGroup.DescriptorSets[_vulkan->_currentImage],
 					0,
 					nullptr
 				);
 			}
 
-			_vulkan->DrawMesh(
-				*_vulkan->GetMainCommandBuffer(),
-				&model->Drawables[j]->Mesh->VertexBuffer,
-				&model->Drawables[j]->Mesh->IndexBuffer,
-				model->Drawables[j]->Mesh->Indices.size()
+			boundMaterial = batch.Material;
+		}
+
+		// the commands are missing when they didn't fit in the frame allocator
+		if (UseIndirectDraws && batch.CommandOffset != FrameAllocator::INVALID_OFFSET)
+		{
+			batch.Mesh->Arena->Bind(commandBuffer, batch.Mesh->Geometry, &boundBlock);
+
+			uint32_t end = i + 1;
+			while (end < last && IsSameMultiDraw(batch, _instanceBatches[end]))
+			{
+				end++;
+			}
+
+			bool counted = _vulkan->_drawIndirectCount && batch.CountOffset != FrameAllocator::INVALID_OFFSET;
+			_vulkan->DrawIndexedIndirect(
+				commandBuffer,
+				frameBuffer,
+				batch.CommandOffset,
+				counted ? frameBuffer : VK_NULL_HANDLE,
+				batch.CountOffset,
+				end - i
 			);
+
+			i = end;
+		}
+		else
+		{
+			batch.Mesh->RecordDrawCommands(commandBuffer, &boundBlock, batch.InstanceCount, batch.FirstInstance, batch.Lod);
+			i++;
 		}
 	}
+}
 
-	if (endRenderPass)
-	{
-		vkCmdEndRenderPass(*_vulkan->GetMainCommandBuffer());
-	}
-}
\ No newline at end of file
+bool ModelPipeline::IsSameMultiDraw(const InstanceBatch& a, const InstanceBatch& b)
+{
+	// block numbers are per arena, the arenas of the other index types count from 0 too
+	return (UseBindless || a.Material == b.Material) && a.Mesh->Arena == b.Mesh->Arena && a.Mesh->Geometry->Block == b.Mesh->Geometry->Block;
+}
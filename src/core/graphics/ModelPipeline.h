@@ -4,16 +4,22 @@
 #include "vulkan/Vulkan.h"
 #include "Common.h"
 #include "Vertex.h"
+#include "PackedVertex.h"
 #include "Model.h"
 #include "DirectionalLight.h"
 #include "AmbientLight.h"
 #include "BufferGroup.h"
 #include "DescriptorSetGroup.h"
 #include "Camera.h"
+#include "RenderQueue.h"
+#include "GpuCulling.h"
 #include "../math/Math.h"
+#include "../math/Frustum.h"
 
 #include <vulkan/vulkan.h>
 #include <vector>
+#include <string>
+#include <unordered_map>
 
 namespace Euler 
 {
@@ -22,29 +28,110 @@ namespace Euler
 		class EULER_API ModelPipeline
 		{
 		private:
-			/// <summary>
-			/// This constant will be used when calculating the initial size of the dynamic uniform buffer which contains
-			/// the model matrices. The size of the buffer will be INITIAL_MODELS_FOR_BUFFER_SIZE * sizeof(model_matrix).
-			/// </summary>
-			const uint32_t INITIAL_MODELS_FOR_BUFFER_SIZE = 25;
+			struct InstanceBatch
+			{
+				Euler::Mesh* Mesh;
+				Graphics::Material* Material;
+				uint32_t Lod;
+				uint32_t FirstInstance;
+				uint32_t InstanceCount;
+				uint32_t CommandOffset;
+				uint32_t CountOffset;
+			};
 
 			Vulkan* _vulkan;
 
 			VkPipeline _pipeline;
 			VkPipelineLayout _pipelineLayout;
 
+			VkPipeline _instancedPipeline = VK_NULL_HANDLE;
+			VkPipelineLayout _instancedPipelineLayout = VK_NULL_HANDLE;
+			struct InstanceDrawable
+			{
+				MeshMaterial* Drawable;
+				uint32_t Model;
+				uint32_t Lod;
+			};
+
+			std::vector<InstanceBatch> _instanceBatches;
+			std::vector<InstanceDrawable> _instanceDrawables;
+			std::unordered_map<Graphics::Material*, uint32_t> _materialIndices;
+
+			// world space bounding spheres of all drawables, one array per component for the batch cull
+			std::vector<float> _cullX;
+			std::vector<float> _cullY;
+			std::vector<float> _cullZ;
+			std::vector<float> _cullRadius;
+
+			// object of every drawable slot in the GPU culling, UINT32_MAX while the drawable is uploading
+			std::vector<uint32_t> _gpuObjectIndices;
+			// batch of the full detail level of every drawable slot's mesh, the other levels follow it
+			std::vector<uint32_t> _gpuFirstBatches;
+			std::vector<uint32_t> _gpuModelVersions;
+			// what every model and drawable slot held when the objects were laid out, a change lays them out again
+			struct GpuSlot
+			{
+				MeshMaterial* Drawable;
+				Euler::Mesh* Mesh;
+				Graphics::Material* Material;
+				bool Ready;
+			};
+			std::vector<Model*> _gpuModels;
+			std::vector<GpuSlot> _gpuSlots;
+			bool _gpuObjectsDirty = true;
+			// the vulkan's _geometryVersion the objects' offsets were read at
+			uint32_t _gpuGeometryVersion = 0;
+
 		public:
+			// draws all drawables sharing a mesh and material as instances of one draw, set before Create.
+			// Needs shaders/out/instanced_vertex.spv, otherwise models are drawn one by one
+			bool UseInstancing = true;
+			// issues the instanced draws through indirect commands, needs drawIndirectFirstInstance
+			bool UseIndirectDraws = false;
+			// reads textures and material parameters through the vulkan's bindless table instead of per-draw sets.
+			// Needs descriptor indexing and shaders/out/bindless_vertex.spv and bindless_fragment.spv
+			bool UseBindless = false;
+			// skips drawables whose bounding sphere is outside the camera frustum (main pass) or the light frustum (shadows)
+			bool UseFrustumCulling = true;
+			// culls and builds the draws of both the main and the shadow pass in compute shaders, set before Create.
+			// Needs UseBindless, indirect count draws and the culling shaders. Update records the culling passes,
+			// so it has to be called outside of a render pass
+			bool UseGpuCulling = false;
+			// also skips objects hidden behind the previous frame's depth, set before Create. Needs UseGpuCulling and
+			// shaders/out/hiz_compute.spv. RecordCommands ends the main pass to build the depth pyramid and draws
+			// the objects that turned out visible in the load render pass after it
+			bool UseOcclusionCulling = false;
+			// draws meshes at the level of detail that keeps their error on screen below Lod.MaxError, in both passes
+			bool UseLods = true;
+			LodSettings Lod;
+			// reads PackedVertex meshes with the shaders compiled with PACKED_VERTICES (the *_packed.spv files), set
+			// before Create. Falls back to full vertices when shaders/out/vertex_packed.spv is missing, so check it
+			// or GetVertexFormat before creating the meshes
+			bool UsePackedVertices = false;
+
 			std::vector<Model*> Models;
 			DirectionalLight* DirLight;
 			AmbientLight AmbLight;
 
 			VkDescriptorPool _descriptorPool;
 
-			BufferGroup _viewProjBuffers;
-			BufferGroup _modelBuffers;
-			BufferGroup _directionalLightBuffers;
-			BufferGroup _ambientLightBuffers;
-			BufferGroup _lightViewProjBuffers;
+			// offsets of this frame's data in the vulkan frame allocator, written in Update
+			uint32_t _viewProjOffset;
+			uint32_t _directionalLightOffset;
+			uint32_t _ambientLightOffset;
+			uint32_t _lightViewProjOffset;
+			std::vector<uint32_t> _modelOffsets;
+			uint32_t _objectsOffset;
+			// bytes the objects descriptor covers past _objectsOffset
+			VkDeviceSize _objectsRange = 0;
+			// false when the frame allocator ran out before the data all draws share, nothing is drawn then.
+			// Models whose offset is FrameAllocator::INVALID_OFFSET are skipped
+			bool _frameDataValid = false;
+
+			// visibility of drawable j of model i is at _drawableOffsets[i] + j, written in Update
+			std::vector<uint32_t> _drawableOffsets;
+			std::vector<uint8_t> _cameraVisibility;
+			std::vector<uint8_t> _lightVisibility;
 
 			VkDescriptorSetLayout ViewProjLayout;
 			VkDescriptorSetLayout ModelLayout;
@@ -53,21 +140,33 @@ namespace Euler
 			VkDescriptorSetLayout MaterialPropertiesLayout;
 			VkDescriptorSetLayout DirectionalLightLayout;
 			VkDescriptorSetLayout LightViewProjLayout;
+			VkDescriptorSetLayout ObjectsLayout;
 
 			DescriptorSetGroup _viewProjDescriptorSetGroup;
 			DescriptorSetGroup _modelDescriptorSetGroup;
 			DescriptorSetGroup _lightDescriptorSetGroup;
 			DescriptorSetGroup _lightViewProjDescriptorSetGroup;
+			DescriptorSetGroup _objectsDescriptorSetGroup;
+
+			// draws of the regular (not instanced) path, built in Update
+			RenderQueue _renderQueue;
 
-			uint64_t _modelMatrixAlignment;
+			GpuCulling _gpuCulling;
 
 			void Create(Vulkan* vulkan, float viewportWidth, float viewportHeight);
 			void Destroy();
 
 			void Update(Camera* camera, ViewProj viewProjMatrix);
 			void RecordCommands(ViewProj viewProjMatrix);
+			// lays the GPU culling objects out again in the next Update, for changes the pipeline can't see, like
+			// geometry moving inside its arena
+			void InvalidateGpuObjects();
 
 			std::vector<VertexAttributeInfo> GetVertexAttributes();
+			uint32_t GetVertexStride();
+			VertexFormat GetVertexFormat();
+			// shaders/out/<name>.spv, or the _packed variant with UsePackedVertices
+			std::string GetVertexShaderPath(const char* name);
 
 		private:
 			void CreateDescriptorSetLayouts();
@@ -77,6 +176,18 @@ namespace Euler
 			void CreateModelDescriptorSets();
 			void CreateDirectionalLightDescriptorSets();
 			void CreateLightViewProjDescriptorSets();
+			void CreateObjectsDescriptorSets();
+
+			void CreateInstancedPipeline(float viewportWidth, float viewportHeight);
+			void WriteInstances();
+			// pass is the culling pass the groups are drawn from when UseGpuCulling is set
+			void RecordInstanceBatches(VkCommandBuffer commandBuffer, uint32_t pass, uint32_t first, uint32_t last);
+			bool IsSameMultiDraw(const InstanceBatch& a, const InstanceBatch& b);
+
+			void CullDrawables(const Mat4& cameraViewProj, const Mat4& lightViewProj);
+			void UpdateGpuObjects();
+			void RebuildGpuObjects();
+			void BuildRenderQueue(Camera* camera);
 		};
 	}
 }
\ No newline at end of file
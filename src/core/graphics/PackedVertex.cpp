@@ -0,0 +1,225 @@
+#include "PackedVertex.h"
+
+#include <string.h>
+#include <math.h>
+
+using namespace Euler;
+
+namespace
+{
+	int16_t ToSnorm16(float value)
+	{
+		value = value < -1.0f ? -1.0f : (value > 1.0f ? 1.0f : value);
+		return (int16_t)roundf(value * 32767.0f);
+	}
+
+	float FromSnorm16(int16_t value)
+	{
+		float result = value / 32767.0f;
+		return result < -1.0f ? -1.0f : result;
+	}
+
+	uint8_t ToUnorm8(float value)
+	{
+		value = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+		return (uint8_t)roundf(value * 255.0f);
+	}
+
+	void PackNormals(const Vec3& normal, const Vec3& tangent, const Vec3& bitangent, int16_t* packedNormal, int16_t* packedTangent)
+	{
+		float x, y;
+		EncodeOctahedral(normal, &x, &y);
+		packedNormal[0] = ToSnorm16(x);
+		packedNormal[1] = ToSnorm16(y);
+
+		// y is remapped to [0, 1] and kept away from 0 so the sign survives quantization
+		float handedness = normal.Cross(tangent).Dot(bitangent) < 0.0f ? -1.0f : 1.0f;
+		EncodeOctahedral(tangent, &x, &y);
+		y = fmaxf(y * 0.5f + 0.5f, 1.0f / 32767.0f);
+		packedTangent[0] = ToSnorm16(x);
+		packedTangent[1] = ToSnorm16(handedness * y);
+	}
+
+	void UnpackNormals(const int16_t* packedNormal, const int16_t* packedTangent, Vec3* normal, Vec3* tangent, Vec3* bitangent)
+	{
+		*normal = DecodeOctahedral(FromSnorm16(packedNormal[0]), FromSnorm16(packedNormal[1]));
+
+		float y = FromSnorm16(packedTangent[1]);
+		float handedness = y < 0.0f ? -1.0f : 1.0f;
+		*tangent = DecodeOctahedral(FromSnorm16(packedTangent[0]), fabsf(y) * 2.0f - 1.0f);
+		*bitangent = handedness * normal->Cross(*tangent);
+	}
+}
+
+PackedVertex Euler::PackVertex(const Vertex& vertex)
+{
+	PackedVertex packed;
+	packed.Position = vertex.Position;
+	PackNormals(vertex.Normal, vertex.Tangent, vertex.Bitangent, packed.Normal, packed.Tangent);
+	packed.UV[0] = FloatToHalf(vertex.UV.x);
+	packed.UV[1] = FloatToHalf(vertex.UV.y);
+	return packed;
+}
+
+Vertex Euler::UnpackVertex(const PackedVertex& vertex)
+{
+	Vertex unpacked;
+	unpacked.Position = vertex.Position;
+	UnpackNormals(vertex.Normal, vertex.Tangent, &unpacked.Normal, &unpacked.Tangent, &unpacked.Bitangent);
+	unpacked.UV = Vec2(HalfToFloat(vertex.UV[0]), HalfToFloat(vertex.UV[1]));
+	return unpacked;
+}
+
+PackedAnimatedVertex Euler::PackAnimatedVertex(const AnimatedVertex& vertex)
+{
+	PackedAnimatedVertex packed;
+	packed.Position = vertex.Position;
+	PackNormals(vertex.Normal, vertex.Tangent, vertex.Bitangent, packed.Normal, packed.Tangent);
+	packed.UV[0] = FloatToHalf(vertex.UV.x);
+	packed.UV[1] = FloatToHalf(vertex.UV.y);
+
+	int32_t boneIds[] = { vertex.BoneIds.x, vertex.BoneIds.y, vertex.BoneIds.z };
+	float boneWeights[] = { vertex.BoneWeights.x, vertex.BoneWeights.y, vertex.BoneWeights.z };
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		packed.BoneIds[i] = boneIds[i] < 0 ? 0 : (uint8_t)boneIds[i];
+		packed.BoneWeights[i] = boneIds[i] < 0 ? 0 : ToUnorm8(boneWeights[i]);
+	}
+	packed.BoneIds[3] = 0;
+	packed.BoneWeights[3] = 0;
+
+	return packed;
+}
+
+AnimatedVertex Euler::UnpackAnimatedVertex(const PackedAnimatedVertex& vertex)
+{
+	AnimatedVertex unpacked;
+	unpacked.Position = vertex.Position;
+	UnpackNormals(vertex.Normal, vertex.Tangent, &unpacked.Normal, &unpacked.Tangent, &unpacked.Bitangent);
+	unpacked.UV = Vec2(HalfToFloat(vertex.UV[0]), HalfToFloat(vertex.UV[1]));
+
+	int32_t boneIds[3];
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		boneIds[i] = vertex.BoneWeights[i] == 0 ? -1 : vertex.BoneIds[i];
+	}
+	unpacked.BoneIds = Vec3i(boneIds[0], boneIds[1], boneIds[2]);
+	unpacked.BoneWeights = Vec3(vertex.BoneWeights[0] / 255.0f, vertex.BoneWeights[1] / 255.0f, vertex.BoneWeights[2] / 255.0f);
+
+	return unpacked;
+}
+
+void Euler::EncodeOctahedral(const Vec3& direction, float* x, float* y)
+{
+	float length = fabsf(direction.x) + fabsf(direction.y) + fabsf(direction.z);
+	if (length == 0.0f)
+	{
+		*x = 0.0f;
+		*y = 0.0f;
+		return;
+	}
+
+	float px = direction.x / length;
+	float py = direction.y / length;
+
+	// the lower half folds over the diagonals
+	if (direction.z < 0.0f)
+	{
+		float fx = (1.0f - fabsf(py)) * (px >= 0.0f ? 1.0f : -1.0f);
+		float fy = (1.0f - fabsf(px)) * (py >= 0.0f ? 1.0f : -1.0f);
+		px = fx;
+		py = fy;
+	}
+
+	*x = px;
+	*y = py;
+}
+
+Vec3 Euler::DecodeOctahedral(float x, float y)
+{
+	Vec3 direction(x, y, 1.0f - fabsf(x) - fabsf(y));
+
+	float fold = fmaxf(-direction.z, 0.0f);
+	direction.x += direction.x >= 0.0f ? -fold : fold;
+	direction.y += direction.y >= 0.0f ? -fold : fold;
+
+	return direction.Normalized();
+}
+
+uint16_t Euler::FloatToHalf(float value)
+{
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+
+	uint32_t sign = (bits >> 16) & 0x8000;
+	uint32_t floatExponent = (bits >> 23) & 0xff;
+	uint32_t mantissa = bits & 0x7fffff;
+	int32_t exponent = (int32_t)floatExponent - 127 + 15;
+
+	// infinity and NaN
+	if (floatExponent == 0xff)
+	{
+		return (uint16_t)(sign | 0x7c00 | (mantissa != 0 ? 0x200 : 0));
+	}
+
+	if (exponent >= 31)
+	{
+		return (uint16_t)(sign | 0x7c00);
+	}
+
+	// subnormal halves
+	if (exponent <= 0)
+	{
+		if (exponent < -10)
+		{
+			return (uint16_t)sign;
+		}
+
+		mantissa |= 0x800000;
+		uint32_t shift = 14 - exponent;
+		uint32_t half = mantissa >> shift;
+		uint32_t rest = mantissa & ((1u << shift) - 1);
+		uint32_t halfway = 1u << (shift - 1);
+		if (rest > halfway || (rest == halfway && (half & 1)))
+		{
+			half++;
+		}
+		return (uint16_t)(sign | half);
+	}
+
+	// rounding up can carry into the exponent, which is still the right result
+	uint32_t half = ((uint32_t)exponent << 10) | (mantissa >> 13);
+	uint32_t rest = mantissa & 0x1fff;
+	if (rest > 0x1000 || (rest == 0x1000 && (half & 1)))
+	{
+		half++;
+	}
+	return (uint16_t)(sign | half);
+}
+
+float Euler::HalfToFloat(uint16_t value)
+{
+	uint32_t sign = (uint32_t)(value & 0x8000) << 16;
+	uint32_t exponent = (value >> 10) & 0x1f;
+	uint32_t mantissa = value & 0x3ff;
+
+	if (exponent == 0)
+	{
+		float result = ldexpf((float)mantissa, -24);
+		return sign != 0 ? -result : result;
+	}
+
+	uint32_t bits;
+	if (exponent == 31)
+	{
+		bits = sign | 0x7f800000 | (mantissa << 13);
+	}
+	else
+	{
+		bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+	}
+
+	float result;
+	memcpy(&result, &bits, sizeof(result));
+	return result;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "../API.h"
+#include "Vertex.h"
+#include "AnimatedVertex.h"
+
+#include <stdint.h>
+
+namespace Euler
+{
+	enum VertexFormat
+	{
+		VERTEX_FORMAT_FULL,
+		VERTEX_FORMAT_PACKED
+	};
+
+	// 24 bytes instead of 56. Normal and tangent are octahedral snorm16, the bitangent is rebuilt from them with the
+	// handedness stored in the sign of the tangent's second component, and the UV is two half floats
+	class EULER_API PackedVertex
+	{
+	public:
+		Vec3 Position;
+		int16_t Normal[2];
+		int16_t Tangent[2];
+		uint16_t UV[2];
+	};
+
+	// 32 bytes instead of 72, bone ids are u8 and weights unorm8, bones without an id have id 0 and weight 0
+	class EULER_API PackedAnimatedVertex
+	{
+	public:
+		Vec3 Position;
+		int16_t Normal[2];
+		int16_t Tangent[2];
+		uint16_t UV[2];
+		uint8_t BoneIds[4];
+		uint8_t BoneWeights[4];
+	};
+
+	EULER_API PackedVertex PackVertex(const Vertex& vertex);
+	EULER_API Vertex UnpackVertex(const PackedVertex& vertex);
+	EULER_API PackedAnimatedVertex PackAnimatedVertex(const AnimatedVertex& vertex);
+	EULER_API AnimatedVertex UnpackAnimatedVertex(const PackedAnimatedVertex& vertex);
+
+	// unit vector to the octahedron unfolded on the [-1, 1] square (Cigolle et al.) and back
+	EULER_API void EncodeOctahedral(const Vec3& direction, float* x, float* y);
+	EULER_API Vec3 DecodeOctahedral(float x, float y);
+
+	// IEEE 754 binary16, rounded to nearest
+	EULER_API uint16_t FloatToHalf(float value);
+	EULER_API float HalfToFloat(uint16_t value);
+}
@@ -0,0 +1,183 @@
+#include "RenderQueue.h"
+#include "../util/RadixSort.h"
+
+#include <string.h>
+
+using namespace Euler::Graphics;
+
+const uint32_t DrawPacket::MAX_SETS;
+const uint32_t RenderQueue::PASS_BITS;
+const uint32_t RenderQueue::PIPELINE_BITS;
+const uint32_t RenderQueue::MATERIAL_BITS;
+const uint32_t RenderQueue::MESH_BITS;
+const uint32_t RenderQueue::DEPTH_BITS;
+
+void RenderQueueStats::Add(const RenderQueueStats& other)
+{
+	Draws += other.Draws;
+	PipelineBinds += other.PipelineBinds;
+	PipelineBindsSkipped += other.PipelineBindsSkipped;
+	DescriptorSetBinds += other.DescriptorSetBinds;
+	DescriptorSetBindsSkipped += other.DescriptorSetBindsSkipped;
+	BufferBinds += other.BufferBinds;
+	BufferBindsSkipped += other.BufferBindsSkipped;
+}
+
+uint64_t RenderQueue::MakeSortKey(uint32_t pass, uint32_t pipeline, uint32_t material, uint32_t mesh, float depth)
+{
+	if (depth < 0.0f) depth = 0.0f;
+	if (depth > 1.0f) depth = 1.0f;
+	uint64_t quantizedDepth = (uint64_t)(depth * ((1 << DEPTH_BITS) - 1));
+
+	uint64_t key = pass & ((1 << PASS_BITS) - 1);
+	key = (key << PIPELINE_BITS) | (pipeline & ((1 << PIPELINE_BITS) - 1));
+	key = (key << MATERIAL_BITS) | (material & ((1 << MATERIAL_BITS) - 1));
+	key = (key << MESH_BITS) | (mesh & ((1 << MESH_BITS) - 1));
+	key = (key << DEPTH_BITS) | quantizedDepth;
+	return key;
+}
+
+uint32_t RenderQueue::GetId(const void* object)
+{
+	auto it = _ids.find(object);
+	if (it != _ids.end())
+	{
+		return it->second;
+	}
+
+	uint32_t id = _ids.size();
+	_ids[object] = id;
+	return id;
+}
+
+void RenderQueue::Clear()
+{
+	_packets.clear();
+	_order.clear();
+	_stats = RenderQueueStats();
+}
+
+void RenderQueue::Submit(const DrawPacket& packet)
+{
+	_packets.push_back(packet);
+}
+
+void RenderQueue::Sort()
+{
+	_keys.resize(_packets.size());
+	for (uint32_t i = 0; i < _packets.size(); i++)
+	{
+		_keys[i] = _packets[i].SortKey;
+	}
+
+	RadixSortIndices(_keys.data(), _keys.size(), _order, _scratch);
+}
+
+uint32_t RenderQueue::GetPacketCount() const
+{
+	return _packets.size();
+}
+
+void RenderQueue::Record(VkCommandBuffer commandBuffer, uint32_t first, uint32_t last)
+{
+	RenderQueueStats stats;
+
+	// nothing is bound at the start of a command buffer
+	VkPipeline boundPipeline = VK_NULL_HANDLE;
+	VkPipelineLayout boundLayout = VK_NULL_HANDLE;
+	DescriptorBinding boundSets[DrawPacket::MAX_SETS];
+	VkBuffer boundVertexBuffer = VK_NULL_HANDLE;
+	VkBuffer boundIndexBuffer = VK_NULL_HANDLE;
+
+	for (uint32_t i = first; i < last; i++)
+	{
+		const DrawPacket& packet = _packets[_order[i]];
+
+		if (packet.Pipeline != boundPipeline)
+		{
+			vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, packet.Pipeline);
+			boundPipeline = packet.Pipeline;
+			stats.PipelineBinds++;
+		}
+		else
+		{
+			stats.PipelineBindsSkipped++;
+		}
+
+		// sets bound with another layout can't be relied on
+		if (packet.PipelineLayout != boundLayout)
+		{
+			for (uint32_t set = 0; set < DrawPacket::MAX_SETS; set++)
+			{
+				boundSets[set] = DescriptorBinding();
+			}
+			boundLayout = packet.PipelineLayout;
+		}
+
+		for (uint32_t set = 0; set < DrawPacket::MAX_SETS; set++)
+		{
+			const DescriptorBinding& binding = packet.Sets[set];
+			if (binding.Set == VK_NULL_HANDLE)
+			{
+				continue;
+			}
+
+			DescriptorBinding& bound = boundSets[set];
+			if (bound.Set == binding.Set
+				&& bound.DynamicOffsetCount == binding.DynamicOffsetCount
+				&& memcmp(bound.DynamicOffsets, binding.DynamicOffsets, binding.DynamicOffsetCount * sizeof(uint32_t)) == 0)
+			{
+				stats.DescriptorSetBindsSkipped++;
+				continue;
+			}
+
+			vkCmdBindDescriptorSets(
+				commandBuffer,
+				VK_PIPELINE_BIND_POINT_GRAPHICS,
+				packet.PipelineLayout,
+				set,
+				1,
+				&binding.Set,
+				binding.DynamicOffsetCount,
+				binding.DynamicOffsets
+			);
+			bound = binding;
+			stats.DescriptorSetBinds++;
+		}
+
+		if (packet.VertexBuffer != boundVertexBuffer)
+		{
+			VkDeviceSize offset = 0;
+			vkCmdBindVertexBuffers(commandBuffer, 0, 1, &packet.VertexBuffer, &offset);
+			boundVertexBuffer = packet.VertexBuffer;
+			stats.BufferBinds++;
+		}
+		else
+		{
+			stats.BufferBindsSkipped++;
+		}
+
+		if (packet.IndexBuffer != boundIndexBuffer)
+		{
+			vkCmdBindIndexBuffer(commandBuffer, packet.IndexBuffer, 0, packet.IndexType);
+			boundIndexBuffer = packet.IndexBuffer;
+			stats.BufferBinds++;
+		}
+		else
+		{
+			stats.BufferBindsSkipped++;
+		}
+
+		vkCmdDrawIndexed(commandBuffer, packet.IndexCount, packet.InstanceCount, packet.FirstIndex, packet.VertexOffset, packet.FirstInstance);
+		stats.Draws++;
+	}
+
+	std::lock_guard<std::mutex> lock(_statsMutex);
+	_stats.Add(stats);
+}
+
+RenderQueueStats RenderQueue::GetStats()
+{
+	std::lock_guard<std::mutex> lock(_statsMutex);
+	return _stats;
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "../API.h"
+
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+
+namespace Euler
+{
+	namespace Graphics
+	{
+		struct EULER_API DescriptorBinding
+		{
+			VkDescriptorSet Set = VK_NULL_HANDLE;		// VK_NULL_HANDLE leaves the set index alone
+			uint32_t DynamicOffsetCount = 0;
+			uint32_t DynamicOffsets[2];
+		};
+
+		/// <summary>
+		/// Everything needed to record one draw. Packets only say what has to be bound, the queue
+		/// decides what actually needs binding.
+		/// </summary>
+		struct EULER_API DrawPacket
+		{
+			static const uint32_t MAX_SETS = 8;
+
+			uint64_t SortKey = 0;
+
+			VkPipeline Pipeline = VK_NULL_HANDLE;
+			VkPipelineLayout PipelineLayout = VK_NULL_HANDLE;
+			DescriptorBinding Sets[MAX_SETS];
+
+			VkBuffer VertexBuffer = VK_NULL_HANDLE;
+			VkBuffer IndexBuffer = VK_NULL_HANDLE;
+			VkIndexType IndexType = VK_INDEX_TYPE_UINT32;
+
+			uint32_t IndexCount = 0;
+			uint32_t InstanceCount = 1;
+			uint32_t FirstIndex = 0;
+			int32_t VertexOffset = 0;
+			uint32_t FirstInstance = 0;
+		};
+
+		struct EULER_API RenderQueueStats
+		{
+			uint32_t Draws = 0;
+			uint32_t PipelineBinds = 0;
+			uint32_t PipelineBindsSkipped = 0;
+			uint32_t DescriptorSetBinds = 0;
+			uint32_t DescriptorSetBindsSkipped = 0;
+			uint32_t BufferBinds = 0;
+			uint32_t BufferBindsSkipped = 0;
+
+			void Add(const RenderQueueStats& other);
+		};
+
+		/// <summary>
+		/// Draw packets of one pass, sorted by their 64-bit keys every frame. Recording tracks the
+		/// bound pipeline, descriptor sets and buffers per command buffer and skips binds that
+		/// wouldn't change anything. Packets are submitted from the render thread, ranges of the
+		/// sorted queue can be recorded from any thread.
+		/// </summary>
+		class EULER_API RenderQueue
+		{
+		public:
+			// key layout from the most significant bit: pass 4, pipeline 8, material 16, mesh 16, depth 20
+			static const uint32_t PASS_BITS = 4;
+			static const uint32_t PIPELINE_BITS = 8;
+			static const uint32_t MATERIAL_BITS = 16;
+			static const uint32_t MESH_BITS = 16;
+			static const uint32_t DEPTH_BITS = 20;
+
+		private:
+			std::vector<DrawPacket> _packets;
+			std::vector<uint64_t> _keys;
+			std::vector<uint32_t> _order;
+			std::vector<uint32_t> _scratch;
+
+			// dense ids for pipelines, materials and meshes so they fit in the key
+			std::unordered_map<const void*, uint32_t> _ids;
+
+			std::mutex _statsMutex;
+			RenderQueueStats _stats;
+
+		public:
+			// depth is in [0, 1], smaller is drawn first
+			static uint64_t MakeSortKey(uint32_t pass, uint32_t pipeline, uint32_t material, uint32_t mesh, float depth);
+
+			// the same object always gets the same id, ids wrap around once they don't fit in the key
+			uint32_t GetId(const void* object);
+
+			void Clear();
+			void Submit(const DrawPacket& packet);
+			void Sort();
+			uint32_t GetPacketCount() const;
+
+			// records the sorted packets [first, last)
+			void Record(VkCommandBuffer commandBuffer, uint32_t first, uint32_t last);
+
+			// counters of everything recorded since the last Clear
+			RenderQueueStats GetStats();
+		};
+	}
+}
@@ -3,6 +3,8 @@
 #include "../io/Utils.h"
 #include "../math/Math.h"
 
+#include <iostream>
+
 using namespace Euler::Graphics;
 
 void Shadows::Create(Vulkan* vulkan, ModelPipeline* modelPipeline, float viewportWidth, float viewportHeight)
@@ -18,7 +20,7 @@ void Shadows::Create(Vulkan* vulkan, ModelPipeline* modelPipeline, float viewpor
 
 	/* === READ SHADER CODE === */
 
-	std::vector<char> vertexShaderCode = ReadFile("shaders/out/shadow_vertex.spv");
+	std::vector<char> vertexShaderCode = ReadFile(_modelPipeline->GetVertexShaderPath("shadow_vertex").c_str());
 	std::vector<char> fragmentShaderCode = ReadFile("shaders/out/shadow_fragment.spv");
 
 	/* === CREATE PIPELINE === */
@@ -31,7 +33,7 @@ void Shadows::Create(Vulkan* vulkan, ModelPipeline* modelPipeline, float viewpor
 	pipelineInfo.FragmentShaderCode = fragmentShaderCode.data();
 	pipelineInfo.FragmentShaderCodeSize = fragmentShaderCode.size();
 
-	pipelineInfo.VertexStride = sizeof(Vertex);
+	pipelineInfo.VertexStride = modelPipeline->GetVertexStride();
 	pipelineInfo.VertexAttributes = modelPipeline->GetVertexAttributes();
 
 	pipelineInfo.Topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
@@ -53,14 +55,45 @@ void Shadows::Create(Vulkan* vulkan, ModelPipeline* modelPipeline, float viewpor
 
 	_vulkan->CreatePipeline(&pipelineInfo, &_pipelineLayout, &_pipeline);
 
+	// same pipeline reading the model matrices from the objects the culling pass wrote
+	if (_modelPipeline->UseGpuCulling)
+	{
+		std::string instancedVertexShaderPath = _modelPipeline->GetVertexShaderPath("shadow_instanced_vertex");
+		std::vector<char> instancedVertexShaderCode = ReadFile(instancedVertexShaderPath.c_str());
+		if (instancedVertexShaderCode.empty())
+		{
+			std::cout << "Shadows: " << instancedVertexShaderPath << " not found, culling on the CPU" << std::endl;
+			_modelPipeline->UseGpuCulling = false;
+		}
+		else
+		{
+			pipelineInfo.VertexShaderCode = instancedVertexShaderCode.data();
+			pipelineInfo.VertexShaderCodeSize = instancedVertexShaderCode.size();
+			pipelineInfo.DescriptorSetLayouts = { ViewProjLayout, _modelPipeline->ObjectsLayout };
+
+			_vulkan->CreatePipeline(&pipelineInfo, &_instancedPipelineLayout, &_instancedPipeline);
+		}
+	}
+
 	CreateFramebuffers();
 	UpdateDescriptorSets();
 }
 
 void Shadows::Destroy()
 {
-	_vulkan->DestroySampler(_sampler);
+	for (int i = 0; i < _depthImages.size(); i++)
+	{
+		vkDestroyFramebuffer(_vulkan->_device, _framebuffers[i], nullptr);
+		_vulkan->DestroyImageView(_depthImageViews[i]);
+		_vulkan->DestroyImage(_depthImages[i], _depthImageMemories[i]);
+	}
+
+	_vulkan->ReleaseSampler(_sampler);
 	_vulkan->DestroyPipeline(_pipelineLayout, _pipeline);
+	if (_instancedPipeline != VK_NULL_HANDLE)
+	{
+		_vulkan->DestroyPipeline(_instancedPipelineLayout, _instancedPipeline);
+	}
 	vkDestroyRenderPass(_vulkan->_device, _shadowRenderPass, nullptr);
 }
 
@@ -129,7 +162,7 @@ void Shadows::CreateDescriptorSetLayouts()
 	/* === ViewProj DESCRIPTOR SET LAYOUT === */
 	std::vector<VkDescriptorSetLayoutBinding> viewProjBindings(1);
 	viewProjBindings[0].binding = 0;
-	viewProjBindings[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	viewProjBindings[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 	viewProjBindings[0].descriptorCount = 1;
 	viewProjBindings[0].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
 
@@ -155,17 +188,19 @@ void Shadows::UpdateDescriptorSets()
 
 	for (int i = 0; i < imageCount; i++)
 	{
-		_viewProjDescriptorSetGroup.UpdateUniformBuffer(
+		_viewProjDescriptorSetGroup.UpdateUniformBufferDynamic(
 			_vulkan, 
 			i,
-			_modelPipeline->_lightViewProjBuffers.Get(i)->Buffer,
-			0
+			_vulkan->_frameAllocator.GetBuffer(),
+			0,
+			sizeof(ViewProj)
 		);
 	}
 
 	/* === UPDATE SHADOW MAP === */
 
-	_vulkan->CreateSampler(&_sampler);
+	// the same state as the textures, so it's their sampler
+	_sampler = _vulkan->AcquireSampler(SamplerDesc());
 
 	for (int i = 0; i < _vulkan->GetSwapchainImageCount(); i++)
 	{
@@ -192,50 +227,118 @@ void Shadows::RecordCommands(Camera camera)
 	renderPassBeginInfo.clearValueCount = 1;
 	renderPassBeginInfo.pClearValues = &clearDepth;
 
-	vkCmdBeginRenderPass(*_vulkan->GetMainCommandBuffer(), &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+	vkCmdBeginRenderPass(*_vulkan->GetMainCommandBuffer(), &renderPassBeginInfo, _vulkan->_commandRecorder.GetSubpassContents());
+
+	if (_modelPipeline->UseGpuCulling)
+	{
+		uint32_t count = _modelPipeline->_frameDataValid ? _modelPipeline->_gpuCulling.GetGroupCount() : 0;
+		_vulkan->_commandRecorder.Record(_shadowRenderPass, count, [this](VkCommandBuffer commandBuffer, uint32_t first, uint32_t last) {
+			RecordCulledGroups(commandBuffer, first, last);
+		});
+	}
+	else
+	{
+		BuildRenderQueue();
+
+		_vulkan->_commandRecorder.Record(_shadowRenderPass, _renderQueue.GetPacketCount(), [this](VkCommandBuffer commandBuffer, uint32_t first, uint32_t last) {
+			_renderQueue.Record(commandBuffer, first, last);
+		});
+	}
+
+	//vkCmdEndRenderPass(*_vulkan->GetMainCommandBuffer());
+}
+
+void Shadows::BuildRenderQueue()
+{
+	_renderQueue.Clear();
+	if (!_modelPipeline->_frameDataValid)
+	{
+		return;
+	}
+
+	uint32_t pipelineId = _renderQueue.GetId(_pipeline);
+
+	DrawPacket packet;
+	packet.Pipeline = _pipeline;
+	packet.PipelineLayout = _pipelineLayout;
+
+	packet.Sets[0].Set = _viewProjDescriptorSetGroup.DescriptorSets[_vulkan->_currentImage];
+	packet.Sets[0].DynamicOffsetCount = 1;
+	packet.Sets[0].DynamicOffsets[0] = _modelPipeline->_lightViewProjOffset;
+
+	for (uint32_t i = 0; i < _modelPipeline->Models.size(); i++)
+	{
+		Model* model = _modelPipeline->Models[i];
+		if (_modelPipeline->_modelOffsets[i] == FrameAllocator::INVALID_OFFSET)
+		{
+			continue;
+		}
+
+		packet.Sets[1].Set = _modelPipeline->_modelDescriptorSetGroup.DescriptorSets[_vulkan->_currentImage];
+		packet.Sets[1].DynamicOffsetCount = 1;
+		packet.Sets[1].DynamicOffsets[0] = _modelPipeline->_modelOffsets[i];
+
+		for (uint32_t j = 0; j < model->Drawables.size(); j++)
+		{
+			MeshMaterial* drawable = model->Drawables[j];
+
+			// skip drawables that are still uploading or outside the light frustum
+			if (!drawable->Mesh->IsReady() || !_modelPipeline->_lightVisibility[_modelPipeline->_drawableOffsets[i] + j])
+			{
+				continue;
+			}
+
+			// only depth is written, so there is no material and no need for depth ordering
+			Mesh* mesh = drawable->Mesh;
+			uint32_t lod = model->GetShadowLod(j);
+			packet.VertexBuffer = mesh->Arena->GetVertexBuffer(mesh->Geometry->Block);
+			packet.IndexBuffer = mesh->Arena->GetIndexBuffer(mesh->Geometry->Block);
+			packet.IndexType = mesh->Arena->GetIndexType();
+			packet.IndexCount = mesh->GetIndexCount(lod);
+			packet.FirstIndex = mesh->GetFirstIndex(lod);
+			packet.VertexOffset = mesh->Geometry->VertexOffset;
+
+			packet.SortKey = RenderQueue::MakeSortKey(0, pipelineId, 0, _renderQueue.GetId(mesh), 0.0f);
+			_renderQueue.Submit(packet);
+		}
+	}
+
+	_renderQueue.Sort();
+}
+
+void Shadows::RecordCulledGroups(VkCommandBuffer commandBuffer, uint32_t first, uint32_t last)
+{
+	GpuCulling* culling = &_modelPipeline->_gpuCulling;
 
-	vkCmdBindPipeline(*_vulkan->GetMainCommandBuffer(), VK_PIPELINE_BIND_POINT_GRAPHICS, _pipeline);
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, _instancedPipeline);
 
 	vkCmdBindDescriptorSets(
-		*_vulkan->GetMainCommandBuffer(),
+		commandBuffer,
 		VK_PIPELINE_BIND_POINT_GRAPHICS,
-		_pipelineLayout,
+		_instancedPipelineLayout,
 		0,
 		1,
 		&_viewProjDescriptorSetGroup.DescriptorSets[_vulkan->_currentImage],
-		0,
-		nullptr
+		1,
+		&_modelPipeline->_lightViewProjOffset
 	);
-	
-	// render models
-	for (int i = 0; i < _modelPipeline->Models.size(); i++)
-	{
-		Model* model = _modelPipeline->Models[i];
 
-		// set model matrix
-		uint32_t offset = _modelPipeline->_modelMatrixAlignment * i;
-		vkCmdBindDescriptorSets(
-			*_vulkan->GetMainCommandBuffer(),
-			VK_PIPELINE_BIND_POINT_GRAPHICS,
-			_pipelineLayout,
-			1,
-			1,
-			&_modelPipeline->_modelDescriptorSetGroup.DescriptorSets[_vulkan->_currentImage],
-			1,
-			&offset
-		);
+	VkDescriptorSet objectsSet = culling->GetObjectsSet();
+	uint32_t objectsOffset = culling->GetObjectsOffset(GpuCulling::LIGHT_PASS);
+	vkCmdBindDescriptorSets(
+		commandBuffer,
+		VK_PIPELINE_BIND_POINT_GRAPHICS,
+		_instancedPipelineLayout,
+		1,
+		1,
+		&objectsSet,
+		1,
+		&objectsOffset
+	);
 
-		// draw model meshes
-		for (int j = 0; j < model->Drawables.size(); j++)
-		{
-			_vulkan->DrawMesh(
-				*_vulkan->GetMainCommandBuffer(),
-				&model->Drawables[j]->Mesh->VertexBuffer,
-				&model->Drawables[j]->Mesh->IndexBuffer,
-				model->Drawables[j]->Mesh->Indices.size()
-			);
-		}
+	uint32_t boundBlock = UINT32_MAX;
+	for (uint32_t group = first; group < last; group++)
+	{
+		culling->DrawGroup(commandBuffer, GpuCulling::LIGHT_PASS, group, &boundBlock);
 	}
-
-	//vkCmdEndRenderPass(*_vulkan->GetMainCommandBuffer());
-}
\ No newline at end of file
+}
@@ -7,6 +7,7 @@
 #include "ModelPipeline.h"
 #include "AnimatedModelPipeline.h"
 #include "Camera.h"
+#include "RenderQueue.h"
 
 #include <vector>
 
@@ -24,6 +25,10 @@ namespace Euler
 			VkPipeline _pipeline;
 			VkPipelineLayout _pipelineLayout;
 
+			// draws the objects of the model pipeline's GPU culling
+			VkPipeline _instancedPipeline = VK_NULL_HANDLE;
+			VkPipelineLayout _instancedPipelineLayout = VK_NULL_HANDLE;
+
 			ModelPipeline* _modelPipeline;
 
 			VkDescriptorSetLayout ViewProjLayout;
@@ -33,7 +38,7 @@ namespace Euler
 			float _viewportHeight;
 
 			std::vector<VkImage> _depthImages;
-			std::vector<VkDeviceMemory> _depthImageMemories;
+			std::vector<MemoryAllocation> _depthImageMemories;
 			std::vector<VkImageView> _depthImageViews;
 
 			std::vector<VkFramebuffer> _framebuffers;
@@ -43,6 +48,8 @@ namespace Euler
 			BufferGroup _viewProjBuffers;
 			DescriptorSetGroup _viewProjDescriptorSetGroup;
 
+			RenderQueue _renderQueue;
+
 		public:
 			AnimatedModelPipeline* AnimatedModelPipeline;
 
@@ -55,6 +62,10 @@ namespace Euler
 			void UpdateDescriptorSets();
 
 			void RecordCommands(Camera camera);
+
+		private:
+			void BuildRenderQueue();
+			void RecordCulledGroups(VkCommandBuffer commandBuffer, uint32_t first, uint32_t last);
 		};
 	}
 }
\ No newline at end of file
@@ -1,73 +1,225 @@
 #include "Texture.h"
+#include "../util/MipChain.h"
+#include "../util/BlockCompression.h"
+#include "../resources/Ktx2.h"
+
+#include <iostream>
+#include <algorithm>
+#include <string.h>
 
 using namespace Euler::Graphics;
 
 bool Texture::DescriptorPoolCreated = false;
 VkDescriptorPool Texture::DescriptorPool = VK_NULL_HANDLE;
+uint32_t Texture::DescriptorSetGroupCount = 0;
+const uint32_t Texture::MAX_DESCRIPTOR_SETS;
 
 void Texture::Create(Vulkan* vulkan, void* pixels, uint32_t width, uint32_t height, size_t size, VkDescriptorSetLayout descriptorSetLayout)
 {
 	_vulkan = vulkan;
 
-	/* === CREATE STAGING BUFFER === */
+	CreateUncompressed(pixels, width, height, size, Srgb ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM);
+	CreateDescriptors(descriptorSetLayout);
+}
 
-	VkBuffer stagingBuffer;
-	VkDeviceMemory stagingMemory;
-	_vulkan->CreateBuffer(
-		size, 
-		VK_BUFFER_USAGE_TRANSFER_SRC_BIT, 
-		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-		stagingBuffer, 
-		stagingMemory
-	);
+void Texture::Create(Vulkan* vulkan, TextureResource* textureResource, VkDescriptorSetLayout descriptorSetLayout)
+{
+	_vulkan = vulkan;
+
+	// partially loaded textures start at their first loaded level
+	uint32_t firstLevel = textureResource->GetFirstLevel();
+	uint32_t width = std::max(textureResource->GetWidth() >> firstLevel, 1u);
+	uint32_t height = std::max(textureResource->GetHeight() >> firstLevel, 1u);
+	TextureFormat format = textureResource->GetFormat();
+	// images loaded at runtime don't know whether they're colors
+	bool image = format == TEXTURE_FORMAT_RGBA8 && textureResource->GetLevelCount() == 1;
+	bool srgb = image ? Srgb : textureResource->IsSrgb();
+
+	if (image)
+	{
+		CreateUncompressed(textureResource->GetData(), width, height, textureResource->GetLevelSize(0), GetVkFormat(format, srgb));
+	}
+	else if (format != TEXTURE_FORMAT_RGBA8 && !_vulkan->_textureCompressionBC)
+	{
+		std::cout << "Texture: block compression isn't supported, decoding on the CPU" << std::endl;
+
+		std::vector<uint8_t> pixels;
+		DecompressBlocks(textureResource->GetLevelData(firstLevel), width, height, format, pixels);
+		CreateUncompressed(pixels.data(), width, height, pixels.size(), GetVkFormat(TEXTURE_FORMAT_RGBA8, srgb));
+	}
+	else
+	{
+		std::vector<ImageLevel> levels(textureResource->GetLevelCount() - firstLevel);
+		for (uint32_t i = 0; i < levels.size(); i++)
+		{
+			levels[i].Data = textureResource->GetLevelData(firstLevel + i);
+			levels[i].Size = textureResource->GetLevelSize(firstLevel + i);
+		}
+
+		CreateImage(GetVkFormat(format, srgb), width, height, levels, levels.size());
+	}
+
+	CreateDescriptors(descriptorSetLayout);
+}
+
+void Texture::Create(Vulkan* vulkan, const char* filePath, VkDescriptorSetLayout descriptorSetLayout)
+{
+	TextureResource textureResource;
+	LoadFile(vulkan, filePath, &textureResource);
+	Create(vulkan, filePath, &textureResource, descriptorSetLayout);
+	textureResource.Unload();
+}
+
+void Texture::Create(Vulkan* vulkan, const char* filePath, TextureResource* textureResource, VkDescriptorSetLayout descriptorSetLayout)
+{
+	Create(vulkan, textureResource, descriptorSetLayout);
+
+	// LoadFile only leaves out levels of streamed textures, textures that fit in the tail have nothing to stream
+	if (textureResource->GetFirstLevel() > 0)
+	{
+		_vulkan->_textureStreamer.Register(this, filePath, textureResource);
+	}
+}
+
+void Texture::LoadFile(Vulkan* vulkan, const char* filePath, TextureResource* textureResource)
+{
+	size_t length = strlen(filePath);
+	bool streamed = vulkan->_textureStreamer.Enabled && length > 5 && strcmp(filePath + length - 5, ".ktx2") == 0;
+	if (streamed)
+	{
+		textureResource->LoadLevels(filePath, TextureStreamer::TAIL_SIZE);
+
+		// blocks the device can't sample are decoded on the CPU from the whole texture
+		streamed = textureResource->GetLevelCount() > 0 && (textureResource->GetFormat() == TEXTURE_FORMAT_RGBA8 || vulkan->_textureCompressionBC);
+	}
+
+	if (!streamed)
+	{
+		textureResource->Load(filePath, TEXTURE_CHANNELS_RGBA);
+	}
+}
+
+void Texture::Destroy()
+{
+	_vulkan->_textureStreamer.Unregister(this);
+
+	if (!DescriptorSetGroup.DescriptorSets.empty())
+	{
+		DescriptorSetGroup.Free(_vulkan);
+		DescriptorSetGroup.DescriptorSets.clear();
+
+		if (--Texture::DescriptorSetGroupCount == 0)
+		{
+			DestroyDescriptorPool();
+		}
+	}
+
+	_vulkan->_uploader.Wait(UploadHandle);
+
+	_vulkan->_bindless.UnregisterTexture(BindlessIndex);
+	BindlessIndex = BindlessTable::INVALID_INDEX;
+
+	_vulkan->ReleaseSampler(_sampler);
+	_vulkan->DestroyImageView(_imageView);
+	_vulkan->DestroyImage(_image, _memory);
+}
+
+bool Texture::IsReady()
+{
+	return UploadHandle.IsReady();
+}
 
-	void* data;
-	vkMapMemory(_vulkan->_device, stagingMemory, 0, size, 0, &data);
-	memcpy(data, pixels, size);
-	vkUnmapMemory(_vulkan->_device, stagingMemory);
+VkDeviceSize Texture::GetMemorySize()
+{
+	return _memory.Size;
+}
+
+void Texture::RequestSize(float screenSize)
+{
+	if (_streamingIndex != TextureStreamer::INVALID_INDEX)
+	{
+		_vulkan->_textureStreamer.RequestSize(this, screenSize);
+	}
+}
+
+void Texture::CreateUncompressed(const void* pixels, uint32_t width, uint32_t height, size_t size, VkFormat format)
+{
+	uint32_t mipLevels = UseMipmaps ? GetMipLevelCount(width, height) : 1;
+
+	std::vector<ImageLevel> levels(1);
+	levels[0].Data = pixels;
+	levels[0].Size = size;
+
+	// the uploader blits the missing levels
+	if (mipLevels == 1 || _vulkan->_uploader.CanGenerateMipLevels(format))
+	{
+		CreateImage(format, width, height, levels, mipLevels);
+		return;
+	}
 
+	std::vector<std::vector<uint8_t>> mipChain;
+	GenerateMipChain((const uint8_t*)pixels, width, height, format == VK_FORMAT_R8G8B8A8_SRGB, mipChain);
+
+	for (const std::vector<uint8_t>& level : mipChain)
+	{
+		ImageLevel imageLevel;
+		imageLevel.Data = level.data();
+		imageLevel.Size = level.size();
+		levels.push_back(imageLevel);
+	}
+
+	CreateImage(format, width, height, levels, mipLevels);
+}
+
+void Texture::CreateImage(VkFormat format, uint32_t width, uint32_t height, const std::vector<ImageLevel>& levels, uint32_t mipLevels)
+{
+	UploadHandle = CreateImageLevels(_vulkan, format, width, height, levels, mipLevels, &_image, &_memory, &_imageView);
+
+	/* === CREATE IMAGE SAMPLER === */
+
+	// shared with every texture using the same sampler state
+	_sampler = _vulkan->AcquireSampler(Sampler);
+}
+
+Euler::Graphics::UploadHandle Texture::CreateImageLevels(Vulkan* vulkan, VkFormat format, uint32_t width, uint32_t height, const std::vector<ImageLevel>& levels, uint32_t mipLevels, VkImage* image, MemoryAllocation* memory, VkImageView* imageView)
+{
 	/* === CREATE IMAGE === */
 
-	_vulkan->CreateImage(
+	vulkan->CreateImage(
 		width,
 		height,
-		VK_FORMAT_R8G8B8A8_SRGB,
+		format,
 		VK_IMAGE_TILING_OPTIMAL,
-		VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+		VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | (levels.size() < mipLevels ? VK_IMAGE_USAGE_TRANSFER_SRC_BIT : 0),
 		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-		_image,
-		_memory
+		*image,
+		*memory,
+		mipLevels
 	);
 
-	/* === COPY STAGING BUFFER TO IMAGE */
+	/* === UPLOAD PIXELS === */
 
-	_vulkan->TransitionImageLayout(
-		_image, 
-		VK_FORMAT_R8G8B8A8_SRGB, 
-		VK_IMAGE_LAYOUT_UNDEFINED, 
-		VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
-	);
-
-	_vulkan->CopyBufferToImage(stagingBuffer, _image, width, height);
-
-	_vulkan->TransitionImageLayout(
-		_image, 
-		VK_FORMAT_R8G8B8A8_SRGB, 
-		VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 
-		VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
-	);
-
-	_vulkan->DestroyBuffer(stagingBuffer, stagingMemory);
+	// the copies, blits and layout transitions run on the upload queue
+	Graphics::UploadHandle uploadHandle = vulkan->_uploader.UploadImageLevels(*image, width, height, levels, mipLevels);
 
 	/* === CREATE IMAGE VIEW === */
 
-	_vulkan->CreateImageView(_image, &_imageView);
+	vulkan->CreateImageView(*image, imageView, mipLevels, format);
 
-	/* === CREATE IMAGE SAMPLER === */
+	return uploadHandle;
+}
 
-	_vulkan->CreateSampler(&_sampler);
+void Texture::CreateDescriptors(VkDescriptorSetLayout descriptorSetLayout)
+{
+	if (_vulkan->_bindless.IsEnabled())
+	{
+		BindlessIndex = _vulkan->_bindless.RegisterTexture(_imageView, _sampler);
+	}
 
-	/* === CREATE DESCRIPTORS === */
+	if (descriptorSetLayout == VK_NULL_HANDLE)
+	{
+		return;
+	}
 
 	if (!Texture::DescriptorPoolCreated)
 	{
@@ -77,6 +229,7 @@ void Texture::Create(Vulkan* vulkan, void* pixels, uint32_t width, uint32_t heig
 
 	uint32_t imageCount = _vulkan->GetSwapchainImageCount();
 	DescriptorSetGroup.Allocate(_vulkan, imageCount, descriptorSetLayout, Texture::DescriptorPool);
+	Texture::DescriptorSetGroupCount++;
 
 	for (int i = 0; i < imageCount; i++)
 	{
@@ -84,32 +237,18 @@ void Texture::Create(Vulkan* vulkan, void* pixels, uint32_t width, uint32_t heig
 	}
 }
 
-void Texture::Create(Vulkan* vulkan, TextureResource* textureResource, VkDescriptorSetLayout descriptorSetLayout)
-{
-	Create(vulkan, textureResource->GetData(), textureResource->GetWidth(), textureResource->GetHeight(), textureResource->GetWidth() * textureResource->GetHeight() * 4, descriptorSetLayout);
-}
-
-void Texture::Destroy()
-{
-	if (Texture::DescriptorPoolCreated)
-	{
-		DestroyDescriptorPool();
-	}
-
-	_vulkan->DestroySampler(_sampler);
-	_vulkan->DestroyImageView(_imageView);
-	_vulkan->DestroyImage(_image, _memory);
-}
-
 void Texture::CreateDescriptorPool()
 {
 	std::vector<VkDescriptorPoolSize> poolSizes(1);
-	poolSizes[0] = { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 50 };
+	poolSizes[0] = { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, MAX_DESCRIPTOR_SETS };
 
-	_vulkan->CreateDescriptorPool(poolSizes, 50, &Texture::DescriptorPool);
+	// the sets are freed one texture at a time
+	_vulkan->CreateDescriptorPool(poolSizes, MAX_DESCRIPTOR_SETS, &Texture::DescriptorPool, VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT);
 }
 
 void Texture::DestroyDescriptorPool()
 {
 	_vulkan->DestroyDescriptorPool(Texture::DescriptorPool);
+	Texture::DescriptorPool = VK_NULL_HANDLE;
+	Texture::DescriptorPoolCreated = false;
 }
\ No newline at end of file
@@ -14,28 +14,72 @@ namespace Euler
 	{
 		class EULER_API Texture
 		{
+			friend class TextureStreamer;
+
 		private:
 			Vulkan* _vulkan;
 
 			VkImage _image;
-			VkDeviceMemory _memory;
+			MemoryAllocation _memory;
 			VkImageView _imageView;
 			VkSampler _sampler;
 
+			// slot in the vulkan's texture streamer, INVALID_INDEX when the texture isn't streamed
+			uint32_t _streamingIndex = TextureStreamer::INVALID_INDEX;
+
+			// shared by all textures, destroyed with the last texture's descriptor sets
 			static bool DescriptorPoolCreated;
 			static VkDescriptorPool DescriptorPool;
+			static uint32_t DescriptorSetGroupCount;
 
 		public:
+			static const uint32_t MAX_DESCRIPTOR_SETS = 1024;
+
 			//std::vector<VkDescriptorSet> DescriptorSets;
 			DescriptorSetGroup DescriptorSetGroup;
 
 			float Shininess;
 
+			// full mip chain, blitted on the upload queue or downsampled on the CPU when the format can't be blitted.
+			// Cooked textures bring their own levels. Set before Create
+			bool UseMipmaps = true;
+			// whether the pixels are sRGB colors, normal maps aren't. Cooked textures know it. Set before Create
+			bool Srgb = true;
+			// filtering and addressing, the sampler comes from the vulkan's sampler cache. Set before Create
+			SamplerDesc Sampler;
+
+			// index in the vulkan's bindless table, INVALID_INDEX when bindless isn't supported
+			uint32_t BindlessIndex = BindlessTable::INVALID_INDEX;
+
+			// becomes ready once the pixels reached the device
+			Graphics::UploadHandle UploadHandle;
+
+			// descriptorSetLayout can be VK_NULL_HANDLE for textures only used through the bindless table
 			void Create(Vulkan* vulkan, void* pixels, uint32_t width, uint32_t height, size_t size, VkDescriptorSetLayout descriptorSetLayout);
+			// cooked textures upload their blocks as they are
 			void Create(Vulkan* vulkan, TextureResource* textureResource, VkDescriptorSetLayout descriptorSetLayout);
+			// loads the file, .ktx2 files are streamed when the vulkan's texture streamer is enabled: only the levels
+			// up to TextureStreamer::TAIL_SIZE are loaded here, the finer ones once RequestSize asks for them
+			void Create(Vulkan* vulkan, const char* filePath, VkDescriptorSetLayout descriptorSetLayout);
+			// the file's textureResource was read with LoadFile, e.g. on a loading thread
+			void Create(Vulkan* vulkan, const char* filePath, TextureResource* textureResource, VkDescriptorSetLayout descriptorSetLayout);
 			void Destroy();
+			bool IsReady();
+			// device memory of the image, changes while the texture streams
+			VkDeviceSize GetMemorySize();
+
+			// reads the file the way Create with a path does, only reads the vulkan's settings so it can run on any thread
+			static void LoadFile(Vulkan* vulkan, const char* filePath, TextureResource* textureResource);
+
+			// the models using the texture cover about screenSize pixels this frame, does nothing for textures that aren't streamed
+			void RequestSize(float screenSize);
 
 		private:
+			void CreateUncompressed(const void* pixels, uint32_t width, uint32_t height, size_t size, VkFormat format);
+			void CreateImage(VkFormat format, uint32_t width, uint32_t height, const std::vector<ImageLevel>& levels, uint32_t mipLevels);
+			// the image and view of CreateImage, also used by the streamer for the images it swaps in
+			static Graphics::UploadHandle CreateImageLevels(Vulkan* vulkan, VkFormat format, uint32_t width, uint32_t height, const std::vector<ImageLevel>& levels, uint32_t mipLevels, VkImage* image, MemoryAllocation* memory, VkImageView* imageView);
+			void CreateDescriptors(VkDescriptorSetLayout descriptorSetLayout);
 			void CreateDescriptorPool();
 			void DestroyDescriptorPool();
 		};
@@ -0,0 +1,222 @@
+#include "BindlessTable.h"
+#include "Vulkan.h"
+
+#include <assert.h>
+#include <string.h>
+
+using namespace Euler::Graphics;
+
+const uint32_t BindlessTable::MAX_TEXTURES;
+const uint32_t BindlessTable::MAX_MATERIALS;
+const uint32_t BindlessTable::INVALID_INDEX;
+
+void BindlessTable::Create(Vulkan* vulkan)
+{
+	_vulkan = vulkan;
+	_enabled = _vulkan->_descriptorIndexing;
+	if (!_enabled)
+	{
+		return;
+	}
+
+	_frameTextureFrees.resize(_vulkan->_framesInFlight);
+	_frameMaterialFrees.resize(_vulkan->_framesInFlight);
+
+	/* === DESCRIPTOR SET LAYOUT === */
+
+	VkDescriptorSetLayoutBinding bindings[2] = {};
+	bindings[0].binding = 0;
+	bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	bindings[0].descriptorCount = MAX_TEXTURES;
+	bindings[0].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+	bindings[1].binding = 1;
+	bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	bindings[1].descriptorCount = 1;
+	bindings[1].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+	// unused texture slots are never read and new ones can be written while the set is in use
+	VkDescriptorBindingFlagsEXT bindingFlags[2] = {
+		VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT,
+		0
+	};
+
+	VkDescriptorSetLayoutBindingFlagsCreateInfoEXT bindingFlagsInfo{};
+	bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT;
+	bindingFlagsInfo.bindingCount = 2;
+	bindingFlagsInfo.pBindingFlags = bindingFlags;
+
+	VkDescriptorSetLayoutCreateInfo layoutCreateInfo{};
+	layoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layoutCreateInfo.pNext = &bindingFlagsInfo;
+	layoutCreateInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT;
+	layoutCreateInfo.bindingCount = 2;
+	layoutCreateInfo.pBindings = bindings;
+
+	vkCreateDescriptorSetLayout(_vulkan->_device, &layoutCreateInfo, nullptr, &Layout);
+
+	/* === DESCRIPTOR POOL AND SET === */
+
+	VkDescriptorPoolSize poolSizes[2];
+	poolSizes[0] = { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, MAX_TEXTURES };
+	poolSizes[1] = { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1 };
+
+	VkDescriptorPoolCreateInfo poolCreateInfo{};
+	poolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolCreateInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT;
+	poolCreateInfo.maxSets = 1;
+	poolCreateInfo.poolSizeCount = 2;
+	poolCreateInfo.pPoolSizes = poolSizes;
+
+	vkCreateDescriptorPool(_vulkan->_device, &poolCreateInfo, nullptr, &_descriptorPool);
+
+	VkDescriptorSetAllocateInfo allocateInfo{};
+	allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocateInfo.descriptorPool = _descriptorPool;
+	allocateInfo.descriptorSetCount = 1;
+	allocateInfo.pSetLayouts = &Layout;
+
+	vkAllocateDescriptorSets(_vulkan->_device, &allocateInfo, &DescriptorSet);
+
+	/* === MATERIALS BUFFER === */
+
+	_vulkan->CreateBuffer(
+		MAX_MATERIALS * sizeof(BindlessMaterial),
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		_materialBuffer,
+		_materialMemory
+	);
+	assert(_materialMemory.MappedData != nullptr);
+
+	VkDescriptorBufferInfo bufferInfo{};
+	bufferInfo.buffer = _materialBuffer;
+	bufferInfo.offset = 0;
+	bufferInfo.range = VK_WHOLE_SIZE;
+
+	VkWriteDescriptorSet write{};
+	write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	write.dstSet = DescriptorSet;
+	write.dstBinding = 1;
+	write.descriptorCount = 1;
+	write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	write.pBufferInfo = &bufferInfo;
+
+	vkUpdateDescriptorSets(_vulkan->_device, 1, &write, 0, nullptr);
+}
+
+void BindlessTable::Destroy()
+{
+	if (!_enabled)
+	{
+		return;
+	}
+
+	_vulkan->DestroyBuffer(_materialBuffer, _materialMemory);
+	vkDestroyDescriptorPool(_vulkan->_device, _descriptorPool, nullptr);
+	vkDestroyDescriptorSetLayout(_vulkan->_device, Layout, nullptr);
+
+	_enabled = false;
+}
+
+bool BindlessTable::IsEnabled() const
+{
+	return _enabled;
+}
+
+uint32_t BindlessTable::RegisterTexture(VkImageView imageView, VkSampler sampler)
+{
+	assert(_enabled);
+
+	uint32_t index;
+	if (!_freeTextures.empty())
+	{
+		index = _freeTextures.back();
+		_freeTextures.pop_back();
+	}
+	else
+	{
+		assert(_textureCount < MAX_TEXTURES);
+		index = _textureCount++;
+	}
+
+	VkDescriptorImageInfo imageInfo{};
+	imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	imageInfo.imageView = imageView;
+	imageInfo.sampler = sampler;
+
+	VkWriteDescriptorSet write{};
+	write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	write.dstSet = DescriptorSet;
+	write.dstBinding = 0;
+	write.dstArrayElement = index;
+	write.descriptorCount = 1;
+	write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	write.pImageInfo = &imageInfo;
+
+	vkUpdateDescriptorSets(_vulkan->_device, 1, &write, 0, nullptr);
+
+	return index;
+}
+
+void BindlessTable::UnregisterTexture(uint32_t index)
+{
+	if (!_enabled || index == INVALID_INDEX)
+	{
+		return;
+	}
+
+	_frameTextureFrees[_vulkan->_currentFrame].push_back(index);
+}
+
+uint32_t BindlessTable::RegisterMaterial(const BindlessMaterial& material)
+{
+	assert(_enabled);
+
+	uint32_t index;
+	if (!_freeMaterials.empty())
+	{
+		index = _freeMaterials.back();
+		_freeMaterials.pop_back();
+	}
+	else
+	{
+		assert(_materialCount < MAX_MATERIALS);
+		index = _materialCount++;
+	}
+
+	UpdateMaterial(index, material);
+
+	return index;
+}
+
+void BindlessTable::UpdateMaterial(uint32_t index, const BindlessMaterial& material)
+{
+	assert(_enabled && index < _materialCount);
+
+	memcpy(static_cast<BindlessMaterial*>(_materialMemory.MappedData) + index, &material, sizeof(BindlessMaterial));
+}
+
+void BindlessTable::UnregisterMaterial(uint32_t index)
+{
+	if (!_enabled || index == INVALID_INDEX)
+	{
+		return;
+	}
+
+	_frameMaterialFrees[_vulkan->_currentFrame].push_back(index);
+}
+
+void BindlessTable::Update(int frame)
+{
+	if (!_enabled)
+	{
+		return;
+	}
+
+	_freeTextures.insert(_freeTextures.end(), _frameTextureFrees[frame].begin(), _frameTextureFrees[frame].end());
+	_frameTextureFrees[frame].clear();
+
+	_freeMaterials.insert(_freeMaterials.end(), _frameMaterialFrees[frame].begin(), _frameMaterialFrees[frame].end());
+	_frameMaterialFrees[frame].clear();
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "../../API.h"
+#include "MemoryAllocator.h"
+
+#include <vulkan/vulkan.h>
+#include <vector>
+
+namespace Euler
+{
+	namespace Graphics
+	{
+		class Vulkan;
+
+		// std430 layout of one element in the materials storage buffer
+		struct EULER_API BindlessMaterial
+		{
+			uint32_t ColorMap;
+			uint32_t NormalMap;
+			uint32_t SpecularMap;
+			float Shininess;
+			float UseNormalMap;
+			float UseSpecularMap;
+			float Padding[2];
+		};
+
+		/// <summary>
+		/// One descriptor set with a big array of all textures (binding 0) and a storage buffer with
+		/// the parameters of all materials (binding 1). Textures and materials register into it and
+		/// the shaders index it with the ids from the per-draw data, so the set is bound once per
+		/// command buffer. Needs VK_EXT_descriptor_indexing, Create does nothing without it.
+		/// </summary>
+		class EULER_API BindlessTable
+		{
+		public:
+			static const uint32_t MAX_TEXTURES = 4096;
+			static const uint32_t MAX_MATERIALS = 4096;
+			static const uint32_t INVALID_INDEX = UINT32_MAX;
+
+		private:
+			Vulkan* _vulkan = nullptr;
+			bool _enabled = false;
+
+			VkDescriptorPool _descriptorPool = VK_NULL_HANDLE;
+
+			VkBuffer _materialBuffer = VK_NULL_HANDLE;
+			MemoryAllocation _materialMemory;
+
+			uint32_t _textureCount = 0;
+			uint32_t _materialCount = 0;
+			std::vector<uint32_t> _freeTextures;
+			std::vector<uint32_t> _freeMaterials;
+			// unregistered ids per frame in flight, reused once the frame's fence is signaled
+			std::vector<std::vector<uint32_t>> _frameTextureFrees;
+			std::vector<std::vector<uint32_t>> _frameMaterialFrees;
+
+		public:
+			VkDescriptorSetLayout Layout = VK_NULL_HANDLE;
+			VkDescriptorSet DescriptorSet = VK_NULL_HANDLE;
+
+			void Create(Vulkan* vulkan);
+			void Destroy();
+			bool IsEnabled() const;
+
+			uint32_t RegisterTexture(VkImageView imageView, VkSampler sampler);
+			void UnregisterTexture(uint32_t index);
+
+			uint32_t RegisterMaterial(const BindlessMaterial& material);
+			// the buffer isn't double buffered, frames in flight may see the new values
+			void UpdateMaterial(uint32_t index, const BindlessMaterial& material);
+			void UnregisterMaterial(uint32_t index);
+
+			// makes the ids unregistered while the given frame was last in flight available again
+			void Update(int frame);
+		};
+	}
+}
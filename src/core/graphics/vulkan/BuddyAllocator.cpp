@@ -0,0 +1,161 @@
+#include "BuddyAllocator.h"
+
+#include <assert.h>
+
+using namespace Euler::Graphics;
+
+const uint64_t BuddyAllocator::INVALID_OFFSET;
+
+void BuddyAllocator::Init(uint64_t size, uint64_t minNodeSize)
+{
+	// both sizes have to be powers of two
+	assert(size > 0 && (size & (size - 1)) == 0);
+	assert(minNodeSize > 0 && (minNodeSize & (minNodeSize - 1)) == 0);
+	assert(minNodeSize <= size);
+
+	_size = size;
+	_minNodeSize = minNodeSize;
+	_usedSize = 0;
+
+	_levelCount = 1;
+	while ((size >> (_levelCount - 1)) > minNodeSize)
+	{
+		_levelCount++;
+	}
+
+	_freeNodes.clear();
+	_freeNodes.resize(_levelCount);
+	_freeNodes[0].insert(0);
+
+	_allocatedNodes.clear();
+}
+
+uint64_t BuddyAllocator::Allocate(uint64_t size, uint64_t alignment)
+{
+	uint64_t nodeSize = GetNodeSize(size, alignment);
+	if (nodeSize > _size)
+	{
+		return INVALID_OFFSET;
+	}
+
+	// find the level that exactly fits the node size
+	uint32_t level = 0;
+	while (GetLevelSize(level) > nodeSize)
+	{
+		level++;
+	}
+
+	// find the closest level (going up) that has a free node
+	int freeLevel = level;
+	while (freeLevel >= 0 && _freeNodes[freeLevel].empty())
+	{
+		freeLevel--;
+	}
+
+	if (freeLevel < 0)
+	{
+		return INVALID_OFFSET;
+	}
+
+	uint64_t offset = *_freeNodes[freeLevel].begin();
+	_freeNodes[freeLevel].erase(_freeNodes[freeLevel].begin());
+
+	// split down to the requested level, keeping the left half and freeing the right one
+	for (uint32_t l = freeLevel + 1; l <= level; l++)
+	{
+		_freeNodes[l].insert(offset + GetLevelSize(l));
+	}
+
+	_allocatedNodes[offset] = level;
+	_usedSize += GetLevelSize(level);
+
+	return offset;
+}
+
+void BuddyAllocator::Free(uint64_t offset)
+{
+	auto it = _allocatedNodes.find(offset);
+	assert(it != _allocatedNodes.end());
+	if (it == _allocatedNodes.end())
+	{
+		return;
+	}
+
+	uint32_t level = it->second;
+	_allocatedNodes.erase(it);
+	_usedSize -= GetLevelSize(level);
+
+	// merge with the buddy while it is free
+	while (level > 0)
+	{
+		uint64_t buddy = offset ^ GetLevelSize(level);
+		auto buddyIt = _freeNodes[level].find(buddy);
+		if (buddyIt == _freeNodes[level].end())
+		{
+			break;
+		}
+
+		_freeNodes[level].erase(buddyIt);
+		offset = offset < buddy ? offset : buddy;
+		level--;
+	}
+
+	_freeNodes[level].insert(offset);
+}
+
+uint64_t BuddyAllocator::GetSize() const
+{
+	return _size;
+}
+
+uint64_t BuddyAllocator::GetUsedSize() const
+{
+	return _usedSize;
+}
+
+uint64_t BuddyAllocator::GetFreeSize() const
+{
+	return _size - _usedSize;
+}
+
+uint64_t BuddyAllocator::GetLargestFreeNode() const
+{
+	for (uint32_t level = 0; level < _levelCount; level++)
+	{
+		if (!_freeNodes[level].empty())
+		{
+			return GetLevelSize(level);
+		}
+	}
+
+	return 0;
+}
+
+uint32_t BuddyAllocator::GetAllocationCount() const
+{
+	return _allocatedNodes.size();
+}
+
+bool BuddyAllocator::IsEmpty() const
+{
+	return _allocatedNodes.empty();
+}
+
+uint64_t BuddyAllocator::GetNodeSize(uint64_t size, uint64_t alignment) const
+{
+	// nodes are aligned to their own size, so a node at least as big as the alignment is enough
+	uint64_t required = size > alignment ? size : alignment;
+
+	uint64_t nodeSize = _minNodeSize;
+	while (nodeSize < required)
+	{
+		nodeSize <<= 1;
+	}
+
+	return nodeSize;
+}
+
+uint64_t BuddyAllocator::GetLevelSize(uint32_t level) const
+{
+	return _size >> level;
+}
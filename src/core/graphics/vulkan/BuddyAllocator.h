@@ -0,0 +1,56 @@
+#pragma once
+
+#include "../../API.h"
+
+#include <stdint.h>
+#include <vector>
+#include <set>
+#include <unordered_map>
+
+namespace Euler
+{
+	namespace Graphics
+	{
+		/// <summary>
+		/// Power-of-two buddy placement inside a single memory block. Only tracks offsets,
+		/// the owner is responsible for the actual memory.
+		/// </summary>
+		class EULER_API BuddyAllocator
+		{
+		public:
+			static const uint64_t INVALID_OFFSET = UINT64_MAX;
+
+		private:
+			uint64_t _size = 0;
+			uint64_t _minNodeSize = 0;
+			uint32_t _levelCount = 0;
+
+			// free node offsets per level, level 0 is the whole block
+			std::vector<std::set<uint64_t>> _freeNodes;
+			// allocated node offset -> level
+			std::unordered_map<uint64_t, uint32_t> _allocatedNodes;
+
+			uint64_t _usedSize = 0;
+
+		public:
+			void Init(uint64_t size, uint64_t minNodeSize);
+
+			// returns INVALID_OFFSET if there is no free node big enough
+			uint64_t Allocate(uint64_t size, uint64_t alignment);
+			void Free(uint64_t offset);
+
+			uint64_t GetSize() const;
+			uint64_t GetUsedSize() const;
+			uint64_t GetFreeSize() const;
+			uint64_t GetLargestFreeNode() const;
+			uint32_t GetAllocationCount() const;
+			bool IsEmpty() const;
+
+			// rounded size that an allocation of the given size and alignment will occupy
+			uint64_t GetNodeSize(uint64_t size, uint64_t alignment) const;
+
+		private:
+			uint64_t GetLevelSize(uint32_t level) const;
+		};
+	}
+}
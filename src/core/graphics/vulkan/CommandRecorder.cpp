@@ -0,0 +1,224 @@
+#include "CommandRecorder.h"
+#include "Vulkan.h"
+
+#include <assert.h>
+#include <chrono>
+
+using namespace Euler::Graphics;
+
+void CommandRecorder::Create(Vulkan* vulkan, uint32_t workerCount, uint32_t frameCount)
+{
+	_vulkan = vulkan;
+	_workerCount = workerCount;
+	_frameCount = frameCount;
+	_frame = 0;
+	_stop = false;
+	_pendingJobs = 0;
+
+	_workerFrames.resize(_workerCount);
+	for (uint32_t i = 0; i < _workerCount; i++)
+	{
+		_workerFrames[i].resize(_frameCount);
+		for (uint32_t j = 0; j < _frameCount; j++)
+		{
+			VkCommandPoolCreateInfo createInfo{};
+			createInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+			createInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+			createInfo.queueFamilyIndex = _vulkan->_graphicsQueueFamilyIndex;
+
+			VkResult result = vkCreateCommandPool(_vulkan->_device, &createInfo, nullptr, &_workerFrames[i][j].CommandPool);
+			assert(result == VK_SUCCESS);
+		}
+	}
+
+	_jobs.resize(_workerCount);
+	for (uint32_t i = 0; i < _workerCount; i++)
+	{
+		_workers.push_back(std::thread(&CommandRecorder::WorkerLoop, this, i));
+	}
+}
+
+void CommandRecorder::Destroy()
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stop = true;
+	}
+	_jobCondition.notify_all();
+
+	for (auto& worker : _workers)
+	{
+		worker.join();
+	}
+	_workers.clear();
+	_jobs.clear();
+
+	for (auto& frames : _workerFrames)
+	{
+		for (auto& frame : frames)
+		{
+			// destroying the pool frees its command buffers
+			vkDestroyCommandPool(_vulkan->_device, frame.CommandPool, nullptr);
+		}
+	}
+	_workerFrames.clear();
+}
+
+void CommandRecorder::SetWorkerCount(uint32_t workerCount)
+{
+	if (workerCount == _workerCount)
+	{
+		return;
+	}
+
+	vkDeviceWaitIdle(_vulkan->_device);
+
+	int frame = _frame;
+	Destroy();
+	Create(_vulkan, workerCount, _frameCount);
+	_frame = frame;
+}
+
+uint32_t CommandRecorder::GetWorkerCount() const
+{
+	return _workerCount;
+}
+
+void CommandRecorder::BeginFrame(int frame)
+{
+	_frame = frame;
+
+	for (auto& frames : _workerFrames)
+	{
+		WorkerFrame& workerFrame = frames[_frame];
+		if (workerFrame.UsedCommandBuffers > 0)
+		{
+			vkResetCommandPool(_vulkan->_device, workerFrame.CommandPool, 0);
+			workerFrame.UsedCommandBuffers = 0;
+		}
+	}
+
+	_frameRecordingTime = 0.0;
+}
+
+VkSubpassContents CommandRecorder::GetSubpassContents() const
+{
+	return _workerCount > 0 ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE;
+}
+
+void CommandRecorder::Record(VkRenderPass renderPass, uint32_t itemCount, const RecordFunction& record)
+{
+	auto startTime = std::chrono::high_resolution_clock::now();
+
+	if (_workerCount == 0)
+	{
+		record(*_vulkan->GetMainCommandBuffer(), 0, itemCount);
+	}
+	else if (itemCount > 0)
+	{
+		uint32_t sliceCount = itemCount < _workerCount ? itemCount : _workerCount;
+		uint32_t sliceSize = (itemCount + sliceCount - 1) / sliceCount;
+
+		std::vector<VkCommandBuffer> commandBuffers;
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+
+			for (uint32_t i = 0; i < sliceCount; i++)
+			{
+				uint32_t first = i * sliceSize;
+				uint32_t last = first + sliceSize < itemCount ? first + sliceSize : itemCount;
+				if (first >= last)
+				{
+					break;
+				}
+
+				Job& job = _jobs[i];
+				job.Function = &record;
+				job.CommandBuffer = AcquireCommandBuffer(i);
+				job.RenderPass = renderPass;
+				job.First = first;
+				job.Last = last;
+				job.Pending = true;
+
+				commandBuffers.push_back(job.CommandBuffer);
+				_pendingJobs++;
+			}
+		}
+		_jobCondition.notify_all();
+
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_doneCondition.wait(lock, [this] { return _pendingJobs == 0; });
+		}
+
+		vkCmdExecuteCommands(*_vulkan->GetMainCommandBuffer(), commandBuffers.size(), commandBuffers.data());
+	}
+
+	_frameRecordingTime += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+}
+
+double CommandRecorder::GetFrameRecordingTime() const
+{
+	return _frameRecordingTime;
+}
+
+VkCommandBuffer CommandRecorder::AcquireCommandBuffer(uint32_t worker)
+{
+	WorkerFrame& workerFrame = _workerFrames[worker][_frame];
+
+	if (workerFrame.UsedCommandBuffers == workerFrame.CommandBuffers.size())
+	{
+		VkCommandBufferAllocateInfo allocateInfo{};
+		allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+		allocateInfo.commandPool = workerFrame.CommandPool;
+		allocateInfo.commandBufferCount = 1;
+
+		VkCommandBuffer commandBuffer;
+		VkResult result = vkAllocateCommandBuffers(_vulkan->_device, &allocateInfo, &commandBuffer);
+		assert(result == VK_SUCCESS);
+
+		workerFrame.CommandBuffers.push_back(commandBuffer);
+	}
+
+	return workerFrame.CommandBuffers[workerFrame.UsedCommandBuffers++];
+}
+
+void CommandRecorder::WorkerLoop(uint32_t worker)
+{
+	while (true)
+	{
+		Job job;
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_jobCondition.wait(lock, [this, worker] { return _stop || _jobs[worker].Pending; });
+			if (_stop)
+			{
+				return;
+			}
+			job = _jobs[worker];
+		}
+
+		VkCommandBufferInheritanceInfo inheritanceInfo{};
+		inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+		inheritanceInfo.renderPass = job.RenderPass;
+		inheritanceInfo.subpass = 0;
+		inheritanceInfo.framebuffer = VK_NULL_HANDLE;
+
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+		vkBeginCommandBuffer(job.CommandBuffer, &beginInfo);
+		(*job.Function)(job.CommandBuffer, job.First, job.Last);
+		vkEndCommandBuffer(job.CommandBuffer);
+
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_jobs[worker].Pending = false;
+			_pendingJobs--;
+		}
+		_doneCondition.notify_one();
+	}
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "../../API.h"
+
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace Euler
+{
+	namespace Graphics
+	{
+		class Vulkan;
+
+		/// <summary>
+		/// Records draw commands on worker threads. Record splits a range of items (usually models) into
+		/// one slice per worker, every worker records its slice into a secondary command buffer from its own
+		/// command pool for the current frame in flight and the secondary buffers are executed from the main
+		/// command buffer in slice order. With 0 workers everything is recorded inline into the main command
+		/// buffer. Record must only be called from the render thread.
+		/// </summary>
+		class EULER_API CommandRecorder
+		{
+		public:
+			// records items [first, last) into the command buffer
+			typedef std::function<void(VkCommandBuffer commandBuffer, uint32_t first, uint32_t last)> RecordFunction;
+
+		private:
+			struct Job
+			{
+				const RecordFunction* Function = nullptr;
+				VkCommandBuffer CommandBuffer = VK_NULL_HANDLE;
+				VkRenderPass RenderPass = VK_NULL_HANDLE;
+				uint32_t First = 0;
+				uint32_t Last = 0;
+				bool Pending = false;
+			};
+
+			struct WorkerFrame
+			{
+				VkCommandPool CommandPool = VK_NULL_HANDLE;
+				std::vector<VkCommandBuffer> CommandBuffers;
+				uint32_t UsedCommandBuffers = 0;
+			};
+
+			Vulkan* _vulkan = nullptr;
+			uint32_t _workerCount = 0;
+			uint32_t _frameCount = 0;
+			int _frame = 0;
+
+			// indexed by [worker][frame]
+			std::vector<std::vector<WorkerFrame>> _workerFrames;
+
+			std::vector<std::thread> _workers;
+			std::vector<Job> _jobs;
+			uint32_t _pendingJobs = 0;
+			bool _stop = false;
+			std::mutex _mutex;
+			std::condition_variable _jobCondition;
+			std::condition_variable _doneCondition;
+
+			double _frameRecordingTime = 0.0;
+
+		public:
+			void Create(Vulkan* vulkan, uint32_t workerCount, uint32_t frameCount);
+			void Destroy();
+
+			// waits for the device to be idle and recreates the workers
+			void SetWorkerCount(uint32_t workerCount);
+			uint32_t GetWorkerCount() const;
+
+			// resets the command pools of the frame, the frame's fence must have been waited on
+			void BeginFrame(int frame);
+
+			// contents to begin render passes with, secondary command buffers can't be mixed with inline commands
+			VkSubpassContents GetSubpassContents() const;
+
+			// records itemCount items inside the current subpass of renderPass
+			void Record(VkRenderPass renderPass, uint32_t itemCount, const RecordFunction& record);
+
+			// milliseconds the render thread spent in Record since the frame began
+			double GetFrameRecordingTime() const;
+
+		private:
+			VkCommandBuffer AcquireCommandBuffer(uint32_t worker);
+			void WorkerLoop(uint32_t worker);
+		};
+	}
+}
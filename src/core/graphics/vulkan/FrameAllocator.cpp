@@ -0,0 +1,108 @@
+#include "FrameAllocator.h"
+#include "Vulkan.h"
+
+#include <assert.h>
+#include <string.h>
+#include <iostream>
+
+using namespace Euler::Graphics;
+
+const VkDeviceSize FrameAllocator::DEFAULT_FRAME_SIZE;
+const uint32_t FrameAllocator::INVALID_OFFSET;
+
+void FrameAllocator::Create(Vulkan* vulkan, uint32_t frameCount, VkDeviceSize frameSize)
+{
+	_vulkan = vulkan;
+
+	// every allocation has to be usable as a dynamic uniform or storage buffer offset
+	VkPhysicalDeviceLimits& limits = _vulkan->GetPhysicalDevice()->Properties.limits;
+	_alignment = limits.minUniformBufferOffsetAlignment > limits.minStorageBufferOffsetAlignment ? limits.minUniformBufferOffsetAlignment : limits.minStorageBufferOffsetAlignment;
+	_frameSize = (frameSize + _alignment - 1) & ~(_alignment - 1);
+
+	// the last part is padding, a dynamic offset plus the descriptor's range must not pass the end of the buffer
+	_vulkan->CreateBuffer(
+		_frameSize * (frameCount + 1),
+		VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		_buffer,
+		_memory
+	);
+	assert(_memory.MappedData != nullptr);
+
+	_frameStart = 0;
+	_head = 0;
+}
+
+void FrameAllocator::Destroy()
+{
+	_vulkan->DestroyBuffer(_buffer, _memory);
+}
+
+void FrameAllocator::BeginFrame(int frame)
+{
+	if (_overflowSize > 0)
+	{
+		std::cout << "FrameAllocator: the frame needed " << (GetUsedSize() + _overflowSize) << " bytes but only has " << _frameSize
+			<< ", the data that didn't fit wasn't drawn. Raise App::FrameMemory" << std::endl;
+		_overflowSize = 0;
+	}
+
+	_frameStart = _frameSize * frame;
+	_head = _frameStart;
+	_frameNumber++;
+}
+
+FrameAllocation FrameAllocator::Allocate(VkDeviceSize size)
+{
+	FrameAllocation allocation;
+
+	VkDeviceSize offset = (_head + _alignment - 1) & ~(_alignment - 1);
+	if (offset + size > _frameStart + _frameSize)
+	{
+		// reported once the frame is over, with everything it would have needed
+		_overflowSize += size;
+		return allocation;
+	}
+
+	_head = offset + size;
+
+	allocation.Data = (char*)_memory.MappedData + offset;
+	allocation.Offset = (uint32_t)offset;
+	return allocation;
+}
+
+uint32_t FrameAllocator::Push(const void* data, VkDeviceSize size)
+{
+	FrameAllocation allocation = Allocate(size);
+	if (allocation.Data != nullptr)
+	{
+		memcpy(allocation.Data, data, size);
+	}
+
+	return allocation.Offset;
+}
+
+VkBuffer FrameAllocator::GetBuffer()
+{
+	return _buffer;
+}
+
+VkDeviceSize FrameAllocator::GetAlignment()
+{
+	return _alignment;
+}
+
+VkDeviceSize FrameAllocator::GetUsedSize()
+{
+	return _head - _frameStart;
+}
+
+VkDeviceSize FrameAllocator::GetFrameSize()
+{
+	return _frameSize;
+}
+
+uint64_t FrameAllocator::GetFrameNumber()
+{
+	return _frameNumber;
+}
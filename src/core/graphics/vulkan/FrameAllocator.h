@@ -0,0 +1,69 @@
+#pragma once
+
+#include "../../API.h"
+#include "MemoryAllocator.h"
+
+#include <vulkan/vulkan.h>
+
+namespace Euler
+{
+	namespace Graphics
+	{
+		class Vulkan;
+
+		struct EULER_API FrameAllocation
+		{
+			void* Data = nullptr;
+			uint32_t Offset = UINT32_MAX;		// offset in the frame allocator buffer, used as the dynamic offset
+		};
+
+		/// <summary>
+		/// Persistently mapped buffer for transient uniform and storage data. The buffer is split into
+		/// one part per frame in flight and every allocation is a pointer bump in the current frame's part,
+		/// so per-frame data can be written without any driver calls. Allocations are only valid until
+		/// the same frame slot comes around again. When a frame's part is used up allocations fail with
+		/// INVALID_OFFSET and the frame reports it once, whatever needed them has to be skipped.
+		/// The buffer ends with one more frame size, so dynamic descriptors with a range up to GetFrameSize()
+		/// stay inside it at any offset.
+		/// </summary>
+		class EULER_API FrameAllocator
+		{
+		public:
+			static const VkDeviceSize DEFAULT_FRAME_SIZE = 4 * 1024 * 1024;
+			static const uint32_t INVALID_OFFSET = UINT32_MAX;
+
+		private:
+			Vulkan* _vulkan = nullptr;
+
+			VkBuffer _buffer = VK_NULL_HANDLE;
+			MemoryAllocation _memory;
+
+			VkDeviceSize _frameSize = 0;
+			VkDeviceSize _alignment = 0;
+			VkDeviceSize _frameStart = 0;
+			VkDeviceSize _head = 0;
+
+			uint64_t _frameNumber = 0;
+			// bytes the allocations that didn't fit this frame asked for
+			VkDeviceSize _overflowSize = 0;
+
+		public:
+			void Create(Vulkan* vulkan, uint32_t frameCount, VkDeviceSize frameSize = DEFAULT_FRAME_SIZE);
+			void Destroy();
+
+			// resets the given frame's part, must be called after the frame's fence was waited on
+			void BeginFrame(int frame);
+
+			// Data is nullptr and Offset INVALID_OFFSET when the frame's part is full
+			FrameAllocation Allocate(VkDeviceSize size);
+			// copies the data and returns its offset, INVALID_OFFSET when the frame's part is full
+			uint32_t Push(const void* data, VkDeviceSize size);
+
+			VkBuffer GetBuffer();
+			VkDeviceSize GetAlignment();
+			VkDeviceSize GetUsedSize();
+			VkDeviceSize GetFrameSize();
+			uint64_t GetFrameNumber();
+		};
+	}
+}
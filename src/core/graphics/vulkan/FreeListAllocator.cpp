@@ -0,0 +1,113 @@
+#include "FreeListAllocator.h"
+
+#include <assert.h>
+#include <iterator>
+
+using namespace Euler::Graphics;
+
+const uint64_t FreeListAllocator::INVALID_OFFSET;
+
+void FreeListAllocator::Init(uint64_t size)
+{
+	_size = size;
+	_usedSize = 0;
+
+	_freeRanges.clear();
+	if (size > 0)
+	{
+		_freeRanges[0] = size;
+	}
+}
+
+uint64_t FreeListAllocator::Allocate(uint64_t size)
+{
+	if (size == 0)
+	{
+		return INVALID_OFFSET;
+	}
+
+	for (auto it = _freeRanges.begin(); it != _freeRanges.end(); it++)
+	{
+		if (it->second < size)
+		{
+			continue;
+		}
+
+		uint64_t offset = it->first;
+		uint64_t remaining = it->second - size;
+		_freeRanges.erase(it);
+
+		if (remaining > 0)
+		{
+			_freeRanges[offset + size] = remaining;
+		}
+
+		_usedSize += size;
+		return offset;
+	}
+
+	return INVALID_OFFSET;
+}
+
+void FreeListAllocator::Free(uint64_t offset, uint64_t size)
+{
+	assert(size > 0 && offset + size <= _size);
+
+	_usedSize -= size;
+
+	// merge with the next range
+	auto next = _freeRanges.lower_bound(offset);
+	assert(next == _freeRanges.end() || next->first >= offset + size);
+	if (next != _freeRanges.end() && next->first == offset + size)
+	{
+		size += next->second;
+		next = _freeRanges.erase(next);
+	}
+
+	// merge with the previous range
+	if (next != _freeRanges.begin())
+	{
+		auto previous = std::prev(next);
+		assert(previous->first + previous->second <= offset);
+		if (previous->first + previous->second == offset)
+		{
+			previous->second += size;
+			return;
+		}
+	}
+
+	_freeRanges[offset] = size;
+}
+
+uint64_t FreeListAllocator::GetSize() const
+{
+	return _size;
+}
+
+uint64_t FreeListAllocator::GetUsedSize() const
+{
+	return _usedSize;
+}
+
+uint64_t FreeListAllocator::GetFreeSize() const
+{
+	return _size - _usedSize;
+}
+
+uint64_t FreeListAllocator::GetLargestFreeRange() const
+{
+	uint64_t largest = 0;
+	for (auto& range : _freeRanges)
+	{
+		if (range.second > largest)
+		{
+			largest = range.second;
+		}
+	}
+	return largest;
+}
+
+uint32_t FreeListAllocator::GetFreeRangeCount() const
+{
+	return _freeRanges.size();
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "../../API.h"
+
+#include <stdint.h>
+#include <map>
+
+namespace Euler
+{
+	namespace Graphics
+	{
+		/// <summary>
+		/// First-fit range allocator that merges neighbouring free ranges. Works in whatever unit the
+		/// owner uses (bytes, vertices, indices) and only tracks offsets.
+		/// </summary>
+		class EULER_API FreeListAllocator
+		{
+		public:
+			static const uint64_t INVALID_OFFSET = UINT64_MAX;
+
+		private:
+			uint64_t _size = 0;
+			uint64_t _usedSize = 0;
+
+			// free range offset -> size
+			std::map<uint64_t, uint64_t> _freeRanges;
+
+		public:
+			void Init(uint64_t size);
+
+			// returns INVALID_OFFSET if there is no free range big enough
+			uint64_t Allocate(uint64_t size);
+			void Free(uint64_t offset, uint64_t size);
+
+			uint64_t GetSize() const;
+			uint64_t GetUsedSize() const;
+			uint64_t GetFreeSize() const;
+			uint64_t GetLargestFreeRange() const;
+			uint32_t GetFreeRangeCount() const;
+		};
+	}
+}
@@ -0,0 +1,355 @@
+#include "GeometryArena.h"
+#include "Vulkan.h"
+
+#include <assert.h>
+#include <algorithm>
+
+using namespace Euler::Graphics;
+
+const uint32_t GeometryArena::DEFAULT_VERTEX_CAPACITY;
+const uint32_t GeometryArena::DEFAULT_INDEX_CAPACITY;
+const uint32_t GeometryArena::COMPACT_THRESHOLD_PERCENT;
+
+void GeometryArena::Create(Vulkan* vulkan, uint32_t id, uint32_t vertexStride, VkIndexType indexType, uint32_t vertexCapacity, uint32_t indexCapacity)
+{
+	_vulkan = vulkan;
+	_id = id;
+	_vertexStride = vertexStride;
+	_indexType = indexType;
+	_indexSize = indexType == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t);
+	_vertexCapacity = vertexCapacity;
+	_indexCapacity = indexCapacity;
+
+	_frameFrees.resize(_vulkan->_framesInFlight);
+}
+
+void GeometryArena::Destroy()
+{
+	for (auto& block : _blocks)
+	{
+		DestroyBlock(block);
+	}
+	_blocks.clear();
+
+	for (auto allocation : _allocations)
+	{
+		delete allocation;
+	}
+	_allocations.clear();
+
+	for (auto& frees : _frameFrees)
+	{
+		for (auto allocation : frees)
+		{
+			delete allocation;
+		}
+		frees.clear();
+	}
+}
+
+GeometryAllocation* GeometryArena::Allocate(const void* vertices, uint32_t vertexCount, const void* indices, uint32_t indexCount, UploadHandle* uploadHandle)
+{
+	assert(vertexCount > 0 && indexCount > 0);
+
+	GeometryAllocation* allocation = new GeometryAllocation();
+	allocation->VertexCount = vertexCount;
+	allocation->IndexCount = indexCount;
+
+	for (uint32_t i = 0; i < _blocks.size() && allocation->Block == UINT32_MAX; i++)
+	{
+		uint64_t vertexOffset = _blocks[i].Vertices.Allocate(vertexCount);
+		if (vertexOffset == FreeListAllocator::INVALID_OFFSET)
+		{
+			continue;
+		}
+
+		uint64_t firstIndex = _blocks[i].Indices.Allocate(indexCount);
+		if (firstIndex == FreeListAllocator::INVALID_OFFSET)
+		{
+			_blocks[i].Vertices.Free(vertexOffset, vertexCount);
+			continue;
+		}
+
+		allocation->Block = i;
+		allocation->VertexOffset = vertexOffset;
+		allocation->FirstIndex = firstIndex;
+	}
+
+	// no room left, meshes bigger than the default capacity get a block of their own size
+	if (allocation->Block == UINT32_MAX)
+	{
+		CreateBlock(std::max(vertexCount, _vertexCapacity), std::max(indexCount, _indexCapacity));
+
+		allocation->Block = _blocks.size() - 1;
+		allocation->VertexOffset = _blocks.back().Vertices.Allocate(vertexCount);
+		allocation->FirstIndex = _blocks.back().Indices.Allocate(indexCount);
+	}
+
+	_allocations.push_back(allocation);
+
+	// both copies go in the same batch, so the index handle covers the vertices too
+	Block& block = _blocks[allocation->Block];
+	_vulkan->_uploader.UploadBuffer(block.VertexBuffer, (VkDeviceSize)allocation->VertexOffset * _vertexStride, vertices, (VkDeviceSize)vertexCount * _vertexStride);
+	*uploadHandle = _vulkan->_uploader.UploadBuffer(block.IndexBuffer, (VkDeviceSize)allocation->FirstIndex * _indexSize, indices, (VkDeviceSize)indexCount * _indexSize);
+
+	return allocation;
+}
+
+void GeometryArena::Free(GeometryAllocation* allocation)
+{
+	if (allocation == nullptr)
+	{
+		return;
+	}
+
+	auto it = std::find(_allocations.begin(), _allocations.end(), allocation);
+	assert(it != _allocations.end());
+	_allocations.erase(it);
+
+	// frames in flight may still draw from the ranges
+	_frameFrees[_vulkan->_currentFrame].push_back(allocation);
+}
+
+void GeometryArena::Update(int frame)
+{
+	for (auto allocation : _frameFrees[frame])
+	{
+		Release(allocation);
+	}
+	_frameFrees[frame].clear();
+}
+
+void GeometryArena::Compact()
+{
+	WaitForCompaction();
+
+	bool moved = false;
+	for (uint32_t i = 0; i < _blocks.size(); i++)
+	{
+		if (_blocks[i].Vertices.GetFreeRangeCount() > 1 || _blocks[i].Indices.GetFreeRangeCount() > 1)
+		{
+			moved = CompactBlock(i) || moved;
+		}
+	}
+
+	// anything that kept the old offsets, like the GPU culling objects, has to read them again
+	if (moved)
+	{
+		_vulkan->_geometryVersion++;
+	}
+}
+
+bool GeometryArena::CompactFragmentedBlock()
+{
+	for (uint32_t i = 0; i < _blocks.size(); i++)
+	{
+		if (IsFragmented(_blocks[i].Vertices) || IsFragmented(_blocks[i].Indices))
+		{
+			WaitForCompaction();
+			if (CompactBlock(i))
+			{
+				_vulkan->_geometryVersion++;
+			}
+			return true;
+		}
+	}
+	return false;
+}
+
+bool GeometryArena::IsFragmented() const
+{
+	for (auto& block : _blocks)
+	{
+		if (IsFragmented(block.Vertices) || IsFragmented(block.Indices))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void GeometryArena::Bind(VkCommandBuffer commandBuffer, const GeometryAllocation* allocation, uint32_t* boundBlock)
+{
+	// the arena id in the high bits, so blocks of other arenas don't count as bound
+	uint32_t bindKey = (_id << 16) | allocation->Block;
+	if (*boundBlock == bindKey)
+	{
+		return;
+	}
+
+	const Block& block = _blocks[allocation->Block];
+
+	VkBuffer buffers[] = { block.VertexBuffer };
+	VkDeviceSize offsets[] = { 0 };
+	vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
+	vkCmdBindIndexBuffer(commandBuffer, block.IndexBuffer, 0, _indexType);
+
+	*boundBlock = bindKey;
+}
+
+void GeometryArena::Draw(VkCommandBuffer commandBuffer, const GeometryAllocation* allocation, uint32_t instanceCount, uint32_t firstInstance)
+{
+	vkCmdDrawIndexed(commandBuffer, allocation->IndexCount, instanceCount, allocation->FirstIndex, allocation->VertexOffset, firstInstance);
+}
+
+uint32_t GeometryArena::GetVertexStride() const
+{
+	return _vertexStride;
+}
+
+VkIndexType GeometryArena::GetIndexType() const
+{
+	return _indexType;
+}
+
+uint32_t GeometryArena::GetBlockCount() const
+{
+	return _blocks.size();
+}
+
+VkBuffer GeometryArena::GetVertexBuffer(uint32_t block) const
+{
+	return _blocks[block].VertexBuffer;
+}
+
+VkBuffer GeometryArena::GetIndexBuffer(uint32_t block) const
+{
+	return _blocks[block].IndexBuffer;
+}
+
+void GeometryArena::CreateBlock(uint32_t vertexCapacity, uint32_t indexCapacity)
+{
+	Block block;
+	block.Vertices.Init(vertexCapacity);
+	block.Indices.Init(indexCapacity);
+
+	// transfer src so the block can be copied when compacting
+	_vulkan->CreateBuffer(
+		(VkDeviceSize)vertexCapacity * _vertexStride,
+		VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		block.VertexBuffer,
+		block.VertexMemory
+	);
+	_vulkan->CreateBuffer(
+		(VkDeviceSize)indexCapacity * _indexSize,
+		VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		block.IndexBuffer,
+		block.IndexMemory
+	);
+
+	_blocks.push_back(block);
+}
+
+void GeometryArena::DestroyBlock(Block& block)
+{
+	_vulkan->DestroyBuffer(block.VertexBuffer, block.VertexMemory);
+	_vulkan->DestroyBuffer(block.IndexBuffer, block.IndexMemory);
+}
+
+void GeometryArena::Release(GeometryAllocation* allocation)
+{
+	Block& block = _blocks[allocation->Block];
+	block.Vertices.Free(allocation->VertexOffset, allocation->VertexCount);
+	block.Indices.Free(allocation->FirstIndex, allocation->IndexCount);
+
+	delete allocation;
+}
+
+void GeometryArena::WaitForCompaction()
+{
+	_vulkan->_uploader.WaitIdle();
+	vkDeviceWaitIdle(_vulkan->_device);
+
+	// nothing draws from the freed ranges anymore
+	for (uint32_t i = 0; i < _frameFrees.size(); i++)
+	{
+		Update(i);
+	}
+}
+
+bool GeometryArena::CompactBlock(uint32_t index)
+{
+	Block& block = _blocks[index];
+
+	// allocations in the block ordered by vertex offset, packed from the start of new buffers
+	std::vector<GeometryAllocation*> allocations;
+	for (auto allocation : _allocations)
+	{
+		if (allocation->Block == index)
+		{
+			allocations.push_back(allocation);
+		}
+	}
+	std::sort(allocations.begin(), allocations.end(), [](GeometryAllocation* a, GeometryAllocation* b) {
+		return a->VertexOffset < b->VertexOffset;
+	});
+
+	Block compacted;
+	compacted.Vertices.Init(block.Vertices.GetSize());
+	compacted.Indices.Init(block.Indices.GetSize());
+
+	_vulkan->CreateBuffer(
+		block.Vertices.GetSize() * _vertexStride,
+		VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		compacted.VertexBuffer,
+		compacted.VertexMemory
+	);
+	_vulkan->CreateBuffer(
+		block.Indices.GetSize() * _indexSize,
+		VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		compacted.IndexBuffer,
+		compacted.IndexMemory
+	);
+
+	std::vector<VkBufferCopy> vertexCopies;
+	std::vector<VkBufferCopy> indexCopies;
+	bool moved = false;
+	for (auto allocation : allocations)
+	{
+		uint32_t vertexOffset = compacted.Vertices.Allocate(allocation->VertexCount);
+		uint32_t firstIndex = compacted.Indices.Allocate(allocation->IndexCount);
+
+		VkBufferCopy vertexCopy{};
+		vertexCopy.srcOffset = (VkDeviceSize)allocation->VertexOffset * _vertexStride;
+		vertexCopy.dstOffset = (VkDeviceSize)vertexOffset * _vertexStride;
+		vertexCopy.size = (VkDeviceSize)allocation->VertexCount * _vertexStride;
+		vertexCopies.push_back(vertexCopy);
+
+		VkBufferCopy indexCopy{};
+		indexCopy.srcOffset = (VkDeviceSize)allocation->FirstIndex * _indexSize;
+		indexCopy.dstOffset = (VkDeviceSize)firstIndex * _indexSize;
+		indexCopy.size = (VkDeviceSize)allocation->IndexCount * _indexSize;
+		indexCopies.push_back(indexCopy);
+
+		moved = moved || allocation->VertexOffset != vertexOffset || allocation->FirstIndex != firstIndex;
+		allocation->VertexOffset = vertexOffset;
+		allocation->FirstIndex = firstIndex;
+	}
+
+	if (!allocations.empty())
+	{
+		VkCommandBuffer commandBuffer = _vulkan->BeginSingleUseCommandBuffer();
+		vkCmdCopyBuffer(commandBuffer, block.VertexBuffer, compacted.VertexBuffer, vertexCopies.size(), vertexCopies.data());
+		vkCmdCopyBuffer(commandBuffer, block.IndexBuffer, compacted.IndexBuffer, indexCopies.size(), indexCopies.data());
+		_vulkan->EndSingleUseCommandBuffer(commandBuffer);
+	}
+
+	DestroyBlock(block);
+	block = compacted;
+	return moved;
+}
+
+bool GeometryArena::IsFragmented(const FreeListAllocator& allocator)
+{
+	if (allocator.GetFreeRangeCount() <= 1)
+	{
+		return false;
+	}
+
+	uint64_t scattered = allocator.GetFreeSize() - allocator.GetLargestFreeRange();
+	return scattered * 100 >= allocator.GetSize() * COMPACT_THRESHOLD_PERCENT;
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "../../API.h"
+#include "MemoryAllocator.h"
+#include "FreeListAllocator.h"
+#include "Uploader.h"
+
+#include <vulkan/vulkan.h>
+#include <vector>
+
+namespace Euler
+{
+	namespace Graphics
+	{
+		class Vulkan;
+
+		/// <summary>
+		/// Where a mesh lives inside a geometry arena. Owned by the arena, the offsets can change
+		/// when the arena is compacted.
+		/// </summary>
+		struct EULER_API GeometryAllocation
+		{
+			uint32_t Block = UINT32_MAX;
+			uint32_t VertexOffset = 0;		// in vertices, passed as vertexOffset
+			uint32_t VertexCount = 0;
+			uint32_t FirstIndex = 0;		// in indices
+			uint32_t IndexCount = 0;
+		};
+
+		/// <summary>
+		/// Big device local vertex and index buffers that meshes with the same vertex stride and index type
+		/// are sub-allocated from, so the buffers only have to be bound when the block changes.
+		/// Indices stay relative to the mesh, draws add the allocation's vertex offset.
+		/// </summary>
+		class EULER_API GeometryArena
+		{
+		public:
+			static const uint32_t DEFAULT_VERTEX_CAPACITY = 1024 * 1024;
+			static const uint32_t DEFAULT_INDEX_CAPACITY = 4 * 1024 * 1024;
+			// a block is compacted once the free space outside its largest free range reaches this percentage of it
+			static const uint32_t COMPACT_THRESHOLD_PERCENT = 25;
+
+		private:
+			struct Block
+			{
+				VkBuffer VertexBuffer = VK_NULL_HANDLE;
+				MemoryAllocation VertexMemory;
+				VkBuffer IndexBuffer = VK_NULL_HANDLE;
+				MemoryAllocation IndexMemory;
+				FreeListAllocator Vertices;
+				FreeListAllocator Indices;
+			};
+
+			Vulkan* _vulkan = nullptr;
+			// tells the blocks of different arenas apart in Bind
+			uint32_t _id = 0;
+			uint32_t _vertexStride = 0;
+			VkIndexType _indexType = VK_INDEX_TYPE_UINT32;
+			uint32_t _indexSize = sizeof(uint32_t);
+			uint32_t _vertexCapacity = 0;
+			uint32_t _indexCapacity = 0;
+
+			std::vector<Block> _blocks;
+			std::vector<GeometryAllocation*> _allocations;
+			// freed allocations per frame in flight, their ranges are reused once the frame's fence is signaled
+			std::vector<std::vector<GeometryAllocation*>> _frameFrees;
+
+		public:
+			// id has to be unique among the arenas drawn in the same command buffer
+			void Create(Vulkan* vulkan, uint32_t id, uint32_t vertexStride, VkIndexType indexType, uint32_t vertexCapacity = DEFAULT_VERTEX_CAPACITY, uint32_t indexCapacity = DEFAULT_INDEX_CAPACITY);
+			void Destroy();
+
+			// copies the data through the uploader, the geometry can be drawn once uploadHandle is ready.
+			// indices are uint16_t or uint32_t, matching the arena's index type
+			GeometryAllocation* Allocate(const void* vertices, uint32_t vertexCount, const void* indices, uint32_t indexCount, UploadHandle* uploadHandle);
+			void Free(GeometryAllocation* allocation);
+
+			// releases the ranges freed while the given frame was last in flight
+			void Update(int frame);
+			// moves all allocations to the front of their blocks, waits for the device to be idle.
+			// Bumps the vulkan's _geometryVersion when anything moved
+			void Compact();
+			// compacts only the first block split up past COMPACT_THRESHOLD_PERCENT, false when there is none.
+			// Waits for the device to be idle as well, so the frame it runs in hitches
+			bool CompactFragmentedBlock();
+			// true when a block's free space is split up past COMPACT_THRESHOLD_PERCENT
+			bool IsFragmented() const;
+
+			// binds the block's buffers if they aren't bound already, boundBlock should start as UINT32_MAX for every command buffer
+			// and is shared by all arenas drawn in it
+			void Bind(VkCommandBuffer commandBuffer, const GeometryAllocation* allocation, uint32_t* boundBlock);
+			void Draw(VkCommandBuffer commandBuffer, const GeometryAllocation* allocation, uint32_t instanceCount = 1, uint32_t firstInstance = 0);
+
+			uint32_t GetVertexStride() const;
+			VkIndexType GetIndexType() const;
+			uint32_t GetBlockCount() const;
+			VkBuffer GetVertexBuffer(uint32_t block) const;
+			VkBuffer GetIndexBuffer(uint32_t block) const;
+
+		private:
+			void CreateBlock(uint32_t vertexCapacity, uint32_t indexCapacity);
+			void DestroyBlock(Block& block);
+			void Release(GeometryAllocation* allocation);
+			// waits for the uploads and the device and releases all deferred frees
+			void WaitForCompaction();
+			// returns whether any allocation moved
+			bool CompactBlock(uint32_t index);
+			static bool IsFragmented(const FreeListAllocator& allocator);
+		};
+	}
+}
@@ -0,0 +1,279 @@
+#include "MemoryAllocator.h"
+
+#include <assert.h>
+
+using namespace Euler::Graphics;
+
+const VkDeviceSize MemoryAllocator::DEFAULT_BLOCK_SIZE;
+const VkDeviceSize MemoryAllocator::MIN_NODE_SIZE;
+
+void MemoryAllocator::Create(VkDevice device, const VkPhysicalDeviceMemoryProperties& memoryProperties, const VkPhysicalDeviceLimits& limits)
+{
+	_device = device;
+	_memoryProperties = memoryProperties;
+	_bufferImageGranularity = limits.bufferImageGranularity;
+
+	_pools.resize(memoryProperties.memoryTypeCount * 2);
+	for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
+	{
+		// use smaller blocks on small heaps so a single block can't take most of the heap
+		VkDeviceSize heapSize = memoryProperties.memoryHeaps[memoryProperties.memoryTypes[i].heapIndex].size;
+		VkDeviceSize blockSize = DEFAULT_BLOCK_SIZE;
+		while (blockSize > MIN_NODE_SIZE && blockSize > heapSize / 8)
+		{
+			blockSize >>= 1;
+		}
+
+		for (uint32_t j = 0; j < 2; j++)
+		{
+			Pool& pool = _pools[i * 2 + j];
+			pool.MemoryTypeIndex = i;
+			pool.Optimal = j == 1;
+			pool.BlockSize = blockSize;
+		}
+	}
+}
+
+void MemoryAllocator::Destroy()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	for (auto& pool : _pools)
+	{
+		for (auto& block : pool.Blocks)
+		{
+			if (block.Memory != VK_NULL_HANDLE)
+			{
+				// unmapping is implicit when the memory is freed
+				vkFreeMemory(_device, block.Memory, nullptr);
+			}
+		}
+		pool.Blocks.clear();
+	}
+
+	for (auto& dedicated : _dedicatedAllocations)
+	{
+		vkFreeMemory(_device, dedicated.Memory, nullptr);
+	}
+	_dedicatedAllocations.clear();
+}
+
+MemoryAllocation MemoryAllocator::Allocate(const VkMemoryRequirements& requirements, uint32_t memoryTypeIndex, bool optimal)
+{
+	assert(memoryTypeIndex < _memoryProperties.memoryTypeCount);
+
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	MemoryAllocation allocation{};
+	allocation.MemoryTypeIndex = memoryTypeIndex;
+	allocation.Size = requirements.size;
+
+	// buddy nodes are aligned to their size, so when the granularity is not bigger than the smallest
+	// node, linear and optimal resources can never end up on the same page and can share blocks
+	bool separatePools = _bufferImageGranularity > MIN_NODE_SIZE;
+	uint32_t poolIndex = memoryTypeIndex * 2 + (separatePools && optimal ? 1 : 0);
+	Pool& pool = _pools[poolIndex];
+
+	// big resources get their own allocation, placing them in a block would waste most of it
+	VkDeviceSize nodeSize = requirements.size > requirements.alignment ? requirements.size : requirements.alignment;
+	if (nodeSize > pool.BlockSize / 2)
+	{
+		VkResult result = AllocateDeviceMemory(requirements.size, memoryTypeIndex, &allocation.Memory, &allocation.MappedData);
+		assert(result == VK_SUCCESS);
+
+		_dedicatedAllocations.push_back({ allocation.Memory, requirements.size, memoryTypeIndex });
+		return allocation;
+	}
+
+	// try the existing blocks first
+	uint32_t emptySlot = UINT32_MAX;
+	for (uint32_t i = 0; i < pool.Blocks.size(); i++)
+	{
+		Block& block = pool.Blocks[i];
+		if (block.Memory == VK_NULL_HANDLE)
+		{
+			emptySlot = i;
+			continue;
+		}
+
+		uint64_t offset = block.Allocator.Allocate(requirements.size, requirements.alignment);
+		if (offset != BuddyAllocator::INVALID_OFFSET)
+		{
+			block.RequestedBytes += requirements.size;
+
+			allocation.Memory = block.Memory;
+			allocation.Offset = offset;
+			allocation.PoolIndex = poolIndex;
+			allocation.BlockIndex = i;
+			allocation.MappedData = block.MappedData != nullptr ? (char*)block.MappedData + offset : nullptr;
+			return allocation;
+		}
+	}
+
+	// no space left, create a new block
+	if (emptySlot == UINT32_MAX)
+	{
+		emptySlot = pool.Blocks.size();
+		pool.Blocks.push_back(Block());
+	}
+
+	Block& block = pool.Blocks[emptySlot];
+	VkResult result = AllocateDeviceMemory(pool.BlockSize, memoryTypeIndex, &block.Memory, &block.MappedData);
+	assert(result == VK_SUCCESS);
+	block.Allocator.Init(pool.BlockSize, MIN_NODE_SIZE);
+	block.RequestedBytes = 0;
+
+	uint64_t offset = block.Allocator.Allocate(requirements.size, requirements.alignment);
+	assert(offset != BuddyAllocator::INVALID_OFFSET);
+	block.RequestedBytes += requirements.size;
+
+	allocation.Memory = block.Memory;
+	allocation.Offset = offset;
+	allocation.PoolIndex = poolIndex;
+	allocation.BlockIndex = emptySlot;
+	allocation.MappedData = block.MappedData != nullptr ? (char*)block.MappedData + offset : nullptr;
+	return allocation;
+}
+
+void MemoryAllocator::Free(MemoryAllocation& allocation)
+{
+	if (allocation.Memory == VK_NULL_HANDLE)
+	{
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	if (allocation.BlockIndex == UINT32_MAX)
+	{
+		for (uint32_t i = 0; i < _dedicatedAllocations.size(); i++)
+		{
+			if (_dedicatedAllocations[i].Memory == allocation.Memory)
+			{
+				_dedicatedAllocations.erase(_dedicatedAllocations.begin() + i);
+				break;
+			}
+		}
+
+		vkFreeMemory(_device, allocation.Memory, nullptr);
+		allocation = MemoryAllocation();
+		return;
+	}
+
+	Pool& pool = _pools[allocation.PoolIndex];
+	Block& block = pool.Blocks[allocation.BlockIndex];
+	assert(block.Memory == allocation.Memory);
+
+	block.Allocator.Free(allocation.Offset);
+	block.RequestedBytes -= allocation.Size;
+
+	// release the block once it is empty, but keep one empty block around so that
+	// creating and destroying a single resource doesn't hit vkAllocateMemory every time
+	if (block.Allocator.IsEmpty())
+	{
+		bool hasOtherEmptyBlock = false;
+		for (uint32_t i = 0; i < pool.Blocks.size(); i++)
+		{
+			if (i != allocation.BlockIndex && pool.Blocks[i].Memory != VK_NULL_HANDLE && pool.Blocks[i].Allocator.IsEmpty())
+			{
+				hasOtherEmptyBlock = true;
+				break;
+			}
+		}
+
+		if (hasOtherEmptyBlock)
+		{
+			vkFreeMemory(_device, block.Memory, nullptr);
+			block.Memory = VK_NULL_HANDLE;
+			block.MappedData = nullptr;
+		}
+	}
+
+	allocation = MemoryAllocation();
+}
+
+std::vector<MemoryHeapStats> MemoryAllocator::GetStats()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	std::vector<MemoryHeapStats> stats(_memoryProperties.memoryHeapCount);
+	for (uint32_t i = 0; i < _memoryProperties.memoryHeapCount; i++)
+	{
+		stats[i].HeapIndex = i;
+		stats[i].HeapSize = _memoryProperties.memoryHeaps[i].size;
+	}
+
+	for (auto& pool : _pools)
+	{
+		MemoryHeapStats& heapStats = stats[_memoryProperties.memoryTypes[pool.MemoryTypeIndex].heapIndex];
+		for (auto& block : pool.Blocks)
+		{
+			if (block.Memory == VK_NULL_HANDLE)
+			{
+				continue;
+			}
+
+			heapStats.BlockCount++;
+			heapStats.AllocationCount += block.Allocator.GetAllocationCount();
+			heapStats.AllocatedBytes += block.Allocator.GetSize();
+			heapStats.UsedBytes += block.Allocator.GetUsedSize();
+			heapStats.RequestedBytes += block.RequestedBytes;
+			heapStats.FreeBytes += block.Allocator.GetFreeSize();
+			
+			VkDeviceSize largestFree = block.Allocator.GetLargestFreeNode();
+			if (largestFree > heapStats.LargestFreeRange)
+			{
+				heapStats.LargestFreeRange = largestFree;
+			}
+		}
+	}
+
+	for (auto& dedicated : _dedicatedAllocations)
+	{
+		MemoryHeapStats& heapStats = stats[_memoryProperties.memoryTypes[dedicated.MemoryTypeIndex].heapIndex];
+		heapStats.DedicatedAllocationCount++;
+		heapStats.AllocationCount++;
+		heapStats.AllocatedBytes += dedicated.Size;
+		heapStats.UsedBytes += dedicated.Size;
+		heapStats.RequestedBytes += dedicated.Size;
+	}
+
+	for (auto& heapStats : stats)
+	{
+		if (heapStats.FreeBytes > 0)
+		{
+			heapStats.Fragmentation = 1.0f - (float)heapStats.LargestFreeRange / (float)heapStats.FreeBytes;
+		}
+	}
+
+	return stats;
+}
+
+bool MemoryAllocator::IsHostVisible(uint32_t memoryTypeIndex)
+{
+	return (_memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0;
+}
+
+VkResult MemoryAllocator::AllocateDeviceMemory(VkDeviceSize size, uint32_t memoryTypeIndex, VkDeviceMemory* memory, void** mappedData)
+{
+	VkMemoryAllocateInfo allocateInfo{};
+	allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocateInfo.allocationSize = size;
+	allocateInfo.memoryTypeIndex = memoryTypeIndex;
+
+	VkResult result = vkAllocateMemory(_device, &allocateInfo, nullptr, memory);
+	if (result != VK_SUCCESS)
+	{
+		return result;
+	}
+
+	// host visible memory stays mapped for its whole lifetime, a VkDeviceMemory can only be
+	// mapped once at a time and several resources share each block
+	*mappedData = nullptr;
+	if (IsHostVisible(memoryTypeIndex))
+	{
+		result = vkMapMemory(_device, *memory, 0, VK_WHOLE_SIZE, 0, mappedData);
+	}
+
+	return result;
+}
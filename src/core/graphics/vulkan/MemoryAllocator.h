@@ -0,0 +1,100 @@
+#pragma once
+
+#include "../../API.h"
+#include "BuddyAllocator.h"
+
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <mutex>
+
+namespace Euler
+{
+	namespace Graphics
+	{
+		struct EULER_API MemoryAllocation
+		{
+			VkDeviceMemory Memory = VK_NULL_HANDLE;
+			VkDeviceSize Offset = 0;
+			VkDeviceSize Size = 0;
+			uint32_t MemoryTypeIndex = UINT32_MAX;
+			uint32_t PoolIndex = UINT32_MAX;
+			uint32_t BlockIndex = UINT32_MAX;		// UINT32_MAX for dedicated allocations
+			void* MappedData = nullptr;				// set for host visible memory, points at Offset
+		};
+
+		struct EULER_API MemoryHeapStats
+		{
+			uint32_t HeapIndex = 0;
+			VkDeviceSize HeapSize = 0;
+			uint32_t BlockCount = 0;
+			uint32_t DedicatedAllocationCount = 0;
+			uint32_t AllocationCount = 0;
+			VkDeviceSize AllocatedBytes = 0;		// total size of vkAllocateMemory calls
+			VkDeviceSize UsedBytes = 0;				// bytes taken by sub-allocations (after rounding)
+			VkDeviceSize RequestedBytes = 0;		// bytes actually requested by the resources
+			VkDeviceSize FreeBytes = 0;
+			VkDeviceSize LargestFreeRange = 0;
+			float Fragmentation = 0.0f;				// 0 when all free memory is one range, close to 1 when it is scattered
+		};
+
+		/// <summary>
+		/// Allocates device memory in big blocks per memory type and places resources inside
+		/// them with a buddy allocator. Linear resources (buffers) and optimal images live in
+		/// separate blocks when bufferImageGranularity is bigger than the smallest node.
+		/// </summary>
+		class EULER_API MemoryAllocator
+		{
+		public:
+			static const VkDeviceSize DEFAULT_BLOCK_SIZE = 64 * 1024 * 1024;
+			static const VkDeviceSize MIN_NODE_SIZE = 256;
+
+		private:
+			struct Block
+			{
+				VkDeviceMemory Memory = VK_NULL_HANDLE;
+				void* MappedData = nullptr;
+				BuddyAllocator Allocator;
+				VkDeviceSize RequestedBytes = 0;
+			};
+
+			struct Pool
+			{
+				uint32_t MemoryTypeIndex = 0;
+				bool Optimal = false;
+				VkDeviceSize BlockSize = 0;
+				std::vector<Block> Blocks;
+			};
+
+			struct DedicatedAllocation
+			{
+				VkDeviceMemory Memory;
+				VkDeviceSize Size;
+				uint32_t MemoryTypeIndex;
+			};
+
+			VkDevice _device = VK_NULL_HANDLE;
+			VkPhysicalDeviceMemoryProperties _memoryProperties{};
+			VkDeviceSize _bufferImageGranularity = 1;
+
+			// two pools per memory type, [type * 2] for linear and [type * 2 + 1] for optimal resources
+			std::vector<Pool> _pools;
+			std::vector<DedicatedAllocation> _dedicatedAllocations;
+
+			std::mutex _mutex;
+
+		public:
+			void Create(VkDevice device, const VkPhysicalDeviceMemoryProperties& memoryProperties, const VkPhysicalDeviceLimits& limits);
+			void Destroy();
+
+			// optimal should be true for images created with VK_IMAGE_TILING_OPTIMAL
+			MemoryAllocation Allocate(const VkMemoryRequirements& requirements, uint32_t memoryTypeIndex, bool optimal);
+			void Free(MemoryAllocation& allocation);
+
+			std::vector<MemoryHeapStats> GetStats();
+
+		private:
+			bool IsHostVisible(uint32_t memoryTypeIndex);
+			VkResult AllocateDeviceMemory(VkDeviceSize size, uint32_t memoryTypeIndex, VkDeviceMemory* memory, void** mappedData);
+		};
+	}
+}
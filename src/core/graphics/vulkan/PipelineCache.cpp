@@ -0,0 +1,115 @@
+#include "PipelineCache.h"
+#include "../../io/Utils.h"
+
+#include <assert.h>
+#include <string.h>
+#include <iostream>
+
+using namespace Euler::Graphics;
+
+const uint32_t PipelineCache::FILE_MAGIC;
+const uint32_t PipelineCache::FILE_VERSION;
+
+void PipelineCache::Create(VkDevice device, const VkPhysicalDeviceProperties& properties, const char* filePath)
+{
+	_device = device;
+	_properties = properties;
+	_filePath = filePath;
+
+	std::vector<char> fileData = Euler::ReadFile(_filePath);
+	uint64_t dataSize = Validate(fileData, _properties);
+	_warm = dataSize > 0;
+
+	VkPipelineCacheCreateInfo createInfo{};
+	createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+	createInfo.initialDataSize = dataSize;
+	createInfo.pInitialData = _warm ? fileData.data() + sizeof(FileHeader) : nullptr;
+
+	VkResult result = vkCreatePipelineCache(_device, &createInfo, nullptr, &_cache);
+	if (result != VK_SUCCESS && _warm)
+	{
+		// the driver rejected the data, start with an empty cache
+		_warm = false;
+		createInfo.initialDataSize = 0;
+		createInfo.pInitialData = nullptr;
+		result = vkCreatePipelineCache(_device, &createInfo, nullptr, &_cache);
+	}
+	assert(result == VK_SUCCESS);
+
+	std::cout << "Pipeline cache " << (_warm ? "loaded" : "empty") << " (" << dataSize << " bytes)" << std::endl;
+}
+
+void PipelineCache::Destroy()
+{
+	vkDestroyPipelineCache(_device, _cache, nullptr);
+	_cache = VK_NULL_HANDLE;
+}
+
+bool PipelineCache::Save()
+{
+	size_t dataSize = 0;
+	if (vkGetPipelineCacheData(_device, _cache, &dataSize, nullptr) != VK_SUCCESS || dataSize == 0)
+	{
+		return false;
+	}
+
+	std::vector<char> fileData(sizeof(FileHeader) + dataSize);
+	if (vkGetPipelineCacheData(_device, _cache, &dataSize, fileData.data() + sizeof(FileHeader)) != VK_SUCCESS)
+	{
+		return false;
+	}
+	fileData.resize(sizeof(FileHeader) + dataSize);
+
+	FileHeader header = CreateHeader(_properties, dataSize);
+	memcpy(fileData.data(), &header, sizeof(header));
+
+	return Euler::WriteFile(_filePath, fileData);
+}
+
+VkPipelineCache PipelineCache::Get() const
+{
+	return _cache;
+}
+
+bool PipelineCache::IsWarm() const
+{
+	return _warm;
+}
+
+uint64_t PipelineCache::Validate(const std::vector<char>& fileData, const VkPhysicalDeviceProperties& properties)
+{
+	if (fileData.size() <= sizeof(FileHeader))
+	{
+		return 0;
+	}
+
+	FileHeader header;
+	memcpy(&header, fileData.data(), sizeof(header));
+
+	FileHeader expected = CreateHeader(properties, fileData.size() - sizeof(FileHeader));
+	if (header.Magic != expected.Magic ||
+		header.Version != expected.Version ||
+		header.VendorID != expected.VendorID ||
+		header.DeviceID != expected.DeviceID ||
+		header.DriverVersion != expected.DriverVersion ||
+		memcmp(header.PipelineCacheUUID, expected.PipelineCacheUUID, VK_UUID_SIZE) != 0 ||
+		header.DataSize != expected.DataSize)
+	{
+		return 0;
+	}
+
+	return header.DataSize;
+}
+
+PipelineCache::FileHeader PipelineCache::CreateHeader(const VkPhysicalDeviceProperties& properties, uint64_t dataSize)
+{
+	FileHeader header{};
+	header.Magic = FILE_MAGIC;
+	header.Version = FILE_VERSION;
+	header.VendorID = properties.vendorID;
+	header.DeviceID = properties.deviceID;
+	header.DriverVersion = properties.driverVersion;
+	memcpy(header.PipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE);
+	header.DataSize = dataSize;
+	return header;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "../../API.h"
+
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <stdint.h>
+
+namespace Euler
+{
+	namespace Graphics
+	{
+		/// <summary>
+		/// Wraps the VkPipelineCache used for every pipeline the engine creates. The cache is loaded from
+		/// a file when the device is created and written back when the renderer is cleaned up. The file
+		/// starts with a header identifying the device and driver that produced it; data from another
+		/// device, driver version or engine cache version is discarded and the cache starts empty.
+		/// </summary>
+		class EULER_API PipelineCache
+		{
+		public:
+			static const uint32_t FILE_MAGIC = 0x43504C45;	// "ELPC"
+			static const uint32_t FILE_VERSION = 1;
+
+			struct FileHeader
+			{
+				uint32_t Magic;
+				uint32_t Version;
+				uint32_t VendorID;
+				uint32_t DeviceID;
+				uint32_t DriverVersion;
+				uint8_t PipelineCacheUUID[VK_UUID_SIZE];
+				uint64_t DataSize;
+			};
+
+		private:
+			VkDevice _device = VK_NULL_HANDLE;
+			VkPhysicalDeviceProperties _properties;
+			VkPipelineCache _cache = VK_NULL_HANDLE;
+			const char* _filePath = nullptr;
+			bool _warm = false;
+
+		public:
+			void Create(VkDevice device, const VkPhysicalDeviceProperties& properties, const char* filePath);
+			void Destroy();
+
+			// writes the current cache contents to the file, returns false if the file can't be written
+			bool Save();
+
+			VkPipelineCache Get() const;
+
+			// true if valid data was loaded from the file when the cache was created
+			bool IsWarm() const;
+
+			// returns the size of the driver data following the header or 0 if the file contents don't match the device
+			static uint64_t Validate(const std::vector<char>& fileData, const VkPhysicalDeviceProperties& properties);
+			static FileHeader CreateHeader(const VkPhysicalDeviceProperties& properties, uint64_t dataSize);
+		};
+	}
+}
@@ -0,0 +1,192 @@
+#include "SamplerCache.h"
+
+#include <assert.h>
+#include <string.h>
+#include <iostream>
+
+using namespace Euler::Graphics;
+
+namespace
+{
+	// FNV-1a over the fields, not the struct, so padding doesn't change the hash
+	template <typename T>
+	void HashField(uint64_t& hash, const T& value)
+	{
+		const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+		for (size_t i = 0; i < sizeof(T); i++)
+		{
+			hash ^= bytes[i];
+			hash *= 1099511628211ull;
+		}
+	}
+}
+
+bool SamplerDesc::operator==(const SamplerDesc& other) const
+{
+	return MagFilter == other.MagFilter
+		&& MinFilter == other.MinFilter
+		&& MipmapMode == other.MipmapMode
+		&& AddressModeU == other.AddressModeU
+		&& AddressModeV == other.AddressModeV
+		&& AddressModeW == other.AddressModeW
+		&& BorderColor == other.BorderColor
+		&& MaxAnisotropy == other.MaxAnisotropy
+		&& MipLodBias == other.MipLodBias
+		&& MinLod == other.MinLod
+		&& MaxLod == other.MaxLod
+		&& CompareEnable == other.CompareEnable
+		&& CompareOp == other.CompareOp;
+}
+
+uint64_t SamplerDesc::GetHash() const
+{
+	uint64_t hash = 14695981039346656037ull;
+	HashField(hash, MagFilter);
+	HashField(hash, MinFilter);
+	HashField(hash, MipmapMode);
+	HashField(hash, AddressModeU);
+	HashField(hash, AddressModeV);
+	HashField(hash, AddressModeW);
+	HashField(hash, BorderColor);
+	HashField(hash, MaxAnisotropy);
+	HashField(hash, MipLodBias);
+	HashField(hash, MinLod);
+	HashField(hash, MaxLod);
+	HashField(hash, CompareEnable);
+	HashField(hash, CompareOp);
+	return hash;
+}
+
+void SamplerCache::Create(VkDevice device, const VkPhysicalDeviceLimits& limits, bool anisotropy, PFN_vkCreateSampler createSampler, PFN_vkDestroySampler destroySampler)
+{
+	_device = device;
+	_createSampler = createSampler;
+	_destroySampler = destroySampler;
+	_limits = limits;
+	_anisotropy = anisotropy;
+}
+
+void SamplerCache::Destroy()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	// samplers nobody released are destroyed with the device
+	for (auto& bucket : _entries)
+	{
+		for (auto& entry : bucket.second)
+		{
+			_destroySampler(_device, entry.Sampler, nullptr);
+		}
+	}
+	_entries.clear();
+	_hashes.clear();
+}
+
+VkSampler SamplerCache::Acquire(const SamplerDesc& desc)
+{
+	SamplerDesc resolved = Resolve(desc);
+	uint64_t hash = resolved.GetHash();
+
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	std::vector<Entry>& bucket = _entries[hash];
+	for (auto& entry : bucket)
+	{
+		if (entry.Desc == resolved)
+		{
+			entry.References++;
+			return entry.Sampler;
+		}
+	}
+
+	VkSamplerCreateInfo samplerCreateInfo{};
+	samplerCreateInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	samplerCreateInfo.magFilter = resolved.MagFilter;
+	samplerCreateInfo.minFilter = resolved.MinFilter;
+	samplerCreateInfo.mipmapMode = resolved.MipmapMode;
+	samplerCreateInfo.addressModeU = resolved.AddressModeU;
+	samplerCreateInfo.addressModeV = resolved.AddressModeV;
+	samplerCreateInfo.addressModeW = resolved.AddressModeW;
+	samplerCreateInfo.borderColor = resolved.BorderColor;
+	samplerCreateInfo.anisotropyEnable = resolved.MaxAnisotropy > 1.0f ? VK_TRUE : VK_FALSE;
+	samplerCreateInfo.maxAnisotropy = resolved.MaxAnisotropy;
+	samplerCreateInfo.mipLodBias = resolved.MipLodBias;
+	samplerCreateInfo.minLod = resolved.MinLod;
+	samplerCreateInfo.maxLod = resolved.MaxLod;
+	samplerCreateInfo.compareEnable = resolved.CompareEnable ? VK_TRUE : VK_FALSE;
+	samplerCreateInfo.compareOp = resolved.CompareOp;
+	samplerCreateInfo.unnormalizedCoordinates = VK_FALSE;
+
+	if (_hashes.size() >= _limits.maxSamplerAllocationCount)
+	{
+		std::cout << "SamplerCache: over the device's limit of " << _limits.maxSamplerAllocationCount << " samplers" << std::endl;
+	}
+
+	Entry entry;
+	entry.Desc = resolved;
+	entry.References = 1;
+	VkResult result = _createSampler(_device, &samplerCreateInfo, nullptr, &entry.Sampler);
+	assert(result == VK_SUCCESS);
+
+	bucket.push_back(entry);
+	_hashes[entry.Sampler] = hash;
+
+	return entry.Sampler;
+}
+
+void SamplerCache::Release(VkSampler sampler)
+{
+	if (sampler == VK_NULL_HANDLE)
+	{
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	auto hash = _hashes.find(sampler);
+	assert(hash != _hashes.end());
+
+	std::vector<Entry>& bucket = _entries[hash->second];
+	for (uint32_t i = 0; i < bucket.size(); i++)
+	{
+		if (bucket[i].Sampler != sampler)
+		{
+			continue;
+		}
+
+		if (--bucket[i].References == 0)
+		{
+			_destroySampler(_device, sampler, nullptr);
+			bucket.erase(bucket.begin() + i);
+			if (bucket.empty())
+			{
+				_entries.erase(hash->second);
+			}
+			_hashes.erase(hash);
+		}
+		return;
+	}
+}
+
+uint32_t SamplerCache::GetSamplerCount()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _hashes.size();
+}
+
+SamplerDesc SamplerCache::Resolve(const SamplerDesc& desc) const
+{
+	SamplerDesc resolved = desc;
+
+	float maxAnisotropy = _anisotropy ? _limits.maxSamplerAnisotropy : 1.0f;
+	if (resolved.MaxAnisotropy <= 0.0f || resolved.MaxAnisotropy > maxAnisotropy)
+	{
+		resolved.MaxAnisotropy = maxAnisotropy;
+	}
+	if (resolved.MaxAnisotropy < 1.0f)
+	{
+		resolved.MaxAnisotropy = 1.0f;
+	}
+
+	return resolved;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "../../API.h"
+
+#include <vulkan/vulkan.h>
+#include <unordered_map>
+#include <vector>
+#include <mutex>
+#include <stdint.h>
+
+namespace Euler
+{
+	namespace Graphics
+	{
+		// the sampler state the cache is keyed by, the defaults are the trilinear anisotropic repeat sampler textures use
+		struct EULER_API SamplerDesc
+		{
+			VkFilter MagFilter = VK_FILTER_LINEAR;
+			VkFilter MinFilter = VK_FILTER_LINEAR;
+			VkSamplerMipmapMode MipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+			VkSamplerAddressMode AddressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+			VkSamplerAddressMode AddressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+			VkSamplerAddressMode AddressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+			VkBorderColor BorderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_BLACK;
+			// 0 is the device's limit, 1 turns anisotropic filtering off
+			float MaxAnisotropy = 0.0f;
+			float MipLodBias = 0.0f;
+			float MinLod = 0.0f;
+			// the view decides how many levels there are
+			float MaxLod = VK_LOD_CLAMP_NONE;
+			// depth comparison for shadow maps
+			bool CompareEnable = false;
+			VkCompareOp CompareOp = VK_COMPARE_OP_ALWAYS;
+
+			bool operator==(const SamplerDesc& other) const;
+			uint64_t GetHash() const;
+		};
+
+		/// <summary>
+		/// Shares one VkSampler between everything that samples with the same state. Drivers only allow a
+		/// few thousand samplers, while textures almost all use the same one. Acquire returns the sampler
+		/// for a description and counts the reference, Release destroys it when the last user is gone.
+		/// </summary>
+		class EULER_API SamplerCache
+		{
+		private:
+			struct Entry
+			{
+				SamplerDesc Desc;
+				VkSampler Sampler = VK_NULL_HANDLE;
+				uint32_t References = 0;
+			};
+
+			VkDevice _device = VK_NULL_HANDLE;
+			PFN_vkCreateSampler _createSampler = nullptr;
+			PFN_vkDestroySampler _destroySampler = nullptr;
+			VkPhysicalDeviceLimits _limits;
+			bool _anisotropy = false;
+
+			std::mutex _mutex;
+			// hash of the description to the samplers with it, collisions share a bucket
+			std::unordered_map<uint64_t, std::vector<Entry>> _entries;
+			std::unordered_map<VkSampler, uint64_t> _hashes;
+
+		public:
+			// anisotropy is whether the samplerAnisotropy feature was enabled. The sampler functions can be replaced
+			// to use the cache without a device, like the tests do
+			void Create(VkDevice device, const VkPhysicalDeviceLimits& limits, bool anisotropy,
+				PFN_vkCreateSampler createSampler = vkCreateSampler, PFN_vkDestroySampler destroySampler = vkDestroySampler);
+			void Destroy();
+
+			VkSampler Acquire(const SamplerDesc& desc);
+			void Release(VkSampler sampler);
+
+			uint32_t GetSamplerCount();
+
+		private:
+			// the description with the anisotropy the device supports, so equivalent descriptions share a sampler
+			SamplerDesc Resolve(const SamplerDesc& desc) const;
+		};
+	}
+}
@@ -0,0 +1,481 @@
+#include "TextureStreamer.h"
+#include "Vulkan.h"
+#include "../Texture.h"
+#include "../../resources/Ktx2.h"
+#include "../../util/BlockCompression.h"
+
+#include <algorithm>
+#include <math.h>
+
+using namespace Euler::Graphics;
+
+const uint32_t TextureStreamer::TAIL_SIZE;
+const uint32_t TextureStreamer::MAX_PENDING_LOADS;
+const uint32_t TextureStreamer::INVALID_INDEX;
+
+void TextureStreamer::Create(Vulkan* vulkan)
+{
+	_vulkan = vulkan;
+	_frameRetiredImages.resize(_vulkan->_framesInFlight);
+}
+
+void TextureStreamer::Destroy()
+{
+	if (_thread.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_stop = true;
+		}
+		_condition.notify_one();
+		_thread.join();
+	}
+
+	for (auto& result : _results)
+	{
+		delete result.Resource;
+	}
+	_results.clear();
+	_requests.clear();
+
+	// the textures still registered keep their current images, the streamer only owns the others
+	_vulkan->_uploader.WaitIdle();
+	for (auto& texture : _textures)
+	{
+		if (texture.Owner == nullptr)
+		{
+			continue;
+		}
+
+		if (texture.Uploading)
+		{
+			DestroyImage(texture.PendingImage);
+		}
+		if (texture.Retiring)
+		{
+			DestroyImage(texture.OldImage);
+		}
+		texture.Owner->_streamingIndex = INVALID_INDEX;
+	}
+
+	for (auto& images : _frameRetiredImages)
+	{
+		for (auto& image : images)
+		{
+			DestroyImage(image);
+		}
+	}
+
+	_textures.clear();
+	_freeTextures.clear();
+	_frameRetiredImages.clear();
+	_textureCount = 0;
+	_pendingLoads = 0;
+	_residentBytes = 0;
+}
+
+bool TextureStreamer::HasTextures() const
+{
+	return _textureCount > 0;
+}
+
+void TextureStreamer::Register(Texture* texture, const char* filePath, TextureResource* textureResource)
+{
+	uint32_t index;
+	if (!_freeTextures.empty())
+	{
+		index = _freeTextures.back();
+		_freeTextures.pop_back();
+	}
+	else
+	{
+		index = _textures.size();
+		_textures.emplace_back();
+	}
+
+	StreamedTexture& streamed = _textures[index];
+	streamed = StreamedTexture();
+	streamed.Owner = texture;
+	streamed.Id = _nextId++;
+	streamed.FilePath = filePath;
+	streamed.Format = textureResource->GetFormat();
+	streamed.Srgb = textureResource->IsSrgb();
+	streamed.Width = textureResource->GetWidth();
+	streamed.Height = textureResource->GetHeight();
+	streamed.LevelCount = textureResource->GetLevelCount();
+	streamed.TailLevel = textureResource->GetFirstLevel();
+	streamed.FirstLevel = streamed.TailLevel;
+	streamed.WantedLevel = streamed.TailLevel;
+	streamed.LastUsedFrame = _frame;
+
+	texture->_streamingIndex = index;
+	_textureCount++;
+	_residentBytes += GetSize(streamed, streamed.FirstLevel);
+
+	if (!_thread.joinable())
+	{
+		_stop = false;
+		_thread = std::thread(&TextureStreamer::Run, this);
+	}
+}
+
+void TextureStreamer::Unregister(Texture* texture)
+{
+	if (texture->_streamingIndex == INVALID_INDEX)
+	{
+		return;
+	}
+
+	// like Texture::Destroy, the images are destroyed right away, a load still on the thread is dropped when it comes back
+	StreamedTexture& streamed = _textures[texture->_streamingIndex];
+	if (streamed.Uploading)
+	{
+		_vulkan->_uploader.Wait(streamed.PendingUpload);
+		DestroyImage(streamed.PendingImage);
+	}
+	if (streamed.Retiring)
+	{
+		DestroyImage(streamed.OldImage);
+	}
+	_residentBytes -= GetSize(streamed, streamed.FirstLevel);
+
+	streamed.Owner = nullptr;
+	streamed.Uploading = false;
+	streamed.Retiring = false;
+	_freeTextures.push_back(texture->_streamingIndex);
+	_textureCount--;
+
+	texture->_streamingIndex = INVALID_INDEX;
+}
+
+void TextureStreamer::RequestSize(Texture* texture, float screenSize)
+{
+	StreamedTexture& streamed = _textures[texture->_streamingIndex];
+
+	// the finest level still at least as big as the texture is on screen
+	uint32_t size = std::max(streamed.Width, streamed.Height);
+	uint32_t level = screenSize >= size ? 0 : (screenSize <= 1.0f ? streamed.TailLevel : (uint32_t)floorf(log2f(size / screenSize)));
+	level = std::min(level, streamed.TailLevel);
+
+	// the finest level any of the texture's users asked for this frame
+	if (streamed.LastUsedFrame != _frame || level < streamed.WantedLevel)
+	{
+		streamed.WantedLevel = level;
+	}
+	streamed.LastUsedFrame = _frame;
+}
+
+void TextureStreamer::Update(int frame, uint32_t image)
+{
+	if (_frameRetiredImages.empty())
+	{
+		return;
+	}
+
+	for (auto& retired : _frameRetiredImages[frame])
+	{
+		DestroyImage(retired);
+	}
+	_frameRetiredImages[frame].clear();
+
+	if (_textureCount > 0)
+	{
+		FinishLoads();
+		SwapImages();
+		UpdateDescriptorSets(frame, image);
+		RequestLoads();
+	}
+
+	_frame++;
+}
+
+VkDeviceSize TextureStreamer::GetResidentBytes() const
+{
+	return _residentBytes;
+}
+
+VkDeviceSize TextureStreamer::GetBudget()
+{
+	if (Budget != 0)
+	{
+		return Budget;
+	}
+
+	return (VkDeviceSize)(_vulkan->GetDeviceLocalBudget() * BudgetFraction);
+}
+
+void TextureStreamer::Run()
+{
+	while (true)
+	{
+		LoadRequest request;
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_condition.wait(lock, [this] { return _stop || !_requests.empty(); });
+			if (_stop)
+			{
+				return;
+			}
+
+			request = _requests.front();
+			_requests.pop_front();
+		}
+
+		// only the levels from FirstLevel on are read from the file
+		request.Resource = new TextureResource();
+		request.Resource->LoadLevels(request.FilePath.c_str(), request.MaxSize);
+
+		std::lock_guard<std::mutex> lock(_mutex);
+		_results.push_back(request);
+	}
+}
+
+void TextureStreamer::FinishLoads()
+{
+	std::vector<LoadRequest> results;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		results.swap(_results);
+	}
+
+	for (auto& result : results)
+	{
+		_pendingLoads--;
+
+		// the texture may have been destroyed, or its slot reused, while the file was read
+		StreamedTexture& streamed = _textures[result.Index];
+		bool valid = streamed.Owner != nullptr && streamed.Id == result.Id;
+		if (valid)
+		{
+			streamed.Loading = false;
+		}
+
+		TextureResource* resource = result.Resource;
+		if (!valid || resource->GetLevelCount() != streamed.LevelCount || resource->GetFirstLevel() != result.FirstLevel)
+		{
+			resource->Unload();
+			delete resource;
+			continue;
+		}
+
+		std::vector<ImageLevel> levels(streamed.LevelCount - result.FirstLevel);
+		for (uint32_t i = 0; i < levels.size(); i++)
+		{
+			levels[i].Data = resource->GetLevelData(result.FirstLevel + i);
+			levels[i].Size = resource->GetLevelSize(result.FirstLevel + i);
+		}
+
+		// the uploader copies the levels into its staging memory, the resource can go right away
+		streamed.PendingLevel = result.FirstLevel;
+		streamed.PendingImage.Size = GetSize(streamed, result.FirstLevel);
+		streamed.PendingUpload = Texture::CreateImageLevels(
+			_vulkan,
+			GetVkFormat(streamed.Format, streamed.Srgb),
+			std::max(streamed.Width >> result.FirstLevel, 1u),
+			std::max(streamed.Height >> result.FirstLevel, 1u),
+			levels,
+			levels.size(),
+			&streamed.PendingImage.Image,
+			&streamed.PendingImage.Memory,
+			&streamed.PendingImage.View
+		);
+		streamed.Uploading = true;
+		_residentBytes += streamed.PendingImage.Size;
+
+		resource->Unload();
+		delete resource;
+	}
+}
+
+void TextureStreamer::SwapImages()
+{
+	for (auto& streamed : _textures)
+	{
+		if (streamed.Owner == nullptr || !streamed.Uploading || !streamed.PendingUpload.IsReady())
+		{
+			continue;
+		}
+
+		Texture* texture = streamed.Owner;
+
+		streamed.OldImage.Image = texture->_image;
+		streamed.OldImage.Memory = texture->_memory;
+		streamed.OldImage.View = texture->_imageView;
+		streamed.OldImage.Size = GetSize(streamed, streamed.FirstLevel);
+
+		texture->_image = streamed.PendingImage.Image;
+		texture->_memory = streamed.PendingImage.Memory;
+		texture->_imageView = streamed.PendingImage.View;
+		texture->UploadHandle = streamed.PendingUpload;
+
+		// the new view gets a new slot, the old one is only reused once the frames in flight are done with it.
+		// Materials pick up the new index in Material::UpdateBindless
+		if (texture->BindlessIndex != BindlessTable::INVALID_INDEX)
+		{
+			_vulkan->_bindless.UnregisterTexture(texture->BindlessIndex);
+			texture->BindlessIndex = _vulkan->_bindless.RegisterTexture(texture->_imageView, texture->_sampler);
+		}
+
+		// the per-image descriptor sets are rewritten as their images come up
+		streamed.StaleSets.assign(texture->DescriptorSetGroup.DescriptorSets.size(), true);
+
+		streamed.FirstLevel = streamed.PendingLevel;
+		streamed.PendingImage = StreamedImage();
+		streamed.Uploading = false;
+		streamed.Retiring = true;
+	}
+}
+
+void TextureStreamer::UpdateDescriptorSets(int frame, uint32_t image)
+{
+	for (auto& streamed : _textures)
+	{
+		if (streamed.Owner == nullptr || !streamed.Retiring)
+		{
+			continue;
+		}
+
+		// the image's fence was waited on, so no frame in flight uses its set
+		Texture* texture = streamed.Owner;
+		if (image < streamed.StaleSets.size() && streamed.StaleSets[image])
+		{
+			texture->DescriptorSetGroup.UpdateSampler(_vulkan, image, texture->_imageView, texture->_sampler, 0);
+			streamed.StaleSets[image] = false;
+		}
+
+		if (std::find(streamed.StaleSets.begin(), streamed.StaleSets.end(), true) != streamed.StaleSets.end())
+		{
+			continue;
+		}
+
+		// frames submitted until now may still read the old image, the last of them is done once this frame is
+		_frameRetiredImages[frame].push_back(streamed.OldImage);
+		streamed.OldImage = StreamedImage();
+		streamed.Retiring = false;
+	}
+}
+
+void TextureStreamer::RequestLoads()
+{
+	// the level every texture should be at, starting from what its users asked for
+	std::vector<uint32_t> targets(_textures.size(), 0);
+	std::vector<uint32_t> candidates;
+	VkDeviceSize total = 0;
+	for (uint32_t i = 0; i < _textures.size(); i++)
+	{
+		StreamedTexture& streamed = _textures[i];
+		if (streamed.Owner == nullptr)
+		{
+			continue;
+		}
+
+		// textures that are changing keep their images until the change is done
+		if (streamed.Loading || streamed.Uploading || streamed.Retiring)
+		{
+			total += GetSize(streamed, streamed.FirstLevel) + (streamed.Uploading ? streamed.PendingImage.Size : streamed.OldImage.Size);
+			targets[i] = UINT32_MAX;
+			continue;
+		}
+
+		// one level of hysteresis keeps textures at the edge of a level from reloading every few frames
+		uint32_t target = streamed.WantedLevel;
+		if (target == streamed.FirstLevel + 1)
+		{
+			target = streamed.FirstLevel;
+		}
+
+		targets[i] = target;
+		total += GetSize(streamed, target);
+		candidates.push_back(i);
+	}
+
+	// over the budget the least recently used textures lose their finer levels first, the smaller ones on screen before the rest
+	VkDeviceSize budget = GetBudget();
+	if (total > budget)
+	{
+		std::sort(candidates.begin(), candidates.end(), [&](uint32_t a, uint32_t b)
+		{
+			if (_textures[a].LastUsedFrame != _textures[b].LastUsedFrame)
+			{
+				return _textures[a].LastUsedFrame < _textures[b].LastUsedFrame;
+			}
+			return _textures[a].WantedLevel > _textures[b].WantedLevel;
+		});
+
+		for (uint32_t i : candidates)
+		{
+			StreamedTexture& streamed = _textures[i];
+			while (total > budget && targets[i] < streamed.TailLevel)
+			{
+				total -= GetSize(streamed, targets[i]) - GetSize(streamed, targets[i] + 1);
+				targets[i]++;
+			}
+		}
+
+	}
+
+	// dropping levels frees memory, so those go before loading finer ones, then the most recently used
+	std::stable_sort(candidates.begin(), candidates.end(), [&](uint32_t a, uint32_t b)
+	{
+		bool dropA = targets[a] > _textures[a].FirstLevel;
+		bool dropB = targets[b] > _textures[b].FirstLevel;
+		if (dropA != dropB)
+		{
+			return dropA;
+		}
+		return _textures[a].LastUsedFrame > _textures[b].LastUsedFrame;
+	});
+
+	for (uint32_t i : candidates)
+	{
+		if (_pendingLoads >= MAX_PENDING_LOADS)
+		{
+			break;
+		}
+
+		StreamedTexture& streamed = _textures[i];
+		if (targets[i] == streamed.FirstLevel)
+		{
+			continue;
+		}
+
+		LoadRequest request;
+		request.Index = i;
+		request.Id = streamed.Id;
+		request.FirstLevel = targets[i];
+		request.FilePath = streamed.FilePath;
+		request.MaxSize = std::max(streamed.Width, streamed.Height) >> targets[i];
+
+		streamed.Loading = true;
+		_pendingLoads++;
+
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_requests.push_back(request);
+		}
+		_condition.notify_one();
+	}
+}
+
+VkDeviceSize TextureStreamer::GetSize(const StreamedTexture& texture, uint32_t firstLevel) const
+{
+	VkDeviceSize size = 0;
+	for (uint32_t i = firstLevel; i < texture.LevelCount; i++)
+	{
+		size += GetLevelSize(texture.Format, std::max(texture.Width >> i, 1u), std::max(texture.Height >> i, 1u));
+	}
+	return size;
+}
+
+void TextureStreamer::DestroyImage(StreamedImage& image)
+{
+	if (image.Image == VK_NULL_HANDLE)
+	{
+		return;
+	}
+
+	_vulkan->DestroyImageView(image.View);
+	_vulkan->DestroyImage(image.Image, image.Memory);
+	_residentBytes -= std::min(image.Size, _residentBytes);
+	image = StreamedImage();
+}
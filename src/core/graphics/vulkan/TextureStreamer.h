@@ -0,0 +1,147 @@
+#pragma once
+
+#include "../../API.h"
+#include "../../resources/TextureResource.h"
+#include "MemoryAllocator.h"
+#include "Uploader.h"
+
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <deque>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace Euler
+{
+	namespace Graphics
+	{
+		class Vulkan;
+		class Texture;
+
+		/// <summary>
+		/// Streams the finer mip levels of cooked .ktx2 textures. The levels up to TAIL_SIZE are loaded
+		/// with the texture and stay resident; finer levels are read on a background thread once the
+		/// models using the texture cover enough pixels to need them, and dropped again from the least
+		/// recently used textures when the streamed textures go over the budget. A texture changes its
+		/// levels by uploading a new image and swapping it in once the upload was submitted, the old
+		/// image is destroyed once no frame in flight can read it, so frames never wait on the streaming.
+		/// </summary>
+		class EULER_API TextureStreamer
+		{
+		public:
+			// larger side of the finest level that is always resident
+			static const uint32_t TAIL_SIZE = 64;
+			// level changes being read or uploaded at once
+			static const uint32_t MAX_PENDING_LOADS = 4;
+			static const uint32_t INVALID_INDEX = UINT32_MAX;
+
+		private:
+			struct StreamedImage
+			{
+				VkImage Image = VK_NULL_HANDLE;
+				MemoryAllocation Memory;
+				VkImageView View = VK_NULL_HANDLE;
+				VkDeviceSize Size = 0;
+			};
+
+			struct StreamedTexture
+			{
+				Texture* Owner = nullptr;		// nullptr for free slots
+				uint32_t Id = 0;
+				std::string FilePath;
+				TextureFormat Format = TEXTURE_FORMAT_RGBA8;
+				bool Srgb = true;
+				uint32_t Width = 0;
+				uint32_t Height = 0;
+				uint32_t LevelCount = 0;
+				uint32_t TailLevel = 0;
+
+				// the finest level of the texture's image
+				uint32_t FirstLevel = 0;
+				// the finest level the last frame with feedback asked for
+				uint32_t WantedLevel = 0;
+				uint64_t LastUsedFrame = 0;
+
+				// a level change is being read on the thread
+				bool Loading = false;
+				// the new image while it uploads
+				bool Uploading = false;
+				uint32_t PendingLevel = 0;
+				StreamedImage PendingImage;
+				UploadHandle PendingUpload;
+
+				// the replaced image until every per-image descriptor set stopped using it
+				bool Retiring = false;
+				StreamedImage OldImage;
+				std::vector<bool> StaleSets;
+			};
+
+			struct LoadRequest
+			{
+				uint32_t Index = 0;
+				uint32_t Id = 0;
+				uint32_t FirstLevel = 0;
+				std::string FilePath;
+				uint32_t MaxSize = 0;
+				TextureResource* Resource = nullptr;
+			};
+
+			Vulkan* _vulkan = nullptr;
+			uint64_t _frame = 0;
+
+			std::vector<StreamedTexture> _textures;
+			std::vector<uint32_t> _freeTextures;
+			uint32_t _textureCount = 0;
+			uint32_t _nextId = 1;
+			uint32_t _pendingLoads = 0;
+			// bytes of every streamed texture image, including the ones uploading or retiring
+			VkDeviceSize _residentBytes = 0;
+
+			// replaced images per frame in flight, destroyed once the frame's fence is signaled
+			std::vector<std::vector<StreamedImage>> _frameRetiredImages;
+
+			// the loading thread, started with the first streamed texture
+			std::thread _thread;
+			std::mutex _mutex;
+			std::condition_variable _condition;
+			std::deque<LoadRequest> _requests;
+			std::vector<LoadRequest> _results;
+			bool _stop = false;
+
+		public:
+			// set before creating textures, Texture::Create with a .ktx2 path streams it
+			bool Enabled = false;
+			// bytes the streamed textures may use, 0 takes BudgetFraction of the device local heap budget
+			VkDeviceSize Budget = 0;
+			float BudgetFraction = 0.5f;
+
+			void Create(Vulkan* vulkan);
+			void Destroy();
+			bool HasTextures() const;
+
+			// called by Texture, textureResource holds the resident levels the texture was created with
+			void Register(Texture* texture, const char* filePath, TextureResource* textureResource);
+			void Unregister(Texture* texture);
+
+			// feedback: the texture covers about screenSize pixels on screen this frame
+			void RequestSize(Texture* texture, float screenSize);
+
+			// called by the vulkan once the frame's fence and the image's fence were waited on
+			void Update(int frame, uint32_t image);
+
+			VkDeviceSize GetResidentBytes() const;
+			VkDeviceSize GetBudget();
+
+		private:
+			void Run();
+			void FinishLoads();
+			void SwapImages();
+			void UpdateDescriptorSets(int frame, uint32_t image);
+			void RequestLoads();
+			VkDeviceSize GetSize(const StreamedTexture& texture, uint32_t firstLevel) const;
+			void DestroyImage(StreamedImage& image);
+		};
+	}
+}
@@ -0,0 +1,468 @@
+#include "Uploader.h"
+#include "Vulkan.h"
+
+#include <assert.h>
+#include <string.h>
+#include <algorithm>
+
+using namespace Euler::Graphics;
+
+const VkDeviceSize Uploader::DEFAULT_STAGING_SIZE;
+
+bool UploadHandle::IsReady() const
+{
+	return Owner == nullptr || Owner->IsSubmitted(Batch);
+}
+
+bool UploadHandle::IsComplete() const
+{
+	return Owner == nullptr || Owner->IsComplete(Batch);
+}
+
+void Uploader::Create(Vulkan* vulkan, VkQueue queue, uint32_t queueFamilyIndex, VkDeviceSize stagingSize)
+{
+	_vulkan = vulkan;
+	_queue = queue;
+	_stagingSize = stagingSize;
+
+	for (auto& queueFamily : _vulkan->_physicalDevice->QueueFamilies)
+	{
+		if (queueFamily.Index == queueFamilyIndex)
+		{
+			_queueSupportsBlit = queueFamily.Graphics;
+		}
+	}
+
+	_head = 0;
+	_tail = 0;
+
+	VkCommandPoolCreateInfo poolCreateInfo{};
+	poolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	poolCreateInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT | VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+	poolCreateInfo.queueFamilyIndex = queueFamilyIndex;
+	vkCreateCommandPool(_vulkan->_device, &poolCreateInfo, nullptr, &_commandPool);
+
+	_vulkan->CreateBuffer(
+		_stagingSize,
+		VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		_stagingBuffer,
+		_stagingMemory
+	);
+
+	_frameWaitSemaphores.resize(_vulkan->_framesInFlight);
+}
+
+void Uploader::Destroy()
+{
+	WaitIdle();
+
+	for (auto& batch : _freeBatches)
+	{
+		vkDestroyFence(_vulkan->_device, batch.Fence, nullptr);
+	}
+	_freeBatches.clear();
+
+	for (auto& semaphores : _frameWaitSemaphores)
+	{
+		_freeSemaphores.insert(_freeSemaphores.end(), semaphores.begin(), semaphores.end());
+		semaphores.clear();
+	}
+	_freeSemaphores.insert(_freeSemaphores.end(), _pendingWaitSemaphores.begin(), _pendingWaitSemaphores.end());
+	_pendingWaitSemaphores.clear();
+
+	for (auto semaphore : _freeSemaphores)
+	{
+		vkDestroySemaphore(_vulkan->_device, semaphore, nullptr);
+	}
+	_freeSemaphores.clear();
+
+	vkDestroyCommandPool(_vulkan->_device, _commandPool, nullptr);
+	_vulkan->DestroyBuffer(_stagingBuffer, _stagingMemory);
+}
+
+UploadHandle Uploader::UploadBuffer(VkBuffer buffer, VkDeviceSize offset, const void* data, VkDeviceSize size)
+{
+	VkBuffer stagingBuffer;
+	VkDeviceSize stagingOffset;
+	GetStaging(size, 4, data, &stagingBuffer, &stagingOffset);
+
+	VkBufferCopy copyRegion{};
+	copyRegion.srcOffset = stagingOffset;
+	copyRegion.dstOffset = offset;
+	copyRegion.size = size;
+	vkCmdCopyBuffer(_recording.CommandBuffer, stagingBuffer, buffer, 1, &copyRegion);
+
+	UploadHandle handle;
+	handle.Owner = this;
+	handle.Batch = _recording.Id;
+	return handle;
+}
+
+UploadHandle Uploader::UploadImage(VkImage image, uint32_t width, uint32_t height, const void* data, VkDeviceSize size, uint32_t mipLevels)
+{
+	ImageLevel level;
+	level.Data = data;
+	level.Size = size;
+	return UploadImageLevels(image, width, height, { level }, mipLevels);
+}
+
+UploadHandle Uploader::UploadImageLevels(VkImage image, uint32_t width, uint32_t height, const std::vector<ImageLevel>& levels, uint32_t mipLevels)
+{
+	assert(!levels.empty() && levels.size() <= mipLevels);
+
+	VkImageMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.image = image;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	barrier.subresourceRange.baseMipLevel = 0;
+	barrier.subresourceRange.levelCount = mipLevels;
+	barrier.subresourceRange.baseArrayLayer = 0;
+	barrier.subresourceRange.layerCount = 1;
+
+	// each copy is recorded right after its staging, a full ring can submit the batch in between
+	for (uint32_t i = 0; i < levels.size(); i++)
+	{
+		VkBuffer stagingBuffer;
+		VkDeviceSize stagingOffset;
+		GetStaging(levels[i].Size, 16, levels[i].Data, &stagingBuffer, &stagingOffset);
+
+		if (i == 0)
+		{
+			// undefined -> transfer dst, all levels
+			barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			barrier.srcAccessMask = 0;
+			barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			vkCmdPipelineBarrier(_recording.CommandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+		}
+
+		VkBufferImageCopy copyRegion{};
+		copyRegion.bufferOffset = stagingOffset;
+		copyRegion.bufferRowLength = 0;
+		copyRegion.bufferImageHeight = 0;
+		copyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		copyRegion.imageSubresource.mipLevel = i;
+		copyRegion.imageSubresource.baseArrayLayer = 0;
+		copyRegion.imageSubresource.layerCount = 1;
+		copyRegion.imageOffset = { 0, 0, 0 };
+		copyRegion.imageExtent = { std::max(width >> i, 1u), std::max(height >> i, 1u), 1 };
+		vkCmdCopyBufferToImage(_recording.CommandBuffer, stagingBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copyRegion);
+	}
+
+	// every level is blitted from the previous one, which has to be a transfer src by then
+	barrier.subresourceRange.levelCount = 1;
+	for (uint32_t i = levels.size(); i < mipLevels; i++)
+	{
+		barrier.subresourceRange.baseMipLevel = i - 1;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+		vkCmdPipelineBarrier(_recording.CommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+		VkImageBlit blit{};
+		blit.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, i - 1, 0, 1 };
+		blit.srcOffsets[1] = { (int32_t)std::max(width >> (i - 1), 1u), (int32_t)std::max(height >> (i - 1), 1u), 1 };
+		blit.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, i, 0, 1 };
+		blit.dstOffsets[1] = { (int32_t)std::max(width >> i, 1u), (int32_t)std::max(height >> i, 1u), 1 };
+		vkCmdBlitImage(_recording.CommandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
+	}
+
+	// transfer dst or src -> shader read, the graphics queue waits on the batch semaphore so
+	// there's no need for a destination access here (the transfer queue has no shader stages)
+	for (uint32_t i = 0; i < mipLevels; i++)
+	{
+		bool blitSource = i + 1 >= levels.size() && i + 1 < mipLevels;
+
+		barrier.subresourceRange.baseMipLevel = i;
+		barrier.oldLayout = blitSource ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		barrier.srcAccessMask = blitSource ? VK_ACCESS_TRANSFER_READ_BIT : VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = 0;
+		vkCmdPipelineBarrier(_recording.CommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+	}
+
+	UploadHandle handle;
+	handle.Owner = this;
+	handle.Batch = _recording.Id;
+	return handle;
+}
+
+bool Uploader::CanGenerateMipLevels(VkFormat format) const
+{
+	if (!_queueSupportsBlit)
+	{
+		return false;
+	}
+
+	VkFormatProperties properties;
+	vkGetPhysicalDeviceFormatProperties(_vulkan->_physicalDevice->Handle, format, &properties);
+
+	VkFormatFeatureFlags required = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+	return (properties.optimalTilingFeatures & required) == required;
+}
+
+void Uploader::Flush()
+{
+	Submit(true);
+}
+
+void Uploader::Update(int frame)
+{
+	// the frame's fence was waited on, so its semaphore waits are done
+	auto& semaphores = _frameWaitSemaphores[frame];
+	_freeSemaphores.insert(_freeSemaphores.end(), semaphores.begin(), semaphores.end());
+	semaphores.clear();
+
+	RetireBatches(false);
+}
+
+void Uploader::WaitIdle()
+{
+	Submit(false);
+
+	while (!_inFlight.empty())
+	{
+		RetireBatches(true);
+	}
+}
+
+void Uploader::Wait(const UploadHandle& handle)
+{
+	if (handle.Owner == nullptr || IsComplete(handle.Batch))
+	{
+		return;
+	}
+
+	if (!IsSubmitted(handle.Batch))
+	{
+		Submit(false);
+	}
+
+	while (!IsComplete(handle.Batch))
+	{
+		RetireBatches(true);
+	}
+}
+
+bool Uploader::IsSubmitted(uint64_t batch) const
+{
+	return batch <= _lastSubmittedBatch;
+}
+
+bool Uploader::IsComplete(uint64_t batch) const
+{
+	return batch <= _lastCompletedBatch;
+}
+
+std::vector<VkSemaphore>& Uploader::TakeWaitSemaphores(int frame)
+{
+	auto& semaphores = _frameWaitSemaphores[frame];
+	semaphores.insert(semaphores.end(), _pendingWaitSemaphores.begin(), _pendingWaitSemaphores.end());
+	_pendingWaitSemaphores.clear();
+	return semaphores;
+}
+
+void Uploader::Submit(bool signalSemaphore)
+{
+	if (!_recordingStarted)
+	{
+		return;
+	}
+
+	vkEndCommandBuffer(_recording.CommandBuffer);
+
+	VkSubmitInfo submitInfo{};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &_recording.CommandBuffer;
+
+	_recording.Semaphore = VK_NULL_HANDLE;
+	if (signalSemaphore)
+	{
+		_recording.Semaphore = GetSemaphore();
+		submitInfo.signalSemaphoreCount = 1;
+		submitInfo.pSignalSemaphores = &_recording.Semaphore;
+		_pendingWaitSemaphores.push_back(_recording.Semaphore);
+	}
+
+	VkResult result = vkQueueSubmit(_queue, 1, &submitInfo, _recording.Fence);
+	assert(result == VK_SUCCESS);
+
+	_recording.RingEnd = _head;
+	_lastSubmittedBatch = _recording.Id;
+
+	_inFlight.push_back(_recording);
+	_recording = Batch();
+	_recordingStarted = false;
+}
+
+void Uploader::RetireBatches(bool wait)
+{
+	bool waited = false;
+
+	while (!_inFlight.empty())
+	{
+		Batch& batch = _inFlight.front();
+
+		if (vkGetFenceStatus(_vulkan->_device, batch.Fence) != VK_SUCCESS)
+		{
+			// when waiting, block for the oldest batch only and just poll the rest
+			if (!wait || waited)
+			{
+				break;
+			}
+
+			vkWaitForFences(_vulkan->_device, 1, &batch.Fence, VK_TRUE, UINT64_MAX);
+			waited = true;
+		}
+
+		_tail = batch.RingEnd;
+		_lastCompletedBatch = batch.Id;
+
+		for (int i = 0; i < batch.TemporaryBuffers.size(); i++)
+		{
+			_vulkan->DestroyBuffer(batch.TemporaryBuffers[i], batch.TemporaryMemories[i]);
+		}
+		batch.TemporaryBuffers.clear();
+		batch.TemporaryMemories.clear();
+
+		vkResetFences(_vulkan->_device, 1, &batch.Fence);
+		_freeBatches.push_back(batch);
+		_inFlight.pop_front();
+	}
+
+	// start from the beginning when nothing is in use, keeps big uploads from wrapping
+	if (_inFlight.empty() && !_recordingStarted)
+	{
+		_head = 0;
+		_tail = 0;
+	}
+}
+
+bool Uploader::AllocateStaging(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize* offset)
+{
+	VkDeviceSize alignedHead = (_head + alignment - 1) & ~(alignment - 1);
+
+	if (_head >= _tail)
+	{
+		// free space is [head, end) and [0, tail)
+		if (alignedHead + size <= _stagingSize)
+		{
+			*offset = alignedHead;
+			_head = alignedHead + size;
+			return true;
+		}
+
+		// head must never catch up with the tail, equal offsets mean an empty ring
+		if (size < _tail)
+		{
+			*offset = 0;
+			_head = size;
+			return true;
+		}
+	}
+	else if (alignedHead + size < _tail)
+	{
+		// free space is [head, tail)
+		*offset = alignedHead;
+		_head = alignedHead + size;
+		return true;
+	}
+
+	return false;
+}
+
+void Uploader::GetStaging(VkDeviceSize size, VkDeviceSize alignment, const void* data, VkBuffer* buffer, VkDeviceSize* offset)
+{
+	// uploads bigger than half the ring get their own staging buffer
+	if (size > _stagingSize / 2)
+	{
+		VkBuffer temporaryBuffer;
+		MemoryAllocation temporaryMemory;
+		_vulkan->CreateBuffer(
+			size,
+			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			temporaryBuffer,
+			temporaryMemory
+		);
+		_vulkan->CopyToMemory(temporaryMemory, 0, size, (void*)data);
+
+		BeginRecording();
+		_recording.TemporaryBuffers.push_back(temporaryBuffer);
+		_recording.TemporaryMemories.push_back(temporaryMemory);
+
+		*buffer = temporaryBuffer;
+		*offset = 0;
+		return;
+	}
+
+	while (!AllocateStaging(size, alignment, offset))
+	{
+		// the ring is full, submit what we have and wait for the oldest batch to free its part
+		Submit(true);
+		RetireBatches(true);
+	}
+
+	memcpy((char*)_stagingMemory.MappedData + *offset, data, size);
+	*buffer = _stagingBuffer;
+
+	BeginRecording();
+}
+
+void Uploader::BeginRecording()
+{
+	if (_recordingStarted)
+	{
+		return;
+	}
+
+	if (!_freeBatches.empty())
+	{
+		_recording = _freeBatches.back();
+		_freeBatches.pop_back();
+	}
+	else
+	{
+		VkCommandBufferAllocateInfo allocateInfo{};
+		allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocateInfo.commandPool = _commandPool;
+		allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocateInfo.commandBufferCount = 1;
+		vkAllocateCommandBuffers(_vulkan->_device, &allocateInfo, &_recording.CommandBuffer);
+
+		VkFenceCreateInfo fenceCreateInfo{};
+		fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+		vkCreateFence(_vulkan->_device, &fenceCreateInfo, nullptr, &_recording.Fence);
+	}
+
+	_recording.Id = _nextBatchId++;
+
+	VkCommandBufferBeginInfo beginInfo{};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	vkBeginCommandBuffer(_recording.CommandBuffer, &beginInfo);
+
+	_recordingStarted = true;
+}
+
+VkSemaphore Uploader::GetSemaphore()
+{
+	if (!_freeSemaphores.empty())
+	{
+		VkSemaphore semaphore = _freeSemaphores.back();
+		_freeSemaphores.pop_back();
+		return semaphore;
+	}
+
+	VkSemaphoreCreateInfo createInfo{};
+	createInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+	VkSemaphore semaphore;
+	vkCreateSemaphore(_vulkan->_device, &createInfo, nullptr, &semaphore);
+	return semaphore;
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include "../../API.h"
+#include "MemoryAllocator.h"
+
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <deque>
+
+namespace Euler
+{
+	namespace Graphics
+	{
+		class Vulkan;
+		class Uploader;
+
+		// pixels of one mip level
+		struct EULER_API ImageLevel
+		{
+			const void* Data = nullptr;
+			VkDeviceSize Size = 0;
+		};
+
+		/// <summary>
+		/// Returned by the uploader for every copy. The resource can be used in a frame once
+		/// IsReady() returns true.
+		/// </summary>
+		struct EULER_API UploadHandle
+		{
+			Uploader* Owner = nullptr;
+			uint64_t Batch = 0;
+
+			bool IsReady() const;
+			bool IsComplete() const;
+		};
+
+		/// <summary>
+		/// Copies data to device local buffers and images on the transfer queue. The data is
+		/// written into a persistently mapped staging ring and recorded into a batch; batches are
+		/// submitted at the end of the frame and the frame's graphics submit waits on their
+		/// semaphores. Must only be used from the render thread.
+		/// </summary>
+		class EULER_API Uploader
+		{
+		public:
+			static const VkDeviceSize DEFAULT_STAGING_SIZE = 64 * 1024 * 1024;
+
+		private:
+			struct Batch
+			{
+				uint64_t Id = 0;
+				VkCommandBuffer CommandBuffer = VK_NULL_HANDLE;
+				VkFence Fence = VK_NULL_HANDLE;
+				VkSemaphore Semaphore = VK_NULL_HANDLE;
+				VkDeviceSize RingEnd = 0;
+				// staging buffers for uploads that don't fit in the ring
+				std::vector<VkBuffer> TemporaryBuffers;
+				std::vector<MemoryAllocation> TemporaryMemories;
+			};
+
+			Vulkan* _vulkan = nullptr;
+
+			VkQueue _queue = VK_NULL_HANDLE;
+			// blits need a graphics queue, a dedicated transfer queue can only copy
+			bool _queueSupportsBlit = false;
+			VkCommandPool _commandPool = VK_NULL_HANDLE;
+
+			VkBuffer _stagingBuffer = VK_NULL_HANDLE;
+			MemoryAllocation _stagingMemory;
+			VkDeviceSize _stagingSize = 0;
+			VkDeviceSize _head = 0;
+			VkDeviceSize _tail = 0;
+
+			Batch _recording;
+			bool _recordingStarted = false;
+			std::deque<Batch> _inFlight;
+			std::vector<Batch> _freeBatches;
+
+			uint64_t _nextBatchId = 1;
+			uint64_t _lastSubmittedBatch = 0;
+			uint64_t _lastCompletedBatch = 0;
+
+			// semaphores the next graphics submit has to wait on
+			std::vector<VkSemaphore> _pendingWaitSemaphores;
+			// semaphores waited on by each frame in flight, recycled when the frame's fence is signaled
+			std::vector<std::vector<VkSemaphore>> _frameWaitSemaphores;
+			std::vector<VkSemaphore> _freeSemaphores;
+
+		public:
+			void Create(Vulkan* vulkan, VkQueue queue, uint32_t queueFamilyIndex, VkDeviceSize stagingSize = DEFAULT_STAGING_SIZE);
+			void Destroy();
+
+			UploadHandle UploadBuffer(VkBuffer buffer, VkDeviceSize offset, const void* data, VkDeviceSize size);
+			// uploads the first mip level and leaves the image in SHADER_READ_ONLY_OPTIMAL layout. The other mipLevels - 1
+			// levels are blitted from it, which needs CanGenerateMipLevels and an image with TRANSFER_SRC usage
+			UploadHandle UploadImage(VkImage image, uint32_t width, uint32_t height, const void* data, VkDeviceSize size, uint32_t mipLevels = 1);
+			// uploads the given levels, level i being half the size of level i - 1, and blits the rest of mipLevels from the last one
+			UploadHandle UploadImageLevels(VkImage image, uint32_t width, uint32_t height, const std::vector<ImageLevel>& levels, uint32_t mipLevels);
+			// whether the upload queue can blit mip levels of images with the format, with linear filtering
+			bool CanGenerateMipLevels(VkFormat format) const;
+
+			// submits the recorded batch, called by Vulkan right before the graphics submit
+			void Flush();
+			// recycles finished batches and the semaphores waited on by the given frame
+			void Update(int frame);
+			// submits everything and blocks until the transfers are finished
+			void WaitIdle();
+			void Wait(const UploadHandle& handle);
+
+			bool IsSubmitted(uint64_t batch) const;
+			bool IsComplete(uint64_t batch) const;
+
+			// moves the pending semaphores to the given frame, they have to be waited on in its submit
+			std::vector<VkSemaphore>& TakeWaitSemaphores(int frame);
+
+		private:
+			void Submit(bool signalSemaphore);
+			void RetireBatches(bool wait);
+			bool AllocateStaging(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize* offset);
+			void GetStaging(VkDeviceSize size, VkDeviceSize alignment, const void* data, VkBuffer* buffer, VkDeviceSize* offset);
+			void BeginRecording();
+			VkSemaphore GetSemaphore();
+		};
+	}
+}
@@ -5,6 +5,8 @@ using namespace Euler::Graphics;
 #include <assert.h>
 #include <iostream>
 #include <algorithm>
+#include <string.h>
+#include <chrono>
 
 #include "../../io/Utils.h"
 #include "../../math/Matrices.h"
@@ -42,26 +44,49 @@ void Vulkan::InitRenderer(uint32_t width, uint32_t height)
 {
 	_extent = { width, height };
 
-	CreateSwapchain();
+	if (_headless)
+	{
+		CreateOffscreenImages();
+	}
+	else
+	{
+		CreateSwapchain();
+	}
 	CreateRenderPass();
 	CreateDepthImage();
 	CreateFramebuffers();
 	CreateCommandPools();
 	AllocateCommandBuffers();
 	CreateFrameSyncObjects();
+
+	_commandRecorder.Create(this, _recordingThreadCount, _framesInFlight);
 }
 
 void Vulkan::Cleanup()
 {
 	vkDeviceWaitIdle(_device);
 
+	_commandRecorder.Destroy();
 	DestroyFrameSyncObjects();
 	FreeCommandBuffers();
 	DestroyCommandPools();
 	DestroyFramebuffers();
 	DestroyDepthImage();
 	DestroyRenderPass();
-	DestroySwapchain();
+	if (_headless)
+	{
+		DestroyOffscreenImages();
+	}
+	else
+	{
+		DestroySwapchain();
+	}
+
+	if (!_pipelineCache.Save())
+	{
+		LOG("Save Pipeline Cache", "failed");
+	}
+
 	DestroyDevice();
 	DestroyDebugUtilsMessengerEXT(_instance, _debugMessenger, nullptr);
 	DestroyInstance();
@@ -78,9 +103,23 @@ void Vulkan::RecreateSwapchain(uint32_t width, uint32_t height)
 	DestroyFramebuffers();
 	DestroyDepthImage();
 	DestroyRenderPass();
-	DestroySwapchain();
+	if (_headless)
+	{
+		DestroyOffscreenImages();
+	}
+	else
+	{
+		DestroySwapchain();
+	}
 
-	CreateSwapchain();
+	if (_headless)
+	{
+		CreateOffscreenImages();
+	}
+	else
+	{
+		CreateSwapchain();
+	}
 	CreateRenderPass();
 	CreateDepthImage();
 	CreateFramebuffers();
@@ -127,10 +166,10 @@ void Vulkan::CreateInstance(const char* appName, uint32_t appVersion, std::vecto
 	appInfo.pEngineName = EULER_ENGINE_NAME;
 	appInfo.pApplicationName = appName;
 	appInfo.applicationVersion = appVersion;
-	appInfo.apiVersion = VK_VERSION_1_1;							// TODO: Allow the engine/user to set the Vulkan version
+	appInfo.apiVersion = VK_API_VERSION_1_1;							// TODO: Allow the engine/user to set the Vulkan version
 
 	VkInstanceCreateInfo createInfo{};
-	createInfo.sType = VK_STRUCTURE_TYPE_IOS_SURFACE_CREATE_INFO_MVK;
+	createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
 	createInfo.pApplicationInfo = &appInfo;
 	createInfo.enabledLayerCount = (uint32_t)requiredLayerNames.size();
 	createInfo.ppEnabledLayerNames = requiredLayerNames.data();
@@ -269,10 +308,14 @@ void Vulkan::DestroyDebugUtilsMessengerEXT(VkInstance instance, VkDebugUtilsMess
 void Vulkan::CreateDevice(VkSurfaceKHR surface, VkPhysicalDeviceFeatures* enabledFeatures, std::vector<const char*> requiredDeviceLayerNames, std::vector<const char*> requiredDeviceExtensionNames)
 {
 	_surface = surface;
+	_headless = surface == VK_NULL_HANDLE;
 
 	// add required layers and extensions
 	requiredDeviceLayerNames.push_back("VK_LAYER_KHRONOS_validation");
-	requiredDeviceExtensionNames.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+	if (!_headless)
+	{
+		requiredDeviceExtensionNames.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+	}
 
 	// add required features
 	enabledFeatures->samplerAnisotropy = VK_TRUE;
@@ -300,7 +343,7 @@ void Vulkan::CreateDevice(VkSurfaceKHR surface, VkPhysicalDeviceFeatures* enable
 		vkGetPhysicalDeviceQueueFamilyProperties(handle, &queueFamilyPropertyCount, nullptr);
 		std::vector<VkQueueFamilyProperties> queueFamilyProperties(queueFamilyPropertyCount);
 		vkGetPhysicalDeviceQueueFamilyProperties(handle, &queueFamilyPropertyCount, queueFamilyProperties.data());
-		physicalDevice->QueueFamilies.resize(queueFamilyPropertyCount);
+		physicalDevice->QueueFamilies.reserve(queueFamilyPropertyCount);
 
 		for (uint32_t i = 0; i < queueFamilyProperties.size(); i++)
 		{
@@ -314,15 +357,36 @@ void Vulkan::CreateDevice(VkSurfaceKHR surface, VkPhysicalDeviceFeatures* enable
 			queueFamily.Compute = (VK_QUEUE_COMPUTE_BIT & familyProperties.queueFlags) > 0;
 			queueFamily.Sparse = (VK_QUEUE_SPARSE_BINDING_BIT & familyProperties.queueFlags) > 0;
 
-			vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physicalDevice->Handle, _surface, &physicalDevice->SurfaceCapabilities);
+			if (_headless)
+			{
+				// nothing is presented, the graphics queue doubles as the present queue
+				queueFamily.Present = queueFamily.Graphics;
+			}
+			else
+			{
+				vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physicalDevice->Handle, _surface, &physicalDevice->SurfaceCapabilities);
 
-			VkBool32 presentSupported{};
-			vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevice->Handle, i, _surface, &presentSupported);
-			queueFamily.Present = presentSupported == VK_TRUE;
+				VkBool32 presentSupported{};
+				vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevice->Handle, i, _surface, &presentSupported);
+				queueFamily.Present = presentSupported == VK_TRUE;
+			}
 
 			physicalDevice->QueueFamilies.push_back(queueFamily);
 		}
 
+		vkGetPhysicalDeviceMemoryProperties(physicalDevice->Handle, &physicalDevice->MemoryProperties);
+		vkGetPhysicalDeviceFeatures(physicalDevice->Handle, &physicalDevice->Features);
+
+		uint32_t extensionCount;
+		vkEnumerateDeviceExtensionProperties(physicalDevice->Handle, nullptr, &extensionCount, nullptr);
+		physicalDevice->Extensions.resize(extensionCount);
+		vkEnumerateDeviceExtensionProperties(physicalDevice->Handle, nullptr, &extensionCount, physicalDevice->Extensions.data());
+
+		if (_headless)
+		{
+			continue;
+		}
+
 		uint32_t surfaceFormatCount;
 		vkGetPhysicalDeviceSurfaceFormatsKHR(physicalDevice->Handle, _surface, &surfaceFormatCount, nullptr);
 		physicalDevice->SurfaceFormats.resize(surfaceFormatCount);
@@ -332,8 +396,6 @@ void Vulkan::CreateDevice(VkSurfaceKHR surface, VkPhysicalDeviceFeatures* enable
 		vkGetPhysicalDeviceSurfacePresentModesKHR(physicalDevice->Handle, _surface, &presentModeCount, nullptr);
 		physicalDevice->PresentModes.resize(presentModeCount);
 		vkGetPhysicalDeviceSurfacePresentModesKHR(physicalDevice->Handle, _surface, &presentModeCount, physicalDevice->PresentModes.data());
-
-		vkGetPhysicalDeviceMemoryProperties(physicalDevice->Handle, &physicalDevice->MemoryProperties);
 	}
 
 	// pick physical device
@@ -342,9 +404,66 @@ void Vulkan::CreateDevice(VkSurfaceKHR surface, VkPhysicalDeviceFeatures* enable
 
 	// TODO: check if the required features, layers and extensions are supported
 
+	// enable indirect drawing features when the device supports them
+	_multiDrawIndirect = _physicalDevice->Features.multiDrawIndirect == VK_TRUE;
+	_drawIndirectFirstInstance = _physicalDevice->Features.drawIndirectFirstInstance == VK_TRUE;
+	_drawIndirectCount = IsDeviceExtensionSupported(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+	enabledFeatures->multiDrawIndirect = _physicalDevice->Features.multiDrawIndirect;
+	enabledFeatures->drawIndirectFirstInstance = _physicalDevice->Features.drawIndirectFirstInstance;
+	if (_drawIndirectCount)
+	{
+		requiredDeviceExtensionNames.push_back(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+	}
+
+	// cooked textures are block compressed
+	_textureCompressionBC = _physicalDevice->Features.textureCompressionBC == VK_TRUE;
+	enabledFeatures->textureCompressionBC = _physicalDevice->Features.textureCompressionBC;
+
+	// streamed textures stay within the heap budget the driver reports
+	_memoryBudget = IsDeviceExtensionSupported(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+	if (_memoryBudget)
+	{
+		requiredDeviceExtensionNames.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+	}
+
+	// enable the descriptor indexing features the bindless table needs when the device supports them
+	VkPhysicalDeviceDescriptorIndexingFeaturesEXT descriptorIndexingFeatures{};
+	descriptorIndexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+	if (IsDeviceExtensionSupported(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME))
+	{
+		VkPhysicalDeviceFeatures2 features{};
+		features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		features.pNext = &descriptorIndexingFeatures;
+		vkGetPhysicalDeviceFeatures2(_physicalDevice->Handle, &features);
+
+		_descriptorIndexing = descriptorIndexingFeatures.shaderSampledImageArrayNonUniformIndexing
+			&& descriptorIndexingFeatures.runtimeDescriptorArray
+			&& descriptorIndexingFeatures.descriptorBindingPartiallyBound
+			&& descriptorIndexingFeatures.descriptorBindingSampledImageUpdateAfterBind;
+	}
+
+	VkPhysicalDeviceDescriptorIndexingFeaturesEXT enabledDescriptorIndexingFeatures{};
+	enabledDescriptorIndexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+	if (_descriptorIndexing)
+	{
+		enabledDescriptorIndexingFeatures.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+		enabledDescriptorIndexingFeatures.runtimeDescriptorArray = VK_TRUE;
+		enabledDescriptorIndexingFeatures.descriptorBindingPartiallyBound = VK_TRUE;
+		enabledDescriptorIndexingFeatures.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+		requiredDeviceExtensionNames.push_back(VK_KHR_MAINTENANCE3_EXTENSION_NAME);
+		requiredDeviceExtensionNames.push_back(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME);
+	}
+
+	if (_headless)
+	{
+		// offscreen images are created in RGBA so they can be read back without swizzling
+		_surfaceFormat = { VK_FORMAT_R8G8B8A8_SRGB, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR };
+		_presentMode = VK_PRESENT_MODE_FIFO_KHR;
+	}
+
 	// select surface format
-	ASSERT(_physicalDevice->SurfaceFormats.size() > 0, "");
-	bool formatSelected = false;
+	ASSERT(_headless || _physicalDevice->SurfaceFormats.size() > 0, "");
+	bool formatSelected = _headless;
 	for (auto& surfaceFormat : _physicalDevice->SurfaceFormats)
 	{
 		if (surfaceFormat.format == VK_FORMAT_B8G8R8A8_SRGB && surfaceFormat.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR)
@@ -361,8 +480,8 @@ void Vulkan::CreateDevice(VkSurfaceKHR surface, VkPhysicalDeviceFeatures* enable
 	}
 
 	// select present mode
-	ASSERT(_physicalDevice->PresentModes.size() > 0, "");
-	bool presentModeSelected = false;
+	ASSERT(_headless || _physicalDevice->PresentModes.size() > 0, "");
+	bool presentModeSelected = _headless;
 	for (auto& presentMode : _physicalDevice->PresentModes)
 	{
 		if (presentMode == VK_PRESENT_MODE_MAILBOX_KHR)
@@ -400,6 +519,34 @@ void Vulkan::CreateDevice(VkSurfaceKHR surface, VkPhysicalDeviceFeatures* enable
 		}
 	}
 	ASSERT(presentQueueFamily != nullptr, "Select Present Queue Family");
+
+	// prefer a transfer-only family (usually a dedicated copy engine), then any non-graphics family
+	// that can do transfers and fall back to the graphics queue
+	QueueFamily* transferQueueFamily = nullptr;
+	for (auto& queueFamily : _physicalDevice->QueueFamilies)
+	{
+		if (queueFamily.Transfer && !queueFamily.Graphics && !queueFamily.Compute)
+		{
+			transferQueueFamily = &queueFamily;
+			break;
+		}
+	}
+	if (transferQueueFamily == nullptr)
+	{
+		for (auto& queueFamily : _physicalDevice->QueueFamilies)
+		{
+			if (queueFamily.Transfer && !queueFamily.Graphics)
+			{
+				transferQueueFamily = &queueFamily;
+				break;
+			}
+		}
+	}
+	if (transferQueueFamily == nullptr)
+	{
+		transferQueueFamily = graphicsQueueFamily;
+	}
+	bool separateTransferQueue = transferQueueFamily->Index != graphicsQueueFamily->Index && transferQueueFamily->Index != presentQueueFamily->Index;
 	
 	std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
 
@@ -435,6 +582,18 @@ void Vulkan::CreateDevice(VkSurfaceKHR surface, VkPhysicalDeviceFeatures* enable
 		queueCreateInfos.push_back(presentQueueCreateInfo);
 	}
 
+	const float transferPriority = 1.0f;
+	if (separateTransferQueue)
+	{
+		VkDeviceQueueCreateInfo transferQueueCreateInfo{};
+		transferQueueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+		transferQueueCreateInfo.queueFamilyIndex = transferQueueFamily->Index;
+		transferQueueCreateInfo.queueCount = 1;
+		transferQueueCreateInfo.pQueuePriorities = &transferPriority;
+
+		queueCreateInfos.push_back(transferQueueCreateInfo);
+	}
+
 	// set-up device
 	VkDeviceCreateInfo createInfo{};
 	createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -443,6 +602,7 @@ void Vulkan::CreateDevice(VkSurfaceKHR surface, VkPhysicalDeviceFeatures* enable
 	createInfo.enabledExtensionCount = requiredDeviceExtensionNames.size();
 	createInfo.ppEnabledExtensionNames = requiredDeviceExtensionNames.data();
 	createInfo.pEnabledFeatures = enabledFeatures;
+	createInfo.pNext = _descriptorIndexing ? &enabledDescriptorIndexingFeatures : nullptr;
 	createInfo.queueCreateInfoCount = queueCreateInfos.size();
 	createInfo.pQueueCreateInfos = queueCreateInfos.data();
 	
@@ -462,11 +622,52 @@ void Vulkan::CreateDevice(VkSurfaceKHR surface, VkPhysicalDeviceFeatures* enable
 		vkGetDeviceQueue(_device, presentQueueFamily->Index, 0, &_presentQueue);
 	}
 	ASSERT(_graphicsQueue != nullptr, "Get Graphics Queue");
+
+	if (_drawIndirectCount)
+	{
+		_vkCmdDrawIndexedIndirectCount = (PFN_vkCmdDrawIndexedIndirectCountKHR)vkGetDeviceProcAddr(_device, "vkCmdDrawIndexedIndirectCountKHR");
+		_drawIndirectCount = _vkCmdDrawIndexedIndirectCount != nullptr;
+	}
 	ASSERT(_presentQueue != nullptr, "Get Present Queue");
+
+	if (separateTransferQueue)
+	{
+		_transferQueueFamilyIndex = transferQueueFamily->Index;
+		vkGetDeviceQueue(_device, transferQueueFamily->Index, 0, &_transferQueue);
+	}
+	else
+	{
+		// the queue is shared with the graphics (or present) queue
+		_transferQueueFamilyIndex = transferQueueFamily->Index;
+		_transferQueue = transferQueueFamily->Index == graphicsQueueFamily->Index ? _graphicsQueue : _presentQueue;
+	}
+	ASSERT(_transferQueue != nullptr, "Get Transfer Queue");
+	LOG("Transfer queue family", _transferQueueFamilyIndex);
+
+	_memoryAllocator.Create(_device, _physicalDevice->MemoryProperties, _physicalDevice->Properties.limits);
+	_samplerCache.Create(_device, _physicalDevice->Properties.limits, enabledFeatures->samplerAnisotropy == VK_TRUE);
+	_uploader.Create(this, _transferQueue, _transferQueueFamilyIndex);
+	_frameAllocator.Create(this, _framesInFlight, _frameAllocatorSize);
+	_pipelineCache.Create(_device, _physicalDevice->Properties, _pipelineCacheFilePath);
+	_bindless.Create(this);
+	_textureStreamer.Create(this);
 }
 
 void Vulkan::DestroyDevice()
 {
+	_pipelineCache.Destroy();
+	_textureStreamer.Destroy();
+	_bindless.Destroy();
+	for (auto arena : _geometryArenas)
+	{
+		arena->Destroy();
+		delete arena;
+	}
+	_geometryArenas.clear();
+	_frameAllocator.Destroy();
+	_uploader.Destroy();
+	_samplerCache.Destroy();
+	_memoryAllocator.Destroy();
 	vkDestroyDevice(_device, nullptr);
 	LOG("Create Device", "Destroyed");
 }
@@ -550,6 +751,123 @@ void Vulkan::DestroySwapchain()
 	vkDestroySwapchainKHR(_device, _swapchain, nullptr);
 }
 
+void Vulkan::CreateOffscreenImages()
+{
+	// one image per frame in flight so the current image always matches the current frame
+	_swapchainImages.resize(_framesInFlight);
+	_swapchainImageViews.resize(_framesInFlight);
+	_offscreenImageMemories.resize(_framesInFlight);
+
+	for (int i = 0; i < _swapchainImages.size(); i++)
+	{
+		CreateImage(
+			_extent.width,
+			_extent.height,
+			_surfaceFormat.format,
+			VK_IMAGE_TILING_OPTIMAL,
+			VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			_swapchainImages[i],
+			_offscreenImageMemories[i]
+		);
+
+		VkImageViewCreateInfo imageViewCreateInfo{};
+		imageViewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		imageViewCreateInfo.image = _swapchainImages[i];
+		imageViewCreateInfo.format = _surfaceFormat.format;
+		imageViewCreateInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		imageViewCreateInfo.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+		imageViewCreateInfo.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+		imageViewCreateInfo.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+		imageViewCreateInfo.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+		imageViewCreateInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		imageViewCreateInfo.subresourceRange.levelCount = 1;
+		imageViewCreateInfo.subresourceRange.baseMipLevel = 0;
+		imageViewCreateInfo.subresourceRange.layerCount = 1;
+		imageViewCreateInfo.subresourceRange.baseArrayLayer = 0;
+
+		HANDLE_VKRESULT(vkCreateImageView(_device, &imageViewCreateInfo, nullptr, &_swapchainImageViews[i]), "Create Image View");
+	}
+}
+
+void Vulkan::DestroyOffscreenImages()
+{
+	for (int i = 0; i < _swapchainImages.size(); i++)
+	{
+		vkDestroyImageView(_device, _swapchainImageViews[i], nullptr);
+		DestroyImage(_swapchainImages[i], _offscreenImageMemories[i]);
+	}
+}
+
+void Vulkan::ReadbackImage(std::vector<uint8_t>& pixels)
+{
+	// swapchain images can't be copied from, only offscreen images are created with TRANSFER_SRC usage
+	ASSERT(_headless);
+
+	vkDeviceWaitIdle(_device);
+
+	VkDeviceSize size = _extent.width * _extent.height * 4;
+
+	VkBuffer readbackBuffer;
+	MemoryAllocation readbackMemory;
+	CreateBuffer(size, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, readbackBuffer, readbackMemory);
+
+	VkCommandBuffer commandBuffer = BeginSingleUseCommandBuffer();
+
+	// the render pass leaves the image in TRANSFER_SRC_OPTIMAL, only the writes have to be made visible
+	VkImageMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+	barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = _swapchainImages[_currentImage];
+	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	barrier.subresourceRange.baseMipLevel = 0;
+	barrier.subresourceRange.levelCount = 1;
+	barrier.subresourceRange.baseArrayLayer = 0;
+	barrier.subresourceRange.layerCount = 1;
+	barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+	VkBufferImageCopy region{};
+	region.bufferOffset = 0;
+	region.bufferRowLength = 0;
+	region.bufferImageHeight = 0;
+	region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	region.imageSubresource.mipLevel = 0;
+	region.imageSubresource.baseArrayLayer = 0;
+	region.imageSubresource.layerCount = 1;
+	region.imageOffset = { 0, 0, 0 };
+	region.imageExtent = { _extent.width, _extent.height, 1 };
+
+	vkCmdCopyImageToBuffer(commandBuffer, _swapchainImages[_currentImage], VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, readbackBuffer, 1, &region);
+
+	VkBufferMemoryBarrier bufferBarrier{};
+	bufferBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	bufferBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	bufferBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	bufferBarrier.buffer = readbackBuffer;
+	bufferBarrier.offset = 0;
+	bufferBarrier.size = VK_WHOLE_SIZE;
+	bufferBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	bufferBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1, &bufferBarrier, 0, nullptr);
+
+	EndSingleUseCommandBuffer(commandBuffer);
+
+	void* data;
+	MapMemory(readbackMemory, 0, size, &data);
+	pixels.resize(size);
+	memcpy(pixels.data(), data, size);
+	UnmapMemory(readbackMemory);
+
+	DestroyBuffer(readbackBuffer, readbackMemory);
+}
+
 void Vulkan::CreateShadowRenderPass(VkRenderPass* renderPass)
 {
 	/* === SETUP ATTACHMENTS === */
@@ -634,7 +952,7 @@ void Vulkan::CreateRenderPass()
 	VkAttachmentDescription colorAttachmentDescription{};
 	colorAttachmentDescription.format = _surfaceFormat.format;
 	colorAttachmentDescription.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-	colorAttachmentDescription.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+	colorAttachmentDescription.finalLayout = _headless ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
 	colorAttachmentDescription.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
 	colorAttachmentDescription.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
 	colorAttachmentDescription.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
@@ -646,7 +964,7 @@ void Vulkan::CreateRenderPass()
 	depthAttachmentDescription.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 	depthAttachmentDescription.finalLayout = VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL;
 	depthAttachmentDescription.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-	depthAttachmentDescription.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	depthAttachmentDescription.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
 	depthAttachmentDescription.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 	depthAttachmentDescription.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
 
@@ -671,10 +989,19 @@ void Vulkan::CreateRenderPass()
 	createInfo.pDependencies = &dependency;
 
 	HANDLE_VKRESULT(vkCreateRenderPass(_device, &createInfo, nullptr, &_renderPass), "Create Render Pass");
+
+	// the load pass starts from what the first pass left
+	attachments[0].loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+	attachments[0].initialLayout = attachments[0].finalLayout;
+	attachments[1].loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+	attachments[1].initialLayout = attachments[1].finalLayout;
+
+	HANDLE_VKRESULT(vkCreateRenderPass(_device, &createInfo, nullptr, &_loadRenderPass), "Create Render Pass");
 }
 
 void Vulkan::DestroyRenderPass()
 {	vkDestroyRenderPass(_device, _renderPass, nullptr);
+	vkDestroyRenderPass(_device, _loadRenderPass, nullptr);
 	LOG("Create Render Pass", "Destroyed");
 }
 
@@ -877,7 +1204,9 @@ void Vulkan::CreatePipeline(const PipelineInfo* pipelineInfo, VkPipelineLayout*
 	createInfo.renderPass = pipelineInfo->RenderPass;
 	createInfo.subpass = 0;
 
-	HANDLE_VKRESULT(vkCreateGraphicsPipelines(_device, VK_NULL_HANDLE, 1, &createInfo, nullptr, pipeline), "");
+	auto startTime = std::chrono::high_resolution_clock::now();
+	HANDLE_VKRESULT(vkCreateGraphicsPipelines(_device, _pipelineCache.Get(), 1, &createInfo, nullptr, pipeline), "");
+	_pipelineCreationTime += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
 
 	/* === CLEAN UP === */
 
@@ -1054,7 +1383,9 @@ void Vulkan::CreatePipeline(const Euler::Graphics::RendererInfo* rendererInfo, V
 	createInfo.renderPass = rendererInfo->RenderPass;
 	createInfo.subpass = 0;
 
-	HANDLE_VKRESULT(vkCreateGraphicsPipelines(_device, VK_NULL_HANDLE, 1, &createInfo, nullptr, pipeline), "");
+	auto startTime = std::chrono::high_resolution_clock::now();
+	HANDLE_VKRESULT(vkCreateGraphicsPipelines(_device, _pipelineCache.Get(), 1, &createInfo, nullptr, pipeline), "");
+	_pipelineCreationTime += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
 
 	/* === CLEAN UP === */
 
@@ -1068,6 +1399,73 @@ void Vulkan::DestroyPipeline(VkPipelineLayout pipelineLayout, VkPipeline pipelin
 	vkDestroyPipelineLayout(_device, pipelineLayout, nullptr);
 }
 
+void Vulkan::CreateComputePipeline(const ComputePipelineInfo* pipelineInfo, VkPipelineLayout* pipelineLayout, VkPipeline* pipeline)
+{
+	/* === PIPELINE SHADER AND STAGE === */
+
+	VkShaderModule shaderModule;
+	CreateShaderModule(pipelineInfo->ShaderCode, pipelineInfo->ShaderCodeSize, &shaderModule);
+
+	VkPipelineShaderStageCreateInfo stageCreateInfo{};
+	stageCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	stageCreateInfo.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	stageCreateInfo.module = shaderModule;
+	stageCreateInfo.pName = "main";
+
+	/* === PIPELINE LAYOUT === */
+
+	VkPushConstantRange pushConstantRange{};
+	pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	pushConstantRange.offset = 0;
+	pushConstantRange.size = pipelineInfo->PushConstantSize;
+
+	VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo{};
+	pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutCreateInfo.setLayoutCount = pipelineInfo->DescriptorSetLayouts.size();
+	pipelineLayoutCreateInfo.pSetLayouts = pipelineInfo->DescriptorSetLayouts.data();
+	pipelineLayoutCreateInfo.pushConstantRangeCount = pipelineInfo->PushConstantSize > 0 ? 1 : 0;
+	pipelineLayoutCreateInfo.pPushConstantRanges = &pushConstantRange;
+
+	HANDLE_VKRESULT(vkCreatePipelineLayout(_device, &pipelineLayoutCreateInfo, nullptr, pipelineLayout), "");
+
+	/* === CREATE PIPELINE === */
+
+	VkComputePipelineCreateInfo createInfo{};
+	createInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	createInfo.stage = stageCreateInfo;
+	createInfo.layout = *pipelineLayout;
+
+	auto startTime = std::chrono::high_resolution_clock::now();
+	HANDLE_VKRESULT(vkCreateComputePipelines(_device, _pipelineCache.Get(), 1, &createInfo, nullptr, pipeline), "");
+	_pipelineCreationTime += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+
+	/* === CLEAN UP === */
+
+	DestroyShaderModule(shaderModule);
+}
+
+void Vulkan::Dispatch(VkCommandBuffer commandBuffer, VkPipeline pipeline, VkPipelineLayout pipelineLayout, const void* pushConstants, uint32_t pushConstantSize, uint32_t threadCount, uint32_t groupSize)
+{
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+
+	if (pushConstantSize > 0)
+	{
+		vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, pushConstantSize, pushConstants);
+	}
+
+	vkCmdDispatch(commandBuffer, (threadCount + groupSize - 1) / groupSize, 1, 1);
+}
+
+void Vulkan::PipelineBarrier(VkCommandBuffer commandBuffer, VkPipelineStageFlags srcStage, VkAccessFlags srcAccess, VkPipelineStageFlags dstStage, VkAccessFlags dstAccess)
+{
+	VkMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = srcAccess;
+	barrier.dstAccessMask = dstAccess;
+
+	vkCmdPipelineBarrier(commandBuffer, srcStage, dstStage, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+
 void Vulkan::CreateFramebuffers()
 {
 	_swapchainFramebuffers.resize(_swapchainImageViews.size());
@@ -1200,7 +1598,7 @@ uint32_t Vulkan::FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags prope
 	return UINT32_MAX;
 }
 
-void Vulkan::CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& deviceMemory)
+void Vulkan::CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, MemoryAllocation& memory)
 {
 	VkBufferCreateInfo createInfo{};
 	createInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -1208,25 +1606,33 @@ void Vulkan::CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryP
 	createInfo.usage = usage;
 	createInfo.size = size;
 
+	// buffers filled by the uploader are shared with the transfer queue
+	uint32_t queueFamilyIndices[] = { _graphicsQueueFamilyIndex, _transferQueueFamilyIndex };
+	if ((usage & VK_BUFFER_USAGE_TRANSFER_DST_BIT) != 0 && _graphicsQueueFamilyIndex != _transferQueueFamilyIndex)
+	{
+		createInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+		createInfo.queueFamilyIndexCount = 2;
+		createInfo.pQueueFamilyIndices = queueFamilyIndices;
+	}
+
 	HANDLE_VKRESULT(vkCreateBuffer(_device, &createInfo, nullptr, &buffer), "Create Buffer");
 
 	VkMemoryRequirements memreq;
 	vkGetBufferMemoryRequirements(_device, buffer, &memreq);
 
-	VkMemoryAllocateInfo allocateInfo{};
-	allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-	allocateInfo.allocationSize = memreq.size;
-	allocateInfo.memoryTypeIndex = FindMemoryType(memreq.memoryTypeBits, properties);
-	ASSERT(allocateInfo.memoryTypeIndex < UINT32_MAX);
+	uint32_t memoryTypeIndex = FindMemoryType(memreq.memoryTypeBits, properties);
+	ASSERT(memoryTypeIndex < UINT32_MAX);
+
+	memory = _memoryAllocator.Allocate(memreq, memoryTypeIndex, false);
+	ASSERT(memory.Memory != VK_NULL_HANDLE);
 
-	HANDLE_VKRESULT(vkAllocateMemory(_device, &allocateInfo, nullptr, &deviceMemory), "Allocate Buffer Memory");
-	HANDLE_VKRESULT(vkBindBufferMemory(_device, buffer, deviceMemory, 0), "Bind Buffer Memory");
+	HANDLE_VKRESULT(vkBindBufferMemory(_device, buffer, memory.Memory, memory.Offset), "Bind Buffer Memory");
 }
 
-void Vulkan::DestroyBuffer(VkBuffer buffer, VkDeviceMemory deviceMemory)
+void Vulkan::DestroyBuffer(VkBuffer buffer, MemoryAllocation& memory)
 {
 	vkDestroyBuffer(_device, buffer, nullptr);
-	vkFreeMemory(_device, deviceMemory, nullptr);
+	_memoryAllocator.Free(memory);
 }
 
 void Vulkan::CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size)
@@ -1242,7 +1648,7 @@ void Vulkan::CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize siz
 	EndSingleUseCommandBuffer(commandBuffer);
 }
 
-void Vulkan::CreateVertexBuffer(size_t vertexSize, uint32_t vertexCount, void* data, Buffer* buffer)
+UploadHandle Vulkan::CreateVertexBuffer(size_t vertexSize, uint32_t vertexCount, void* data, Buffer* buffer)
 {
 	ASSERT(vertexSize > 0);
 	ASSERT(vertexCount > 0);
@@ -1250,23 +1656,6 @@ void Vulkan::CreateVertexBuffer(size_t vertexSize, uint32_t vertexCount, void* d
 
 	size_t bufferSize = vertexSize * vertexCount;
 
-	// create staging buffer
-	VkBuffer stagingBuffer;
-	VkDeviceMemory stagingBufferMemory;
-	CreateBuffer(
-		bufferSize,
-		VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-		stagingBuffer,
-		stagingBufferMemory
-	);
-
-	// fill staging buffer
-	void* bufferData;
-	vkMapMemory(_device, stagingBufferMemory, 0, bufferSize, 0, &bufferData);
-	memcpy(bufferData, data, bufferSize);
-	vkUnmapMemory(_device, stagingBufferMemory);
-
 	// create device-local buffer
 	CreateBuffer(
 		bufferSize,
@@ -1276,14 +1665,11 @@ void Vulkan::CreateVertexBuffer(size_t vertexSize, uint32_t vertexCount, void* d
 		buffer->Memory
 	);
 
-	// copy staging to device-local
-	CopyBuffer(stagingBuffer, buffer->Buffer, bufferSize);
-
-	// destroy staging buffer
-	DestroyBuffer(stagingBuffer, stagingBufferMemory);
+	// copy through the staging ring, the buffer can be used once the handle is ready
+	return _uploader.UploadBuffer(buffer->Buffer, 0, data, bufferSize);
 }
 
-void Vulkan::CreateIndexBuffer(size_t indexSize, uint32_t indexCount, void* data, Buffer* buffer)
+UploadHandle Vulkan::CreateIndexBuffer(size_t indexSize, uint32_t indexCount, void* data, Buffer* buffer)
 {
 	ASSERT(indexSize > 0);
 	ASSERT(indexCount > 0);
@@ -1291,23 +1677,6 @@ void Vulkan::CreateIndexBuffer(size_t indexSize, uint32_t indexCount, void* data
 
 	size_t bufferSize = indexSize * indexCount;
 
-	// create staging buffer
-	VkBuffer stagingBuffer;
-	VkDeviceMemory stagingBufferMemory;
-	CreateBuffer(
-		bufferSize,
-		VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-		stagingBuffer,
-		stagingBufferMemory
-	);
-
-	// fill staging buffer
-	void* bufferData;
-	vkMapMemory(_device, stagingBufferMemory, 0, bufferSize, 0, &bufferData);
-	memcpy(bufferData, data, bufferSize);
-	vkUnmapMemory(_device, stagingBufferMemory);
-
 	// create device-local buffer
 	CreateBuffer(
 		bufferSize,
@@ -1317,14 +1686,11 @@ void Vulkan::CreateIndexBuffer(size_t indexSize, uint32_t indexCount, void* data
 		buffer->Memory
 	);
 
-	// copy staging to device-local
-	CopyBuffer(stagingBuffer, buffer->Buffer, bufferSize);
-
-	// destroy staging buffer
-	DestroyBuffer(stagingBuffer, stagingBufferMemory);
+	// copy through the staging ring, the buffer can be used once the handle is ready
+	return _uploader.UploadBuffer(buffer->Buffer, 0, data, bufferSize);
 }
 
-void Vulkan::CreateImage(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& memory)
+void Vulkan::CreateImage(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, MemoryAllocation& memory, uint32_t mipLevels)
 {
 	VkImageCreateInfo createInfo{};
 	createInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -1333,7 +1699,7 @@ void Vulkan::CreateImage(uint32_t width, uint32_t height, VkFormat format, VkIma
 	createInfo.extent.height = height;
 	createInfo.extent.depth = 1;
 	createInfo.arrayLayers = 1;
-	createInfo.mipLevels = 1;
+	createInfo.mipLevels = mipLevels;
 	createInfo.format = format;
 	createInfo.tiling = tiling;
 	createInfo.usage = usage;
@@ -1341,25 +1707,33 @@ void Vulkan::CreateImage(uint32_t width, uint32_t height, VkFormat format, VkIma
 	createInfo.samples = VK_SAMPLE_COUNT_1_BIT;
 	createInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
+	// images filled by the uploader are shared with the transfer queue
+	uint32_t queueFamilyIndices[] = { _graphicsQueueFamilyIndex, _transferQueueFamilyIndex };
+	if ((usage & VK_IMAGE_USAGE_TRANSFER_DST_BIT) != 0 && _graphicsQueueFamilyIndex != _transferQueueFamilyIndex)
+	{
+		createInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+		createInfo.queueFamilyIndexCount = 2;
+		createInfo.pQueueFamilyIndices = queueFamilyIndices;
+	}
+
 	HANDLE_VKRESULT(vkCreateImage(_device, &createInfo, nullptr, &image), "Create Image");
 
 	VkMemoryRequirements memreq;
 	vkGetImageMemoryRequirements(_device, image, &memreq);
 
-	VkMemoryAllocateInfo allocInfo{};
-	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-	allocInfo.allocationSize = memreq.size;
-	allocInfo.memoryTypeIndex = FindMemoryType(memreq.memoryTypeBits, properties);
+	uint32_t memoryTypeIndex = FindMemoryType(memreq.memoryTypeBits, properties);
+	ASSERT(memoryTypeIndex < UINT32_MAX);
 
-	HANDLE_VKRESULT(vkAllocateMemory(_device, &allocInfo, nullptr, &memory), "Allocate Image Memory");
+	memory = _memoryAllocator.Allocate(memreq, memoryTypeIndex, tiling == VK_IMAGE_TILING_OPTIMAL);
+	ASSERT(memory.Memory != VK_NULL_HANDLE);
 
-	vkBindImageMemory(_device, image, memory, 0);
+	HANDLE_VKRESULT(vkBindImageMemory(_device, image, memory.Memory, memory.Offset), "Bind Image Memory");
 }
 
-void Vulkan::DestroyImage(VkImage image, VkDeviceMemory memory)
+void Vulkan::DestroyImage(VkImage image, MemoryAllocation& memory)
 {
 	vkDestroyImage(_device, image, nullptr);
-	vkFreeMemory(_device, memory, nullptr);
+	_memoryAllocator.Free(memory);
 }
 
 void Vulkan::TransitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout)
@@ -1437,7 +1811,7 @@ void Vulkan::CopyBufferToImage(VkBuffer srcBuffer, VkImage dstImage, uint32_t wi
 }
 
 // TODO: This needs a lot of abstraction
-void Vulkan::CreateImageView(VkImage image, VkImageView* imageView)
+void Vulkan::CreateImageView(VkImage image, VkImageView* imageView, uint32_t mipLevels, VkFormat format)
 {
 	VkImageViewCreateInfo imageViewCreateInfo{};
 	imageViewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
@@ -1446,13 +1820,13 @@ void Vulkan::CreateImageView(VkImage image, VkImageView* imageView)
 	imageViewCreateInfo.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
 	imageViewCreateInfo.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
 	imageViewCreateInfo.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
-	imageViewCreateInfo.format = VK_FORMAT_R8G8B8A8_SRGB;
+	imageViewCreateInfo.format = format;
 	imageViewCreateInfo.image = image;
 	imageViewCreateInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
 	imageViewCreateInfo.subresourceRange.baseArrayLayer = 0;
 	imageViewCreateInfo.subresourceRange.layerCount = 1;
 	imageViewCreateInfo.subresourceRange.baseMipLevel = 0;
-	imageViewCreateInfo.subresourceRange.levelCount = 1;
+	imageViewCreateInfo.subresourceRange.levelCount = mipLevels;
 
 	HANDLE_VKRESULT(vkCreateImageView(_device, &imageViewCreateInfo, nullptr, imageView), "Create Image View");
 }
@@ -1462,33 +1836,14 @@ void Vulkan::DestroyImageView(VkImageView imageView)
 	vkDestroyImageView(_device, imageView, nullptr);
 }
 
-// TODO: This needs a lot abstraction
-void Vulkan::CreateSampler(VkSampler* sampler)
+VkSampler Vulkan::AcquireSampler(const SamplerDesc& desc)
 {
-	VkSamplerCreateInfo samplerCreateInfo{};
-	samplerCreateInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
-	samplerCreateInfo.magFilter = VK_FILTER_LINEAR;
-	samplerCreateInfo.minFilter = VK_FILTER_LINEAR;
-	samplerCreateInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-	samplerCreateInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-	samplerCreateInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-	samplerCreateInfo.anisotropyEnable = VK_TRUE;
-	samplerCreateInfo.maxAnisotropy = _physicalDevice->Properties.limits.maxSamplerAnisotropy;
-	samplerCreateInfo.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_BLACK;
-	samplerCreateInfo.unnormalizedCoordinates = VK_FALSE;
-	samplerCreateInfo.compareEnable = VK_FALSE;
-	samplerCreateInfo.compareOp = VK_COMPARE_OP_ALWAYS;
-	samplerCreateInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
-	samplerCreateInfo.mipLodBias = 0.0f;
-	samplerCreateInfo.minLod = 0.0f;
-	samplerCreateInfo.maxLod = 0.0f;
-
-	HANDLE_VKRESULT(vkCreateSampler(_device, &samplerCreateInfo, nullptr, sampler), "Create Sampler");
+	return _samplerCache.Acquire(desc);
 }
 
-void Vulkan::DestroySampler(VkSampler sampler)
+void Vulkan::ReleaseSampler(VkSampler sampler)
 {
-	vkDestroySampler(_device, sampler, nullptr);
+	_samplerCache.Release(sampler);
 }
 
 void Vulkan::CreateDepthImage()
@@ -1498,7 +1853,7 @@ void Vulkan::CreateDepthImage()
 		_extent.height,
 		VK_FORMAT_D32_SFLOAT,
 		VK_IMAGE_TILING_OPTIMAL,
-		VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
+		VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,		// sampled to build the hi-z pyramid
 		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
 		_depthImage,
 		_depthMemory
@@ -1565,15 +1920,37 @@ int Vulkan::GetSwapchainImageCount()
 	return _swapchainImages.size();
 }
 
+VkDeviceSize Vulkan::GetDeviceLocalBudget()
+{
+	VkPhysicalDeviceMemoryBudgetPropertiesEXT budget{};
+	budget.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+
+	VkPhysicalDeviceMemoryProperties2 properties{};
+	properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+	properties.pNext = _memoryBudget ? &budget : nullptr;
+	vkGetPhysicalDeviceMemoryProperties2(_physicalDevice->Handle, &properties);
+
+	VkDeviceSize result = 0;
+	for (uint32_t i = 0; i < properties.memoryProperties.memoryHeapCount; i++)
+	{
+		if (properties.memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
+		{
+			result = std::max(result, _memoryBudget ? budget.heapBudget[i] : properties.memoryProperties.memoryHeaps[i].size);
+		}
+	}
+	return result;
+}
+
 PhysicalDevice* Vulkan::GetPhysicalDevice()
 {
 	return _physicalDevice;
 }
 
-void Vulkan::CreateDescriptorPool(std::vector<VkDescriptorPoolSize> poolSizes, uint32_t maxSets, VkDescriptorPool* pool)
+void Vulkan::CreateDescriptorPool(std::vector<VkDescriptorPoolSize> poolSizes, uint32_t maxSets, VkDescriptorPool* pool, VkDescriptorPoolCreateFlags flags)
 {
 	VkDescriptorPoolCreateInfo poolCreateInfo{};
 	poolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolCreateInfo.flags = flags;
 	poolCreateInfo.poolSizeCount = poolSizes.size();
 	poolCreateInfo.pPoolSizes = poolSizes.data();
 	poolCreateInfo.maxSets = maxSets;
@@ -1596,8 +1973,33 @@ void Vulkan::BeginDrawFrame()
 	}
 
 	vkWaitForFences(_device, 1, &_fences[_currentFrame], VK_TRUE, UINT64_MAX);
+	_uploader.Update(_currentFrame);
+	for (auto arena : _geometryArenas)
+	{
+		arena->Update(_currentFrame);
+	}
 
-	VkResult acquireImageResult = vkAcquireNextImageKHR(_device, _swapchain, UINT64_MAX, _imageAvailableSemaphores[_currentFrame], VK_NULL_HANDLE, &_currentImage);
+	// nothing of this frame is recorded yet, so a block can be moved before anything draws from it
+	for (uint32_t i = 0; _compactGeometry && i < _geometryArenas.size(); i++)
+	{
+		if (_geometryArenas[i]->CompactFragmentedBlock())
+		{
+			break;
+		}
+	}
+	_bindless.Update(_currentFrame);
+	_frameAllocator.BeginFrame(_currentFrame);
+	_commandRecorder.BeginFrame(_currentFrame);
+
+	VkResult acquireImageResult = VK_SUCCESS;
+	if (_headless)
+	{
+		_currentImage = _currentFrame;
+	}
+	else
+	{
+		acquireImageResult = vkAcquireNextImageKHR(_device, _swapchain, UINT64_MAX, _imageAvailableSemaphores[_currentFrame], VK_NULL_HANDLE, &_currentImage);
+	}
 
 	if (acquireImageResult == VK_ERROR_OUT_OF_DATE_KHR)
 	{
@@ -1608,6 +2010,15 @@ void Vulkan::BeginDrawFrame()
 		ASSERT(acquireImageResult == VK_SUCCESS || acquireImageResult == VK_SUBOPTIMAL_KHR);
 	}
 
+	// the image's command buffer and descriptor sets may still be used by an earlier frame that rendered to it
+	if (_imageFences[_currentImage] != VK_NULL_HANDLE)
+	{
+		vkWaitForFences(_device, 1, &_imageFences[_currentImage], VK_TRUE, UINT64_MAX);
+	}
+	_imageFences[_currentImage] = _fences[_currentFrame];
+
+	_textureStreamer.Update(_currentFrame, _currentImage);
+
 	vkResetCommandPool(_device, _commandPools[_currentImage], 0);
 
 	// begin recording the main command buffer
@@ -1627,26 +2038,43 @@ void Vulkan::EndDrawFrame()
 	// end recording the main command buffer
 	vkEndCommandBuffer(_commandBuffers[_currentImage]);
 
-	if (_imageFences[_currentImage] != VK_NULL_HANDLE)
+	// submit the uploads recorded this frame, the frame waits on them and on every earlier batch
+	// that hasn't been waited on yet before reading vertices, indices or textures
+	_uploader.Flush();
+	std::vector<VkSemaphore>& uploadSemaphores = _uploader.TakeWaitSemaphores(_currentFrame);
+
+	std::vector<VkSemaphore> waitSemaphores;
+	std::vector<VkPipelineStageFlags> waitStages;
+	if (!_headless)
 	{
-		vkWaitForFences(_device, 1, &_imageFences[_currentImage], VK_TRUE, UINT64_MAX);
+		waitSemaphores.push_back(_imageAvailableSemaphores[_currentFrame]);
+		waitStages.push_back(VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+	}
+	for (auto semaphore : uploadSemaphores)
+	{
+		waitSemaphores.push_back(semaphore);
+		waitStages.push_back(VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
 	}
-	_imageFences[_currentImage] = _fences[_currentFrame];
 
-	VkPipelineStageFlags waitStages = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
 	VkSubmitInfo submitInfo{};
 	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 	submitInfo.commandBufferCount = 1;
 	submitInfo.pCommandBuffers = &_commandBuffers[_currentImage];
-	submitInfo.waitSemaphoreCount = 1;
-	submitInfo.pWaitSemaphores = &_imageAvailableSemaphores[_currentFrame];
-	submitInfo.pWaitDstStageMask = &waitStages;
-	submitInfo.signalSemaphoreCount = 1;
+	submitInfo.waitSemaphoreCount = waitSemaphores.size();
+	submitInfo.pWaitSemaphores = waitSemaphores.data();
+	submitInfo.pWaitDstStageMask = waitStages.data();
+	submitInfo.signalSemaphoreCount = _headless ? 0 : 1;
 	submitInfo.pSignalSemaphores = &_renderFinishedSemaphores[_currentFrame];
 
 	vkResetFences(_device, 1, &_fences[_currentFrame]);
 	vkQueueSubmit(_graphicsQueue, 1, &submitInfo, _fences[_currentFrame]);
 
+	if (_headless)
+	{
+		_currentFrame = (_currentFrame + 1) % _framesInFlight;
+		return;
+	}
+
 	VkPresentInfoKHR presentInfo{};
 	presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
 	presentInfo.swapchainCount = 1;
@@ -1670,17 +2098,20 @@ void Vulkan::EndDrawFrame()
 	_currentFrame = (_currentFrame + 1) % _framesInFlight;
 }
 
-void Vulkan::MapMemory(VkDeviceMemory memory, VkDeviceSize offset, VkDeviceSize size, void** data)
+void Vulkan::MapMemory(const MemoryAllocation& memory, VkDeviceSize offset, VkDeviceSize size, void** data)
 {
-	vkMapMemory(_device, memory, offset, size, 0, data);
+	// host visible memory is persistently mapped by the allocator
+	ASSERT(memory.MappedData != nullptr);
+	ASSERT(offset + size <= memory.Size);
+	*data = (char*)memory.MappedData + offset;
 }
 
-void Vulkan::UnmapMemory(VkDeviceMemory memory)
+void Vulkan::UnmapMemory(const MemoryAllocation& memory)
 {
-	vkUnmapMemory(_device, memory);
+	// nothing to do, the memory stays mapped until it's freed
 }
 
-void Vulkan::CopyToMemory(VkDeviceMemory memory, VkDeviceSize offset, VkDeviceSize size, void* sourceData)
+void Vulkan::CopyToMemory(const MemoryAllocation& memory, VkDeviceSize offset, VkDeviceSize size, void* sourceData)
 {
 	void* destinationData;
 	MapMemory(memory, offset, size, &destinationData);
@@ -1688,12 +2119,57 @@ void Vulkan::CopyToMemory(VkDeviceMemory memory, VkDeviceSize offset, VkDeviceSi
 	UnmapMemory(memory);
 }
 
-void Vulkan::DrawMesh(VkCommandBuffer commandBuffer, Buffer* vertexBuffer, Buffer* indexBuffer, int indexCount)
+std::vector<MemoryHeapStats> Vulkan::GetMemoryStats()
 {
-	VkBuffer buffers[] = { vertexBuffer->Buffer };
-	VkDeviceSize offsets[] = { 0 };
+	return _memoryAllocator.GetStats();
+}
 
-	vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
-	vkCmdBindIndexBuffer(commandBuffer, indexBuffer->Buffer, 0, VK_INDEX_TYPE_UINT32);
-	vkCmdDrawIndexed(commandBuffer, indexCount, 1, 0, 0, 0);
-}
\ No newline at end of file
+GeometryArena* Vulkan::GetGeometryArena(uint32_t vertexStride, VkIndexType indexType)
+{
+	for (auto arena : _geometryArenas)
+	{
+		if (arena->GetVertexStride() == vertexStride && arena->GetIndexType() == indexType)
+		{
+			return arena;
+		}
+	}
+
+	GeometryArena* arena = new GeometryArena();
+	arena->Create(this, _geometryArenas.size(), vertexStride, indexType);
+	_geometryArenas.push_back(arena);
+	return arena;
+}
+
+void Vulkan::DrawIndexedIndirect(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset, VkBuffer countBuffer, VkDeviceSize countOffset, uint32_t maxDrawCount)
+{
+	uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+
+	if (_drawIndirectCount && countBuffer != VK_NULL_HANDLE)
+	{
+		_vkCmdDrawIndexedIndirectCount(commandBuffer, buffer, offset, countBuffer, countOffset, maxDrawCount, stride);
+	}
+	else if (_multiDrawIndirect)
+	{
+		vkCmdDrawIndexedIndirect(commandBuffer, buffer, offset, maxDrawCount, stride);
+	}
+	else
+	{
+		// without multiDrawIndirect the draw count has to be 0 or 1
+		for (uint32_t i = 0; i < maxDrawCount; i++)
+		{
+			vkCmdDrawIndexedIndirect(commandBuffer, buffer, offset + i * stride, 1, stride);
+		}
+	}
+}
+
+bool Vulkan::IsDeviceExtensionSupported(const char* extensionName)
+{
+	for (auto& extension : _physicalDevice->Extensions)
+	{
+		if (strcmp(extension.extensionName, extensionName) == 0)
+		{
+			return true;
+		}
+	}
+	return false;
+}
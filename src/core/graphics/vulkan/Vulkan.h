@@ -6,6 +6,15 @@
 #include "../../math/Mat4.h"
 #include "../Common.h"
 #include "../RendererInfo.h"
+#include "MemoryAllocator.h"
+#include "Uploader.h"
+#include "FrameAllocator.h"
+#include "PipelineCache.h"
+#include "CommandRecorder.h"
+#include "GeometryArena.h"
+#include "BindlessTable.h"
+#include "TextureStreamer.h"
+#include "SamplerCache.h"
 
 #include <vulkan/vulkan.h>
 #include <vector>
@@ -34,13 +43,15 @@ namespace Euler
             std::vector<VkSurfaceFormatKHR> SurfaceFormats;
             std::vector<VkPresentModeKHR> PresentModes;
             VkPhysicalDeviceMemoryProperties MemoryProperties;
+            VkPhysicalDeviceFeatures Features;
+            std::vector<VkExtensionProperties> Extensions;
         };
 
         class EULER_API Buffer
         {
         public:
             VkBuffer Buffer;
-            VkDeviceMemory Memory;
+            MemoryAllocation Memory;
         };
 
         class EULER_API Vulkan
@@ -53,6 +64,7 @@ namespace Euler
             PhysicalDevice* _physicalDevice;
             std::vector<PhysicalDevice> _physicalDevices;
             VkDevice _device;
+            MemoryAllocator _memoryAllocator;
             QueueFamily* _graphicsQueueFamily;
 
             uint32_t _graphicsQueueFamilyIndex;
@@ -61,6 +73,46 @@ namespace Euler
             uint32_t _presentQueueFamilyIndex;
             VkQueue _presentQueue;
 
+            uint32_t _transferQueueFamilyIndex;
+            VkQueue _transferQueue;
+            Uploader _uploader;
+            FrameAllocator _frameAllocator;
+            // bytes of per-frame data of each frame in flight, set before CreateDevice
+            VkDeviceSize _frameAllocatorSize = FrameAllocator::DEFAULT_FRAME_SIZE;
+            // one arena per vertex stride, created when the first mesh with that stride is
+            std::vector<GeometryArena*> _geometryArenas;
+            // bumped whenever an arena compaction moves geometry, caches of the offsets are rebuilt when it changes
+            uint32_t _geometryVersion = 0;
+            // compacts at most one fragmented arena block per frame in BeginDrawFrame. A compaction waits for the
+            // device to be idle and copies the block, so the frames that compact hitch. Off by default
+            bool _compactGeometry = false;
+
+            // indirect drawing support, enabled in CreateDevice when the device has it
+            bool _multiDrawIndirect = false;
+            bool _drawIndirectFirstInstance = false;
+            bool _drawIndirectCount = false;
+            PFN_vkCmdDrawIndexedIndirectCountKHR _vkCmdDrawIndexedIndirectCount = nullptr;
+
+            // block compressed textures, cooked textures are decoded on the CPU without it
+            bool _textureCompressionBC = false;
+
+            // the texture streamer's budget follows the heap budget when the device has VK_EXT_memory_budget
+            bool _memoryBudget = false;
+            TextureStreamer _textureStreamer;
+
+            // descriptor indexing support for the bindless table, enabled in CreateDevice when the device has it
+            bool _descriptorIndexing = false;
+            BindlessTable _bindless;
+
+            SamplerCache _samplerCache;
+            PipelineCache _pipelineCache;
+            const char* _pipelineCacheFilePath = "pipeline_cache.bin";
+            double _pipelineCreationTime = 0.0;     // total milliseconds spent in vkCreateGraphicsPipelines
+
+            // rendering goes to offscreen images instead of a swapchain when no surface is given
+            bool _headless = false;
+            std::vector<MemoryAllocation> _offscreenImageMemories;
+
             VkSurfaceKHR _surface;
             VkSurfaceFormatKHR _surfaceFormat;
             VkPresentModeKHR _presentMode;
@@ -71,6 +123,8 @@ namespace Euler
             std::vector<VkFramebuffer> _swapchainFramebuffers;
 
             VkRenderPass _renderPass;
+            // same attachments as _renderPass but keeps their contents, to continue drawing after the pass was ended
+            VkRenderPass _loadRenderPass;
 
             VkPipelineLayout _graphicsPipelineLayout;
             VkPipeline _graphicsPipeline;
@@ -78,6 +132,10 @@ namespace Euler
             std::vector<VkCommandPool> _commandPools;
             std::vector<VkCommandBuffer> _commandBuffers;
 
+            // set before InitRenderer, 0 records everything on the render thread
+            uint32_t _recordingThreadCount = 0;
+            CommandRecorder _commandRecorder;
+
             std::vector<VkSemaphore> _imageAvailableSemaphores;
             std::vector<VkSemaphore> _renderFinishedSemaphores;
             std::vector<VkFence> _fences;
@@ -107,7 +165,7 @@ namespace Euler
             VkSampler _sampler;
 
             VkImage _depthImage;
-            VkDeviceMemory _depthMemory;
+            MemoryAllocation _depthMemory;
             VkImageView _depthImageView;
             
             // tmp:
@@ -141,6 +199,10 @@ namespace Euler
             void CreateSwapchain();
             void DestroySwapchain();
 
+            void CreateOffscreenImages();
+            void DestroyOffscreenImages();
+            void ReadbackImage(std::vector<uint8_t>& pixels);
+
             void CreateRenderPass();
             void DestroyRenderPass();
 
@@ -175,25 +237,28 @@ namespace Euler
             PhysicalDevice* GetPhysicalDevice();
 
             uint32_t FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
-            void CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& deviceMemory);
-            void DestroyBuffer(VkBuffer buffer, VkDeviceMemory deviceMemory);
+            // bytes of the largest device local heap this process may use, its size without VK_EXT_memory_budget
+            VkDeviceSize GetDeviceLocalBudget();
+            void CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, MemoryAllocation& memory);
+            void DestroyBuffer(VkBuffer buffer, MemoryAllocation& memory);
             void CopyBuffer(VkBuffer srcBuffer, VkBuffer destBuffer, VkDeviceSize size);
 
-            void CreateImage(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& memory);
-            void DestroyImage(VkImage image, VkDeviceMemory memory);
+            void CreateImage(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, MemoryAllocation& memory, uint32_t mipLevels = 1);
+            void DestroyImage(VkImage image, MemoryAllocation& memory);
             void TransitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout);
             void CopyBufferToImage(VkBuffer srcBuffer, VkImage dstImage, uint32_t width, uint32_t height);
 
-            void CreateImageView(VkImage image, VkImageView* imageView);
+            void CreateImageView(VkImage image, VkImageView* imageView, uint32_t mipLevels = 1, VkFormat format = VK_FORMAT_R8G8B8A8_SRGB);
             void DestroyImageView(VkImageView imageView);
 
-            void CreateSampler(VkSampler* sampler);
-            void DestroySampler(VkSampler sampler);
+            // samplers are shared through the sampler cache, every acquire needs a release
+            VkSampler AcquireSampler(const SamplerDesc& desc);
+            void ReleaseSampler(VkSampler sampler);
 
             void CreateShaderModule(const char* shaderCode, size_t codeSize, VkShaderModule* shaderModule);
             void DestroyShaderModule(VkShaderModule shaderModule);
 
-            void CreateDescriptorPool(std::vector<VkDescriptorPoolSize> poolSizes, uint32_t maxSets, VkDescriptorPool* pool);
+            void CreateDescriptorPool(std::vector<VkDescriptorPoolSize> poolSizes, uint32_t maxSets, VkDescriptorPool* pool, VkDescriptorPoolCreateFlags flags = 0);
             void DestroyDescriptorPool(VkDescriptorPool pool);
 
             void CreateDescriptorSetLayout(std::vector<VkDescriptorSetLayoutBinding> bindings, VkDescriptorSetLayout* descriptorSetLayout);
@@ -203,14 +268,23 @@ namespace Euler
             void CreatePipeline(const Euler::Graphics::RendererInfo* rendererInfo, VkPipelineLayout* pipelineLayout, VkPipeline* pipeline);
             void DestroyPipeline(VkPipelineLayout pipelineLayout, VkPipeline pipeline);
 
-            void CreateVertexBuffer(size_t vertexSize, uint32_t vertexCount, void* data, Buffer* buffer);
-            void CreateIndexBuffer(size_t indexSize, uint32_t indexCount, void*data, Buffer* buffer);
+            void CreateComputePipeline(const ComputePipelineInfo* pipelineInfo, VkPipelineLayout* pipelineLayout, VkPipeline* pipeline);
+            // binds the pipeline, pushes the constants and dispatches enough groups of groupSize to cover threadCount
+            void Dispatch(VkCommandBuffer commandBuffer, VkPipeline pipeline, VkPipelineLayout pipelineLayout, const void* pushConstants, uint32_t pushConstantSize, uint32_t threadCount, uint32_t groupSize);
+            // global memory barrier between two stages of the same queue
+            void PipelineBarrier(VkCommandBuffer commandBuffer, VkPipelineStageFlags srcStage, VkAccessFlags srcAccess, VkPipelineStageFlags dstStage, VkAccessFlags dstAccess);
+
+            UploadHandle CreateVertexBuffer(size_t vertexSize, uint32_t vertexCount, void* data, Buffer* buffer);
+            UploadHandle CreateIndexBuffer(size_t indexSize, uint32_t indexCount, void*data, Buffer* buffer);
 
-            void MapMemory(VkDeviceMemory memory, VkDeviceSize offset, VkDeviceSize size, void** data);
-            void UnmapMemory(VkDeviceMemory memory);
-            void CopyToMemory(VkDeviceMemory memory, VkDeviceSize offset, VkDeviceSize size, void* sourceData);
+            void MapMemory(const MemoryAllocation& memory, VkDeviceSize offset, VkDeviceSize size, void** data);
+            void UnmapMemory(const MemoryAllocation& memory);
+            void CopyToMemory(const MemoryAllocation& memory, VkDeviceSize offset, VkDeviceSize size, void* sourceData);
+            std::vector<MemoryHeapStats> GetMemoryStats();
 
-            void DrawMesh(VkCommandBuffer commandBuffer, Buffer* vertexBuffer, Buffer* indexBuffer, int indexCount);
+            GeometryArena* GetGeometryArena(uint32_t vertexStride, VkIndexType indexType = VK_INDEX_TYPE_UINT32);
+            void DrawIndexedIndirect(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset, VkBuffer countBuffer, VkDeviceSize countOffset, uint32_t maxDrawCount);
+            bool IsDeviceExtensionSupported(const char* extensionName);
 
             // ===== ABSTRACTED END =====
         };
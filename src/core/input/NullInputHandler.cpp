@@ -0,0 +1,38 @@
+#include "NullInputHandler.h"
+
+using namespace Euler;
+
+NullInputHandler::NullInputHandler() {
+}
+
+NullInputHandler::~NullInputHandler() {
+}
+
+void NullInputHandler::Init() {
+};
+
+void NullInputHandler::Dispose() {
+};
+
+float NullInputHandler::GetMouseX() {
+	return 0;
+};
+
+float NullInputHandler::GetMouseY() {
+	return 0;
+};
+
+void NullInputHandler::HideCursor() {
+}
+
+bool NullInputHandler::GetKey(Key key) {
+	return false;
+};
+
+bool NullInputHandler::GetKeyDown(Key key) {
+	return false;
+};
+
+bool NullInputHandler::GetKeyUp(Key key) {
+	return true;
+};
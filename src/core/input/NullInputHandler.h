@@ -0,0 +1,27 @@
+#pragma once
+
+#include "../API.h"
+#include "InputHandler.h"
+#include "Key.h"
+
+namespace Euler {
+
+	// input handler used when there is no window, no key is ever pressed and the mouse never moves
+	class EULER_API NullInputHandler : public InputHandler {
+
+	public:
+		NullInputHandler();
+		~NullInputHandler();
+
+		// overriden methods from interface
+		void Init();
+		void Dispose();
+		float GetMouseX();
+		float GetMouseY();
+		void HideCursor();
+		bool GetKey(Key key);
+		bool GetKeyDown(Key key);
+		bool GetKeyUp(Key key);
+	};
+
+};
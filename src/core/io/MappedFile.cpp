@@ -0,0 +1,177 @@
+#include "MappedFile.h"
+
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+using namespace Euler;
+
+MappedFile::MappedFile()
+{
+}
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+bool MappedFile::Open(const char* filePath)
+{
+	Close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(filePath, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	void* data = mapping != nullptr ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+	if (data == nullptr)
+	{
+		if (mapping != nullptr)
+		{
+			CloseHandle(mapping);
+		}
+		CloseHandle(file);
+		return false;
+	}
+
+	_file = file;
+	_mapping = mapping;
+	_data = (const uint8_t*)data;
+	_size = size.QuadPart;
+#else
+	int file = open(filePath, O_RDONLY);
+	if (file < 0)
+	{
+		return false;
+	}
+
+	struct stat status;
+	if (fstat(file, &status) != 0 || status.st_size == 0)
+	{
+		close(file);
+		return false;
+	}
+
+	// the mapping keeps the file referenced, the descriptor isn't needed anymore
+	void* data = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+	close(file);
+	if (data == MAP_FAILED)
+	{
+		return false;
+	}
+
+	_data = (const uint8_t*)data;
+	_size = status.st_size;
+#endif
+
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (_data == nullptr)
+	{
+		return;
+	}
+
+#ifdef _WIN32
+	UnmapViewOfFile(_data);
+	CloseHandle(_mapping);
+	CloseHandle(_file);
+	_mapping = nullptr;
+	_file = nullptr;
+#else
+	munmap((void*)_data, _size);
+#endif
+
+	_data = nullptr;
+	_size = 0;
+}
+
+bool MappedFile::IsOpen() const
+{
+	return _data != nullptr;
+}
+
+const uint8_t* MappedFile::GetData() const
+{
+	return _data;
+}
+
+uint64_t MappedFile::GetSize() const
+{
+	return _size;
+}
+
+void MappedFile::Prefetch(const void* data, uint64_t size) const
+{
+	if (size == 0)
+	{
+		return;
+	}
+
+	const uint64_t pageSize = 4096;
+	const volatile uint8_t* bytes = (const volatile uint8_t*)data;
+
+#ifndef _WIN32
+	// lets the kernel read ahead while the pages are touched
+	uintptr_t start = (uintptr_t)data & ~(uintptr_t)(pageSize - 1);
+	madvise((void*)start, size + ((uintptr_t)data - start), MADV_WILLNEED);
+#endif
+
+	// touching a byte of every page faults it in
+	uint8_t sum = 0;
+	for (uint64_t offset = 0; offset < size; offset += pageSize)
+	{
+		sum += bytes[offset];
+	}
+	sum += bytes[size - 1];
+	(void)sum;
+}
+
+MappedFileReader::MappedFileReader(const MappedFile& file)
+	: _data(file.GetData()), _size(file.GetSize())
+{
+}
+
+bool MappedFileReader::Read(void* destination, uint64_t size)
+{
+	const uint8_t* source = Skip(size);
+	if (source == nullptr)
+	{
+		return false;
+	}
+
+	memcpy(destination, source, size);
+	return true;
+}
+
+const uint8_t* MappedFileReader::Skip(uint64_t size)
+{
+	if (_data == nullptr || size > _size - _offset)
+	{
+		return nullptr;
+	}
+
+	const uint8_t* data = _data + _offset;
+	_offset += size;
+	return data;
+}
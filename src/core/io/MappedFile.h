@@ -0,0 +1,64 @@
+#pragma once
+
+#include "../API.h"
+
+#include <stdint.h>
+
+namespace Euler
+{
+	/// <summary>
+	/// A file mapped read-only into memory, the pages are read from disk when they are first touched.
+	/// Data can be copied from the mapping straight to where it goes instead of being read into a buffer first.
+	/// </summary>
+	class EULER_API MappedFile
+	{
+	private:
+		const uint8_t* _data = nullptr;
+		uint64_t _size = 0;
+#ifdef _WIN32
+		void* _file = nullptr;
+		void* _mapping = nullptr;
+#endif
+
+	public:
+		MappedFile();
+		~MappedFile();
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		// returns false if the file can't be opened or is empty
+		bool Open(const char* filePath);
+		void Close();
+		bool IsOpen() const;
+
+		const uint8_t* GetData() const;
+		uint64_t GetSize() const;
+
+		// reads the pages of the range from disk now, so it's the calling thread that waits for them
+		void Prefetch(const void* data, uint64_t size) const;
+	};
+
+	/// <summary>
+	/// Reads a mapped file front to back. A read going past the end fails and reads nothing.
+	/// </summary>
+	class EULER_API MappedFileReader
+	{
+	private:
+		const uint8_t* _data;
+		uint64_t _size;
+		uint64_t _offset = 0;
+
+	public:
+		MappedFileReader(const MappedFile& file);
+
+		bool Read(void* destination, uint64_t size);
+		// the next size bytes in the mapping without copying them, nullptr past the end
+		const uint8_t* Skip(uint64_t size);
+
+		template <typename T>
+		bool Read(T& value)
+		{
+			return Read(&value, sizeof(T));
+		}
+	};
+}
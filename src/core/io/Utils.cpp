@@ -23,3 +23,45 @@ std::vector<char> Euler::ReadFile(const char* filePath)
 
 	return buffer;
 }
+
+bool Euler::WriteFile(const char* filePath, const std::vector<char>& data)
+{
+	std::ofstream file(filePath, std::ios::binary);
+
+	if (!file.is_open()) {
+		return false;
+	}
+
+	file.write(data.data(), data.size());
+	file.close();
+
+	return true;
+}
+
+bool Euler::WriteImagePPM(const char* filePath, uint32_t width, uint32_t height, const std::vector<uint8_t>& pixels)
+{
+	std::ofstream file(filePath, std::ios::binary);
+
+	if (!file.is_open()) {
+		return false;
+	}
+
+	file << "P6\n" << width << " " << height << "\n255\n";
+
+	std::vector<char> row(width * 3);
+	for (uint32_t y = 0; y < height; y++)
+	{
+		for (uint32_t x = 0; x < width; x++)
+		{
+			const uint8_t* pixel = &pixels[(y * width + x) * 4];
+			row[x * 3 + 0] = pixel[0];
+			row[x * 3 + 1] = pixel[1];
+			row[x * 3 + 2] = pixel[2];
+		}
+		file.write(row.data(), row.size());
+	}
+
+	file.close();
+
+	return true;
+}
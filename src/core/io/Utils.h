@@ -3,8 +3,13 @@
 #include "../API.h"
 
 #include <vector>
+#include <stdint.h>
 
 namespace Euler
 {
 	std::vector<char> ReadFile(const char* filePath);
+	bool WriteFile(const char* filePath, const std::vector<char>& data);
+
+	// writes 8-bit RGBA pixels as a binary PPM (alpha is dropped), returns false if the file can't be opened
+	bool WriteImagePPM(const char* filePath, uint32_t width, uint32_t height, const std::vector<uint8_t>& pixels);
 }
\ No newline at end of file
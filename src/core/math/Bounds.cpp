@@ -0,0 +1,111 @@
+#include "Bounds.h"
+
+using namespace Euler::Math;
+
+static const Vec3& PointAt(const Vec3* points, uint32_t index, uint32_t stride)
+{
+	return *(const Vec3*)((const uint8_t*)points + (size_t)index * stride);
+}
+
+BoundingBox::BoundingBox()
+{
+}
+
+BoundingBox::BoundingBox(Vec3 min, Vec3 max)
+{
+	Min = min;
+	Max = max;
+}
+
+BoundingBox BoundingBox::FromPoints(const Vec3* points, uint32_t count, uint32_t stride)
+{
+	if (count == 0)
+		return BoundingBox();
+
+	BoundingBox box(PointAt(points, 0, stride), PointAt(points, 0, stride));
+	for (uint32_t i = 1; i < count; i++)
+		box.Extend(PointAt(points, i, stride));
+
+	return box;
+}
+
+void BoundingBox::Extend(const Vec3& point)
+{
+	Min.x = fminf(Min.x, point.x);
+	Min.y = fminf(Min.y, point.y);
+	Min.z = fminf(Min.z, point.z);
+	Max.x = fmaxf(Max.x, point.x);
+	Max.y = fmaxf(Max.y, point.y);
+	Max.z = fmaxf(Max.z, point.z);
+}
+
+Vec3 BoundingBox::GetCenter() const
+{
+	return Vec3((Min.x + Max.x) * 0.5f, (Min.y + Max.y) * 0.5f, (Min.z + Max.z) * 0.5f);
+}
+
+Vec3 BoundingBox::GetExtents() const
+{
+	return Vec3((Max.x - Min.x) * 0.5f, (Max.y - Min.y) * 0.5f, (Max.z - Min.z) * 0.5f);
+}
+
+BoundingBox BoundingBox::Transform(const Mat4& matrix) const
+{
+	// Arvo: the new extents are the old ones projected through the absolute rotation/scale part
+	Vec3 center = GetCenter();
+	Vec3 extents = GetExtents();
+
+	float c[3];
+	float e[3];
+	for (int i = 0; i < 3; i++)
+	{
+		c[i] = matrix.Get(i, 0) * center.x + matrix.Get(i, 1) * center.y + matrix.Get(i, 2) * center.z + matrix.Get(i, 3);
+		e[i] = fabsf(matrix.Get(i, 0)) * extents.x + fabsf(matrix.Get(i, 1)) * extents.y + fabsf(matrix.Get(i, 2)) * extents.z;
+	}
+
+	return BoundingBox(Vec3(c[0] - e[0], c[1] - e[1], c[2] - e[2]), Vec3(c[0] + e[0], c[1] + e[1], c[2] + e[2]));
+}
+
+BoundingSphere::BoundingSphere()
+{
+	Radius = 0;
+}
+
+BoundingSphere::BoundingSphere(Vec3 center, float radius)
+{
+	Center = center;
+	Radius = radius;
+}
+
+BoundingSphere BoundingSphere::FromPoints(const Vec3* points, uint32_t count, uint32_t stride)
+{
+	Vec3 center = BoundingBox::FromPoints(points, count, stride).GetCenter();
+
+	float radiusSquared = 0;
+	for (uint32_t i = 0; i < count; i++)
+	{
+		const Vec3& point = PointAt(points, i, stride);
+		Vec3 offset(point.x - center.x, point.y - center.y, point.z - center.z);
+		radiusSquared = fmaxf(radiusSquared, offset.LengthSquared());
+	}
+
+	return BoundingSphere(center, sqrtf(radiusSquared));
+}
+
+BoundingSphere BoundingSphere::Transform(const Mat4& matrix) const
+{
+	Vec3 center(
+		matrix.Get(0, 0) * Center.x + matrix.Get(0, 1) * Center.y + matrix.Get(0, 2) * Center.z + matrix.Get(0, 3),
+		matrix.Get(1, 0) * Center.x + matrix.Get(1, 1) * Center.y + matrix.Get(1, 2) * Center.z + matrix.Get(1, 3),
+		matrix.Get(2, 0) * Center.x + matrix.Get(2, 1) * Center.y + matrix.Get(2, 2) * Center.z + matrix.Get(2, 3)
+	);
+
+	float scaleSquared = 0;
+	for (int j = 0; j < 3; j++)
+	{
+		Vec3 axis(matrix.Get(0, j), matrix.Get(1, j), matrix.Get(2, j));
+		scaleSquared = fmaxf(scaleSquared, axis.LengthSquared());
+	}
+
+	return BoundingSphere(center, Radius * sqrtf(scaleSquared));
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "../API.h"
+
+#include "Vec3.h"
+#include "Mat4.h"
+#include <stdint.h>
+
+namespace Euler
+{
+	namespace Math
+	{
+		struct EULER_API BoundingBox
+		{
+			Vec3 Min;
+			Vec3 Max;
+
+			BoundingBox();
+			BoundingBox(Vec3 min, Vec3 max);
+
+			// positions are read with the given byte stride so vertex arrays can be passed directly
+			static BoundingBox FromPoints(const Vec3* points, uint32_t count, uint32_t stride);
+
+			void Extend(const Vec3& point);
+			Vec3 GetCenter() const;
+			Vec3 GetExtents() const;
+			// matrix is in the math convention (not transposed for upload)
+			BoundingBox Transform(const Mat4& matrix) const;
+		};
+
+		struct EULER_API BoundingSphere
+		{
+			Vec3 Center;
+			float Radius;
+
+			BoundingSphere();
+			BoundingSphere(Vec3 center, float radius);
+
+			// centered on the box of the points, so the sphere is not minimal but always encloses them
+			static BoundingSphere FromPoints(const Vec3* points, uint32_t count, uint32_t stride);
+
+			// matrix is in the math convention (not transposed for upload), the radius grows by the largest axis scale
+			BoundingSphere Transform(const Mat4& matrix) const;
+		};
+	}
+}
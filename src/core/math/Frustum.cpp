@@ -0,0 +1,90 @@
+#include "Frustum.h"
+
+using namespace Euler::Math;
+
+const uint32_t Frustum::PLANE_COUNT;
+
+static Vec4 NormalizePlane(float x, float y, float z, float w)
+{
+	float length = sqrtf(x * x + y * y + z * z);
+	return Vec4(x / length, y / length, z / length, w / length);
+}
+
+// row 3 of the matrix gives w, the clip test for row r is -w <= r <= w
+static Vec4 MakePlane(const Mat4& m, int row, float sign)
+{
+	return NormalizePlane(
+		m.Get(3, 0) + sign * m.Get(row, 0),
+		m.Get(3, 1) + sign * m.Get(row, 1),
+		m.Get(3, 2) + sign * m.Get(row, 2),
+		m.Get(3, 3) + sign * m.Get(row, 3)
+	);
+}
+
+Frustum::Frustum()
+{
+}
+
+Frustum Frustum::FromMatrix(const Mat4& viewProj)
+{
+	Frustum frustum;
+	frustum.Planes[0] = MakePlane(viewProj, 0, 1);
+	frustum.Planes[1] = MakePlane(viewProj, 0, -1);
+	frustum.Planes[2] = MakePlane(viewProj, 1, 1);
+	frustum.Planes[3] = MakePlane(viewProj, 1, -1);
+	// depth is 0 <= z <= w, so the near plane is row 2 on its own
+	frustum.Planes[4] = NormalizePlane(viewProj.Get(2, 0), viewProj.Get(2, 1), viewProj.Get(2, 2), viewProj.Get(2, 3));
+	frustum.Planes[5] = MakePlane(viewProj, 2, -1);
+
+	return frustum;
+}
+
+bool Frustum::IsVisible(const BoundingSphere& sphere) const
+{
+	for (uint32_t i = 0; i < PLANE_COUNT; i++)
+	{
+		const Vec4& p = Planes[i];
+		if (p.x * sphere.Center.x + p.y * sphere.Center.y + p.z * sphere.Center.z + p.w < -sphere.Radius)
+			return false;
+	}
+
+	return true;
+}
+
+bool Frustum::IsVisible(const BoundingBox& box) const
+{
+	for (uint32_t i = 0; i < PLANE_COUNT; i++)
+	{
+		// test the corner furthest along the plane normal
+		const Vec4& p = Planes[i];
+		float x = p.x >= 0 ? box.Max.x : box.Min.x;
+		float y = p.y >= 0 ? box.Max.y : box.Min.y;
+		float z = p.z >= 0 ? box.Max.z : box.Min.z;
+		if (p.x * x + p.y * y + p.z * z + p.w < 0)
+			return false;
+	}
+
+	return true;
+}
+
+void Frustum::CullSpheres(const float* x, const float* y, const float* z, const float* radius, uint32_t count, uint8_t* visible) const
+{
+	float px[PLANE_COUNT], py[PLANE_COUNT], pz[PLANE_COUNT], pw[PLANE_COUNT];
+	for (uint32_t i = 0; i < PLANE_COUNT; i++)
+	{
+		px[i] = Planes[i].x;
+		py[i] = Planes[i].y;
+		pz[i] = Planes[i].z;
+		pw[i] = Planes[i].w;
+	}
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		// smallest signed distance over all planes, no early out so the body stays branch free
+		float distance = px[0] * x[i] + py[0] * y[i] + pz[0] * z[i] + pw[0];
+		for (uint32_t j = 1; j < PLANE_COUNT; j++)
+			distance = fminf(distance, px[j] * x[i] + py[j] * y[i] + pz[j] * z[i] + pw[j]);
+
+		visible[i] = distance >= -radius[i] ? 1 : 0;
+	}
+}
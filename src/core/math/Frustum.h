@@ -0,0 +1,35 @@
+#pragma once
+
+#include "../API.h"
+
+#include "Vec4.h"
+#include "Mat4.h"
+#include "Bounds.h"
+#include <stdint.h>
+
+namespace Euler
+{
+	namespace Math
+	{
+		class EULER_API Frustum
+		{
+		public:
+			static const uint32_t PLANE_COUNT = 6;
+
+			// left, right, bottom, top, near, far; xyz is the normal pointing inside, w the distance
+			Vec4 Planes[PLANE_COUNT];
+
+			Frustum();
+
+			// viewProj is proj * view in the math convention (not transposed for upload), depth range is [0, 1]
+			static Frustum FromMatrix(const Mat4& viewProj);
+
+			bool IsVisible(const BoundingSphere& sphere) const;
+			bool IsVisible(const BoundingBox& box) const;
+
+			// writes 1 to visible[i] when sphere i touches the frustum, 0 otherwise
+			// spheres are passed as separate arrays so the loop vectorizes
+			void CullSpheres(const float* x, const float* y, const float* z, const float* radius, uint32_t count, uint8_t* visible) const;
+		};
+	}
+}
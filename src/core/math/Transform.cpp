@@ -11,6 +11,7 @@ void Transform::SetPosition(Vec3 position)
 {
 	_position = position;
 	_dirty = true;
+	_version++;
 }
 
 void Transform::SetPosition(float x, float y, float z)
@@ -19,6 +20,7 @@ void Transform::SetPosition(float x, float y, float z)
 	_position.y = y;
 	_position.z = z;
 	_dirty = true;
+	_version++;
 }
 
 Quaternion Transform::GetRotation()
@@ -30,6 +32,7 @@ void Transform::SetRotation(Quaternion rotation)
 {
 	_rotation = rotation;
 	_dirty = true;
+	_version++;
 }
 
 Vec3 Transform::GetScale()
@@ -41,6 +44,7 @@ void Transform::SetScale(Vec3 scale)
 {
 	_scale = scale;
 	_dirty = true;
+	_version++;
 }
 
 void Transform::SetScale(float x, float y, float z)
@@ -49,6 +53,7 @@ void Transform::SetScale(float x, float y, float z)
 	_scale.y = y;
 	_scale.z = z;
 	_dirty = true;
+	_version++;
 }
 
 void Transform::SetScale(float s) {
@@ -56,6 +61,7 @@ void Transform::SetScale(float s) {
 	_scale.y = s;
 	_scale.z = s;
 	_dirty = true;
+	_version++;
 }
 
 Mat4 Transform::GetModelMatrix()
@@ -64,6 +70,11 @@ Mat4 Transform::GetModelMatrix()
 	return _modelMatrix;
 }
 
+uint32_t Transform::GetVersion()
+{
+	return _version;
+}
+
 void Transform::CheckModelMatrix()
 {
 	if (!_dirty)
@@ -150,6 +161,7 @@ void Transform::LookAt(Vec3 point, Vec3 up)
 
 	_rotation = Quaternion::FromMatrix(rotationMatrix);
 	_dirty = true;
+	_version++;
 
 	//Mat4 t = Math::Matrices::Translate(-_position.x, -_position.y, -_position.z);
 	//t.Transpose();
@@ -15,6 +15,8 @@ namespace Euler
 		Vec3 _scale = Vec3(1, 1, 1);
 
 		bool _dirty = false;
+		// incremented on every change, lets renderers find moved objects without comparing matrices
+		uint32_t _version = 0;
 		Mat4 _modelMatrix = Math::Matrices::Identity();
 		Vec3 _forward;
 		Vec3 _right;
@@ -34,6 +36,7 @@ namespace Euler
 		void SetScale(float s);
 
 		Mat4 GetModelMatrix();
+		uint32_t GetVersion();
 		void CheckModelMatrix();
 
 		Vec3 Forward();
@@ -1,86 +1,192 @@
 #include "AnimatedModelResource.h"
 
-#include <iostream>
-#include <fstream>
+#include <string.h>
 
 using namespace Euler;
 
-void AnimatedModelResource::Load(const char* filePath)
+const uint32_t AnimatedModelResource::FILE_MAGIC;
+
+namespace
 {
-	//std::ifstream fs;
-	//fs.open(filePath);
+	// the data in the mapping may not be aligned for T
+	template <typename T>
+	void CopyArray(std::vector<T>& vector, const void* data, uint32_t count)
+	{
+		vector.resize(count);
+		if (count > 0)
+		{
+			memcpy(vector.data(), data, count * sizeof(T));
+		}
+	}
+}
 
-	//uint32_t vertexCount;
-	//uint32_t indexCount;
+void AnimatedModelResource::Load(const char* filePath, VertexFormat format)
+{
+	Read(filePath, format, true);
+}
 
-	//fs >> vertexCount;
-	//fs >> indexCount;
+void AnimatedModelResource::Map(const char* filePath, VertexFormat format)
+{
+	Read(filePath, format, false);
+}
 
-	//Vertices.resize(vertexCount);
-	//Indices.resize(indexCount);
+void AnimatedModelResource::Unload()
+{
+	// trick to force the vectors to free-up the memory
+	std::vector<AnimatedVertex>().swap(Vertices);
+	std::vector<PackedAnimatedVertex>().swap(PackedVertices);
+	std::vector<uint32_t>().swap(Indices);
+	std::vector<uint16_t>().swap(ShortIndices);
+	std::vector<MeshLod>().swap(Lods);
 
-	//for (uint32_t i = 0; i < vertexCount; i++)
-	//{
-	//	fs >> Vertices[i].Position.x;
-	//	fs >> Vertices[i].Position.y;
-	//	fs >> Vertices[i].Position.z;
+	View = GeometryView();
+	_file.Close();
+}
 
-	//	fs >> Vertices[i].Normal.x;
-	//	fs >> Vertices[i].Normal.y;
-	//	fs >> Vertices[i].Normal.z;
+void AnimatedModelResource::Read(const char* filePath, VertexFormat format, bool copy)
+{
+	Unload();
+	if (!_file.Open(filePath))
+	{
+		return;
+	}
 
-	//	fs >> Vertices[i].UV.x;
-	//	fs >> Vertices[i].UV.y;
-	//}
+	MappedFileReader reader(_file);
 
-	//for (uint32_t i = 0; i < indexCount; i++)
-	//{
-	//	fs >> Indices[i];
-	//}
+	uint32_t magic = 0;
+	uint32_t version = 0;
+	uint32_t meshCount;
+	uint32_t vertexCount = 0;
+	uint32_t indexCount = 0;
+	uint32_t lodCount = 0;
+	uint32_t indexSize = sizeof(uint32_t);
+	uint32_t fileFormat = VERTEX_FORMAT_FULL;
+
+	bool valid = reader.Read(magic);
+	if ((magic & 0x00FFFFFF) == (FILE_MAGIC & 0x00FFFFFF))
+	{
+		version = (magic >> 24) - '0';
+		valid = valid && reader.Read(meshCount);
+	}
+	else
+	{
+		meshCount = magic;
+	}
 
-	std::ifstream fs;
-	fs.open(filePath, std::ios::in | std::ios::binary);
+	if (version >= 2)
+	{
+		valid = valid && reader.Read(fileFormat);
+	}
+	uint32_t vertexSize = fileFormat == VERTEX_FORMAT_PACKED ? sizeof(PackedAnimatedVertex) : sizeof(AnimatedVertex);
 
-	uint32_t meshCount;
-	uint32_t vertexCount;
-	uint32_t indexCount;
+	valid = valid && reader.Read(vertexCount) && reader.Read(indexCount);
+	if (version >= 1)
+	{
+		valid = valid && reader.Read(lodCount);
+	}
+	if (version >= 3)
+	{
+		valid = valid && reader.Read(indexSize);
+	}
+	valid = valid && (indexSize == sizeof(uint16_t) || indexSize == sizeof(uint32_t));
 
-	fs.read((char*)(&meshCount), sizeof(uint32_t));
-	fs.read((char*)(&vertexCount), sizeof(uint32_t));
-	fs.read((char*)(&indexCount), sizeof(uint32_t));
+	const uint8_t* vertices = valid ? reader.Skip((uint64_t)vertexCount * vertexSize) : nullptr;
+	const uint8_t* indices = vertices != nullptr ? reader.Skip((uint64_t)indexCount * indexSize) : nullptr;
+	const uint8_t* lods = indices != nullptr ? reader.Skip((uint64_t)lodCount * sizeof(MeshLod)) : nullptr;
+	valid = lods != nullptr;
 
-	Vertices.resize(vertexCount);
-	Indices.resize(indexCount);
 	BoneParents.resize(MAX_BONES);
 	BoneOffsetMatrices.resize(MAX_BONES);
+	valid = valid && reader.Read(BoneParents.data(), MAX_BONES * sizeof(int));
+	valid = valid && reader.Read(BoneOffsetMatrices.data(), MAX_BONES * sizeof(Mat4));
 
-	fs.read((char*)Vertices.data(), vertexCount * sizeof(AnimatedVertex));
-	fs.read((char*)Indices.data(), indexCount * sizeof(uint32_t));
-	fs.read((char*)BoneParents.data(), MAX_BONES * sizeof(int));
-	fs.read((char*)BoneOffsetMatrices.data(), MAX_BONES * sizeof(Mat4));
+	uint32_t animationCount = 0;
+	valid = valid && reader.Read(animationCount);
 
-	uint32_t animationCount;
-	fs.read((char*)(&animationCount), sizeof(uint32_t));
-
-	for (int i = 0; i < animationCount; i++)
+	std::vector<Animation*> animations;
+	for (uint32_t i = 0; valid && i < animationCount; i++)
 	{
 		float animationDuration;
 		int keyFrameCount;
 
-		fs.read((char*)(&animationDuration), sizeof(float));
-		fs.read((char*)(&keyFrameCount), sizeof(int));
+		valid = reader.Read(animationDuration) && reader.Read(keyFrameCount) && keyFrameCount >= 0;
+		const uint8_t* keyFrames = valid ? reader.Skip((uint64_t)keyFrameCount * sizeof(KeyFrame)) : nullptr;
+		valid = keyFrames != nullptr;
+
+		if (valid)
+		{
+			Animation* animation = new Animation(keyFrameCount);
+			// the key frames are plain data in the file
+			memcpy((void*)animation->KeyFrames, keyFrames, sizeof(KeyFrame) * keyFrameCount);
+			animations.push_back(animation);
+		}
+	}
 
-		Animation* animation = new Animation(keyFrameCount);
-		fs.read((char*)animation->KeyFrames, sizeof(KeyFrame) * keyFrameCount);
-		Animations.push_back(animation);
+	if (!valid)
+	{
+		for (auto animation : animations)
+		{
+			delete animation;
+		}
+		Unload();
+		return;
 	}
 
-	fs.close();
-}
+	Animations.insert(Animations.end(), animations.begin(), animations.end());
+	CopyArray(Lods, lods, lodCount);
 
-void AnimatedModelResource::Unload()
-{
-	// trick to force the vectors to free-up the memory
-	std::vector<AnimatedVertex>().swap(Vertices);
-	std::vector<uint32_t>().swap(Indices);
-}
\ No newline at end of file
+	// the mapping can only be uploaded as it is when it has the requested format and its values are aligned
+	bool aligned = (uintptr_t)vertices % sizeof(float) == 0 && (uintptr_t)indices % indexSize == 0;
+	if (!copy && fileFormat == (uint32_t)format && aligned)
+	{
+		View.Vertices = vertices;
+		View.VertexCount = vertexCount;
+		View.VertexStride = vertexSize;
+		View.Indices = indices;
+		View.IndexCount = indexCount;
+		View.IndexSize = indexSize;
+
+		// the indices follow the vertices
+		_file.Prefetch(vertices, View.GetSize());
+		return;
+	}
+
+	if (fileFormat == VERTEX_FORMAT_PACKED)
+	{
+		CopyArray(PackedVertices, vertices, vertexCount);
+	}
+	else
+	{
+		CopyArray(Vertices, vertices, vertexCount);
+	}
+
+	if (indexSize == sizeof(uint16_t))
+	{
+		CopyArray(ShortIndices, indices, indexCount);
+	}
+	else
+	{
+		CopyArray(Indices, indices, indexCount);
+	}
+
+	_file.Close();
+
+	if (format == VERTEX_FORMAT_PACKED && fileFormat != VERTEX_FORMAT_PACKED)
+	{
+		PackedVertices.resize(Vertices.size());
+		for (uint32_t i = 0; i < Vertices.size(); i++)
+		{
+			PackedVertices[i] = PackAnimatedVertex(Vertices[i]);
+		}
+		std::vector<AnimatedVertex>().swap(Vertices);
+	}
+	else if (format == VERTEX_FORMAT_FULL && fileFormat == VERTEX_FORMAT_PACKED)
+	{
+		Vertices.resize(PackedVertices.size());
+		for (uint32_t i = 0; i < PackedVertices.size(); i++)
+		{
+			Vertices[i] = UnpackAnimatedVertex(PackedVertices[i]);
+		}
+		std::vector<PackedAnimatedVertex>().swap(PackedVertices);
+	}
+}
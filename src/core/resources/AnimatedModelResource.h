@@ -2,7 +2,11 @@
 
 #include "../API.h"
 #include "../graphics/AnimatedVertex.h"
+#include "../graphics/PackedVertex.h"
 #include "../graphics/Animation.h"
+#include "../graphics/MeshLod.h"
+#include "../graphics/GeometryView.h"
+#include "../io/MappedFile.h"
 
 #include <vector>
 
@@ -11,13 +15,32 @@ namespace Euler
 	class EULER_API AnimatedModelResource
 	{
 	public:
+		// "BEA" and the version digit, versions as in ModelResource
+		static const uint32_t FILE_MAGIC = 0x33414542;
+
+		// only the vector of the format passed to Load is filled, the file's vertices are converted when it differs
 		std::vector<AnimatedVertex> Vertices;
+		std::vector<PackedAnimatedVertex> PackedVertices;
+		// files with 16-bit indices fill ShortIndices instead of Indices
 		std::vector<uint32_t> Indices;
+		std::vector<uint16_t> ShortIndices;
+		// index ranges of the levels of detail, empty for files without them
+		std::vector<MeshLod> Lods;
+		// set by Map instead of the vertex and index vectors, points into the mapped file until Unload
+		GeometryView View;
 		std::vector<Animation*> Animations;
 		std::vector<int> BoneParents;
 		std::vector<Mat4> BoneOffsetMatrices;
 
-		void Load(const char* filePath);
+		void Load(const char* filePath, VertexFormat format = VERTEX_FORMAT_FULL);
+		// see ModelResource::Map, the bones and animations are read as by Load
+		void Map(const char* filePath, VertexFormat format = VERTEX_FORMAT_FULL);
+		// unmaps the file too
 		void Unload();
+
+	private:
+		MappedFile _file;
+
+		void Read(const char* filePath, VertexFormat format, bool copy);
 	};
 }
\ No newline at end of file
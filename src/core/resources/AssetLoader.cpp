@@ -0,0 +1,394 @@
+#include "AssetLoader.h"
+
+#include <algorithm>
+#include <string>
+
+using namespace Euler;
+
+namespace
+{
+	// heap order, the top is the highest priority requested first
+	bool IsLater(const std::shared_ptr<LoadJob>& a, const std::shared_ptr<LoadJob>& b)
+	{
+		if (a->Priority != b->Priority)
+		{
+			return a->Priority < b->Priority;
+		}
+		return a->Sequence > b->Sequence;
+	}
+}
+
+void AssetLoader::Create(uint32_t workerCount)
+{
+	if (workerCount == 0)
+	{
+		uint32_t cores = std::thread::hardware_concurrency();
+		workerCount = cores > 1 ? cores - 1 : 1;
+	}
+
+	_stop = false;
+	for (uint32_t i = 0; i < workerCount; i++)
+	{
+		_workers.push_back(std::thread(&AssetLoader::Run, this));
+	}
+}
+
+void AssetLoader::Destroy()
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stop = true;
+	}
+	_jobCondition.notify_all();
+
+	for (auto& worker : _workers)
+	{
+		worker.join();
+	}
+	_workers.clear();
+
+	// nothing loads anymore, whatever is left fails
+	std::vector<std::shared_ptr<LoadJob>> jobs = _finished;
+	jobs.insert(jobs.end(), _queue.begin(), _queue.end());
+	_finished.clear();
+	_queue.clear();
+
+	for (auto& job : jobs)
+	{
+		job->State = LOAD_STATE_FAILED;
+		Complete(job);
+	}
+
+	while (!_deferred.empty())
+	{
+		std::shared_ptr<LoadJob> job = _deferred.front();
+		_deferred.erase(_deferred.begin());
+		for (auto& dependency : job->Dependencies)
+		{
+			Finish(dependency);
+		}
+		job->State = LOAD_STATE_FAILED;
+		Complete(job);
+	}
+}
+
+uint32_t AssetLoader::GetWorkerCount() const
+{
+	return _workers.size();
+}
+
+std::shared_ptr<LoadTicket> AssetLoader::Submit(const std::shared_ptr<LoadJob>& job)
+{
+	std::shared_ptr<LoadTicket> ticket = std::make_shared<LoadTicket>();
+	job->Tickets.push_back(ticket);
+	job->Waiting = 1;
+	job->State = LOAD_STATE_QUEUED;
+	_pendingCount++;
+
+	if (!job->Load)
+	{
+		_deferred.push_back(job);
+		return ticket;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		job->Sequence = _nextSequence++;
+		_queue.push_back(job);
+		std::push_heap(_queue.begin(), _queue.end(), IsLater);
+	}
+	_jobCondition.notify_one();
+
+	return ticket;
+}
+
+std::shared_ptr<LoadTicket> AssetLoader::Attach(const std::shared_ptr<LoadJob>& job)
+{
+	// the worker decides to skip a job under the lock, so it can't be revived after that
+	std::lock_guard<std::mutex> lock(_mutex);
+	if (job->Completed || job->State == LOAD_STATE_CANCELED)
+	{
+		return nullptr;
+	}
+
+	std::shared_ptr<LoadTicket> ticket = std::make_shared<LoadTicket>();
+	job->Tickets.push_back(ticket);
+	job->Waiting++;
+	return ticket;
+}
+
+void AssetLoader::SetPriority(const std::shared_ptr<LoadJob>& job, LoadPriority priority)
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		job->Priority = priority;
+		std::make_heap(_queue.begin(), _queue.end(), IsLater);
+	}
+
+	for (auto& dependency : job->Dependencies)
+	{
+		SetPriority(dependency, priority);
+	}
+}
+
+void AssetLoader::Update()
+{
+	std::vector<std::shared_ptr<LoadJob>> finished;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		uint32_t count = _finished.size();
+		if (MaxCompletionsPerUpdate > 0 && count > MaxCompletionsPerUpdate)
+		{
+			count = MaxCompletionsPerUpdate;
+		}
+		finished.assign(_finished.begin(), _finished.begin() + count);
+		_finished.erase(_finished.begin(), _finished.begin() + count);
+	}
+
+	for (auto& job : finished)
+	{
+		Complete(job);
+	}
+
+	for (uint32_t i = 0; i < _deferred.size();)
+	{
+		std::shared_ptr<LoadJob> job = _deferred[i];
+		bool ready = true;
+		for (auto& dependency : job->Dependencies)
+		{
+			ready = ready && dependency->Completed;
+		}
+
+		if (!ready)
+		{
+			i++;
+			continue;
+		}
+
+		_deferred.erase(_deferred.begin() + i);
+		job->State = job->Waiting > 0 ? LOAD_STATE_LOADED : LOAD_STATE_CANCELED;
+		Complete(job);
+	}
+}
+
+void AssetLoader::Finish(const std::shared_ptr<LoadJob>& job)
+{
+	if (job->Completed)
+	{
+		return;
+	}
+
+	for (auto& dependency : job->Dependencies)
+	{
+		Finish(dependency);
+	}
+
+	auto deferred = std::find(_deferred.begin(), _deferred.end(), job);
+	if (deferred != _deferred.end())
+	{
+		_deferred.erase(deferred);
+		job->State = job->Waiting > 0 ? LOAD_STATE_LOADED : LOAD_STATE_CANCELED;
+		Complete(job);
+		return;
+	}
+
+	std::unique_lock<std::mutex> lock(_mutex);
+
+	// not picked up yet, loading it here is faster than waiting behind the other jobs
+	auto queued = std::find(_queue.begin(), _queue.end(), job);
+	if (queued != _queue.end())
+	{
+		_queue.erase(queued);
+		std::make_heap(_queue.begin(), _queue.end(), IsLater);
+		lock.unlock();
+
+		Execute(*job);
+		Complete(job);
+		return;
+	}
+
+	_doneCondition.wait(lock, [this, &job]() { return std::find(_finished.begin(), _finished.end(), job) != _finished.end(); });
+	_finished.erase(std::find(_finished.begin(), _finished.end(), job));
+	lock.unlock();
+
+	Complete(job);
+}
+
+void AssetLoader::FinishAll()
+{
+	while (true)
+	{
+		std::shared_ptr<LoadJob> job;
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			if (_queue.empty() && _finished.empty() && _deferred.empty())
+			{
+				// only jobs being loaded are left, or none
+				if (GetPendingCount() == 0)
+				{
+					return;
+				}
+				_doneCondition.wait(lock, [this]() { return !_finished.empty(); });
+			}
+
+			if (!_queue.empty())
+			{
+				job = _queue.front();
+			}
+			else if (!_finished.empty())
+			{
+				job = _finished.front();
+			}
+		}
+
+		Finish(job != nullptr ? job : _deferred.front());
+	}
+}
+
+uint32_t AssetLoader::GetPendingCount() const
+{
+	return _pendingCount;
+}
+
+LoadHandle<ModelResource> AssetLoader::LoadModel(const char* filePath, VertexFormat format, uint32_t meshIndex, LoadPriority priority)
+{
+	std::shared_ptr<ModelResource> resource = std::make_shared<ModelResource>();
+	std::string path = filePath;
+
+	std::shared_ptr<LoadJob> job = std::make_shared<LoadJob>();
+	job->Priority = priority;
+	job->Load = [resource, path, format, meshIndex]()
+	{
+		resource->Load(path.c_str(), format, meshIndex);
+		return !resource->Vertices.empty() || !resource->PackedVertices.empty();
+	};
+	job->Complete = [resource](LoadJob& job, bool loaded)
+	{
+		for (auto& ticket : job.Tickets)
+		{
+			ticket->Value = loaded ? resource : nullptr;
+		}
+	};
+
+	return LoadHandle<ModelResource>(job, Submit(job));
+}
+
+LoadHandle<AnimatedModelResource> AssetLoader::LoadAnimatedModel(const char* filePath, VertexFormat format, LoadPriority priority)
+{
+	std::shared_ptr<AnimatedModelResource> resource = std::make_shared<AnimatedModelResource>();
+	std::string path = filePath;
+
+	std::shared_ptr<LoadJob> job = std::make_shared<LoadJob>();
+	job->Priority = priority;
+	job->Load = [resource, path, format]()
+	{
+		resource->Load(path.c_str(), format);
+		return !resource->Vertices.empty() || !resource->PackedVertices.empty();
+	};
+	job->Complete = [resource](LoadJob& job, bool loaded)
+	{
+		for (auto& ticket : job.Tickets)
+		{
+			ticket->Value = loaded ? resource : nullptr;
+		}
+	};
+
+	return LoadHandle<AnimatedModelResource>(job, Submit(job));
+}
+
+LoadHandle<TextureResource> AssetLoader::LoadTexture(const char* filePath, TextureChannels textureChannels, LoadPriority priority)
+{
+	// the texture's memory is freed with the last handle
+	std::shared_ptr<TextureResource> resource(new TextureResource(), [](TextureResource* textureResource)
+	{
+		textureResource->Unload();
+		delete textureResource;
+	});
+	std::string path = filePath;
+
+	std::shared_ptr<LoadJob> job = std::make_shared<LoadJob>();
+	job->Priority = priority;
+	job->Load = [resource, path, textureChannels]()
+	{
+		resource->Load(path.c_str(), textureChannels);
+		return resource->GetLevelCount() > 0 && resource->GetLevelData(resource->GetFirstLevel()) != nullptr;
+	};
+	job->Complete = [resource](LoadJob& job, bool loaded)
+	{
+		for (auto& ticket : job.Tickets)
+		{
+			ticket->Value = loaded ? resource : nullptr;
+		}
+	};
+
+	return LoadHandle<TextureResource>(job, Submit(job));
+}
+
+void AssetLoader::Run()
+{
+	std::unique_lock<std::mutex> lock(_mutex);
+	while (true)
+	{
+		_jobCondition.wait(lock, [this]() { return _stop || !_queue.empty(); });
+		if (_stop)
+		{
+			return;
+		}
+
+		std::pop_heap(_queue.begin(), _queue.end(), IsLater);
+		std::shared_ptr<LoadJob> job = _queue.back();
+		_queue.pop_back();
+
+		if (job->Waiting == 0)
+		{
+			job->State = LOAD_STATE_CANCELED;
+		}
+		else
+		{
+			job->State = LOAD_STATE_LOADING;
+			lock.unlock();
+			bool loaded = job->Load();
+			lock.lock();
+			job->State = loaded ? LOAD_STATE_LOADED : LOAD_STATE_FAILED;
+		}
+
+		_finished.push_back(job);
+		_doneCondition.notify_all();
+	}
+}
+
+void AssetLoader::Complete(const std::shared_ptr<LoadJob>& job)
+{
+	bool loaded = job->State == LOAD_STATE_LOADED && job->Waiting > 0;
+	if (job->Complete)
+	{
+		job->Complete(*job, loaded);
+	}
+
+	for (auto& ticket : job->Tickets)
+	{
+		if (ticket->Canceled)
+		{
+			ticket->Value = nullptr;
+		}
+		ticket->Done = true;
+	}
+
+	// the callbacks hold the loaded data
+	job->Load = nullptr;
+	job->Complete = nullptr;
+	job->Completed = true;
+	_pendingCount--;
+}
+
+void AssetLoader::Execute(LoadJob& job)
+{
+	if (job.Waiting == 0)
+	{
+		job.State = LOAD_STATE_CANCELED;
+		return;
+	}
+
+	job.State = LOAD_STATE_LOADING;
+	job.State = job.Load() ? LOAD_STATE_LOADED : LOAD_STATE_FAILED;
+}
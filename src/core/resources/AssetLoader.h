@@ -0,0 +1,206 @@
+#pragma once
+
+#include "../API.h"
+#include "ModelResource.h"
+#include "AnimatedModelResource.h"
+#include "TextureResource.h"
+
+#include <vector>
+#include <memory>
+#include <functional>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace Euler
+{
+	// higher priorities are read first, loads of the same priority in the order they were requested
+	enum LoadPriority
+	{
+		LOAD_PRIORITY_LOW,
+		LOAD_PRIORITY_NORMAL,
+		LOAD_PRIORITY_HIGH
+	};
+
+	enum LoadState
+	{
+		LOAD_STATE_QUEUED,
+		LOAD_STATE_LOADING,
+		LOAD_STATE_LOADED,
+		LOAD_STATE_FAILED,
+		LOAD_STATE_CANCELED
+	};
+
+	// what one handle gets from a load, several handles can wait for the same load
+	struct LoadTicket
+	{
+		std::atomic<bool> Canceled{ false };
+		std::atomic<bool> Done{ false };
+		// nullptr when the load failed, set before Done
+		std::shared_ptr<void> Value;
+	};
+
+	/// <summary>
+	/// One load: Load runs on a worker of the loader, Complete on the render thread in AssetLoader::Update
+	/// and hands the result to the tickets. Jobs without Load only wait for their dependencies, e.g. a
+	/// material for its textures. A job nobody waits for anymore is skipped if it hasn't started yet.
+	/// </summary>
+	class EULER_API LoadJob
+	{
+	public:
+		LoadPriority Priority = LOAD_PRIORITY_NORMAL;
+		uint64_t Sequence = 0;
+		std::atomic<uint32_t> State{ LOAD_STATE_QUEUED };
+		// tickets that weren't canceled
+		std::atomic<uint32_t> Waiting{ 0 };
+
+		// render thread only
+		std::vector<std::shared_ptr<LoadTicket>> Tickets;
+		std::vector<std::shared_ptr<LoadJob>> Dependencies;
+		bool Completed = false;
+
+		// returns whether it loaded, must not touch anything of the render thread
+		std::function<bool()> Load;
+		// loaded is false when the job failed or nobody waits for it anymore
+		std::function<void(LoadJob& job, bool loaded)> Complete;
+	};
+
+	/// <summary>
+	/// The result of a load, valid once IsDone. Handles are meant to be used on the render thread.
+	/// </summary>
+	template <typename T>
+	class LoadHandle
+	{
+	private:
+		std::shared_ptr<LoadJob> _job;
+		std::shared_ptr<LoadTicket> _ticket;
+
+	public:
+		LoadHandle()
+		{
+		}
+
+		LoadHandle(const std::shared_ptr<LoadJob>& job, const std::shared_ptr<LoadTicket>& ticket)
+			: _job(job), _ticket(ticket)
+		{
+		}
+
+		bool IsValid() const
+		{
+			return _ticket != nullptr;
+		}
+
+		bool IsDone() const
+		{
+			return _ticket != nullptr && _ticket->Done;
+		}
+
+		LoadState GetState() const
+		{
+			if (_ticket->Canceled)
+			{
+				return LOAD_STATE_CANCELED;
+			}
+			if (_ticket->Done)
+			{
+				return _ticket->Value != nullptr ? LOAD_STATE_LOADED : LOAD_STATE_FAILED;
+			}
+			return _job->State == LOAD_STATE_LOADING ? LOAD_STATE_LOADING : LOAD_STATE_QUEUED;
+		}
+
+		// nullptr until the load is done, and when it failed or was canceled
+		T* Get() const
+		{
+			return IsDone() && !_ticket->Canceled ? (T*)_ticket->Value.get() : nullptr;
+		}
+
+		// does nothing once the load is done
+		void Cancel()
+		{
+			if (_ticket != nullptr && !_ticket->Done && !_ticket->Canceled.exchange(true))
+			{
+				_job->Waiting--;
+			}
+		}
+
+		const std::shared_ptr<LoadJob>& GetJob() const
+		{
+			return _job;
+		}
+	};
+
+	/// <summary>
+	/// Reads and decodes asset files on a pool of worker threads, so loading scales with the cores
+	/// instead of blocking the render thread on every file. Loads return a handle right away and are
+	/// completed in Update on the render thread, where the CPU data can be uploaded. Finish completes a
+	/// load right away, running it on the calling thread if no worker has picked it up yet.
+	/// </summary>
+	class EULER_API AssetLoader
+	{
+	private:
+		std::vector<std::thread> _workers;
+		std::mutex _mutex;
+		std::condition_variable _jobCondition;
+		std::condition_variable _doneCondition;
+		bool _stop = false;
+		uint64_t _nextSequence = 0;
+
+		// heap of the jobs no worker has picked up
+		std::vector<std::shared_ptr<LoadJob>> _queue;
+		// jobs the workers are done with, in the order they finished
+		std::vector<std::shared_ptr<LoadJob>> _finished;
+		// render thread only, jobs waiting for their dependencies
+		std::vector<std::shared_ptr<LoadJob>> _deferred;
+		// render thread only, jobs submitted and not completed
+		uint32_t _pendingCount = 0;
+
+	public:
+		// completions per Update, spreads the uploads of many finished loads over frames. 0 completes everything
+		uint32_t MaxCompletionsPerUpdate = 0;
+
+		// 0 workers takes one less than the cores, the render thread has one
+		void Create(uint32_t workerCount = 0);
+		// completes the loads that didn't finish as failed
+		void Destroy();
+		uint32_t GetWorkerCount() const;
+
+		// queues the job and returns its first ticket
+		std::shared_ptr<LoadTicket> Submit(const std::shared_ptr<LoadJob>& job);
+		// another ticket for a job that is queued or loading, nullptr when nobody waited for it and it was skipped
+		std::shared_ptr<LoadTicket> Attach(const std::shared_ptr<LoadJob>& job);
+		// applies to the dependencies too
+		void SetPriority(const std::shared_ptr<LoadJob>& job, LoadPriority priority);
+
+		// completes the loads the workers finished, call once a frame on the render thread
+		void Update();
+		// completes the job and its dependencies before returning
+		void Finish(const std::shared_ptr<LoadJob>& job);
+		void FinishAll();
+		// jobs not completed yet
+		uint32_t GetPendingCount() const;
+
+		// the file's CPU data, see ModelResource::Load
+		LoadHandle<ModelResource> LoadModel(const char* filePath, VertexFormat format = VERTEX_FORMAT_FULL, uint32_t meshIndex = 0, LoadPriority priority = LOAD_PRIORITY_NORMAL);
+		// the animations belong to whoever takes them from the resource
+		LoadHandle<AnimatedModelResource> LoadAnimatedModel(const char* filePath, VertexFormat format = VERTEX_FORMAT_FULL, LoadPriority priority = LOAD_PRIORITY_NORMAL);
+		LoadHandle<TextureResource> LoadTexture(const char* filePath, TextureChannels textureChannels = TEXTURE_CHANNELS_RGBA, LoadPriority priority = LOAD_PRIORITY_NORMAL);
+
+		template <typename T>
+		void Finish(const LoadHandle<T>& handle)
+		{
+			Finish(handle.GetJob());
+		}
+
+		template <typename T>
+		void SetPriority(const LoadHandle<T>& handle, LoadPriority priority)
+		{
+			SetPriority(handle.GetJob(), priority);
+		}
+
+	private:
+		void Run();
+		void Complete(const std::shared_ptr<LoadJob>& job);
+		void Execute(LoadJob& job);
+	};
+}
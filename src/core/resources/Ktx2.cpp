@@ -0,0 +1,46 @@
+#include "Ktx2.h"
+
+static_assert(sizeof(Euler::Ktx2Header) == 80, "KTX2 header layout");
+static_assert(sizeof(Euler::Ktx2Level) == 24, "KTX2 level index layout");
+
+VkFormat Euler::GetVkFormat(TextureFormat format, bool srgb)
+{
+	switch (format)
+	{
+	case TEXTURE_FORMAT_BC1:
+		return srgb ? VK_FORMAT_BC1_RGB_SRGB_BLOCK : VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+
+	case TEXTURE_FORMAT_BC3:
+		return srgb ? VK_FORMAT_BC3_SRGB_BLOCK : VK_FORMAT_BC3_UNORM_BLOCK;
+
+	// there's no sRGB BC5, it's meant for normal maps
+	case TEXTURE_FORMAT_BC5:
+		return VK_FORMAT_BC5_UNORM_BLOCK;
+
+	case TEXTURE_FORMAT_BC7:
+		return srgb ? VK_FORMAT_BC7_SRGB_BLOCK : VK_FORMAT_BC7_UNORM_BLOCK;
+
+	default:
+	case TEXTURE_FORMAT_RGBA8:
+		return srgb ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM;
+	}
+}
+
+bool Euler::GetTextureFormat(VkFormat vkFormat, TextureFormat* format, bool* srgb)
+{
+	TextureFormat formats[] = { TEXTURE_FORMAT_RGBA8, TEXTURE_FORMAT_BC1, TEXTURE_FORMAT_BC3, TEXTURE_FORMAT_BC5, TEXTURE_FORMAT_BC7 };
+	for (TextureFormat candidate : formats)
+	{
+		for (bool candidateSrgb : { false, true })
+		{
+			if (GetVkFormat(candidate, candidateSrgb) == vkFormat)
+			{
+				*format = candidate;
+				*srgb = candidateSrgb;
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "../API.h"
+#include "TextureResource.h"
+
+#include <vulkan/vulkan.h>
+#include <stdint.h>
+
+namespace Euler
+{
+	// KTX 2.0 container, only the parts eulertexture writes: 2D, one layer, one face and no supercompression.
+	// The identifier, header and index are one block at the start of the file, the level index follows it
+	struct Ktx2Header
+	{
+		uint8_t Identifier[12];
+		uint32_t VkFormat;
+		uint32_t TypeSize;
+		uint32_t PixelWidth;
+		uint32_t PixelHeight;
+		uint32_t PixelDepth;
+		uint32_t LayerCount;
+		uint32_t FaceCount;
+		uint32_t LevelCount;
+		uint32_t SupercompressionScheme;
+		uint32_t DfdByteOffset;
+		uint32_t DfdByteLength;
+		uint32_t KvdByteOffset;
+		uint32_t KvdByteLength;
+		uint64_t SgdByteOffset;
+		uint64_t SgdByteLength;
+	};
+
+	struct Ktx2Level
+	{
+		uint64_t ByteOffset;
+		uint64_t ByteLength;
+		uint64_t UncompressedByteLength;
+	};
+
+	static const uint8_t KTX2_IDENTIFIER[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+	EULER_API VkFormat GetVkFormat(TextureFormat format, bool srgb);
+	// false for formats the engine doesn't load
+	EULER_API bool GetTextureFormat(VkFormat vkFormat, TextureFormat* format, bool* srgb);
+}
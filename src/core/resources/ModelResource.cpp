@@ -1,66 +1,167 @@
 #include "ModelResource.h"
 
-#include <iostream>
-#include <fstream>
+#include <string.h>
 
 using namespace Euler;
 
-void ModelResource::Load(const char* filePath)
-{
-	//std::ifstream fs;
-	//fs.open(filePath);
-
-	//uint32_t vertexCount;
-	//uint32_t indexCount;
-
-	//fs >> vertexCount;
-	//fs >> indexCount;
-
-	//Vertices.resize(vertexCount);
-	//Indices.resize(indexCount);
-
-	//for (uint32_t i = 0; i < vertexCount; i++)
-	//{
-	//	fs >> Vertices[i].Position.x;
-	//	fs >> Vertices[i].Position.y;
-	//	fs >> Vertices[i].Position.z;
-
-	//	fs >> Vertices[i].Normal.x;
-	//	fs >> Vertices[i].Normal.y;
-	//	fs >> Vertices[i].Normal.z;
-
-	//	fs >> Vertices[i].UV.x;
-	//	fs >> Vertices[i].UV.y;
-	//}
-
-	//for (uint32_t i = 0; i < indexCount; i++)
-	//{
-	//	fs >> Indices[i];
-	//}
-
-	std::ifstream fs;
-	fs.open(filePath, std::ios::in | std::ios::binary);
-
-	uint32_t meshCount;
-	uint32_t vertexCount;
-	uint32_t indexCount;
-	
-	fs.read((char*)(&meshCount), sizeof(uint32_t));
-	fs.read((char*)(&vertexCount), sizeof(uint32_t));
-	fs.read((char*)(&indexCount), sizeof(uint32_t));
+const uint32_t ModelResource::FILE_MAGIC;
 
-	Vertices.resize(vertexCount);
-	Indices.resize(indexCount);
+namespace
+{
+	// the data in the mapping may not be aligned for T
+	template <typename T>
+	void CopyArray(std::vector<T>& vector, const void* data, uint32_t count)
+	{
+		vector.resize(count);
+		if (count > 0)
+		{
+			memcpy(vector.data(), data, count * sizeof(T));
+		}
+	}
+}
 
-	fs.read((char*)Vertices.data(), vertexCount * sizeof(Vertex));
-	fs.read((char*)Indices.data(), indexCount * sizeof(uint32_t));
+void ModelResource::Load(const char* filePath, VertexFormat format, uint32_t meshIndex)
+{
+	Read(filePath, format, meshIndex, true);
+}
 
-	fs.close();
+void ModelResource::Map(const char* filePath, VertexFormat format, uint32_t meshIndex)
+{
+	Read(filePath, format, meshIndex, false);
 }
 
 void ModelResource::Unload()
 {
 	// trick to force the vectors to free-up the memory
 	std::vector<Vertex>().swap(Vertices);
+	std::vector<PackedVertex>().swap(PackedVertices);
 	std::vector<uint32_t>().swap(Indices);
-}
\ No newline at end of file
+	std::vector<uint16_t>().swap(ShortIndices);
+	std::vector<MeshLod>().swap(Lods);
+
+	View = GeometryView();
+	_file.Close();
+}
+
+void ModelResource::Read(const char* filePath, VertexFormat format, uint32_t meshIndex, bool copy)
+{
+	Unload();
+	if (!_file.Open(filePath))
+	{
+		return;
+	}
+
+	MappedFileReader reader(_file);
+
+	uint32_t magic = 0;
+	uint32_t version = 0;
+	uint32_t fileFormat = VERTEX_FORMAT_FULL;
+	uint32_t vertexCount = 0;
+	uint32_t indexCount = 0;
+	uint32_t lodCount = 0;
+	uint32_t indexSize = sizeof(uint32_t);
+
+	bool valid = reader.Read(magic);
+	if ((magic & 0x00FFFFFF) == (FILE_MAGIC & 0x00FFFFFF))
+	{
+		version = (magic >> 24) - '0';
+		valid = valid && reader.Read(MeshCount);
+	}
+	else
+	{
+		MeshCount = magic;
+	}
+
+	if (version >= 2)
+	{
+		valid = valid && reader.Read(fileFormat);
+	}
+	uint32_t vertexSize = fileFormat == VERTEX_FORMAT_PACKED ? sizeof(PackedVertex) : sizeof(Vertex);
+
+	// the meshes before meshIndex are skipped
+	const uint8_t* vertices = nullptr;
+	const uint8_t* indices = nullptr;
+	const uint8_t* lods = nullptr;
+	valid = valid && meshIndex < MeshCount;
+	for (uint32_t i = 0; valid && i <= meshIndex; i++)
+	{
+		valid = reader.Read(vertexCount) && reader.Read(indexCount);
+		if (version >= 1)
+		{
+			valid = valid && reader.Read(lodCount);
+		}
+		if (version >= 3)
+		{
+			valid = valid && reader.Read(indexSize);
+		}
+		valid = valid && (indexSize == sizeof(uint16_t) || indexSize == sizeof(uint32_t));
+
+		vertices = valid ? reader.Skip((uint64_t)vertexCount * vertexSize) : nullptr;
+		indices = vertices != nullptr ? reader.Skip((uint64_t)indexCount * indexSize) : nullptr;
+		lods = indices != nullptr ? reader.Skip((uint64_t)lodCount * sizeof(MeshLod)) : nullptr;
+		valid = lods != nullptr;
+	}
+
+	if (!valid)
+	{
+		Unload();
+		return;
+	}
+
+	CopyArray(Lods, lods, lodCount);
+
+	// the mapping can only be uploaded as it is when it has the requested format and its values are aligned
+	bool aligned = (uintptr_t)vertices % sizeof(float) == 0 && (uintptr_t)indices % indexSize == 0;
+	if (!copy && fileFormat == (uint32_t)format && aligned)
+	{
+		View.Vertices = vertices;
+		View.VertexCount = vertexCount;
+		View.VertexStride = vertexSize;
+		View.Indices = indices;
+		View.IndexCount = indexCount;
+		View.IndexSize = indexSize;
+
+		// the indices follow the vertices
+		_file.Prefetch(vertices, View.GetSize());
+		return;
+	}
+
+	if (fileFormat == VERTEX_FORMAT_PACKED)
+	{
+		CopyArray(PackedVertices, vertices, vertexCount);
+	}
+	else
+	{
+		CopyArray(Vertices, vertices, vertexCount);
+	}
+
+	if (indexSize == sizeof(uint16_t))
+	{
+		CopyArray(ShortIndices, indices, indexCount);
+	}
+	else
+	{
+		CopyArray(Indices, indices, indexCount);
+	}
+
+	_file.Close();
+
+	if (format == VERTEX_FORMAT_PACKED && fileFormat != VERTEX_FORMAT_PACKED)
+	{
+		PackedVertices.resize(Vertices.size());
+		for (uint32_t i = 0; i < Vertices.size(); i++)
+		{
+			PackedVertices[i] = PackVertex(Vertices[i]);
+		}
+		std::vector<Vertex>().swap(Vertices);
+	}
+	else if (format == VERTEX_FORMAT_FULL && fileFormat == VERTEX_FORMAT_PACKED)
+	{
+		Vertices.resize(PackedVertices.size());
+		for (uint32_t i = 0; i < PackedVertices.size(); i++)
+		{
+			Vertices[i] = UnpackVertex(PackedVertices[i]);
+		}
+		std::vector<PackedVertex>().swap(PackedVertices);
+	}
+}
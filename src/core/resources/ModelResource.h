@@ -2,6 +2,10 @@
 
 #include "../API.h"
 #include "../graphics/Vertex.h"
+#include "../graphics/PackedVertex.h"
+#include "../graphics/MeshLod.h"
+#include "../graphics/GeometryView.h"
+#include "../io/MappedFile.h"
 
 #include <vector>
 
@@ -10,10 +14,34 @@ namespace Euler
 	class EULER_API ModelResource
 	{
 	public:
+		// "BEM" and the version digit, version 1 added levels of detail, 2 the vertex format after the mesh count and
+		// 3 the index size after every mesh's level count. Files written before version 1 start with the mesh count instead
+		static const uint32_t FILE_MAGIC = 0x334D4542;
+
+		// only the vector of the format passed to Load is filled, the file's vertices are converted when it differs
 		std::vector<Vertex> Vertices;
+		std::vector<PackedVertex> PackedVertices;
+		// files with 16-bit indices fill ShortIndices instead of Indices
 		std::vector<uint32_t> Indices;
+		std::vector<uint16_t> ShortIndices;
+		// index ranges of the levels of detail, empty for files without them
+		std::vector<MeshLod> Lods;
+		// set by Map instead of the vertex and index vectors, points into the mapped file until Unload
+		GeometryView View;
+
+		// meshes in the file, eulermodel --split writes one per part of the meshes too big for 16-bit indices
+		uint32_t MeshCount = 0;
 
-		void Load(const char* filePath);
+		void Load(const char* filePath, VertexFormat format = VERTEX_FORMAT_FULL, uint32_t meshIndex = 0);
+		// like Load, but keeps the file mapped and points View at its vertices and indices instead of copying them.
+		// The vectors are filled as by Load when the file's vertex format isn't format or its data isn't aligned
+		void Map(const char* filePath, VertexFormat format = VERTEX_FORMAT_FULL, uint32_t meshIndex = 0);
+		// unmaps the file too
 		void Unload();
+
+	private:
+		MappedFile _file;
+
+		void Read(const char* filePath, VertexFormat format, uint32_t meshIndex, bool copy);
 	};
 }
\ No newline at end of file
@@ -1,3 +1,691 @@
 #include "Resources.h"
+#include "ModelResource.h"
+#include "AnimatedModelResource.h"
 
-using namespace Euler;
\ No newline at end of file
+#include <iostream>
+#include <string.h>
+
+using namespace Euler;
+
+namespace
+{
+	// the animations and bones belong to whoever loads them from the file for an animator
+	void DeleteAnimations(AnimatedModelResource& modelResource)
+	{
+		for (auto animation : modelResource.Animations)
+		{
+			delete animation;
+		}
+		modelResource.Animations.clear();
+	}
+
+	// checked on the loading thread, files that can't be read leave the vertices empty
+	bool HasVertices(const ModelResource& modelResource)
+	{
+		return !modelResource.View.IsEmpty() || !modelResource.Vertices.empty() || !modelResource.PackedVertices.empty();
+	}
+
+	bool HasVertices(const AnimatedModelResource& modelResource)
+	{
+		return !modelResource.View.IsEmpty() || !modelResource.Vertices.empty() || !modelResource.PackedVertices.empty();
+	}
+
+	// assets belong to the cache, the handles only point at them
+	std::shared_ptr<void> CachedValue(void* asset)
+	{
+		return std::shared_ptr<void>(asset, [](void*) {});
+	}
+}
+
+float ResourceStats::GetHitRate() const
+{
+	return Requests > 0 ? (float)Hits / Requests : 0.0f;
+}
+
+void Resources::Create(Graphics::Vulkan* vulkan, uint32_t loaderThreadCount)
+{
+	_vulkan = vulkan;
+	_loader.Create(loaderThreadCount);
+}
+
+void Resources::Destroy()
+{
+	// loads that didn't finish fail and don't create anything
+	_loader.Destroy();
+
+	// materials hold references to textures, so they go first
+	ResourceType order[] = { RESOURCE_TYPE_MATERIAL, RESOURCE_TYPE_MESH, RESOURCE_TYPE_ANIMATED_MESH, RESOURCE_TYPE_TEXTURE };
+	for (ResourceType type : order)
+	{
+		for (auto& entry : _entries[type])
+		{
+			DestroyAsset(type, entry.second);
+		}
+		_entries[type].clear();
+		_keys[type].clear();
+		_pending[type].clear();
+		_stats[type] = ResourceStats();
+	}
+	_releasedCount = 0;
+}
+
+Mesh* Resources::GetMesh(const char* filePath, VertexFormat format, uint32_t meshIndex)
+{
+	std::string key = NormalizePath(filePath) + "#" + std::to_string(meshIndex) + "@" + std::to_string(format);
+	FinishPending(RESOURCE_TYPE_MESH, key);
+	Entry* entry = Find(RESOURCE_TYPE_MESH, key);
+	if (entry != nullptr)
+	{
+		return (Mesh*)entry->Asset;
+	}
+
+	ModelResource modelResource;
+	modelResource.Map(filePath, format, meshIndex);
+	if (!HasVertices(modelResource))
+	{
+		std::cout << "Resources: can't load a mesh from " << filePath << std::endl;
+		return nullptr;
+	}
+
+	uint64_t bytes = 0;
+	Mesh* mesh = CreateMesh(modelResource, bytes);
+	Add(RESOURCE_TYPE_MESH, key, mesh, bytes);
+	return mesh;
+}
+
+AnimatedMesh* Resources::GetAnimatedMesh(const char* filePath, VertexFormat format)
+{
+	std::string key = NormalizePath(filePath) + "@" + std::to_string(format);
+	FinishPending(RESOURCE_TYPE_ANIMATED_MESH, key);
+	Entry* entry = Find(RESOURCE_TYPE_ANIMATED_MESH, key);
+	if (entry != nullptr)
+	{
+		return (AnimatedMesh*)entry->Asset;
+	}
+
+	AnimatedModelResource modelResource;
+	modelResource.Map(filePath, format);
+	DeleteAnimations(modelResource);
+
+	if (!HasVertices(modelResource))
+	{
+		std::cout << "Resources: can't load an animated mesh from " << filePath << std::endl;
+		return nullptr;
+	}
+
+	uint64_t bytes = 0;
+	AnimatedMesh* mesh = CreateAnimatedMesh(modelResource, bytes);
+	Add(RESOURCE_TYPE_ANIMATED_MESH, key, mesh, bytes);
+	return mesh;
+}
+
+Graphics::Texture* Resources::GetTexture(const char* filePath, VkDescriptorSetLayout descriptorSetLayout, bool srgb)
+{
+	// the descriptor sets are allocated with the layout, so textures for other layouts are other assets
+	std::string key = NormalizePath(filePath) + (srgb ? "@srgb@" : "@linear@") + std::to_string((uint64_t)descriptorSetLayout);
+	FinishPending(RESOURCE_TYPE_TEXTURE, key);
+	Entry* entry = Find(RESOURCE_TYPE_TEXTURE, key);
+	if (entry != nullptr)
+	{
+		return (Graphics::Texture*)entry->Asset;
+	}
+
+	Graphics::Texture* texture = new Graphics::Texture();
+	texture->Srgb = srgb;
+	texture->Create(_vulkan, filePath, descriptorSetLayout);
+
+	// streamed textures change size, GetStats reads it again
+	Add(RESOURCE_TYPE_TEXTURE, key, texture, texture->GetMemorySize());
+	return texture;
+}
+
+Graphics::Material* Resources::GetMaterial(const MaterialDesc& desc, VkDescriptorSetLayout textureLayout, VkDescriptorSetLayout propertiesLayout)
+{
+	std::string key = GetMaterialKey(desc, textureLayout, propertiesLayout);
+	FinishPending(RESOURCE_TYPE_MATERIAL, key);
+	Entry* entry = Find(RESOURCE_TYPE_MATERIAL, key);
+	if (entry != nullptr)
+	{
+		return (Graphics::Material*)entry->Asset;
+	}
+
+	Graphics::Material* material = new Graphics::Material();
+	material->ColorMap = desc.ColorMap != nullptr ? GetTexture(desc.ColorMap, textureLayout, true) : nullptr;
+	material->NormalMap = desc.NormalMap != nullptr ? GetTexture(desc.NormalMap, textureLayout, false) : nullptr;
+	material->SpecularMap = desc.SpecularMap != nullptr ? GetTexture(desc.SpecularMap, textureLayout, false) : nullptr;
+	material->Properties = desc.Properties;
+	material->Create(_vulkan, propertiesLayout);
+
+	Entry& added = Add(RESOURCE_TYPE_MATERIAL, key, material, sizeof(Graphics::MaterialProperties) * _vulkan->GetSwapchainImageCount());
+	for (Graphics::Texture* texture : { material->ColorMap, material->NormalMap, material->SpecularMap })
+	{
+		if (texture != nullptr)
+		{
+			added.Textures.push_back(texture);
+		}
+	}
+
+	return material;
+}
+
+LoadHandle<Mesh> Resources::GetMeshAsync(const char* filePath, VertexFormat format, uint32_t meshIndex, LoadPriority priority)
+{
+	std::string key = NormalizePath(filePath) + "#" + std::to_string(meshIndex) + "@" + std::to_string(format);
+	std::shared_ptr<LoadJob> job;
+	std::shared_ptr<LoadTicket> ticket = FindAsync(RESOURCE_TYPE_MESH, key, job);
+	if (ticket != nullptr)
+	{
+		return LoadHandle<Mesh>(job, ticket);
+	}
+
+	std::shared_ptr<ModelResource> modelResource = std::make_shared<ModelResource>();
+	std::string path = filePath;
+
+	job = std::make_shared<LoadJob>();
+	job->Priority = priority;
+	job->Load = [modelResource, path, format, meshIndex]()
+	{
+		modelResource->Map(path.c_str(), format, meshIndex);
+		return HasVertices(*modelResource);
+	};
+
+	CreateFunction create = [this, modelResource](uint64_t& bytes, std::vector<Graphics::Texture*>&)
+	{
+		return (void*)CreateMesh(*modelResource, bytes);
+	};
+	job->Complete = [this, key, create](LoadJob& job, bool loaded)
+	{
+		CompleteAsync(RESOURCE_TYPE_MESH, key, job, loaded, create);
+	};
+
+	return LoadHandle<Mesh>(job, SubmitAsync(RESOURCE_TYPE_MESH, key, job));
+}
+
+LoadHandle<AnimatedMesh> Resources::GetAnimatedMeshAsync(const char* filePath, VertexFormat format, LoadPriority priority)
+{
+	std::string key = NormalizePath(filePath) + "@" + std::to_string(format);
+	std::shared_ptr<LoadJob> job;
+	std::shared_ptr<LoadTicket> ticket = FindAsync(RESOURCE_TYPE_ANIMATED_MESH, key, job);
+	if (ticket != nullptr)
+	{
+		return LoadHandle<AnimatedMesh>(job, ticket);
+	}
+
+	std::shared_ptr<AnimatedModelResource> modelResource = std::make_shared<AnimatedModelResource>();
+	std::string path = filePath;
+
+	job = std::make_shared<LoadJob>();
+	job->Priority = priority;
+	job->Load = [modelResource, path, format]()
+	{
+		modelResource->Map(path.c_str(), format);
+		DeleteAnimations(*modelResource);
+		return HasVertices(*modelResource);
+	};
+
+	CreateFunction create = [this, modelResource](uint64_t& bytes, std::vector<Graphics::Texture*>&)
+	{
+		return (void*)CreateAnimatedMesh(*modelResource, bytes);
+	};
+	job->Complete = [this, key, create](LoadJob& job, bool loaded)
+	{
+		CompleteAsync(RESOURCE_TYPE_ANIMATED_MESH, key, job, loaded, create);
+	};
+
+	return LoadHandle<AnimatedMesh>(job, SubmitAsync(RESOURCE_TYPE_ANIMATED_MESH, key, job));
+}
+
+LoadHandle<Graphics::Texture> Resources::GetTextureAsync(const char* filePath, VkDescriptorSetLayout descriptorSetLayout, bool srgb, LoadPriority priority)
+{
+	std::string key = NormalizePath(filePath) + (srgb ? "@srgb@" : "@linear@") + std::to_string((uint64_t)descriptorSetLayout);
+	std::shared_ptr<LoadJob> job;
+	std::shared_ptr<LoadTicket> ticket = FindAsync(RESOURCE_TYPE_TEXTURE, key, job);
+	if (ticket != nullptr)
+	{
+		return LoadHandle<Graphics::Texture>(job, ticket);
+	}
+
+	// the pixels are freed with the job once the texture was created, or the load failed
+	std::shared_ptr<TextureResource> textureResource(new TextureResource(), [](TextureResource* resource)
+	{
+		resource->Unload();
+		delete resource;
+	});
+	std::string path = filePath;
+	Graphics::Vulkan* vulkan = _vulkan;
+
+	job = std::make_shared<LoadJob>();
+	job->Priority = priority;
+	job->Load = [vulkan, textureResource, path]()
+	{
+		Graphics::Texture::LoadFile(vulkan, path.c_str(), textureResource.get());
+		return textureResource->GetLevelCount() > 0 && textureResource->GetLevelData(textureResource->GetFirstLevel()) != nullptr;
+	};
+
+	CreateFunction create = [this, textureResource, path, srgb, descriptorSetLayout](uint64_t& bytes, std::vector<Graphics::Texture*>&)
+	{
+		Graphics::Texture* texture = new Graphics::Texture();
+		texture->Srgb = srgb;
+		texture->Create(_vulkan, path.c_str(), textureResource.get(), descriptorSetLayout);
+		bytes = texture->GetMemorySize();
+		return (void*)texture;
+	};
+	job->Complete = [this, key, create](LoadJob& job, bool loaded)
+	{
+		CompleteAsync(RESOURCE_TYPE_TEXTURE, key, job, loaded, create);
+	};
+
+	return LoadHandle<Graphics::Texture>(job, SubmitAsync(RESOURCE_TYPE_TEXTURE, key, job));
+}
+
+LoadHandle<Graphics::Material> Resources::GetMaterialAsync(const MaterialDesc& desc, VkDescriptorSetLayout textureLayout, VkDescriptorSetLayout propertiesLayout, LoadPriority priority)
+{
+	std::string key = GetMaterialKey(desc, textureLayout, propertiesLayout);
+	std::shared_ptr<LoadJob> job;
+	std::shared_ptr<LoadTicket> ticket = FindAsync(RESOURCE_TYPE_MATERIAL, key, job);
+	if (ticket != nullptr)
+	{
+		return LoadHandle<Graphics::Material>(job, ticket);
+	}
+
+	// the material's job only waits for its textures, their references go to the material
+	job = std::make_shared<LoadJob>();
+	job->Priority = priority;
+
+	const char* paths[] = { desc.ColorMap, desc.NormalMap, desc.SpecularMap };
+	std::vector<LoadHandle<Graphics::Texture>> maps(3);
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		if (paths[i] != nullptr)
+		{
+			maps[i] = GetTextureAsync(paths[i], textureLayout, i == 0, priority);
+			job->Dependencies.push_back(maps[i].GetJob());
+		}
+	}
+
+	Graphics::MaterialProperties properties = desc.Properties;
+	CreateFunction create = [this, maps, properties, propertiesLayout](uint64_t& bytes, std::vector<Graphics::Texture*>& textures)
+	{
+		for (auto& map : maps)
+		{
+			if (map.IsValid() && map.Get() == nullptr)
+			{
+				return (void*)nullptr;
+			}
+		}
+
+		Graphics::Material* material = new Graphics::Material();
+		material->ColorMap = maps[0].Get();
+		material->NormalMap = maps[1].Get();
+		material->SpecularMap = maps[2].Get();
+		material->Properties = properties;
+		material->Create(_vulkan, propertiesLayout);
+
+		bytes = sizeof(Graphics::MaterialProperties) * _vulkan->GetSwapchainImageCount();
+		for (auto& map : maps)
+		{
+			if (map.Get() != nullptr)
+			{
+				textures.push_back(map.Get());
+			}
+		}
+		return (void*)material;
+	};
+	job->Complete = [this, key, create, maps](LoadJob& job, bool loaded)
+	{
+		// without a material the textures that did load aren't held by anything
+		if (CompleteAsync(RESOURCE_TYPE_MATERIAL, key, job, loaded, create) == nullptr)
+		{
+			for (auto& map : maps)
+			{
+				Release(map.Get());
+			}
+		}
+	};
+
+	return LoadHandle<Graphics::Material>(job, SubmitAsync(RESOURCE_TYPE_MATERIAL, key, job));
+}
+
+void Resources::Release(Mesh* mesh)
+{
+	Release(RESOURCE_TYPE_MESH, mesh);
+}
+
+void Resources::Release(AnimatedMesh* mesh)
+{
+	Release(RESOURCE_TYPE_ANIMATED_MESH, mesh);
+}
+
+void Resources::Release(Graphics::Texture* texture)
+{
+	Release(RESOURCE_TYPE_TEXTURE, texture);
+}
+
+void Resources::Release(Graphics::Material* material)
+{
+	Release(RESOURCE_TYPE_MATERIAL, material);
+}
+
+void Resources::Update()
+{
+	_loader.Update();
+
+	_frame++;
+	if (_releasedCount == 0)
+	{
+		return;
+	}
+
+	// materials release their textures when they're destroyed, so they go first
+	ResourceType order[] = { RESOURCE_TYPE_MATERIAL, RESOURCE_TYPE_MESH, RESOURCE_TYPE_ANIMATED_MESH, RESOURCE_TYPE_TEXTURE };
+	for (ResourceType type : order)
+	{
+		for (auto it = _entries[type].begin(); it != _entries[type].end();)
+		{
+			Entry& entry = it->second;
+			if (entry.References > 0 || _frame - entry.ReleasedFrame <= (uint64_t)_vulkan->_framesInFlight)
+			{
+				++it;
+				continue;
+			}
+
+			DestroyAsset(type, entry);
+			_keys[type].erase(entry.Asset);
+			it = _entries[type].erase(it);
+			_releasedCount--;
+		}
+	}
+}
+
+AssetLoader& Resources::GetLoader()
+{
+	return _loader;
+}
+
+ResourceStats Resources::GetStats(ResourceType type)
+{
+	ResourceStats stats = _stats[type];
+	stats.Loaded = _entries[type].size();
+	stats.Bytes = 0;
+	for (auto& entry : _entries[type])
+	{
+		stats.Bytes += type == RESOURCE_TYPE_TEXTURE ? ((Graphics::Texture*)entry.second.Asset)->GetMemorySize() : entry.second.Bytes;
+	}
+	return stats;
+}
+
+void Resources::PrintStats()
+{
+	const char* names[] = { "meshes", "animated meshes", "textures", "materials" };
+	for (uint32_t i = 0; i < RESOURCE_TYPE_COUNT; i++)
+	{
+		ResourceStats stats = GetStats((ResourceType)i);
+		std::cout << "Resources: " << stats.Loaded << " " << names[i]
+			<< ", " << stats.Hits << "/" << stats.Requests << " requests cached (" << stats.GetHitRate() * 100.0f << "%)"
+			<< ", " << stats.Bytes / 1024 << " KB" << std::endl;
+	}
+}
+
+std::string Resources::NormalizePath(const char* filePath)
+{
+	std::string path = filePath;
+	for (char& c : path)
+	{
+		if (c == '\\')
+		{
+			c = '/';
+		}
+	}
+
+	while (path.compare(0, 2, "./") == 0)
+	{
+		path.erase(0, 2);
+	}
+
+	return path;
+}
+
+Resources::Entry* Resources::Find(ResourceType type, const std::string& key)
+{
+	_stats[type].Requests++;
+
+	auto it = _entries[type].find(key);
+	if (it == _entries[type].end())
+	{
+		return nullptr;
+	}
+
+	// released assets waiting to be destroyed come back
+	Entry& entry = it->second;
+	if (entry.References == 0)
+	{
+		_releasedCount--;
+	}
+	entry.References++;
+	_stats[type].Hits++;
+	return &entry;
+}
+
+Resources::Entry& Resources::Add(ResourceType type, const std::string& key, void* asset, uint64_t bytes)
+{
+	Entry& entry = _entries[type][key];
+	entry.Asset = asset;
+	entry.References = 1;
+	entry.Bytes = bytes;
+	_keys[type][asset] = key;
+	return entry;
+}
+
+void Resources::Release(ResourceType type, const void* asset)
+{
+	if (asset == nullptr)
+	{
+		return;
+	}
+
+	auto key = _keys[type].find(asset);
+	if (key == _keys[type].end())
+	{
+		std::cout << "Resources: released an asset that isn't in the cache" << std::endl;
+		return;
+	}
+
+	Entry& entry = _entries[type][key->second];
+	if (entry.References > 0 && --entry.References == 0)
+	{
+		entry.ReleasedFrame = _frame;
+		_releasedCount++;
+	}
+}
+
+void Resources::DestroyAsset(ResourceType type, Entry& entry)
+{
+	switch (type)
+	{
+	case RESOURCE_TYPE_MESH:
+	{
+		Mesh* mesh = (Mesh*)entry.Asset;
+		mesh->Destroy(_vulkan);
+		delete mesh;
+		break;
+	}
+
+	case RESOURCE_TYPE_ANIMATED_MESH:
+	{
+		AnimatedMesh* mesh = (AnimatedMesh*)entry.Asset;
+		mesh->Destroy(_vulkan);
+		delete mesh;
+		break;
+	}
+
+	case RESOURCE_TYPE_TEXTURE:
+	{
+		Graphics::Texture* texture = (Graphics::Texture*)entry.Asset;
+		texture->Destroy();
+		delete texture;
+		break;
+	}
+
+	case RESOURCE_TYPE_MATERIAL:
+	{
+		Graphics::Material* material = (Graphics::Material*)entry.Asset;
+		material->Destroy();
+		delete material;
+		for (Graphics::Texture* texture : entry.Textures)
+		{
+			Release(texture);
+		}
+		break;
+	}
+
+	default:
+		break;
+	}
+
+	entry.Asset = nullptr;
+}
+
+Mesh* Resources::CreateMesh(ModelResource& modelResource, uint64_t& bytes)
+{
+	Mesh* mesh = new Mesh();
+	mesh->Vertices = std::move(modelResource.Vertices);
+	mesh->PackedVertices = std::move(modelResource.PackedVertices);
+	mesh->Indices = std::move(modelResource.Indices);
+	mesh->ShortIndices = std::move(modelResource.ShortIndices);
+	mesh->Lods = std::move(modelResource.Lods);
+	// mapped files are uploaded straight from the mapping
+	mesh->View = modelResource.View;
+
+	bytes = mesh->View.GetSize() + mesh->Vertices.size() * sizeof(Vertex) + mesh->PackedVertices.size() * sizeof(PackedVertex)
+		+ mesh->Indices.size() * sizeof(uint32_t) + mesh->ShortIndices.size() * sizeof(uint16_t);
+	mesh->Create(_vulkan);
+
+	modelResource.Unload();
+	return mesh;
+}
+
+AnimatedMesh* Resources::CreateAnimatedMesh(AnimatedModelResource& modelResource, uint64_t& bytes)
+{
+	AnimatedMesh* mesh = new AnimatedMesh();
+	mesh->Vertices = std::move(modelResource.Vertices);
+	mesh->PackedVertices = std::move(modelResource.PackedVertices);
+	mesh->Indices = std::move(modelResource.Indices);
+	mesh->ShortIndices = std::move(modelResource.ShortIndices);
+	mesh->Lods = std::move(modelResource.Lods);
+	// mapped files are uploaded straight from the mapping
+	mesh->View = modelResource.View;
+
+	bytes = mesh->View.GetSize() + mesh->Vertices.size() * sizeof(AnimatedVertex) + mesh->PackedVertices.size() * sizeof(PackedAnimatedVertex)
+		+ mesh->Indices.size() * sizeof(uint32_t) + mesh->ShortIndices.size() * sizeof(uint16_t);
+	mesh->Create(_vulkan);
+
+	modelResource.Unload();
+	return mesh;
+}
+
+std::string Resources::GetMaterialKey(const MaterialDesc& desc, VkDescriptorSetLayout textureLayout, VkDescriptorSetLayout propertiesLayout)
+{
+	const char* paths[] = { desc.ColorMap, desc.NormalMap, desc.SpecularMap };
+
+	std::string key;
+	for (const char* path : paths)
+	{
+		key += (path != nullptr ? NormalizePath(path) : std::string()) + "|";
+	}
+	key += std::to_string(desc.Properties.Shininess) + "|" + std::to_string(desc.Properties.UseNormalMap) + "|" + std::to_string(desc.Properties.UseSpecularMap)
+		+ "@" + std::to_string((uint64_t)textureLayout) + "@" + std::to_string((uint64_t)propertiesLayout);
+	return key;
+}
+
+void Resources::FinishPending(ResourceType type, const std::string& key)
+{
+	auto pending = _pending[type].find(key);
+	if (pending != _pending[type].end())
+	{
+		// completing erases it from the map
+		std::shared_ptr<LoadJob> job = pending->second;
+		_loader.Finish(job);
+	}
+}
+
+std::shared_ptr<LoadTicket> Resources::FindAsync(ResourceType type, const std::string& key, std::shared_ptr<LoadJob>& job)
+{
+	Entry* entry = Find(type, key);
+	if (entry != nullptr)
+	{
+		std::shared_ptr<LoadTicket> ticket = std::make_shared<LoadTicket>();
+		ticket->Value = CachedValue(entry->Asset);
+		ticket->Done = true;
+
+		job = std::make_shared<LoadJob>();
+		job->State = LOAD_STATE_LOADED;
+		job->Completed = true;
+		job->Tickets.push_back(ticket);
+		return ticket;
+	}
+
+	auto pending = _pending[type].find(key);
+	if (pending != _pending[type].end())
+	{
+		// nullptr when everyone canceled and the load was skipped, a new one replaces it
+		std::shared_ptr<LoadTicket> ticket = _loader.Attach(pending->second);
+		if (ticket != nullptr)
+		{
+			job = pending->second;
+			_stats[type].Hits++;
+			return ticket;
+		}
+	}
+
+	return nullptr;
+}
+
+std::shared_ptr<LoadTicket> Resources::SubmitAsync(ResourceType type, const std::string& key, const std::shared_ptr<LoadJob>& job)
+{
+	_pending[type][key] = job;
+	return _loader.Submit(job);
+}
+
+void* Resources::CompleteAsync(ResourceType type, const std::string& key, LoadJob& job, bool loaded, const CreateFunction& create)
+{
+	auto pending = _pending[type].find(key);
+	if (pending != _pending[type].end() && pending->second.get() == &job)
+	{
+		_pending[type].erase(pending);
+	}
+
+	uint32_t waiting = 0;
+	for (auto& ticket : job.Tickets)
+	{
+		waiting += ticket->Canceled ? 0 : 1;
+	}
+
+	void* asset = nullptr;
+	if (loaded && waiting > 0)
+	{
+		uint64_t bytes = 0;
+		std::vector<Graphics::Texture*> textures;
+		asset = create(bytes, textures);
+		if (asset != nullptr)
+		{
+			Entry& entry = Add(type, key, asset, bytes);
+			entry.References = waiting;
+			entry.Textures = textures;
+		}
+	}
+
+	if (waiting > 0 && asset == nullptr)
+	{
+		std::cout << "Resources: can't load " << key << std::endl;
+	}
+
+	for (auto& ticket : job.Tickets)
+	{
+		if (!ticket->Canceled)
+		{
+			ticket->Value = asset != nullptr ? CachedValue(asset) : nullptr;
+		}
+	}
+
+	return asset;
+}
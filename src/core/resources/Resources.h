@@ -3,10 +3,142 @@
 #include "../API.h"
 
 #include "TextureResource.h"
+#include "AssetLoader.h"
+#include "../graphics/PackedVertex.h"
+#include "../graphics/Mesh.h"
+#include "../graphics/AnimatedMesh.h"
+#include "../graphics/Texture.h"
+#include "../graphics/Material.h"
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <functional>
 
 namespace Euler
 {
+	enum ResourceType
+	{
+		RESOURCE_TYPE_MESH,
+		RESOURCE_TYPE_ANIMATED_MESH,
+		RESOURCE_TYPE_TEXTURE,
+		RESOURCE_TYPE_MATERIAL,
+		RESOURCE_TYPE_COUNT
+	};
+
+	struct EULER_API ResourceStats
+	{
+		uint32_t Loaded = 0;		// assets in the cache, including released ones not destroyed yet
+		uint64_t Requests = 0;
+		uint64_t Hits = 0;			// requests served without loading the asset
+		uint64_t Bytes = 0;			// device memory of the loaded assets
+
+		float GetHitRate() const;
+	};
+
+	// what a material is made of, requests with the same description share the material and its textures
+	struct EULER_API MaterialDesc
+	{
+		const char* ColorMap = nullptr;
+		const char* NormalMap = nullptr;
+		const char* SpecularMap = nullptr;
+		Graphics::MaterialProperties Properties;
+	};
+
+	/// <summary>
+	/// Cache of the meshes, textures and materials loaded from files. Assets are keyed by their path and
+	/// the options they were created with, so every request for the same file gets the same object and
+	/// the file is only read and uploaded once. Every Get needs a Release; an asset nobody references
+	/// anymore is destroyed in Update once the frames in flight that could use it are done, and is
+	/// revived without loading if it's requested again before that. The Async variants read and decode
+	/// the files on the loader's workers and create the assets in Update; requests for an asset that is
+	/// still loading share the load. Model files are mapped and their geometry uploaded from the mapping.
+	/// </summary>
 	class EULER_API Resources
 	{
+	private:
+		struct Entry
+		{
+			void* Asset = nullptr;
+			uint32_t References = 0;
+			uint64_t Bytes = 0;
+			// Update's frame counter when the last reference was released
+			uint64_t ReleasedFrame = 0;
+			// the textures a material holds references to
+			std::vector<Graphics::Texture*> Textures;
+		};
+
+		// creates the asset from the loaded data on the render thread, textures are the ones a material holds references to
+		typedef std::function<void*(uint64_t& bytes, std::vector<Graphics::Texture*>& textures)> CreateFunction;
+
+		Graphics::Vulkan* _vulkan = nullptr;
+		uint64_t _frame = 0;
+		AssetLoader _loader;
+
+		std::unordered_map<std::string, Entry> _entries[RESOURCE_TYPE_COUNT];
+		std::unordered_map<const void*, std::string> _keys[RESOURCE_TYPE_COUNT];
+		ResourceStats _stats[RESOURCE_TYPE_COUNT];
+		uint32_t _releasedCount = 0;
+		// loads in flight by key
+		std::unordered_map<std::string, std::shared_ptr<LoadJob>> _pending[RESOURCE_TYPE_COUNT];
+
+	public:
+		// loaderThreadCount 0 takes one less than the cores
+		void Create(Graphics::Vulkan* vulkan, uint32_t loaderThreadCount = 0);
+		// destroys every asset still loaded, the device must be idle
+		void Destroy();
+
+		// meshIndex picks one mesh of files eulermodel --split wrote
+		Mesh* GetMesh(const char* filePath, VertexFormat format = VERTEX_FORMAT_FULL, uint32_t meshIndex = 0);
+		AnimatedMesh* GetAnimatedMesh(const char* filePath, VertexFormat format = VERTEX_FORMAT_FULL);
+		// srgb only applies to images, cooked textures know whether they're colors
+		Graphics::Texture* GetTexture(const char* filePath, VkDescriptorSetLayout descriptorSetLayout, bool srgb = true);
+		// normal and specular maps are loaded as linear
+		Graphics::Material* GetMaterial(const MaterialDesc& desc, VkDescriptorSetLayout textureLayout, VkDescriptorSetLayout propertiesLayout);
+
+		// a done handle holds a reference like Get, release what it returns. Canceling a handle that
+		// isn't done takes no reference, and the file isn't read if nobody else waits for it
+		LoadHandle<Mesh> GetMeshAsync(const char* filePath, VertexFormat format = VERTEX_FORMAT_FULL, uint32_t meshIndex = 0, LoadPriority priority = LOAD_PRIORITY_NORMAL);
+		LoadHandle<AnimatedMesh> GetAnimatedMeshAsync(const char* filePath, VertexFormat format = VERTEX_FORMAT_FULL, LoadPriority priority = LOAD_PRIORITY_NORMAL);
+		LoadHandle<Graphics::Texture> GetTextureAsync(const char* filePath, VkDescriptorSetLayout descriptorSetLayout, bool srgb = true, LoadPriority priority = LOAD_PRIORITY_NORMAL);
+		// done once all its textures are
+		LoadHandle<Graphics::Material> GetMaterialAsync(const MaterialDesc& desc, VkDescriptorSetLayout textureLayout, VkDescriptorSetLayout propertiesLayout, LoadPriority priority = LOAD_PRIORITY_NORMAL);
+
+		void Release(Mesh* mesh);
+		void Release(AnimatedMesh* mesh);
+		void Release(Graphics::Texture* texture);
+		void Release(Graphics::Material* material);
+
+		// creates the assets that finished loading and destroys the released ones no frame in flight can use anymore,
+		// call once a frame after Vulkan::BeginDrawFrame
+		void Update();
+
+		// FinishAll waits for every load, e.g. at the end of a level's setup
+		AssetLoader& GetLoader();
+
+		ResourceStats GetStats(ResourceType type);
+		void PrintStats();
+
+		// separators are unified so the same file found through different spellings is one asset
+		static std::string NormalizePath(const char* filePath);
+
+	private:
+		// the entry for the key, counts the request and a hit when it exists
+		Entry* Find(ResourceType type, const std::string& key);
+		Entry& Add(ResourceType type, const std::string& key, void* asset, uint64_t bytes);
+		void Release(ResourceType type, const void* asset);
+		void DestroyAsset(ResourceType type, Entry& entry);
+
+		Mesh* CreateMesh(ModelResource& modelResource, uint64_t& bytes);
+		AnimatedMesh* CreateAnimatedMesh(AnimatedModelResource& modelResource, uint64_t& bytes);
+		std::string GetMaterialKey(const MaterialDesc& desc, VkDescriptorSetLayout textureLayout, VkDescriptorSetLayout propertiesLayout);
+
+		// completes the load in flight for the key, so a synchronous Get finds the asset
+		void FinishPending(ResourceType type, const std::string& key);
+		// a done ticket for the cached asset or a ticket of the load in flight, nullptr when there is neither
+		std::shared_ptr<LoadTicket> FindAsync(ResourceType type, const std::string& key, std::shared_ptr<LoadJob>& job);
+		std::shared_ptr<LoadTicket> SubmitAsync(ResourceType type, const std::string& key, const std::shared_ptr<LoadJob>& job);
+		// adds the created asset with a reference for every ticket still waiting, returns nullptr when nothing was created
+		void* CompleteAsync(ResourceType type, const std::string& key, LoadJob& job, bool loaded, const CreateFunction& create);
 	};
-}
\ No newline at end of file
+}
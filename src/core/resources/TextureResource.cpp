@@ -1,11 +1,24 @@
 #include "TextureResource.h"
+#include "Ktx2.h"
 
 #include "stb_image.h"
 
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <string.h>
+
 using namespace Euler;
 
 void TextureResource::Load(const char* filePath, TextureChannels textureChannels)
 {
+	size_t length = strlen(filePath);
+	if (length > 5 && strcmp(filePath + length - 5, ".ktx2") == 0)
+	{
+		LoadLevels(filePath, UINT32_MAX);
+		return;
+	}
+
 	int width, height, channels;
 	_data = stbi_load(filePath, &width, &height, &channels, TextureChannelsToStbDesiredChannels(textureChannels));
 
@@ -14,14 +27,100 @@ void TextureResource::Load(const char* filePath, TextureChannels textureChannels
 	_width = width;
 	_height = height;
 	_channels = channels;
+
+	_format = TEXTURE_FORMAT_RGBA8;
+	_srgb = true;
+	_levelOffsets = { 0 };
+	_levelSizes = { (uint64_t)width * height * TextureChannelsToStbDesiredChannels(textureChannels) };
+}
+
+void TextureResource::LoadLevels(const char* filePath, uint32_t maxSize)
+{
+	Unload();
+
+	// only the header, the level index and the wanted levels are read
+	std::ifstream file(filePath, std::ios::binary);
+
+	Ktx2Header header;
+	if (!file.read((char*)&header, sizeof(header)))
+	{
+		std::cout << "TextureResource: can't read " << filePath << std::endl;
+		Unload();
+		return;
+	}
+
+	std::vector<Ktx2Level> levels;
+	if (memcmp(header.Identifier, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) != 0 ||
+		!GetTextureFormat((VkFormat)header.VkFormat, &_format, &_srgb) ||
+		header.SupercompressionScheme != 0 || header.LevelCount == 0)
+	{
+		std::cout << "TextureResource: " << filePath << " isn't a texture cooked by eulertexture" << std::endl;
+		Unload();
+		return;
+	}
+
+	levels.resize(header.LevelCount);
+	if (!file.read((char*)levels.data(), levels.size() * sizeof(Ktx2Level)))
+	{
+		std::cout << "TextureResource: " << filePath << " is truncated" << std::endl;
+		Unload();
+		return;
+	}
+
+	_width = header.PixelWidth;
+	_height = header.PixelHeight;
+	_channels = _format == TEXTURE_FORMAT_BC5 ? 2 : 4;
+
+	// the last level is always loaded
+	_firstLevel = header.LevelCount - 1;
+	while (_firstLevel > 0 && std::max(_width >> (_firstLevel - 1), _height >> (_firstLevel - 1)) <= maxSize)
+	{
+		_firstLevel--;
+	}
+
+	uint64_t size = 0;
+	for (uint32_t i = _firstLevel; i < header.LevelCount; i++)
+	{
+		size += levels[i].ByteLength;
+	}
+	_fileData.resize(size);
+
+	uint64_t offset = 0;
+	for (uint32_t i = 0; i < header.LevelCount; i++)
+	{
+		if (i < _firstLevel)
+		{
+			_levelOffsets.push_back(0);
+			_levelSizes.push_back(0);
+			continue;
+		}
+
+		if (!file.seekg(levels[i].ByteOffset) || !file.read(_fileData.data() + offset, levels[i].ByteLength))
+		{
+			std::cout << "TextureResource: " << filePath << " is truncated" << std::endl;
+			Unload();
+			return;
+		}
+
+		_levelOffsets.push_back(offset);
+		_levelSizes.push_back(levels[i].ByteLength);
+		offset += levels[i].ByteLength;
+	}
 }
 
 void TextureResource::Unload()
 {
 	stbi_image_free(_data);
+	_data = nullptr;
 	_width = 0;
 	_height = 0;
 	_channels = 0;
+
+	_fileData.clear();
+	_fileData.shrink_to_fit();
+	_levelOffsets.clear();
+	_levelSizes.clear();
+	_firstLevel = 0;
 }
 
 uint32_t TextureResource::GetWidth()
@@ -41,7 +140,47 @@ uint32_t TextureResource::GetChannels()
 
 unsigned char* TextureResource::GetData()
 {
-	return _data;
+	return GetLevelData(0);
+}
+
+TextureFormat TextureResource::GetFormat()
+{
+	return _format;
+}
+
+bool TextureResource::IsSrgb()
+{
+	return _srgb;
+}
+
+uint32_t TextureResource::GetLevelCount()
+{
+	return _levelSizes.size();
+}
+
+uint32_t TextureResource::GetFirstLevel()
+{
+	return _firstLevel;
+}
+
+unsigned char* TextureResource::GetLevelData(uint32_t level)
+{
+	if (level >= _levelOffsets.size())
+	{
+		return _data;
+	}
+
+	if (level < _firstLevel)
+	{
+		return nullptr;
+	}
+
+	return (_fileData.empty() ? _data : (unsigned char*)_fileData.data()) + _levelOffsets[level];
+}
+
+uint64_t TextureResource::GetLevelSize(uint32_t level)
+{
+	return _levelSizes[level];
 }
 
 int TextureResource::TextureChannelsToStbDesiredChannels(TextureChannels textureChannels)
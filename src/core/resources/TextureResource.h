@@ -3,6 +3,7 @@
 #include "../API.h"
 
 #include <stdint.h>
+#include <vector>
 
 namespace Euler
 {
@@ -14,6 +15,16 @@ namespace Euler
 		TEXTURE_CHANNELS_RGBA
 	};
 
+	// images are RGBA8, cooked textures can also be 4x4 blocks
+	enum TextureFormat
+	{
+		TEXTURE_FORMAT_RGBA8,
+		TEXTURE_FORMAT_BC1,
+		TEXTURE_FORMAT_BC3,
+		TEXTURE_FORMAT_BC5,
+		TEXTURE_FORMAT_BC7
+	};
+
 	class EULER_API TextureResource
 	{
 	private:
@@ -22,15 +33,36 @@ namespace Euler
 		uint32_t _channels = 0;
 		unsigned char* _data = nullptr;
 
+		// cooked .ktx2 textures keep the loaded levels of the file, the levels point into it
+		TextureFormat _format = TEXTURE_FORMAT_RGBA8;
+		bool _srgb = true;
+		std::vector<char> _fileData;
+		std::vector<uint64_t> _levelOffsets;
+		std::vector<uint64_t> _levelSizes;
+		uint32_t _firstLevel = 0;
+
 	public:
+		// .ktx2 files written by eulertexture are loaded as they are, textureChannels only applies to images
 		void Load(const char* filePath, TextureChannels textureChannels);
+		// loads the levels of a .ktx2 file that are at most maxSize on their larger side, and at least the last one,
+		// the finer levels aren't read and have no data
+		void LoadLevels(const char* filePath, uint32_t maxSize);
 		void Unload();
 
 		uint32_t GetWidth();
 		uint32_t GetHeight();
 		uint32_t GetChannels();
+		// the first level
 		unsigned char* GetData();
 
+		TextureFormat GetFormat();
+		bool IsSrgb();
+		uint32_t GetLevelCount();
+		// the finest loaded level
+		uint32_t GetFirstLevel();
+		unsigned char* GetLevelData(uint32_t level);
+		uint64_t GetLevelSize(uint32_t level);
+
 	private:
 		int TextureChannelsToStbDesiredChannels(TextureChannels textureChannels);
 	};
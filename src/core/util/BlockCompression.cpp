@@ -0,0 +1,602 @@
+#include "BlockCompression.h"
+
+#include <string.h>
+#include <math.h>
+#include <stdlib.h>
+
+using namespace Euler;
+
+namespace
+{
+	// BC7 weights for 4-bit indices, out of 64
+	const uint32_t BC7_WEIGHTS[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	void WriteBits(uint8_t* block, uint32_t* position, uint32_t value, uint32_t count)
+	{
+		for (uint32_t i = 0; i < count; i++, (*position)++)
+		{
+			if ((value >> i) & 1)
+			{
+				block[*position / 8] |= 1 << (*position % 8);
+			}
+		}
+	}
+
+	uint32_t ReadBits(const uint8_t* block, uint32_t* position, uint32_t count)
+	{
+		uint32_t value = 0;
+		for (uint32_t i = 0; i < count; i++, (*position)++)
+		{
+			value |= ((block[*position / 8] >> (*position % 8)) & 1) << i;
+		}
+		return value;
+	}
+
+	// the block's texels, clamped to the image
+	void GetTexels(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t blockX, uint32_t blockY, uint8_t texels[16][4])
+	{
+		for (uint32_t y = 0; y < 4; y++)
+		{
+			uint32_t row = blockY * 4 + y < height ? blockY * 4 + y : height - 1;
+			for (uint32_t x = 0; x < 4; x++)
+			{
+				uint32_t column = blockX * 4 + x < width ? blockX * 4 + x : width - 1;
+				memcpy(texels[y * 4 + x], pixels + (row * width + column) * 4, 4);
+			}
+		}
+	}
+
+	void SetTexels(uint8_t* pixels, uint32_t width, uint32_t height, uint32_t blockX, uint32_t blockY, const uint8_t texels[16][4])
+	{
+		for (uint32_t y = 0; y < 4 && blockY * 4 + y < height; y++)
+		{
+			for (uint32_t x = 0; x < 4 && blockX * 4 + x < width; x++)
+			{
+				memcpy(pixels + ((blockY * 4 + y) * width + blockX * 4 + x) * 4, texels[y * 4 + x], 4);
+			}
+		}
+	}
+
+	// extremes of the texels' first channelCount channels along their principal axis, found with power iteration
+	void FindEndpoints(const uint8_t texels[16][4], uint32_t channelCount, float* low, float* high)
+	{
+		float mean[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		for (uint32_t i = 0; i < 16; i++)
+		{
+			for (uint32_t c = 0; c < channelCount; c++)
+			{
+				mean[c] += texels[i][c] / 16.0f;
+			}
+		}
+
+		float covariance[4][4] = {};
+		for (uint32_t i = 0; i < 16; i++)
+		{
+			for (uint32_t a = 0; a < channelCount; a++)
+			{
+				for (uint32_t b = 0; b < channelCount; b++)
+				{
+					covariance[a][b] += (texels[i][a] - mean[a]) * (texels[i][b] - mean[b]);
+				}
+			}
+		}
+
+		// starting from the covariance of the widest channel, the bounding box diagonal can't follow channels
+		// going in opposite directions
+		uint32_t widest = 0;
+		for (uint32_t c = 1; c < channelCount; c++)
+		{
+			widest = covariance[c][c] > covariance[widest][widest] ? c : widest;
+		}
+
+		float axis[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		for (uint32_t c = 0; c < channelCount; c++)
+		{
+			axis[c] = covariance[c][widest];
+		}
+
+		for (uint32_t iteration = 0; iteration < 8; iteration++)
+		{
+			float next[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+			float length = 0.0f;
+			for (uint32_t a = 0; a < channelCount; a++)
+			{
+				for (uint32_t b = 0; b < channelCount; b++)
+				{
+					next[a] += covariance[a][b] * axis[b];
+				}
+				length += next[a] * next[a];
+			}
+
+			if (length == 0.0f)
+			{
+				break;
+			}
+
+			length = sqrtf(length);
+			for (uint32_t c = 0; c < channelCount; c++)
+			{
+				axis[c] = next[c] / length;
+			}
+		}
+
+		float minimumT = 0.0f;
+		float maximumT = 0.0f;
+		for (uint32_t i = 0; i < 16; i++)
+		{
+			float t = 0.0f;
+			for (uint32_t c = 0; c < channelCount; c++)
+			{
+				t += (texels[i][c] - mean[c]) * axis[c];
+			}
+			minimumT = fminf(minimumT, t);
+			maximumT = fmaxf(maximumT, t);
+		}
+
+		float axisLength = 0.0f;
+		for (uint32_t c = 0; c < channelCount; c++)
+		{
+			axisLength += axis[c] * axis[c];
+		}
+		axisLength = axisLength > 0.0f ? axisLength : 1.0f;
+
+		for (uint32_t c = 0; c < channelCount; c++)
+		{
+			low[c] = fminf(fmaxf(mean[c] + minimumT / axisLength * axis[c], 0.0f), 255.0f);
+			high[c] = fminf(fmaxf(mean[c] + maximumT / axisLength * axis[c], 0.0f), 255.0f);
+		}
+	}
+
+	uint32_t GetNearest(const uint8_t* texel, const uint8_t palette[][4], uint32_t paletteSize, uint32_t channelCount)
+	{
+		uint32_t nearest = 0;
+		uint32_t nearestDistance = 0xFFFFFFFF;
+		for (uint32_t i = 0; i < paletteSize; i++)
+		{
+			uint32_t distance = 0;
+			for (uint32_t c = 0; c < channelCount; c++)
+			{
+				int32_t difference = (int32_t)texel[c] - palette[i][c];
+				distance += difference * difference;
+			}
+
+			if (distance < nearestDistance)
+			{
+				nearest = i;
+				nearestDistance = distance;
+			}
+		}
+		return nearest;
+	}
+
+	/* === BC1 === */
+
+	uint16_t PackRgb565(const float* color)
+	{
+		uint32_t r = (uint32_t)(color[0] * 31.0f / 255.0f + 0.5f);
+		uint32_t g = (uint32_t)(color[1] * 63.0f / 255.0f + 0.5f);
+		uint32_t b = (uint32_t)(color[2] * 31.0f / 255.0f + 0.5f);
+		return (uint16_t)((r << 11) | (g << 5) | b);
+	}
+
+	void UnpackRgb565(uint16_t color, uint8_t* result)
+	{
+		uint32_t r = (color >> 11) & 31;
+		uint32_t g = (color >> 5) & 63;
+		uint32_t b = color & 31;
+		result[0] = (uint8_t)((r << 3) | (r >> 2));
+		result[1] = (uint8_t)((g << 2) | (g >> 4));
+		result[2] = (uint8_t)((b << 3) | (b >> 2));
+		result[3] = 255;
+	}
+
+	// fourColors is always true in BC3, where the color block has no transparent mode
+	void GetBC1Palette(uint16_t color0, uint16_t color1, bool fourColors, uint8_t palette[4][4])
+	{
+		UnpackRgb565(color0, palette[0]);
+		UnpackRgb565(color1, palette[1]);
+		for (uint32_t c = 0; c < 3; c++)
+		{
+			if (fourColors || color0 > color1)
+			{
+				palette[2][c] = (uint8_t)((2 * palette[0][c] + palette[1][c]) / 3);
+				palette[3][c] = (uint8_t)((palette[0][c] + 2 * palette[1][c]) / 3);
+			}
+			else
+			{
+				palette[2][c] = (uint8_t)((palette[0][c] + palette[1][c]) / 2);
+				palette[3][c] = 0;
+			}
+		}
+		palette[2][3] = 255;
+		palette[3][3] = fourColors || color0 > color1 ? 255 : 0;
+	}
+
+	void EncodeBC1(const uint8_t texels[16][4], uint8_t* block)
+	{
+		float low[4], high[4];
+		FindEndpoints(texels, 3, low, high);
+
+		uint16_t color0 = PackRgb565(high);
+		uint16_t color1 = PackRgb565(low);
+		if (color0 < color1)
+		{
+			uint16_t swap = color0;
+			color0 = color1;
+			color1 = swap;
+		}
+
+		uint8_t palette[4][4];
+		GetBC1Palette(color0, color1, true, palette);
+
+		// equal endpoints are the three color mode, where index 0 is still color0
+		uint32_t indices = 0;
+		for (uint32_t i = 0; i < 16 && color0 != color1; i++)
+		{
+			indices |= GetNearest(texels[i], palette, 4, 3) << (i * 2);
+		}
+
+		memcpy(block, &color0, 2);
+		memcpy(block + 2, &color1, 2);
+		memcpy(block + 4, &indices, 4);
+	}
+
+	void DecodeBC1(const uint8_t* block, bool fourColors, uint8_t texels[16][4])
+	{
+		uint16_t color0, color1;
+		uint32_t indices;
+		memcpy(&color0, block, 2);
+		memcpy(&color1, block + 2, 2);
+		memcpy(&indices, block + 4, 4);
+
+		uint8_t palette[4][4];
+		GetBC1Palette(color0, color1, fourColors, palette);
+
+		for (uint32_t i = 0; i < 16; i++)
+		{
+			memcpy(texels[i], palette[(indices >> (i * 2)) & 3], 4);
+		}
+	}
+
+	/* === BC4 === */
+
+	void GetBC4Palette(uint8_t value0, uint8_t value1, uint8_t palette[8])
+	{
+		palette[0] = value0;
+		palette[1] = value1;
+		if (value0 > value1)
+		{
+			for (uint32_t i = 1; i < 7; i++)
+			{
+				palette[i + 1] = (uint8_t)(((7 - i) * value0 + i * value1) / 7);
+			}
+		}
+		else
+		{
+			for (uint32_t i = 1; i < 5; i++)
+			{
+				palette[i + 1] = (uint8_t)(((5 - i) * value0 + i * value1) / 5);
+			}
+			palette[6] = 0;
+			palette[7] = 255;
+		}
+	}
+
+	// one channel of the texels
+	void EncodeBC4(const uint8_t texels[16][4], uint32_t channel, uint8_t* block)
+	{
+		uint8_t minimum = 255;
+		uint8_t maximum = 0;
+		for (uint32_t i = 0; i < 16; i++)
+		{
+			minimum = texels[i][channel] < minimum ? texels[i][channel] : minimum;
+			maximum = texels[i][channel] > maximum ? texels[i][channel] : maximum;
+		}
+
+		uint8_t palette[8];
+		GetBC4Palette(maximum, minimum, palette);
+
+		uint64_t indices = 0;
+		for (uint32_t i = 0; i < 16 && maximum != minimum; i++)
+		{
+			uint64_t nearest = 0;
+			for (uint32_t p = 1; p < 8; p++)
+			{
+				if (abs(texels[i][channel] - palette[p]) < abs(texels[i][channel] - palette[nearest]))
+				{
+					nearest = p;
+				}
+			}
+			indices |= nearest << (i * 3);
+		}
+
+		block[0] = maximum;
+		block[1] = minimum;
+		for (uint32_t i = 0; i < 6; i++)
+		{
+			block[2 + i] = (uint8_t)(indices >> (i * 8));
+		}
+	}
+
+	void DecodeBC4(const uint8_t* block, uint32_t channel, uint8_t texels[16][4])
+	{
+		uint8_t palette[8];
+		GetBC4Palette(block[0], block[1], palette);
+
+		uint64_t indices = 0;
+		for (uint32_t i = 0; i < 6; i++)
+		{
+			indices |= (uint64_t)block[2 + i] << (i * 8);
+		}
+
+		for (uint32_t i = 0; i < 16; i++)
+		{
+			texels[i][channel] = palette[(indices >> (i * 3)) & 7];
+		}
+	}
+
+	/* === BC7 === */
+
+	void GetBC7Palette(const uint8_t endpoints[2][4], uint8_t palette[16][4])
+	{
+		for (uint32_t i = 0; i < 16; i++)
+		{
+			for (uint32_t c = 0; c < 4; c++)
+			{
+				palette[i][c] = (uint8_t)(((64 - BC7_WEIGHTS[i]) * endpoints[0][c] + BC7_WEIGHTS[i] * endpoints[1][c] + 32) >> 6);
+			}
+		}
+	}
+
+	// mode 6: 7 bit RGBA endpoints with a shared lowest bit per endpoint (the p-bit)
+	void EncodeBC7(const uint8_t texels[16][4], uint8_t* block)
+	{
+		float extremes[2][4];
+		FindEndpoints(texels, 4, extremes[0], extremes[1]);
+
+		uint32_t quantized[2][4];
+		uint32_t pBits[2];
+		for (uint32_t e = 0; e < 2; e++)
+		{
+			// the p-bit that lands closer to the extreme
+			float bestError = 0.0f;
+			for (uint32_t p = 0; p < 2; p++)
+			{
+				uint32_t candidate[4];
+				float error = 0.0f;
+				for (uint32_t c = 0; c < 4; c++)
+				{
+					float value = (extremes[e][c] - p) / 2.0f + 0.5f;
+					candidate[c] = value < 0.0f ? 0 : (value > 127.0f ? 127 : (uint32_t)value);
+					float difference = (float)(candidate[c] * 2 + p) - extremes[e][c];
+					error += difference * difference;
+				}
+
+				if (p == 0 || error < bestError)
+				{
+					bestError = error;
+					pBits[e] = p;
+					memcpy(quantized[e], candidate, sizeof(candidate));
+				}
+			}
+		}
+
+		uint8_t endpoints[2][4];
+		for (uint32_t e = 0; e < 2; e++)
+		{
+			for (uint32_t c = 0; c < 4; c++)
+			{
+				endpoints[e][c] = (uint8_t)(quantized[e][c] * 2 + pBits[e]);
+			}
+		}
+
+		uint8_t palette[16][4];
+		GetBC7Palette(endpoints, palette);
+
+		uint32_t indices[16];
+		for (uint32_t i = 0; i < 16; i++)
+		{
+			indices[i] = GetNearest(texels[i], palette, 16, 4);
+		}
+
+		// the first index is stored without its top bit, so it has to be clear
+		if (indices[0] & 8)
+		{
+			for (uint32_t c = 0; c < 4; c++)
+			{
+				uint32_t swap = quantized[0][c];
+				quantized[0][c] = quantized[1][c];
+				quantized[1][c] = swap;
+			}
+
+			uint32_t swap = pBits[0];
+			pBits[0] = pBits[1];
+			pBits[1] = swap;
+
+			for (uint32_t i = 0; i < 16; i++)
+			{
+				indices[i] = 15 - indices[i];
+			}
+		}
+
+		memset(block, 0, 16);
+		uint32_t position = 0;
+		WriteBits(block, &position, 1 << 6, 7);
+		for (uint32_t c = 0; c < 4; c++)
+		{
+			WriteBits(block, &position, quantized[0][c], 7);
+			WriteBits(block, &position, quantized[1][c], 7);
+		}
+		WriteBits(block, &position, pBits[0], 1);
+		WriteBits(block, &position, pBits[1], 1);
+		WriteBits(block, &position, indices[0], 3);
+		for (uint32_t i = 1; i < 16; i++)
+		{
+			WriteBits(block, &position, indices[i], 4);
+		}
+	}
+
+	void DecodeBC7(const uint8_t* block, uint8_t texels[16][4])
+	{
+		// the mode is the position of the first set bit
+		if ((block[0] & 0x7F) != 1 << 6)
+		{
+			memset(texels, 0, 16 * 4);
+			return;
+		}
+
+		uint32_t position = 7;
+		uint32_t quantized[2][4];
+		for (uint32_t c = 0; c < 4; c++)
+		{
+			quantized[0][c] = ReadBits(block, &position, 7);
+			quantized[1][c] = ReadBits(block, &position, 7);
+		}
+		uint32_t pBits[2];
+		pBits[0] = ReadBits(block, &position, 1);
+		pBits[1] = ReadBits(block, &position, 1);
+
+		uint8_t endpoints[2][4];
+		for (uint32_t e = 0; e < 2; e++)
+		{
+			for (uint32_t c = 0; c < 4; c++)
+			{
+				endpoints[e][c] = (uint8_t)(quantized[e][c] * 2 + pBits[e]);
+			}
+		}
+
+		uint8_t palette[16][4];
+		GetBC7Palette(endpoints, palette);
+
+		for (uint32_t i = 0; i < 16; i++)
+		{
+			memcpy(texels[i], palette[ReadBits(block, &position, i == 0 ? 3 : 4)], 4);
+		}
+	}
+}
+
+uint32_t Euler::GetBlockSize(TextureFormat format)
+{
+	switch (format)
+	{
+	case TEXTURE_FORMAT_BC1:
+		return 8;
+
+	case TEXTURE_FORMAT_BC3:
+	case TEXTURE_FORMAT_BC5:
+	case TEXTURE_FORMAT_BC7:
+		return 16;
+
+	default:
+	case TEXTURE_FORMAT_RGBA8:
+		return 4;
+	}
+}
+
+uint64_t Euler::GetLevelSize(TextureFormat format, uint32_t width, uint32_t height)
+{
+	if (format == TEXTURE_FORMAT_RGBA8)
+	{
+		return (uint64_t)width * height * 4;
+	}
+
+	return (uint64_t)((width + 3) / 4) * ((height + 3) / 4) * GetBlockSize(format);
+}
+
+void Euler::CompressBlocks(const uint8_t* pixels, uint32_t width, uint32_t height, TextureFormat format, std::vector<uint8_t>& blocks)
+{
+	if (format == TEXTURE_FORMAT_RGBA8)
+	{
+		blocks.assign(pixels, pixels + (size_t)width * height * 4);
+		return;
+	}
+
+	uint32_t blocksX = (width + 3) / 4;
+	uint32_t blocksY = (height + 3) / 4;
+	uint32_t blockSize = GetBlockSize(format);
+	blocks.resize((size_t)blocksX * blocksY * blockSize);
+
+	uint8_t texels[16][4];
+	for (uint32_t y = 0; y < blocksY; y++)
+	{
+		for (uint32_t x = 0; x < blocksX; x++)
+		{
+			GetTexels(pixels, width, height, x, y, texels);
+			uint8_t* block = blocks.data() + ((size_t)y * blocksX + x) * blockSize;
+
+			switch (format)
+			{
+			case TEXTURE_FORMAT_BC1:
+				EncodeBC1(texels, block);
+				break;
+
+			case TEXTURE_FORMAT_BC3:
+				EncodeBC4(texels, 3, block);
+				EncodeBC1(texels, block + 8);
+				break;
+
+			case TEXTURE_FORMAT_BC5:
+				EncodeBC4(texels, 0, block);
+				EncodeBC4(texels, 1, block + 8);
+				break;
+
+			default:
+			case TEXTURE_FORMAT_BC7:
+				EncodeBC7(texels, block);
+				break;
+			}
+		}
+	}
+}
+
+void Euler::DecompressBlocks(const uint8_t* blocks, uint32_t width, uint32_t height, TextureFormat format, std::vector<uint8_t>& pixels)
+{
+	if (format == TEXTURE_FORMAT_RGBA8)
+	{
+		pixels.assign(blocks, blocks + (size_t)width * height * 4);
+		return;
+	}
+
+	uint32_t blocksX = (width + 3) / 4;
+	uint32_t blocksY = (height + 3) / 4;
+	uint32_t blockSize = GetBlockSize(format);
+	pixels.resize((size_t)width * height * 4);
+
+	uint8_t texels[16][4];
+	for (uint32_t y = 0; y < blocksY; y++)
+	{
+		for (uint32_t x = 0; x < blocksX; x++)
+		{
+			const uint8_t* block = blocks + ((size_t)y * blocksX + x) * blockSize;
+
+			switch (format)
+			{
+			case TEXTURE_FORMAT_BC1:
+				DecodeBC1(block, false, texels);
+				break;
+
+			case TEXTURE_FORMAT_BC3:
+				DecodeBC1(block + 8, true, texels);
+				DecodeBC4(block, 3, texels);
+				break;
+
+			case TEXTURE_FORMAT_BC5:
+				DecodeBC4(block, 0, texels);
+				DecodeBC4(block + 8, 1, texels);
+				for (uint32_t i = 0; i < 16; i++)
+				{
+					texels[i][2] = 0;
+					texels[i][3] = 255;
+				}
+				break;
+
+			default:
+			case TEXTURE_FORMAT_BC7:
+				DecodeBC7(block, texels);
+				break;
+			}
+
+			SetTexels(pixels.data(), width, height, x, y, texels);
+		}
+	}
+}
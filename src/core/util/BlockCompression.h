@@ -0,0 +1,24 @@
+#pragma once
+
+#include "../API.h"
+#include "../resources/TextureResource.h"
+
+#include <stdint.h>
+#include <vector>
+
+namespace Euler
+{
+	// bytes per 4x4 block, or per pixel for TEXTURE_FORMAT_RGBA8
+	EULER_API uint32_t GetBlockSize(TextureFormat format);
+	// bytes of a width x height level, partial blocks at the edges are whole blocks
+	EULER_API uint64_t GetLevelSize(TextureFormat format, uint32_t width, uint32_t height);
+
+	// Encodes RGBA8 pixels to 4x4 blocks, edge blocks repeat the last row and column. BC1 drops alpha, BC3 keeps it in
+	// a BC4 block, BC5 keeps red and green in two BC4 blocks and BC7 only writes mode 6 (one subset, RGBA endpoints with
+	// a p-bit and 4-bit indices). Endpoints are the extremes along the block's principal axis
+	EULER_API void CompressBlocks(const uint8_t* pixels, uint32_t width, uint32_t height, TextureFormat format, std::vector<uint8_t>& blocks);
+
+	// Back to RGBA8, for devices that can't sample the blocks. BC5 decodes to red and green with blue 0 and alpha 255.
+	// BC7 only decodes mode 6, other modes come out black
+	EULER_API void DecompressBlocks(const uint8_t* blocks, uint32_t width, uint32_t height, TextureFormat format, std::vector<uint8_t>& pixels);
+}
@@ -0,0 +1,408 @@
+#include "MeshOptimizer.h"
+
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+
+using namespace Euler;
+
+namespace
+{
+	// FIFO cache over timestamps: a vertex is in the cache while fewer than cacheSize misses happened since its own
+	class VertexCache
+	{
+	private:
+		std::vector<uint32_t> _timestamps;
+		uint32_t _time;
+		uint32_t _cacheSize;
+
+	public:
+		VertexCache(uint32_t vertexCount, uint32_t cacheSize)
+		{
+			_timestamps.assign(vertexCount, 0);
+			_cacheSize = cacheSize;
+			_time = cacheSize + 1;
+		}
+
+		bool Contains(uint32_t vertex) const
+		{
+			return _time - _timestamps[vertex] <= _cacheSize;
+		}
+
+		uint32_t GetAge(uint32_t vertex) const
+		{
+			return _time - _timestamps[vertex];
+		}
+
+		// returns true on a miss
+		bool Use(uint32_t vertex)
+		{
+			if (Contains(vertex))
+			{
+				return false;
+			}
+
+			_timestamps[vertex] = _time++;
+			return true;
+		}
+
+		void Clear()
+		{
+			_time += _cacheSize + 1;
+		}
+	};
+
+	// clusters receives the first triangle of every run that started at a dead end
+	void Tipsify(const uint32_t* indices, uint32_t indexCount, uint32_t vertexCount, uint32_t cacheSize, std::vector<uint32_t>& result, std::vector<uint32_t>* clusters)
+	{
+		uint32_t triangleCount = indexCount / 3;
+
+		// triangles of every vertex
+		std::vector<uint32_t> offsets(vertexCount + 1, 0);
+		for (uint32_t i = 0; i < triangleCount * 3; i++)
+		{
+			offsets[indices[i] + 1]++;
+		}
+		for (uint32_t v = 0; v < vertexCount; v++)
+		{
+			offsets[v + 1] += offsets[v];
+		}
+
+		std::vector<uint32_t> adjacency(triangleCount * 3);
+		std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+		for (uint32_t i = 0; i < triangleCount * 3; i++)
+		{
+			adjacency[fill[indices[i]]++] = i / 3;
+		}
+
+		// triangles not emitted yet
+		std::vector<uint32_t> live(vertexCount);
+		for (uint32_t v = 0; v < vertexCount; v++)
+		{
+			live[v] = offsets[v + 1] - offsets[v];
+		}
+
+		std::vector<uint8_t> emitted(triangleCount, 0);
+		std::vector<uint32_t> deadEnd;
+		std::vector<uint32_t> candidates;
+		VertexCache cache(vertexCount, cacheSize);
+		uint32_t cursor = 0;
+
+		// the most recent vertex that still has triangles, otherwise the next one in input order
+		auto skipDeadEnd = [&]() -> uint32_t {
+			while (!deadEnd.empty())
+			{
+				uint32_t vertex = deadEnd.back();
+				deadEnd.pop_back();
+				if (live[vertex] > 0)
+				{
+					return vertex;
+				}
+			}
+
+			while (cursor < vertexCount)
+			{
+				if (live[cursor] > 0)
+				{
+					return cursor;
+				}
+				cursor++;
+			}
+
+			return UINT32_MAX;
+		};
+
+		result.clear();
+		result.reserve(triangleCount * 3);
+		if (clusters != nullptr)
+		{
+			clusters->assign(1, 0);
+		}
+
+		uint32_t fanning = skipDeadEnd();
+		while (fanning != UINT32_MAX)
+		{
+			candidates.clear();
+
+			for (uint32_t k = offsets[fanning]; k < offsets[fanning + 1]; k++)
+			{
+				uint32_t triangle = adjacency[k];
+				if (emitted[triangle])
+				{
+					continue;
+				}
+
+				for (uint32_t c = 0; c < 3; c++)
+				{
+					uint32_t vertex = indices[triangle * 3 + c];
+					result.push_back(vertex);
+					deadEnd.push_back(vertex);
+					candidates.push_back(vertex);
+					live[vertex]--;
+					cache.Use(vertex);
+				}
+				emitted[triangle] = 1;
+			}
+
+			// the candidate that stays in the cache the longest once its remaining triangles are emitted
+			uint32_t next = UINT32_MAX;
+			int64_t bestPriority = -1;
+			for (uint32_t vertex : candidates)
+			{
+				if (live[vertex] == 0)
+				{
+					continue;
+				}
+
+				int64_t priority = 0;
+				if (cache.GetAge(vertex) + 2 * live[vertex] <= cacheSize)
+				{
+					priority = cache.GetAge(vertex);
+				}
+
+				if (priority > bestPriority)
+				{
+					bestPriority = priority;
+					next = vertex;
+				}
+			}
+
+			if (next == UINT32_MAX)
+			{
+				next = skipDeadEnd();
+				if (clusters != nullptr && next != UINT32_MAX && result.size() / 3 > clusters->back())
+				{
+					clusters->push_back(result.size() / 3);
+				}
+			}
+
+			fanning = next;
+		}
+	}
+
+	uint32_t CountMisses(const uint32_t* triangle, VertexCache& cache)
+	{
+		uint32_t misses = 0;
+		for (uint32_t c = 0; c < 3; c++)
+		{
+			misses += cache.Use(triangle[c]) ? 1 : 0;
+		}
+		return misses;
+	}
+}
+
+VertexCacheStats Euler::AnalyzeVertexCache(const uint32_t* indices, uint32_t indexCount, uint32_t vertexCount, uint32_t cacheSize)
+{
+	VertexCacheStats stats{};
+
+	uint32_t triangleCount = indexCount / 3;
+	if (triangleCount == 0)
+	{
+		return stats;
+	}
+
+	VertexCache cache(vertexCount, cacheSize);
+	std::vector<uint8_t> used(vertexCount, 0);
+	uint32_t usedCount = 0;
+	uint32_t misses = 0;
+
+	for (uint32_t t = 0; t < triangleCount; t++)
+	{
+		misses += CountMisses(&indices[t * 3], cache);
+
+		for (uint32_t c = 0; c < 3; c++)
+		{
+			usedCount += used[indices[t * 3 + c]] ? 0 : 1;
+			used[indices[t * 3 + c]] = 1;
+		}
+	}
+
+	stats.Acmr = (float)misses / triangleCount;
+	stats.Atvr = (float)misses / usedCount;
+	return stats;
+}
+
+void Euler::OptimizeVertexCache(const uint32_t* indices, uint32_t indexCount, uint32_t vertexCount, std::vector<uint32_t>& result, uint32_t cacheSize)
+{
+	Tipsify(indices, indexCount, vertexCount, cacheSize, result, nullptr);
+}
+
+void Euler::OptimizeOverdraw(const Vec3* positions, uint32_t stride, const uint32_t* indices, uint32_t indexCount, uint32_t vertexCount, float threshold, std::vector<uint32_t>& result, uint32_t cacheSize)
+{
+	std::vector<uint32_t> ordered;
+	std::vector<uint32_t> hardClusters;
+	Tipsify(indices, indexCount, vertexCount, cacheSize, ordered, &hardClusters);
+
+	uint32_t triangleCount = ordered.size() / 3;
+	hardClusters.push_back(triangleCount);
+
+	/* === SOFT BOUNDARIES === */
+
+	// a cluster ends wherever starting over with a cold cache cost no more than threshold times the hard cluster's misses
+	std::vector<uint32_t> clusters;
+	VertexCache cache(vertexCount, cacheSize);
+
+	for (uint32_t i = 0; i + 1 < hardClusters.size(); i++)
+	{
+		uint32_t start = hardClusters[i];
+		uint32_t end = hardClusters[i + 1];
+
+		cache.Clear();
+		uint32_t clusterMisses = 0;
+		for (uint32_t t = start; t < end; t++)
+		{
+			clusterMisses += CountMisses(&ordered[t * 3], cache);
+		}
+		float limit = threshold * clusterMisses / (end - start);
+
+		clusters.push_back(start);
+		cache.Clear();
+		uint32_t misses = 0;
+		for (uint32_t t = start; t + 1 < end; t++)
+		{
+			misses += CountMisses(&ordered[t * 3], cache);
+			if (misses <= limit * (t + 1 - clusters.back()))
+			{
+				clusters.push_back(t + 1);
+				cache.Clear();
+				misses = 0;
+			}
+		}
+	}
+	clusters.push_back(triangleCount);
+
+	/* === SORT CLUSTERS === */
+
+	uint32_t clusterCount = clusters.size() - 1;
+	std::vector<Vec3> centroids(clusterCount, Vec3(0, 0, 0));
+	std::vector<Vec3> normals(clusterCount, Vec3(0, 0, 0));
+	std::vector<float> areas(clusterCount, 0.0f);
+	Vec3 meshCentroid(0, 0, 0);
+	float meshArea = 0.0f;
+
+	const uint8_t* positionData = (const uint8_t*)positions;
+	for (uint32_t c = 0; c < clusterCount; c++)
+	{
+		for (uint32_t t = clusters[c]; t < clusters[c + 1]; t++)
+		{
+			const Vec3& p0 = *(const Vec3*)(positionData + (size_t)ordered[t * 3 + 0] * stride);
+			const Vec3& p1 = *(const Vec3*)(positionData + (size_t)ordered[t * 3 + 1] * stride);
+			const Vec3& p2 = *(const Vec3*)(positionData + (size_t)ordered[t * 3 + 2] * stride);
+
+			// twice the area in length, so the sum is the area weighted normal
+			Vec3 normal = (p1 - p0).Cross(p2 - p0);
+			float area = normal.Length();
+			Vec3 center = (area / 3.0f) * (p0 + p1 + p2);
+
+			normals[c] = normals[c] + normal;
+			centroids[c] = centroids[c] + center;
+			areas[c] += area;
+		}
+
+		meshCentroid = meshCentroid + centroids[c];
+		meshArea += areas[c];
+	}
+
+	if (meshArea > 0.0f)
+	{
+		meshCentroid = (1.0f / meshArea) * meshCentroid;
+	}
+
+	// how far out the cluster is along its own normal
+	std::vector<float> keys(clusterCount, 0.0f);
+	for (uint32_t c = 0; c < clusterCount; c++)
+	{
+		float normalLength = normals[c].Length();
+		if (areas[c] > 0.0f && normalLength > 0.0f)
+		{
+			Vec3 centroid = (1.0f / areas[c]) * centroids[c];
+			keys[c] = (centroid - meshCentroid).Dot(normals[c]) / normalLength;
+		}
+	}
+
+	std::vector<uint32_t> order(clusterCount);
+	for (uint32_t c = 0; c < clusterCount; c++)
+	{
+		order[c] = c;
+	}
+	std::stable_sort(order.begin(), order.end(), [&keys](uint32_t a, uint32_t b) {
+		return keys[a] > keys[b];
+	});
+
+	result.clear();
+	result.reserve(ordered.size());
+	for (uint32_t c : order)
+	{
+		result.insert(result.end(), ordered.begin() + clusters[c] * 3, ordered.begin() + clusters[c + 1] * 3);
+	}
+}
+
+uint32_t Euler::OptimizeVertexFetch(void* vertices, uint32_t vertexCount, uint32_t stride, uint32_t* indices, uint32_t indexCount)
+{
+	std::vector<uint32_t> remap(vertexCount, UINT32_MAX);
+	uint32_t next = 0;
+
+	for (uint32_t i = 0; i < indexCount; i++)
+	{
+		uint32_t& newIndex = remap[indices[i]];
+		if (newIndex == UINT32_MAX)
+		{
+			newIndex = next++;
+		}
+		indices[i] = newIndex;
+	}
+
+	uint8_t* vertexData = (uint8_t*)vertices;
+	std::vector<uint8_t> original(vertexData, vertexData + (size_t)vertexCount * stride);
+
+	for (uint32_t v = 0; v < vertexCount; v++)
+	{
+		if (remap[v] != UINT32_MAX)
+		{
+			memcpy(vertexData + (size_t)remap[v] * stride, original.data() + (size_t)v * stride, stride);
+		}
+	}
+
+	return next;
+}
+
+void Euler::SplitMesh(const uint32_t* indices, uint32_t indexCount, uint32_t vertexCount, uint32_t maxVertices, std::vector<MeshPart>& parts)
+{
+	// index of every vertex in the current part
+	std::vector<uint32_t> remap(vertexCount, UINT32_MAX);
+
+	parts.clear();
+	parts.emplace_back();
+
+	for (uint32_t i = 0; i + 2 < indexCount; i += 3)
+	{
+		uint32_t newVertices = 0;
+		for (uint32_t c = 0; c < 3; c++)
+		{
+			uint32_t vertex = indices[i + c];
+			bool repeated = (c > 0 && indices[i] == vertex) || (c > 1 && indices[i + 1] == vertex);
+			newVertices += remap[vertex] == UINT32_MAX && !repeated ? 1 : 0;
+		}
+
+		if (parts.back().Vertices.size() + newVertices > maxVertices)
+		{
+			for (uint32_t vertex : parts.back().Vertices)
+			{
+				remap[vertex] = UINT32_MAX;
+			}
+			parts.emplace_back();
+		}
+
+		MeshPart& part = parts.back();
+		for (uint32_t c = 0; c < 3; c++)
+		{
+			uint32_t vertex = indices[i + c];
+			if (remap[vertex] == UINT32_MAX)
+			{
+				remap[vertex] = part.Vertices.size();
+				part.Vertices.push_back(vertex);
+			}
+			part.Indices.push_back(remap[vertex]);
+		}
+	}
+}
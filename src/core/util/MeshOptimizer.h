@@ -0,0 +1,41 @@
+#pragma once
+
+#include "../API.h"
+#include "../math/Vec3.h"
+
+#include <stdint.h>
+#include <vector>
+
+namespace Euler
+{
+	struct EULER_API VertexCacheStats
+	{
+		float Acmr;		// vertices transformed per triangle, 0.5 at best and 3 at worst
+		float Atvr;		// vertices transformed per vertex used, 1 at best
+	};
+
+	// simulates a FIFO post-transform cache of cacheSize vertices over an indexed triangle list
+	EULER_API VertexCacheStats AnalyzeVertexCache(const uint32_t* indices, uint32_t indexCount, uint32_t vertexCount, uint32_t cacheSize = 16);
+
+	// reorders the triangles so their vertices are reused while they are still in the post-transform cache (Tipsify, Sander et al.)
+	EULER_API void OptimizeVertexCache(const uint32_t* indices, uint32_t indexCount, uint32_t vertexCount, std::vector<uint32_t>& result, uint32_t cacheSize = 16);
+
+	// like OptimizeVertexCache, then splits the order into clusters wherever the cache is no worse than threshold times the
+	// whole cluster's miss rate and draws the clusters facing outwards first, so they hide the ones behind them. Higher thresholds
+	// give smaller clusters, less overdraw and more cache misses, 1 keeps only the clusters the cache order already has
+	EULER_API void OptimizeOverdraw(const Vec3* positions, uint32_t stride, const uint32_t* indices, uint32_t indexCount, uint32_t vertexCount, float threshold, std::vector<uint32_t>& result, uint32_t cacheSize = 16);
+
+	// moves the vertices into the order the indices first use them and drops unused ones, rewriting the indices.
+	// Returns the new vertex count
+	EULER_API uint32_t OptimizeVertexFetch(void* vertices, uint32_t vertexCount, uint32_t stride, uint32_t* indices, uint32_t indexCount);
+
+	struct EULER_API MeshPart
+	{
+		std::vector<uint32_t> Vertices;		// vertex of the split mesh for every vertex of the part
+		std::vector<uint32_t> Indices;		// into Vertices
+	};
+
+	// splits the triangles in order into parts of at most maxVertices (at least 3) vertices, so meshes too big for 16-bit
+	// indices become several that aren't. Vertices on the seams are duplicated, cache ordered triangles keep parts compact
+	EULER_API void SplitMesh(const uint32_t* indices, uint32_t indexCount, uint32_t vertexCount, uint32_t maxVertices, std::vector<MeshPart>& parts);
+}
@@ -0,0 +1,384 @@
+#include "MeshSimplifier.h"
+
+#include <math.h>
+#include <algorithm>
+#include <queue>
+#include <iterator>
+#include <unordered_map>
+
+namespace
+{
+	// sum of squared distances to a set of planes, the symmetric 4x4 matrix of their equations
+	struct Quadric
+	{
+		double A2 = 0, AB = 0, AC = 0, AD = 0;
+		double B2 = 0, BC = 0, BD = 0;
+		double C2 = 0, CD = 0;
+		double D2 = 0;
+
+		void AddPlane(double a, double b, double c, double d)
+		{
+			A2 += a * a; AB += a * b; AC += a * c; AD += a * d;
+			B2 += b * b; BC += b * c; BD += b * d;
+			C2 += c * c; CD += c * d;
+			D2 += d * d;
+		}
+
+		void Add(const Quadric& other)
+		{
+			A2 += other.A2; AB += other.AB; AC += other.AC; AD += other.AD;
+			B2 += other.B2; BC += other.BC; BD += other.BD;
+			C2 += other.C2; CD += other.CD;
+			D2 += other.D2;
+		}
+
+		double Evaluate(const Vec3& p) const
+		{
+			double x = p.x, y = p.y, z = p.z;
+			double error = A2 * x * x + 2 * AB * x * y + 2 * AC * x * z + 2 * AD * x
+				+ B2 * y * y + 2 * BC * y * z + 2 * BD * y
+				+ C2 * z * z + 2 * CD * z
+				+ D2;
+
+			// rounding can push it slightly below zero
+			return error > 0 ? error : 0;
+		}
+	};
+
+	struct Collapse
+	{
+		double Cost;
+		uint32_t From;
+		uint32_t To;
+
+		bool operator>(const Collapse& other) const
+		{
+			return Cost > other.Cost;
+		}
+	};
+
+	class Simplifier
+	{
+	private:
+		const uint8_t* _positions;
+		uint32_t _stride;
+
+		std::vector<uint32_t> _triangles;
+		std::vector<uint8_t> _triangleRemoved;
+		uint32_t _triangleCount = 0;
+
+		std::vector<std::vector<uint32_t>> _vertexTriangles;
+		std::vector<uint8_t> _locked;
+		std::vector<uint8_t> _removed;
+		std::vector<Quadric> _quadrics;
+
+		std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> _queue;
+
+	public:
+		Simplifier(const Vec3* positions, uint32_t vertexCount, uint32_t stride, const uint32_t* indices, uint32_t indexCount)
+		{
+			_positions = (const uint8_t*)positions;
+			_stride = stride;
+
+			_triangles.assign(indices, indices + indexCount);
+			_triangleCount = indexCount / 3;
+			_triangleRemoved.assign(_triangleCount, 0);
+
+			_vertexTriangles.resize(vertexCount);
+			_locked.assign(vertexCount, 0);
+			_removed.assign(vertexCount, 0);
+			_quadrics.resize(vertexCount);
+
+			for (uint32_t t = 0; t < _triangleCount; t++)
+			{
+				for (uint32_t k = 0; k < 3; k++)
+				{
+					_vertexTriangles[_triangles[t * 3 + k]].push_back(t);
+				}
+			}
+
+			LockSeams(vertexCount);
+			LockBorders();
+			ComputeQuadrics();
+
+			for (uint32_t t = 0; t < _triangleCount; t++)
+			{
+				for (uint32_t k = 0; k < 3; k++)
+				{
+					PushEdge(_triangles[t * 3 + k], _triangles[t * 3 + (k + 1) % 3]);
+				}
+			}
+		}
+
+		float Run(uint32_t targetIndexCount, float maxError, std::vector<uint32_t>& result)
+		{
+			double maxCost = (double)maxError * maxError;
+			double error = 0;
+
+			while (_triangleCount * 3 > targetIndexCount && !_queue.empty())
+			{
+				Collapse collapse = _queue.top();
+				_queue.pop();
+
+				if (_removed[collapse.From] || _removed[collapse.To])
+				{
+					continue;
+				}
+
+				// costs only grow as quadrics merge, stale entries go back with the current one
+				double cost = GetCost(collapse.From, collapse.To);
+				if (cost > collapse.Cost * (1.0 + 1e-9) + 1e-18)
+				{
+					_queue.push({ cost, collapse.From, collapse.To });
+					continue;
+				}
+
+				if (cost > maxCost)
+				{
+					break;
+				}
+
+				if (TryCollapse(collapse.From, collapse.To))
+				{
+					error = std::max(error, cost);
+				}
+			}
+
+			result.clear();
+			for (uint32_t t = 0; t < _triangleRemoved.size(); t++)
+			{
+				if (!_triangleRemoved[t])
+				{
+					result.insert(result.end(), &_triangles[t * 3], &_triangles[t * 3] + 3);
+				}
+			}
+
+			return (float)sqrt(error);
+		}
+
+	private:
+		const Vec3& GetPosition(uint32_t vertex) const
+		{
+			return *(const Vec3*)(_positions + (size_t)vertex * _stride);
+		}
+
+		void LockSeams(uint32_t vertexCount)
+		{
+			std::vector<uint32_t> order(vertexCount);
+			for (uint32_t i = 0; i < vertexCount; i++)
+			{
+				order[i] = i;
+			}
+
+			std::sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) {
+				const Vec3& pa = GetPosition(a);
+				const Vec3& pb = GetPosition(b);
+				if (pa.x != pb.x)
+					return pa.x < pb.x;
+				if (pa.y != pb.y)
+					return pa.y < pb.y;
+				return pa.z < pb.z;
+			});
+
+			for (uint32_t i = 1; i < vertexCount; i++)
+			{
+				const Vec3& previous = GetPosition(order[i - 1]);
+				const Vec3& current = GetPosition(order[i]);
+				if (previous.x == current.x && previous.y == current.y && previous.z == current.z)
+				{
+					_locked[order[i - 1]] = 1;
+					_locked[order[i]] = 1;
+				}
+			}
+		}
+
+		void LockBorders()
+		{
+			// edges used by a single triangle
+			std::unordered_map<uint64_t, uint32_t> edgeUses;
+			for (uint32_t t = 0; t < _triangleCount; t++)
+			{
+				for (uint32_t k = 0; k < 3; k++)
+				{
+					edgeUses[GetEdgeKey(_triangles[t * 3 + k], _triangles[t * 3 + (k + 1) % 3])]++;
+				}
+			}
+
+			for (auto& edge : edgeUses)
+			{
+				if (edge.second == 1)
+				{
+					_locked[(uint32_t)(edge.first >> 32)] = 1;
+					_locked[(uint32_t)(edge.first & 0xFFFFFFFF)] = 1;
+				}
+			}
+		}
+
+		void ComputeQuadrics()
+		{
+			for (uint32_t t = 0; t < _triangleCount; t++)
+			{
+				const Vec3& p0 = GetPosition(_triangles[t * 3 + 0]);
+				Vec3 normal = (GetPosition(_triangles[t * 3 + 1]) - p0).Cross(GetPosition(_triangles[t * 3 + 2]) - p0);
+
+				float length = normal.Length();
+				if (length <= 0.0f)
+				{
+					continue;
+				}
+
+				double a = normal.x / length;
+				double b = normal.y / length;
+				double c = normal.z / length;
+				double d = -(a * p0.x + b * p0.y + c * p0.z);
+
+				for (uint32_t k = 0; k < 3; k++)
+				{
+					_quadrics[_triangles[t * 3 + k]].AddPlane(a, b, c, d);
+				}
+			}
+		}
+
+		static uint64_t GetEdgeKey(uint32_t a, uint32_t b)
+		{
+			return a < b ? ((uint64_t)a << 32) | b : ((uint64_t)b << 32) | a;
+		}
+
+		double GetCost(uint32_t from, uint32_t to) const
+		{
+			Quadric quadric = _quadrics[from];
+			quadric.Add(_quadrics[to]);
+			return quadric.Evaluate(GetPosition(to));
+		}
+
+		void PushEdge(uint32_t a, uint32_t b)
+		{
+			if (!_locked[a])
+			{
+				_queue.push({ GetCost(a, b), a, b });
+			}
+			if (!_locked[b])
+			{
+				_queue.push({ GetCost(b, a), b, a });
+			}
+		}
+
+		// drops removed triangles from the vertex's list and fills its neighbours
+		void GatherNeighbours(uint32_t vertex, std::vector<uint32_t>& neighbours)
+		{
+			std::vector<uint32_t>& triangles = _vertexTriangles[vertex];
+			triangles.erase(std::remove_if(triangles.begin(), triangles.end(), [this](uint32_t t) { return _triangleRemoved[t] != 0; }), triangles.end());
+
+			neighbours.clear();
+			for (uint32_t t : triangles)
+			{
+				for (uint32_t k = 0; k < 3; k++)
+				{
+					if (_triangles[t * 3 + k] != vertex)
+					{
+						neighbours.push_back(_triangles[t * 3 + k]);
+					}
+				}
+			}
+
+			std::sort(neighbours.begin(), neighbours.end());
+			neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+		}
+
+		bool TryCollapse(uint32_t from, uint32_t to)
+		{
+			std::vector<uint32_t> fromNeighbours;
+			std::vector<uint32_t> toNeighbours;
+			GatherNeighbours(from, fromNeighbours);
+			GatherNeighbours(to, toNeighbours);
+
+			uint32_t shared = 0;
+			for (uint32_t t : _vertexTriangles[from])
+			{
+				if (_triangles[t * 3] == to || _triangles[t * 3 + 1] == to || _triangles[t * 3 + 2] == to)
+				{
+					shared++;
+				}
+			}
+
+			// no longer an edge
+			if (shared == 0)
+			{
+				return false;
+			}
+
+			// the link condition, more common neighbours than triangles on the edge would pinch the surface
+			std::vector<uint32_t> common;
+			std::set_intersection(fromNeighbours.begin(), fromNeighbours.end(), toNeighbours.begin(), toNeighbours.end(), std::back_inserter(common));
+			if (common.size() != shared)
+			{
+				return false;
+			}
+
+			// the triangles that stay must not flip or collapse
+			const Vec3& target = GetPosition(to);
+			for (uint32_t t : _vertexTriangles[from])
+			{
+				uint32_t* triangle = &_triangles[t * 3];
+				if (triangle[0] == to || triangle[1] == to || triangle[2] == to)
+				{
+					continue;
+				}
+
+				Vec3 before[3];
+				Vec3 after[3];
+				for (uint32_t k = 0; k < 3; k++)
+				{
+					before[k] = GetPosition(triangle[k]);
+					after[k] = triangle[k] == from ? target : before[k];
+				}
+
+				Vec3 normalBefore = (before[1] - before[0]).Cross(before[2] - before[0]);
+				Vec3 normalAfter = (after[1] - after[0]).Cross(after[2] - after[0]);
+				if (normalAfter.Dot(normalBefore) <= 0.0f || normalAfter.LengthSquared() <= normalBefore.LengthSquared() * 1e-6f)
+				{
+					return false;
+				}
+			}
+
+			for (uint32_t t : _vertexTriangles[from])
+			{
+				uint32_t* triangle = &_triangles[t * 3];
+				if (triangle[0] == to || triangle[1] == to || triangle[2] == to)
+				{
+					_triangleRemoved[t] = 1;
+					_triangleCount--;
+					continue;
+				}
+
+				for (uint32_t k = 0; k < 3; k++)
+				{
+					if (triangle[k] == from)
+					{
+						triangle[k] = to;
+					}
+				}
+				_vertexTriangles[to].push_back(t);
+			}
+
+			_removed[from] = 1;
+			_vertexTriangles[from].clear();
+			_quadrics[to].Add(_quadrics[from]);
+
+			// the costs of all edges around the merged vertex changed
+			GatherNeighbours(to, toNeighbours);
+			for (uint32_t neighbour : toNeighbours)
+			{
+				PushEdge(neighbour, to);
+			}
+
+			return true;
+		}
+	};
+}
+
+float Euler::SimplifyMesh(const Vec3* positions, uint32_t vertexCount, uint32_t stride, const uint32_t* indices, uint32_t indexCount, uint32_t targetIndexCount, float maxError, std::vector<uint32_t>& result)
+{
+	Simplifier simplifier(positions, vertexCount, stride, indices, indexCount);
+	return simplifier.Run(targetIndexCount, maxError, result);
+}
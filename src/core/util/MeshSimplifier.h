@@ -0,0 +1,17 @@
+#pragma once
+
+#include "../API.h"
+#include "../math/Vec3.h"
+
+#include <stdint.h>
+#include <vector>
+
+namespace Euler
+{
+	// Simplifies an indexed triangle list by collapsing edges onto one of their vertices in the order of their
+	// quadric error (Garland-Heckbert), so result still indexes the same vertices. Stops once result has at most
+	// targetIndexCount indices or the next collapse would move the surface further than maxError. Vertices on
+	// open borders and vertices sharing their position with another one (uv and normal seams) are never moved.
+	// Returns the error of result, a bound on how far the moved vertices are from the planes of their original triangles
+	EULER_API float SimplifyMesh(const Vec3* positions, uint32_t vertexCount, uint32_t stride, const uint32_t* indices, uint32_t indexCount, uint32_t targetIndexCount, float maxError, std::vector<uint32_t>& result);
+}
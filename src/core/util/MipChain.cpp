@@ -0,0 +1,92 @@
+#include "MipChain.h"
+
+#include <math.h>
+
+namespace
+{
+	float SrgbToLinear(float value)
+	{
+		return value <= 0.04045f ? value / 12.92f : powf((value + 0.055f) / 1.055f, 2.4f);
+	}
+
+	float LinearToSrgb(float value)
+	{
+		return value <= 0.0031308f ? value * 12.92f : 1.055f * powf(value, 1.0f / 2.4f) - 0.055f;
+	}
+
+	uint8_t ToUnorm8(float value)
+	{
+		value = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+		return (uint8_t)roundf(value * 255.0f);
+	}
+}
+
+uint32_t Euler::GetMipLevelCount(uint32_t width, uint32_t height)
+{
+	uint32_t size = width > height ? width : height;
+
+	uint32_t count = 1;
+	while (size > 1)
+	{
+		size >>= 1;
+		count++;
+	}
+	return count;
+}
+
+void Euler::GenerateMipChain(const uint8_t* pixels, uint32_t width, uint32_t height, bool srgb, std::vector<std::vector<uint8_t>>& levels)
+{
+	float toLinear[256];
+	for (uint32_t i = 0; i < 256; i++)
+	{
+		toLinear[i] = srgb ? SrgbToLinear(i / 255.0f) : i / 255.0f;
+	}
+
+	uint32_t levelCount = GetMipLevelCount(width, height);
+	levels.resize(levelCount - 1);
+
+	const uint8_t* source = pixels;
+	uint32_t sourceWidth = width;
+	uint32_t sourceHeight = height;
+	for (uint32_t level = 0; level < levels.size(); level++)
+	{
+		uint32_t levelWidth = sourceWidth > 1 ? sourceWidth / 2 : 1;
+		uint32_t levelHeight = sourceHeight > 1 ? sourceHeight / 2 : 1;
+		std::vector<uint8_t>& destination = levels[level];
+		destination.resize(levelWidth * levelHeight * 4);
+
+		for (uint32_t y = 0; y < levelHeight; y++)
+		{
+			uint32_t rows[] = { y * 2 < sourceHeight ? y * 2 : sourceHeight - 1, y * 2 + 1 < sourceHeight ? y * 2 + 1 : sourceHeight - 1 };
+			for (uint32_t x = 0; x < levelWidth; x++)
+			{
+				uint32_t columns[] = { x * 2 < sourceWidth ? x * 2 : sourceWidth - 1, x * 2 + 1 < sourceWidth ? x * 2 + 1 : sourceWidth - 1 };
+
+				float sum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+				for (uint32_t row : rows)
+				{
+					for (uint32_t column : columns)
+					{
+						const uint8_t* texel = source + (row * sourceWidth + column) * 4;
+						sum[0] += toLinear[texel[0]];
+						sum[1] += toLinear[texel[1]];
+						sum[2] += toLinear[texel[2]];
+						sum[3] += texel[3] / 255.0f;
+					}
+				}
+
+				uint8_t* result = destination.data() + (y * levelWidth + x) * 4;
+				for (uint32_t channel = 0; channel < 3; channel++)
+				{
+					float value = sum[channel] * 0.25f;
+					result[channel] = ToUnorm8(srgb ? LinearToSrgb(value) : value);
+				}
+				result[3] = ToUnorm8(sum[3] * 0.25f);
+			}
+		}
+
+		source = destination.data();
+		sourceWidth = levelWidth;
+		sourceHeight = levelHeight;
+	}
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include "../API.h"
+
+#include <stdint.h>
+#include <vector>
+
+namespace Euler
+{
+	// levels down to 1x1, each one half the size of the previous, rounded down
+	EULER_API uint32_t GetMipLevelCount(uint32_t width, uint32_t height);
+
+	// CPU fallback for when the device can't blit mip levels. Fills levels with every level after the first of the
+	// RGBA8 image, each a 2x2 box filter of the previous one (odd edges are clamped). With srgb the color channels are
+	// averaged in linear space and alpha as is
+	EULER_API void GenerateMipChain(const uint8_t* pixels, uint32_t width, uint32_t height, bool srgb, std::vector<std::vector<uint8_t>>& levels);
+}
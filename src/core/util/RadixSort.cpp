@@ -0,0 +1,53 @@
+#include "RadixSort.h"
+
+#include <string.h>
+
+void Euler::RadixSortIndices(const uint64_t* keys, uint32_t count, std::vector<uint32_t>& indices, std::vector<uint32_t>& scratch)
+{
+	indices.resize(count);
+	scratch.resize(count);
+	for (uint32_t i = 0; i < count; i++)
+	{
+		indices[i] = i;
+	}
+
+	// histograms of all 8 bytes in one go
+	uint32_t histograms[8][256];
+	memset(histograms, 0, sizeof(histograms));
+	for (uint32_t i = 0; i < count; i++)
+	{
+		uint64_t key = keys[i];
+		for (uint32_t pass = 0; pass < 8; pass++)
+		{
+			histograms[pass][(key >> (pass * 8)) & 0xFF]++;
+		}
+	}
+
+	for (uint32_t pass = 0; pass < 8; pass++)
+	{
+		uint32_t* histogram = histograms[pass];
+		uint32_t shift = pass * 8;
+
+		// every key has the same byte, the order wouldn't change
+		if (count == 0 || histogram[(keys[0] >> shift) & 0xFF] == count)
+		{
+			continue;
+		}
+
+		uint32_t offsets[256];
+		uint32_t offset = 0;
+		for (uint32_t i = 0; i < 256; i++)
+		{
+			offsets[i] = offset;
+			offset += histogram[i];
+		}
+
+		for (uint32_t i = 0; i < count; i++)
+		{
+			uint32_t index = indices[i];
+			scratch[offsets[(keys[index] >> shift) & 0xFF]++] = index;
+		}
+
+		indices.swap(scratch);
+	}
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include "../API.h"
+
+#include <stdint.h>
+#include <vector>
+
+namespace Euler
+{
+	// Fills indices with the order that sorts keys ascending. LSD radix sort with 8 bits per pass,
+	// equal keys keep their submission order and passes where all keys share the byte are skipped.
+	// scratch is reused between calls to avoid allocations
+	EULER_API void RadixSortIndices(const uint64_t* keys, uint32_t count, std::vector<uint32_t>& indices, std::vector<uint32_t>& scratch);
+}
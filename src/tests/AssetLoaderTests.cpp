@@ -0,0 +1,165 @@
+#include "gtest/gtest.h"
+
+#include "resources/AssetLoader.h"
+
+#include <future>
+#include <mutex>
+#include <vector>
+
+using namespace Euler;
+
+namespace
+{
+	// a job that records its value when it loads and hands it to its tickets
+	std::shared_ptr<LoadJob> CreateJob(int value, std::vector<int>* order, std::mutex* mutex, LoadPriority priority = LOAD_PRIORITY_NORMAL)
+	{
+		std::shared_ptr<LoadJob> job = std::make_shared<LoadJob>();
+		job->Priority = priority;
+		job->Load = [value, order, mutex]()
+		{
+			std::lock_guard<std::mutex> lock(*mutex);
+			order->push_back(value);
+			return true;
+		};
+		job->Complete = [value](LoadJob& job, bool loaded)
+		{
+			std::shared_ptr<int> result = std::make_shared<int>(value);
+			for (auto& ticket : job.Tickets)
+			{
+				ticket->Value = loaded ? result : nullptr;
+			}
+		};
+		return job;
+	}
+
+	// keeps the only worker busy until the gate opens
+	std::shared_ptr<LoadJob> CreateGateJob(std::shared_future<void> gate)
+	{
+		std::shared_ptr<LoadJob> job = std::make_shared<LoadJob>();
+		job->Priority = LOAD_PRIORITY_HIGH;
+		job->Load = [gate]()
+		{
+			gate.wait();
+			return true;
+		};
+		return job;
+	}
+
+	void UpdateUntilDone(AssetLoader& loader)
+	{
+		while (loader.GetPendingCount() > 0)
+		{
+			loader.Update();
+			std::this_thread::yield();
+		}
+	}
+}
+
+TEST(AssetLoaderTests, HigherPrioritiesLoadFirst) {
+	AssetLoader loader;
+	loader.Create(1);
+
+	std::promise<void> gate;
+	std::vector<int> order;
+	std::mutex mutex;
+
+	std::shared_ptr<LoadJob> gateJob = CreateGateJob(gate.get_future().share());
+	loader.Submit(gateJob);
+	while (gateJob->State != LOAD_STATE_LOADING)
+	{
+		std::this_thread::yield();
+	}
+
+	std::shared_ptr<LoadJob> low = CreateJob(1, &order, &mutex, LOAD_PRIORITY_LOW);
+	std::shared_ptr<LoadJob> first = CreateJob(2, &order, &mutex);
+	std::shared_ptr<LoadJob> second = CreateJob(3, &order, &mutex);
+	std::shared_ptr<LoadJob> high = CreateJob(4, &order, &mutex, LOAD_PRIORITY_HIGH);
+	loader.Submit(low);
+	loader.Submit(first);
+	loader.Submit(second);
+	loader.Submit(high);
+	loader.SetPriority(second, LOAD_PRIORITY_HIGH);
+
+	gate.set_value();
+	UpdateUntilDone(loader);
+
+	ASSERT_EQ(order, std::vector<int>({ 3, 4, 2, 1 }));
+	loader.Destroy();
+}
+
+TEST(AssetLoaderTests, CanceledLoadsAreSkipped) {
+	AssetLoader loader;
+	loader.Create(1);
+
+	std::promise<void> gate;
+	std::vector<int> order;
+	std::mutex mutex;
+
+	loader.Submit(CreateGateJob(gate.get_future().share()));
+
+	std::shared_ptr<LoadJob> job = CreateJob(1, &order, &mutex);
+	LoadHandle<int> handle(job, loader.Submit(job));
+	ASSERT_EQ(handle.GetState(), LOAD_STATE_QUEUED);
+	handle.Cancel();
+
+	gate.set_value();
+	UpdateUntilDone(loader);
+
+	ASSERT_TRUE(order.empty());
+	ASSERT_TRUE(handle.IsDone());
+	ASSERT_EQ(handle.GetState(), LOAD_STATE_CANCELED);
+	ASSERT_EQ(handle.Get(), nullptr);
+	loader.Destroy();
+}
+
+TEST(AssetLoaderTests, AttachedHandlesShareTheLoad) {
+	AssetLoader loader;
+	loader.Create(2);
+
+	std::vector<int> order;
+	std::mutex mutex;
+
+	std::shared_ptr<LoadJob> job = CreateJob(7, &order, &mutex);
+	LoadHandle<int> first(job, loader.Submit(job));
+	LoadHandle<int> second(job, loader.Attach(job));
+	LoadHandle<int> canceled(job, loader.Attach(job));
+	canceled.Cancel();
+
+	loader.Finish(first);
+
+	ASSERT_EQ(order.size(), 1u);
+	ASSERT_EQ(*first.Get(), 7);
+	ASSERT_EQ(first.Get(), second.Get());
+	ASSERT_EQ(canceled.Get(), nullptr);
+	ASSERT_EQ(loader.GetPendingCount(), 0u);
+	loader.Destroy();
+}
+
+TEST(AssetLoaderTests, DependentJobsCompleteAfterTheirDependencies) {
+	AssetLoader loader;
+	loader.Create(2);
+
+	std::vector<int> order;
+	std::mutex mutex;
+
+	std::shared_ptr<LoadJob> a = CreateJob(1, &order, &mutex);
+	std::shared_ptr<LoadJob> b = CreateJob(2, &order, &mutex);
+	LoadHandle<int> handleA(a, loader.Submit(a));
+	LoadHandle<int> handleB(b, loader.Submit(b));
+
+	std::shared_ptr<LoadJob> sum = std::make_shared<LoadJob>();
+	sum->Dependencies.push_back(a);
+	sum->Dependencies.push_back(b);
+	sum->Complete = [handleA, handleB](LoadJob& job, bool loaded)
+	{
+		job.Tickets[0]->Value = std::make_shared<int>(*handleA.Get() + *handleB.Get());
+	};
+	LoadHandle<int> handleSum(sum, loader.Submit(sum));
+
+	loader.FinishAll();
+
+	ASSERT_TRUE(handleSum.IsDone());
+	ASSERT_EQ(*handleSum.Get(), 3);
+	ASSERT_EQ(loader.GetPendingCount(), 0u);
+	loader.Destroy();
+}
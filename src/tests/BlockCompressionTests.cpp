@@ -0,0 +1,97 @@
+#include "gtest/gtest.h"
+
+#include "util/BlockCompression.h"
+
+#include <stdlib.h>
+
+using namespace Euler;
+
+// a smooth gradient with alpha going the other way
+static std::vector<uint8_t> MakeGradient(uint32_t width, uint32_t height)
+{
+	std::vector<uint8_t> pixels;
+	for (uint32_t y = 0; y < height; y++)
+	{
+		for (uint32_t x = 0; x < width; x++)
+		{
+			pixels.push_back((uint8_t)(x * 255 / (width - 1)));
+			pixels.push_back((uint8_t)(y * 255 / (height - 1)));
+			pixels.push_back((uint8_t)(128 + x * 4));
+			pixels.push_back((uint8_t)(255 - y * 255 / (height - 1)));
+		}
+	}
+	return pixels;
+}
+
+static int32_t GetMaxError(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b, uint32_t channelCount)
+{
+	int32_t maxError = 0;
+	for (uint32_t i = 0; i < a.size(); i++)
+	{
+		if (i % 4 < channelCount)
+		{
+			int32_t error = abs((int32_t)a[i] - b[i]);
+			maxError = error > maxError ? error : maxError;
+		}
+	}
+	return maxError;
+}
+
+TEST(BlockCompressionTests, LevelSize) {
+	ASSERT_EQ(GetLevelSize(TEXTURE_FORMAT_RGBA8, 5, 3), 5 * 3 * 4);
+	ASSERT_EQ(GetLevelSize(TEXTURE_FORMAT_BC1, 256, 256), 64 * 64 * 8);
+	ASSERT_EQ(GetLevelSize(TEXTURE_FORMAT_BC7, 5, 3), 2 * 1 * 16);
+	ASSERT_EQ(GetLevelSize(TEXTURE_FORMAT_BC5, 1, 1), 16);
+}
+
+TEST(BlockCompressionTests, SolidColorRoundTrip) {
+	std::vector<uint8_t> pixels;
+	for (uint32_t i = 0; i < 8 * 8; i++)
+	{
+		uint8_t color[] = { 200, 100, 30, 77 };
+		pixels.insert(pixels.end(), color, color + 4);
+	}
+
+	TextureFormat formats[] = { TEXTURE_FORMAT_BC1, TEXTURE_FORMAT_BC3, TEXTURE_FORMAT_BC5, TEXTURE_FORMAT_BC7 };
+	uint32_t channelCounts[] = { 3, 4, 2, 4 };
+	// BC1 colors are 565, BC7 endpoints 7 bits with a p-bit
+	int32_t tolerances[] = { 4, 4, 0, 1 };
+	for (uint32_t f = 0; f < 4; f++)
+	{
+		std::vector<uint8_t> blocks, decoded;
+		CompressBlocks(pixels.data(), 8, 8, formats[f], blocks);
+		ASSERT_EQ(blocks.size(), GetLevelSize(formats[f], 8, 8));
+
+		DecompressBlocks(blocks.data(), 8, 8, formats[f], decoded);
+		ASSERT_LE(GetMaxError(pixels, decoded, channelCounts[f]), tolerances[f]);
+	}
+}
+
+TEST(BlockCompressionTests, GradientRoundTrip) {
+	std::vector<uint8_t> pixels = MakeGradient(30, 18);
+
+	TextureFormat formats[] = { TEXTURE_FORMAT_BC1, TEXTURE_FORMAT_BC3, TEXTURE_FORMAT_BC5, TEXTURE_FORMAT_BC7 };
+	uint32_t channelCounts[] = { 3, 4, 2, 4 };
+	for (uint32_t f = 0; f < 4; f++)
+	{
+		std::vector<uint8_t> blocks, decoded;
+		CompressBlocks(pixels.data(), 30, 18, formats[f], blocks);
+		DecompressBlocks(blocks.data(), 30, 18, formats[f], decoded);
+
+		ASSERT_EQ(decoded.size(), pixels.size());
+		ASSERT_LE(GetMaxError(pixels, decoded, channelCounts[f]), 16);
+	}
+}
+
+TEST(BlockCompressionTests, BC5ChannelsAreIndependent) {
+	std::vector<uint8_t> pixels = MakeGradient(32, 32);
+
+	// red and green vary along different directions, each gets its own endpoints
+	std::vector<uint8_t> blocks, decoded;
+	CompressBlocks(pixels.data(), 32, 32, TEXTURE_FORMAT_BC5, blocks);
+	DecompressBlocks(blocks.data(), 32, 32, TEXTURE_FORMAT_BC5, decoded);
+
+	ASSERT_LE(GetMaxError(pixels, decoded, 2), 4);
+	ASSERT_EQ(decoded[2], 0);
+	ASSERT_EQ(decoded[3], 255);
+}
@@ -0,0 +1,71 @@
+#include "gtest/gtest.h"
+
+#include "graphics/vulkan/BuddyAllocator.h"
+
+using namespace Euler::Graphics;
+
+TEST(BuddyAllocatorTests, AllocateWholeBlock) {
+	BuddyAllocator allocator;
+	allocator.Init(1024, 64);
+
+	ASSERT_EQ(allocator.Allocate(1024, 1), 0);
+	ASSERT_EQ(allocator.GetFreeSize(), 0);
+	ASSERT_EQ(allocator.Allocate(64, 1), BuddyAllocator::INVALID_OFFSET);
+}
+
+TEST(BuddyAllocatorTests, RoundsToPowerOfTwo) {
+	BuddyAllocator allocator;
+	allocator.Init(1024, 64);
+
+	ASSERT_EQ(allocator.GetNodeSize(1, 1), 64);
+	ASSERT_EQ(allocator.GetNodeSize(65, 1), 128);
+	ASSERT_EQ(allocator.GetNodeSize(100, 512), 512);
+
+	allocator.Allocate(300, 1);
+	ASSERT_EQ(allocator.GetUsedSize(), 512);
+}
+
+TEST(BuddyAllocatorTests, RespectsAlignment) {
+	BuddyAllocator allocator;
+	allocator.Init(4096, 64);
+
+	allocator.Allocate(64, 1);
+	uint64_t offset = allocator.Allocate(64, 256);
+	ASSERT_NE(offset, BuddyAllocator::INVALID_OFFSET);
+	ASSERT_EQ(offset % 256, 0);
+}
+
+TEST(BuddyAllocatorTests, NoOverlap) {
+	BuddyAllocator allocator;
+	allocator.Init(1024, 64);
+
+	uint64_t a = allocator.Allocate(64, 1);
+	uint64_t b = allocator.Allocate(128, 1);
+	uint64_t c = allocator.Allocate(64, 1);
+	uint64_t d = allocator.Allocate(256, 1);
+
+	ASSERT_NE(a, c);
+	ASSERT_TRUE(b + 128 <= d || d + 256 <= b);
+	ASSERT_TRUE(a + 64 <= b || b + 128 <= a);
+	ASSERT_TRUE(c + 64 <= b || b + 128 <= c);
+	ASSERT_EQ(allocator.GetAllocationCount(), 4);
+}
+
+TEST(BuddyAllocatorTests, FreeMergesBuddies) {
+	BuddyAllocator allocator;
+	allocator.Init(1024, 64);
+
+	uint64_t a = allocator.Allocate(64, 1);
+	uint64_t b = allocator.Allocate(64, 1);
+	uint64_t c = allocator.Allocate(512, 1);
+	ASSERT_EQ(allocator.GetLargestFreeNode(), 256);
+
+	allocator.Free(a);
+	allocator.Free(b);
+	allocator.Free(c);
+
+	ASSERT_TRUE(allocator.IsEmpty());
+	ASSERT_EQ(allocator.GetFreeSize(), 1024);
+	ASSERT_EQ(allocator.GetLargestFreeNode(), 1024);
+	ASSERT_EQ(allocator.Allocate(1024, 1), 0);
+}
@@ -0,0 +1,81 @@
+#include "gtest/gtest.h"
+
+#include "graphics/vulkan/FreeListAllocator.h"
+
+using namespace Euler::Graphics;
+
+TEST(FreeListAllocatorTests, AllocatesInOrder) {
+	FreeListAllocator allocator;
+	allocator.Init(100);
+
+	ASSERT_EQ(allocator.Allocate(10), 0);
+	ASSERT_EQ(allocator.Allocate(30), 10);
+	ASSERT_EQ(allocator.Allocate(60), 40);
+	ASSERT_EQ(allocator.GetFreeSize(), 0);
+	ASSERT_EQ(allocator.Allocate(1), FreeListAllocator::INVALID_OFFSET);
+}
+
+TEST(FreeListAllocatorTests, DoesNotRound) {
+	FreeListAllocator allocator;
+	allocator.Init(1000);
+
+	allocator.Allocate(3);
+	allocator.Allocate(7);
+	ASSERT_EQ(allocator.GetUsedSize(), 10);
+}
+
+TEST(FreeListAllocatorTests, ReusesFreedRange) {
+	FreeListAllocator allocator;
+	allocator.Init(100);
+
+	allocator.Allocate(20);
+	uint64_t offset = allocator.Allocate(20);
+	allocator.Allocate(20);
+
+	allocator.Free(offset, 20);
+	ASSERT_EQ(allocator.Allocate(15), offset);
+	ASSERT_EQ(allocator.Allocate(5), offset + 15);
+}
+
+TEST(FreeListAllocatorTests, MergesNeighbours) {
+	FreeListAllocator allocator;
+	allocator.Init(100);
+
+	uint64_t a = allocator.Allocate(25);
+	uint64_t b = allocator.Allocate(25);
+	uint64_t c = allocator.Allocate(25);
+	allocator.Allocate(25);
+
+	allocator.Free(a, 25);
+	allocator.Free(c, 25);
+	ASSERT_EQ(allocator.GetFreeRangeCount(), 2);
+	ASSERT_EQ(allocator.GetLargestFreeRange(), 25);
+
+	allocator.Free(b, 25);
+	ASSERT_EQ(allocator.GetFreeRangeCount(), 1);
+	ASSERT_EQ(allocator.GetLargestFreeRange(), 75);
+	ASSERT_EQ(allocator.Allocate(75), 0);
+}
+
+TEST(FreeListAllocatorTests, FreeEverything) {
+	FreeListAllocator allocator;
+	allocator.Init(64);
+
+	uint64_t offsets[8];
+	for (int i = 0; i < 8; i++)
+	{
+		offsets[i] = allocator.Allocate(8);
+	}
+	for (int i = 7; i >= 0; i -= 2)
+	{
+		allocator.Free(offsets[i], 8);
+	}
+	for (int i = 6; i >= 0; i -= 2)
+	{
+		allocator.Free(offsets[i], 8);
+	}
+
+	ASSERT_EQ(allocator.GetUsedSize(), 0);
+	ASSERT_EQ(allocator.GetFreeRangeCount(), 1);
+	ASSERT_EQ(allocator.GetLargestFreeRange(), 64);
+}
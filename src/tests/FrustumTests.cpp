@@ -0,0 +1,99 @@
+#include "gtest/gtest.h"
+
+#include "math/Frustum.h"
+#include "math/Matrices.h"
+
+using namespace Euler::Math;
+
+static Frustum MakeCameraFrustum()
+{
+	// camera at the origin looking down +z
+	Mat4 proj = Matrices::Perspective(1920, 1080, 60.0f, 0.1f, 100.0f);
+	Mat4 view = Matrices::Identity();
+	return Frustum::FromMatrix(proj.Multiply(view));
+}
+
+TEST(FrustumTests, SphereInsideAndOutside) {
+	Frustum frustum = MakeCameraFrustum();
+
+	ASSERT_TRUE(frustum.IsVisible(BoundingSphere(Vec3(0, 0, 10), 1.0f)));
+	ASSERT_FALSE(frustum.IsVisible(BoundingSphere(Vec3(0, 0, -10), 1.0f)));
+	ASSERT_FALSE(frustum.IsVisible(BoundingSphere(Vec3(0, 0, 200), 1.0f)));
+	ASSERT_FALSE(frustum.IsVisible(BoundingSphere(Vec3(100, 0, 10), 1.0f)));
+	ASSERT_FALSE(frustum.IsVisible(BoundingSphere(Vec3(0, -100, 10), 1.0f)));
+}
+
+TEST(FrustumTests, SphereIntersectingPlane) {
+	Frustum frustum = MakeCameraFrustum();
+
+	// center behind the near plane but the radius reaches into the frustum
+	ASSERT_TRUE(frustum.IsVisible(BoundingSphere(Vec3(0, 0, -1), 2.0f)));
+	ASSERT_TRUE(frustum.IsVisible(BoundingSphere(Vec3(0, 0, 101), 2.0f)));
+}
+
+TEST(FrustumTests, Box) {
+	Frustum frustum = MakeCameraFrustum();
+
+	ASSERT_TRUE(frustum.IsVisible(BoundingBox(Vec3(-1, -1, 5), Vec3(1, 1, 6))));
+	ASSERT_TRUE(frustum.IsVisible(BoundingBox(Vec3(-1000, -1, 5), Vec3(1000, 1, 6))));
+	ASSERT_FALSE(frustum.IsVisible(BoundingBox(Vec3(-1, -1, -6), Vec3(1, 1, -5))));
+}
+
+TEST(FrustumTests, CullSpheresMatchesSingleTests) {
+	Frustum frustum = MakeCameraFrustum();
+
+	float x[] = { 0, 0, 100, 0, 5 };
+	float y[] = { 0, 0, 0, 0, 3 };
+	float z[] = { 10, -10, 10, 101, 20 };
+	float radius[] = { 1, 1, 1, 2, 0.5f };
+	uint8_t visible[5];
+
+	frustum.CullSpheres(x, y, z, radius, 5, visible);
+
+	for (uint32_t i = 0; i < 5; i++)
+	{
+		ASSERT_EQ(visible[i] != 0, frustum.IsVisible(BoundingSphere(Vec3(x[i], y[i], z[i]), radius[i])));
+	}
+	ASSERT_EQ(visible[0], 1);
+	ASSERT_EQ(visible[1], 0);
+}
+
+TEST(FrustumTests, OrthographicFrustum) {
+	Frustum frustum = Frustum::FromMatrix(Matrices::Orthographic(4096, 4096, 6.0f));
+
+	ASSERT_TRUE(frustum.IsVisible(BoundingSphere(Vec3(0, 0, 0), 1.0f)));
+	ASSERT_TRUE(frustum.IsVisible(BoundingSphere(Vec3(5, -5, 40), 1.0f)));
+	ASSERT_FALSE(frustum.IsVisible(BoundingSphere(Vec3(10, 0, 0), 1.0f)));
+	ASSERT_FALSE(frustum.IsVisible(BoundingSphere(Vec3(0, 0, 60), 1.0f)));
+}
+
+TEST(FrustumTests, BoundsFromPoints) {
+	Vec3 points[] = { Vec3(1, 2, 3), Vec3(-1, 0, 5), Vec3(0, -2, 4) };
+
+	BoundingBox box = BoundingBox::FromPoints(points, 3, sizeof(Vec3));
+	ASSERT_FLOAT_EQ(box.Min.x, -1);
+	ASSERT_FLOAT_EQ(box.Min.y, -2);
+	ASSERT_FLOAT_EQ(box.Min.z, 3);
+	ASSERT_FLOAT_EQ(box.Max.x, 1);
+	ASSERT_FLOAT_EQ(box.Max.y, 2);
+	ASSERT_FLOAT_EQ(box.Max.z, 5);
+
+	BoundingSphere sphere = BoundingSphere::FromPoints(points, 3, sizeof(Vec3));
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		Vec3 offset(points[i].x - sphere.Center.x, points[i].y - sphere.Center.y, points[i].z - sphere.Center.z);
+		ASSERT_LE(offset.Length(), sphere.Radius + 1e-5f);
+	}
+}
+
+TEST(FrustumTests, TransformSphere) {
+	BoundingSphere sphere(Vec3(1, 0, 0), 1.0f);
+
+	Mat4 matrix = Matrices::Translate(0, 10, 0).Multiply(Matrices::Scale(1, 3, 1));
+	BoundingSphere transformed = sphere.Transform(matrix);
+
+	ASSERT_FLOAT_EQ(transformed.Center.x, 1);
+	ASSERT_FLOAT_EQ(transformed.Center.y, 10);
+	ASSERT_FLOAT_EQ(transformed.Center.z, 0);
+	ASSERT_FLOAT_EQ(transformed.Radius, 3);
+}
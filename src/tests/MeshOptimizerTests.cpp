@@ -0,0 +1,128 @@
+#include "gtest/gtest.h"
+
+#include "util/MeshOptimizer.h"
+
+#include <algorithm>
+
+using namespace Euler;
+
+// side x side quads in the xy plane, the triangles in a scrambled order
+static void MakeScrambledGrid(uint32_t side, std::vector<Vec3>& positions, std::vector<uint32_t>& indices)
+{
+	for (uint32_t y = 0; y <= side; y++)
+	{
+		for (uint32_t x = 0; x <= side; x++)
+		{
+			positions.push_back(Vec3((float)x, (float)y, 0.0f));
+		}
+	}
+
+	uint32_t quadCount = side * side;
+	for (uint32_t q = 0; q < quadCount; q++)
+	{
+		// 7919 is prime, so this visits every quad once
+		uint32_t quad = (q * 7919) % quadCount;
+		uint32_t i = (quad / side) * (side + 1) + quad % side;
+		uint32_t triangles[] = { i, i + side + 1, i + 1, i + 1, i + side + 1, i + side + 2 };
+		indices.insert(indices.end(), triangles, triangles + 6);
+	}
+}
+
+static std::vector<std::vector<uint32_t>> GetSortedTriangles(const std::vector<uint32_t>& indices)
+{
+	std::vector<std::vector<uint32_t>> triangles;
+	for (uint32_t i = 0; i < indices.size(); i += 3)
+	{
+		// rotated so the smallest index is first, which keeps the winding
+		uint32_t first = indices[i] < indices[i + 1] ? (indices[i] < indices[i + 2] ? 0 : 2) : (indices[i + 1] < indices[i + 2] ? 1 : 2);
+		triangles.push_back({ indices[i + first], indices[i + (first + 1) % 3], indices[i + (first + 2) % 3] });
+	}
+	std::sort(triangles.begin(), triangles.end());
+	return triangles;
+}
+
+TEST(MeshOptimizerTests, AnalyzeVertexCache) {
+	// two triangles sharing an edge transform four vertices
+	uint32_t indices[] = { 0, 1, 2, 2, 1, 3 };
+	VertexCacheStats stats = AnalyzeVertexCache(indices, 6, 4);
+
+	ASSERT_FLOAT_EQ(stats.Acmr, 2.0f);
+	ASSERT_FLOAT_EQ(stats.Atvr, 1.0f);
+}
+
+TEST(MeshOptimizerTests, VertexCacheKeepsTriangles) {
+	std::vector<Vec3> positions;
+	std::vector<uint32_t> indices;
+	MakeScrambledGrid(32, positions, indices);
+
+	std::vector<uint32_t> result;
+	OptimizeVertexCache(indices.data(), indices.size(), positions.size(), result);
+
+	ASSERT_EQ(GetSortedTriangles(result), GetSortedTriangles(indices));
+
+	VertexCacheStats before = AnalyzeVertexCache(indices.data(), indices.size(), positions.size());
+	VertexCacheStats after = AnalyzeVertexCache(result.data(), result.size(), positions.size());
+	ASSERT_LT(after.Acmr, before.Acmr);
+	ASSERT_LT(after.Acmr, 1.0f);
+}
+
+TEST(MeshOptimizerTests, OverdrawKeepsTriangles) {
+	std::vector<Vec3> positions;
+	std::vector<uint32_t> indices;
+	MakeScrambledGrid(32, positions, indices);
+
+	std::vector<uint32_t> result;
+	OptimizeOverdraw(positions.data(), sizeof(Vec3), indices.data(), indices.size(), positions.size(), 1.05f, result);
+
+	ASSERT_EQ(GetSortedTriangles(result), GetSortedTriangles(indices));
+
+	VertexCacheStats before = AnalyzeVertexCache(indices.data(), indices.size(), positions.size());
+	VertexCacheStats after = AnalyzeVertexCache(result.data(), result.size(), positions.size());
+	ASSERT_LT(after.Acmr, before.Acmr);
+}
+
+TEST(MeshOptimizerTests, VertexFetchFirstUseOrder) {
+	std::vector<Vec3> positions = { Vec3(0, 0, 0), Vec3(1, 0, 0), Vec3(2, 0, 0), Vec3(3, 0, 0), Vec3(4, 0, 0) };
+	std::vector<uint32_t> indices = { 3, 1, 4, 4, 1, 0 };
+
+	uint32_t vertexCount = OptimizeVertexFetch(positions.data(), positions.size(), sizeof(Vec3), indices.data(), indices.size());
+
+	// vertex 2 isn't used
+	ASSERT_EQ(vertexCount, 4);
+
+	uint32_t expected[] = { 0, 1, 2, 2, 1, 3 };
+	for (uint32_t i = 0; i < indices.size(); i++)
+	{
+		ASSERT_EQ(indices[i], expected[i]);
+	}
+
+	ASSERT_EQ(positions[0].x, 3.0f);
+	ASSERT_EQ(positions[1].x, 1.0f);
+	ASSERT_EQ(positions[2].x, 4.0f);
+	ASSERT_EQ(positions[3].x, 0.0f);
+}
+
+TEST(MeshOptimizerTests, SplitMeshKeepsTriangles) {
+	std::vector<Vec3> positions;
+	std::vector<uint32_t> indices;
+	MakeScrambledGrid(32, positions, indices);
+
+	std::vector<MeshPart> parts;
+	SplitMesh(indices.data(), indices.size(), positions.size(), 100, parts);
+
+	ASSERT_GT(parts.size(), 1);
+
+	// mapped back to the mesh's vertices, the parts have all the triangles
+	std::vector<uint32_t> joined;
+	for (const MeshPart& part : parts)
+	{
+		ASSERT_LE(part.Vertices.size(), 100);
+		for (uint32_t index : part.Indices)
+		{
+			ASSERT_LT(index, part.Vertices.size());
+			joined.push_back(part.Vertices[index]);
+		}
+	}
+
+	ASSERT_EQ(GetSortedTriangles(joined), GetSortedTriangles(indices));
+}
@@ -0,0 +1,84 @@
+#include "gtest/gtest.h"
+
+#include "util/MeshSimplifier.h"
+
+#include <algorithm>
+
+using namespace Euler;
+
+// side x side quads in the xz plane, heights alternate between 0 and height on the inner vertices
+static void MakeGrid(uint32_t side, float height, std::vector<Vec3>& positions, std::vector<uint32_t>& indices)
+{
+	for (uint32_t z = 0; z <= side; z++)
+	{
+		for (uint32_t x = 0; x <= side; x++)
+		{
+			bool inner = x > 0 && z > 0 && x < side && z < side;
+			positions.push_back(Vec3((float)x, inner && (x + z) % 2 == 1 ? height : 0.0f, (float)z));
+		}
+	}
+
+	for (uint32_t z = 0; z < side; z++)
+	{
+		for (uint32_t x = 0; x < side; x++)
+		{
+			uint32_t i = z * (side + 1) + x;
+			uint32_t quad[] = { i, i + side + 1, i + 1, i + 1, i + side + 1, i + side + 2 };
+			indices.insert(indices.end(), quad, quad + 6);
+		}
+	}
+}
+
+TEST(MeshSimplifierTests, FlatGridReachesTarget) {
+	std::vector<Vec3> positions;
+	std::vector<uint32_t> indices;
+	MakeGrid(16, 0.0f, positions, indices);
+
+	std::vector<uint32_t> result;
+	float error = SimplifyMesh(positions.data(), positions.size(), sizeof(Vec3), indices.data(), indices.size(), 600, 0.01f, result);
+
+	ASSERT_LE(result.size(), 600);
+	ASSERT_EQ(result.size() % 3, 0);
+	ASSERT_LT(error, 1e-3f);
+
+	for (uint32_t i = 0; i < result.size(); i += 3)
+	{
+		ASSERT_LT(result[i], positions.size());
+		ASSERT_NE(result[i], result[i + 1]);
+		ASSERT_NE(result[i + 1], result[i + 2]);
+		ASSERT_NE(result[i], result[i + 2]);
+	}
+}
+
+TEST(MeshSimplifierTests, KeepsBorders) {
+	std::vector<Vec3> positions;
+	std::vector<uint32_t> indices;
+	MakeGrid(8, 0.0f, positions, indices);
+
+	std::vector<uint32_t> result;
+	SimplifyMesh(positions.data(), positions.size(), sizeof(Vec3), indices.data(), indices.size(), 0, 0.01f, result);
+
+	// the corners can't go anywhere
+	uint32_t corners[] = { 0, 8, 9 * 8, 9 * 9 - 1 };
+	for (uint32_t corner : corners)
+	{
+		ASSERT_NE(std::find(result.begin(), result.end(), corner), result.end());
+	}
+}
+
+TEST(MeshSimplifierTests, StopsAtMaxError) {
+	std::vector<Vec3> positions;
+	std::vector<uint32_t> indices;
+	MakeGrid(8, 1.0f, positions, indices);
+
+	std::vector<uint32_t> result;
+	float error = SimplifyMesh(positions.data(), positions.size(), sizeof(Vec3), indices.data(), indices.size(), 0, 0.01f, result);
+	ASSERT_LE(error, 0.01f);
+
+	std::vector<uint32_t> coarse;
+	float coarseError = SimplifyMesh(positions.data(), positions.size(), sizeof(Vec3), indices.data(), indices.size(), 0, 10.0f, coarse);
+
+	// only the flat strip along the border can go without moving the surface
+	ASSERT_GT(result.size(), coarse.size());
+	ASSERT_GT(coarseError, 0.01f);
+}
@@ -0,0 +1,62 @@
+#include "gtest/gtest.h"
+
+#include "util/MipChain.h"
+
+using namespace Euler;
+
+TEST(MipChainTests, LevelCount) {
+	ASSERT_EQ(GetMipLevelCount(1, 1), 1);
+	ASSERT_EQ(GetMipLevelCount(256, 256), 9);
+	ASSERT_EQ(GetMipLevelCount(5, 3), 3);
+	ASSERT_EQ(GetMipLevelCount(1, 1024), 11);
+}
+
+TEST(MipChainTests, OddSizesRoundDown) {
+	std::vector<uint8_t> pixels(5 * 3 * 4, 255);
+
+	std::vector<std::vector<uint8_t>> levels;
+	GenerateMipChain(pixels.data(), 5, 3, true, levels);
+
+	// 5x3 -> 2x1 -> 1x1
+	ASSERT_EQ(levels.size(), 2);
+	ASSERT_EQ(levels[0].size(), 2 * 1 * 4);
+	ASSERT_EQ(levels[1].size(), 1 * 1 * 4);
+}
+
+TEST(MipChainTests, UniformColorStaysUniform) {
+	uint8_t color[] = { 200, 100, 30, 128 };
+	std::vector<uint8_t> pixels;
+	for (uint32_t i = 0; i < 16 * 8; i++)
+	{
+		pixels.insert(pixels.end(), color, color + 4);
+	}
+
+	std::vector<std::vector<uint8_t>> levels;
+	GenerateMipChain(pixels.data(), 16, 8, true, levels);
+
+	for (const std::vector<uint8_t>& level : levels)
+	{
+		for (uint32_t i = 0; i < level.size(); i++)
+		{
+			ASSERT_EQ(level[i], color[i % 4]);
+		}
+	}
+}
+
+TEST(MipChainTests, SrgbAveragesInLinearSpace) {
+	// a black and white checkerboard
+	uint8_t pixels[] = {
+		0, 0, 0, 0,         255, 255, 255, 255,
+		255, 255, 255, 255, 0, 0, 0, 0
+	};
+
+	std::vector<std::vector<uint8_t>> levels;
+	GenerateMipChain(pixels, 2, 2, false, levels);
+	ASSERT_EQ(levels[0][0], 128);
+	ASSERT_EQ(levels[0][3], 128);
+
+	// linear 0.5 is brighter than sRGB 0.5, alpha stays linear
+	GenerateMipChain(pixels, 2, 2, true, levels);
+	ASSERT_EQ(levels[0][0], 188);
+	ASSERT_EQ(levels[0][3], 128);
+}
@@ -0,0 +1,201 @@
+#include "gtest/gtest.h"
+
+#include "resources/ModelResource.h"
+#include "resources/AnimatedModelResource.h"
+#include "io/Utils.h"
+
+#include <stdio.h>
+#include <string.h>
+
+using namespace Euler;
+
+namespace
+{
+	const char* FILE_PATH = "ModelResourceTests.bem";
+
+	void Append(std::vector<char>& data, const void* value, size_t size)
+	{
+		data.insert(data.end(), (const char*)value, (const char*)value + size);
+	}
+
+	void Append(std::vector<char>& data, uint32_t value)
+	{
+		Append(data, &value, sizeof(value));
+	}
+
+	// a version 3 file with one full format mesh
+	std::vector<char> CreateModelFile(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices)
+	{
+		std::vector<char> data;
+		Append(data, ModelResource::FILE_MAGIC);
+		Append(data, 1);
+		Append(data, VERTEX_FORMAT_FULL);
+
+		Append(data, vertices.size());
+		Append(data, indices.size());
+		Append(data, 1);
+		Append(data, sizeof(uint32_t));
+		Append(data, vertices.data(), vertices.size() * sizeof(Vertex));
+		Append(data, indices.data(), indices.size() * sizeof(uint32_t));
+
+		MeshLod lod = { 0, (uint32_t)indices.size(), 0.0f };
+		Append(data, &lod, sizeof(lod));
+		return data;
+	}
+
+	// the format of the files written before the magic, without lods, formats or index sizes
+	void AppendLegacyMesh(std::vector<char>& data, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices)
+	{
+		Append(data, vertices.size());
+		Append(data, indices.size());
+		Append(data, vertices.data(), vertices.size() * sizeof(Vertex));
+		Append(data, indices.data(), indices.size() * sizeof(uint32_t));
+	}
+
+	std::vector<Vertex> CreateVertices()
+	{
+		std::vector<Vertex> vertices;
+		for (int i = 0; i < 4; i++)
+		{
+			vertices.push_back(Vertex(Vec3(i, 1, 2), Vec3(0, 0, 1), Vec3(1, 0, 0), Vec3(0, 1, 0), Vec2(0.25f * i, 0.5f)));
+		}
+		return vertices;
+	}
+}
+
+TEST(ModelResourceTests, MapPointsIntoTheFile) {
+	std::vector<Vertex> vertices = CreateVertices();
+	std::vector<uint32_t> indices = { 0, 1, 2, 2, 1, 3 };
+	ASSERT_TRUE(WriteFile(FILE_PATH, CreateModelFile(vertices, indices)));
+
+	ModelResource mapped;
+	mapped.Map(FILE_PATH);
+	ASSERT_FALSE(mapped.View.IsEmpty());
+	ASSERT_TRUE(mapped.Vertices.empty());
+	ASSERT_EQ(mapped.View.VertexCount, vertices.size());
+	ASSERT_EQ(mapped.View.VertexStride, sizeof(Vertex));
+	ASSERT_EQ(mapped.View.IndexCount, indices.size());
+	ASSERT_EQ(memcmp(mapped.View.Vertices, vertices.data(), vertices.size() * sizeof(Vertex)), 0);
+	ASSERT_EQ(memcmp(mapped.View.Indices, indices.data(), indices.size() * sizeof(uint32_t)), 0);
+	ASSERT_EQ(mapped.Lods.size(), 1u);
+	mapped.Unload();
+	ASSERT_TRUE(mapped.View.IsEmpty());
+
+	ModelResource loaded;
+	loaded.Load(FILE_PATH);
+	ASSERT_TRUE(loaded.View.IsEmpty());
+	ASSERT_EQ(loaded.Vertices.size(), vertices.size());
+	ASSERT_EQ(memcmp(loaded.Vertices.data(), vertices.data(), vertices.size() * sizeof(Vertex)), 0);
+	ASSERT_EQ(loaded.Indices, indices);
+
+	remove(FILE_PATH);
+}
+
+TEST(ModelResourceTests, MapConvertsOtherFormats) {
+	std::vector<Vertex> vertices = CreateVertices();
+	ASSERT_TRUE(WriteFile(FILE_PATH, CreateModelFile(vertices, { 0, 1, 2 })));
+
+	ModelResource resource;
+	resource.Map(FILE_PATH, VERTEX_FORMAT_PACKED);
+	ASSERT_TRUE(resource.View.IsEmpty());
+	ASSERT_TRUE(resource.Vertices.empty());
+	ASSERT_EQ(resource.PackedVertices.size(), vertices.size());
+	ASSERT_EQ(resource.PackedVertices[3].Position.x, 3.0f);
+	ASSERT_EQ(resource.Indices.size(), 3u);
+
+	remove(FILE_PATH);
+}
+
+TEST(ModelResourceTests, TruncatedFilesLoadNothing) {
+	std::vector<char> data = CreateModelFile(CreateVertices(), { 0, 1, 2 });
+	data.resize(data.size() - sizeof(MeshLod) - 1);
+	ASSERT_TRUE(WriteFile(FILE_PATH, data));
+
+	ModelResource resource;
+	resource.Map(FILE_PATH);
+	ASSERT_TRUE(resource.View.IsEmpty());
+	ASSERT_TRUE(resource.Vertices.empty());
+	ASSERT_TRUE(resource.Indices.empty());
+
+	resource.Load("missing.bem");
+	ASSERT_TRUE(resource.Vertices.empty());
+
+	remove(FILE_PATH);
+}
+
+TEST(ModelResourceTests, LegacyFilesSkipToTheMesh) {
+	std::vector<Vertex> vertices = CreateVertices();
+	std::vector<uint32_t> indices = { 0, 1, 2, 2, 1, 3 };
+	std::vector<char> data;
+	Append(data, 2);
+	AppendLegacyMesh(data, std::vector<Vertex>(vertices.begin(), vertices.begin() + 3), { 0, 1, 2 });
+	AppendLegacyMesh(data, vertices, indices);
+	ASSERT_TRUE(WriteFile(FILE_PATH, data));
+
+	ModelResource mapped;
+	mapped.Map(FILE_PATH, VERTEX_FORMAT_FULL, 1);
+	ASSERT_EQ(mapped.MeshCount, 2u);
+	ASSERT_FALSE(mapped.View.IsEmpty());
+	ASSERT_EQ(mapped.View.VertexCount, vertices.size());
+	ASSERT_EQ(mapped.View.IndexCount, indices.size());
+	ASSERT_EQ(mapped.View.IndexSize, sizeof(uint32_t));
+	ASSERT_EQ(memcmp(mapped.View.Vertices, vertices.data(), vertices.size() * sizeof(Vertex)), 0);
+	ASSERT_EQ(memcmp(mapped.View.Indices, indices.data(), indices.size() * sizeof(uint32_t)), 0);
+	ASSERT_TRUE(mapped.Lods.empty());
+	mapped.Unload();
+
+	ModelResource loaded;
+	loaded.Load(FILE_PATH);
+	ASSERT_EQ(loaded.Vertices.size(), 3u);
+	ASSERT_EQ(loaded.Indices.size(), 3u);
+
+	loaded.Load(FILE_PATH, VERTEX_FORMAT_FULL, 2);
+	ASSERT_TRUE(loaded.Vertices.empty());
+
+	remove(FILE_PATH);
+}
+
+TEST(ModelResourceTests, LegacyAnimatedFilesReadTheAnimations) {
+	std::vector<AnimatedVertex> vertices;
+	for (int i = 0; i < 3; i++)
+	{
+		vertices.push_back(AnimatedVertex(Vec3(i, 1, 2), Vec3(0, 0, 1), Vec2(0.5f, 0.5f), Vec3i(0, 1, 2), Vec3(1, 0, 0)));
+	}
+	std::vector<uint32_t> indices = { 0, 1, 2 };
+	std::vector<int> boneParents(MAX_BONES, -1);
+	std::vector<Mat4> boneOffsetMatrices(MAX_BONES);
+	std::vector<char> keyFrames(2 * sizeof(KeyFrame), 0);
+
+	std::vector<char> data;
+	Append(data, 1);
+	Append(data, vertices.size());
+	Append(data, indices.size());
+	Append(data, vertices.data(), vertices.size() * sizeof(AnimatedVertex));
+	Append(data, indices.data(), indices.size() * sizeof(uint32_t));
+	Append(data, boneParents.data(), boneParents.size() * sizeof(int));
+	Append(data, boneOffsetMatrices.data(), boneOffsetMatrices.size() * sizeof(Mat4));
+	Append(data, 1);
+	float duration = 2.0f;
+	Append(data, &duration, sizeof(duration));
+	Append(data, 2);
+	Append(data, keyFrames.data(), keyFrames.size());
+	ASSERT_TRUE(WriteFile(FILE_PATH, data));
+
+	AnimatedModelResource resource;
+	resource.Map(FILE_PATH);
+	ASSERT_FALSE(resource.View.IsEmpty());
+	ASSERT_EQ(resource.View.VertexCount, vertices.size());
+	ASSERT_EQ(resource.View.VertexStride, sizeof(AnimatedVertex));
+	ASSERT_EQ(memcmp(resource.View.Vertices, vertices.data(), vertices.size() * sizeof(AnimatedVertex)), 0);
+	ASSERT_EQ(resource.BoneParents, boneParents);
+	ASSERT_EQ(resource.Animations.size(), 1u);
+	ASSERT_EQ(resource.Animations[0]->KeyFrameCount, 2);
+	ASSERT_EQ(resource.Animations[0]->KeyFrames[1].BoneTransformCount, 0);
+
+	for (auto animation : resource.Animations)
+	{
+		delete animation;
+	}
+	resource.Unload();
+	remove(FILE_PATH);
+}
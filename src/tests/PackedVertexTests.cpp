@@ -0,0 +1,75 @@
+#include "gtest/gtest.h"
+
+#include "graphics/PackedVertex.h"
+
+using namespace Euler;
+
+TEST(PackedVertexTests, Sizes) {
+	ASSERT_EQ(sizeof(PackedVertex), 24);
+	ASSERT_EQ(sizeof(PackedAnimatedVertex), 32);
+}
+
+TEST(PackedVertexTests, OctahedralRoundTrip) {
+	Vec3 directions[] = { Vec3(0, 0, 1), Vec3(0, 0, -1), Vec3(1, 0, 0), Vec3(0, -1, 0), Vec3(1, 2, -3), Vec3(-0.3f, 0.1f, -0.9f) };
+
+	for (Vec3 direction : directions)
+	{
+		direction.Normalize();
+
+		float x, y;
+		EncodeOctahedral(direction, &x, &y);
+		Vec3 decoded = DecodeOctahedral(x, y);
+
+		ASSERT_NEAR(decoded.x, direction.x, 1e-5f);
+		ASSERT_NEAR(decoded.y, direction.y, 1e-5f);
+		ASSERT_NEAR(decoded.z, direction.z, 1e-5f);
+	}
+}
+
+TEST(PackedVertexTests, HalfRoundTrip) {
+	float exact[] = { 0.0f, 1.0f, -2.5f, 0.25f, 65504.0f, 5.9604645e-8f };
+	for (float value : exact)
+	{
+		ASSERT_EQ(HalfToFloat(FloatToHalf(value)), value);
+	}
+
+	// 11 significant bits
+	ASSERT_NEAR(HalfToFloat(FloatToHalf(0.3337f)), 0.3337f, 0.3337f / 2048.0f);
+	ASSERT_TRUE(isinf(HalfToFloat(FloatToHalf(70000.0f))));
+}
+
+TEST(PackedVertexTests, VertexRoundTrip) {
+	Vec3 normal = Vec3(0.2f, 0.9f, -0.3f).Normalized();
+	Vec3 tangent = Vec3(1, 0, 0).Cross(normal).Normalized();
+
+	// both handednesses
+	for (float handedness : { 1.0f, -1.0f })
+	{
+		Vec3 bitangent = handedness * normal.Cross(tangent);
+		Vertex vertex(Vec3(1.5f, -2.0f, 3.25f), normal, tangent, bitangent, Vec2(0.75f, 2.5f));
+
+		Vertex unpacked = UnpackVertex(PackVertex(vertex));
+
+		ASSERT_EQ(unpacked.Position.x, vertex.Position.x);
+		ASSERT_NEAR(unpacked.Normal.Dot(normal), 1.0f, 1e-4f);
+		ASSERT_NEAR(unpacked.Tangent.Dot(tangent), 1.0f, 1e-4f);
+		ASSERT_NEAR(unpacked.Bitangent.Dot(bitangent), 1.0f, 1e-3f);
+		ASSERT_FLOAT_EQ(unpacked.UV.x, 0.75f);
+		ASSERT_FLOAT_EQ(unpacked.UV.y, 2.5f);
+	}
+}
+
+TEST(PackedVertexTests, AnimatedVertexBones) {
+	AnimatedVertex vertex(Vec3(0, 1, 0), Vec3(0, 1, 0), Vec2(0, 0), Vec3i(7, 31, -1), Vec3(0.75f, 0.25f, 0.0f));
+
+	PackedAnimatedVertex packed = PackAnimatedVertex(vertex);
+	ASSERT_EQ(packed.BoneIds[2], 0);
+	ASSERT_EQ(packed.BoneWeights[2], 0);
+
+	AnimatedVertex unpacked = UnpackAnimatedVertex(packed);
+	ASSERT_EQ(unpacked.BoneIds.x, 7);
+	ASSERT_EQ(unpacked.BoneIds.y, 31);
+	ASSERT_EQ(unpacked.BoneIds.z, -1);
+	ASSERT_NEAR(unpacked.BoneWeights.x, 0.75f, 1.0f / 255.0f);
+	ASSERT_NEAR(unpacked.BoneWeights.y, 0.25f, 1.0f / 255.0f);
+}
@@ -0,0 +1,59 @@
+#include "gtest/gtest.h"
+
+#include "util/RadixSort.h"
+
+#include <algorithm>
+
+using namespace Euler;
+
+TEST(RadixSortTests, Empty) {
+	std::vector<uint32_t> indices, scratch;
+	RadixSortIndices(nullptr, 0, indices, scratch);
+
+	ASSERT_TRUE(indices.empty());
+}
+
+TEST(RadixSortTests, SortsAscending) {
+	uint64_t keys[] = { 5, 0xFFFFFFFFFFFFFFFFull, 0, 1ull << 40, 300, 7 };
+	std::vector<uint32_t> indices, scratch;
+	RadixSortIndices(keys, 6, indices, scratch);
+
+	ASSERT_EQ(indices.size(), 6);
+	for (uint32_t i = 1; i < indices.size(); i++)
+	{
+		ASSERT_LE(keys[indices[i - 1]], keys[indices[i]]);
+	}
+	ASSERT_EQ(indices[0], 2);
+	ASSERT_EQ(indices[5], 1);
+}
+
+TEST(RadixSortTests, Stable) {
+	uint64_t keys[] = { 2, 1, 2, 1, 2 };
+	std::vector<uint32_t> indices, scratch;
+	RadixSortIndices(keys, 5, indices, scratch);
+
+	std::vector<uint32_t> expected = { 1, 3, 0, 2, 4 };
+	ASSERT_EQ(indices, expected);
+}
+
+TEST(RadixSortTests, MatchesStdSort) {
+	std::vector<uint64_t> keys;
+	uint64_t state = 0x9E3779B97F4A7C15ull;
+	for (int i = 0; i < 1000; i++)
+	{
+		state ^= state << 13;
+		state ^= state >> 7;
+		state ^= state << 17;
+		keys.push_back(state);
+	}
+
+	std::vector<uint32_t> indices, scratch;
+	RadixSortIndices(keys.data(), keys.size(), indices, scratch);
+
+	std::vector<uint64_t> sorted = keys;
+	std::sort(sorted.begin(), sorted.end());
+	for (uint32_t i = 0; i < keys.size(); i++)
+	{
+		ASSERT_EQ(keys[indices[i]], sorted[i]);
+	}
+}
@@ -0,0 +1,133 @@
+#include "gtest/gtest.h"
+
+#include "graphics/vulkan/SamplerCache.h"
+
+#include <vector>
+
+using namespace Euler::Graphics;
+
+namespace
+{
+	// stand-ins for the device, the handles are just counted up
+	std::vector<VkSamplerCreateInfo> createdSamplers;
+	uint32_t destroyedSamplers = 0;
+
+	VKAPI_ATTR VkResult VKAPI_CALL CreateSampler(VkDevice, const VkSamplerCreateInfo* createInfo, const VkAllocationCallbacks*, VkSampler* sampler)
+	{
+		createdSamplers.push_back(*createInfo);
+		*sampler = (VkSampler)(uintptr_t)createdSamplers.size();
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR void VKAPI_CALL DestroySampler(VkDevice, VkSampler, const VkAllocationCallbacks*)
+	{
+		destroyedSamplers++;
+	}
+
+	void CreateCache(SamplerCache& cache, bool anisotropy)
+	{
+		createdSamplers.clear();
+		destroyedSamplers = 0;
+
+		VkPhysicalDeviceLimits limits{};
+		limits.maxSamplerAllocationCount = 4000;
+		limits.maxSamplerAnisotropy = 16.0f;
+		cache.Create(VK_NULL_HANDLE, limits, anisotropy, CreateSampler, DestroySampler);
+	}
+}
+
+TEST(SamplerCacheTests, EqualDescriptionsHashEqual) {
+	SamplerDesc a;
+	SamplerDesc b;
+	ASSERT_TRUE(a == b);
+	ASSERT_EQ(a.GetHash(), b.GetHash());
+
+	a.MaxLod = 4.0f;
+	b.MaxLod = 4.0f;
+	ASSERT_TRUE(a == b);
+	ASSERT_EQ(a.GetHash(), b.GetHash());
+}
+
+TEST(SamplerCacheTests, EveryFieldChangesTheKey) {
+	SamplerDesc base;
+	std::vector<SamplerDesc> changed(13, base);
+	changed[0].MagFilter = VK_FILTER_NEAREST;
+	changed[1].MinFilter = VK_FILTER_NEAREST;
+	changed[2].MipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	changed[3].AddressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	changed[4].AddressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	changed[5].AddressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	changed[6].BorderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
+	changed[7].MaxAnisotropy = 1.0f;
+	changed[8].MipLodBias = 0.5f;
+	changed[9].MinLod = 1.0f;
+	changed[10].MaxLod = 4.0f;
+	changed[11].CompareEnable = true;
+	changed[12].CompareOp = VK_COMPARE_OP_LESS;
+
+	for (const SamplerDesc& desc : changed)
+	{
+		ASSERT_FALSE(desc == base);
+		ASSERT_NE(desc.GetHash(), base.GetHash());
+	}
+}
+
+TEST(SamplerCacheTests, ReleaseDestroysTheLastReference) {
+	SamplerCache cache;
+	CreateCache(cache, true);
+
+	SamplerDesc clamped;
+	clamped.AddressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+
+	VkSampler a = cache.Acquire(SamplerDesc());
+	VkSampler b = cache.Acquire(SamplerDesc());
+	VkSampler c = cache.Acquire(clamped);
+	ASSERT_EQ(a, b);
+	ASSERT_NE(a, c);
+	ASSERT_EQ(cache.GetSamplerCount(), 2u);
+	ASSERT_EQ(createdSamplers.size(), 2u);
+
+	cache.Release(a);
+	ASSERT_EQ(destroyedSamplers, 0u);
+	ASSERT_EQ(cache.GetSamplerCount(), 2u);
+
+	cache.Release(b);
+	ASSERT_EQ(destroyedSamplers, 1u);
+	ASSERT_EQ(cache.GetSamplerCount(), 1u);
+
+	// a released description gets a new sampler
+	cache.Acquire(SamplerDesc());
+	ASSERT_EQ(createdSamplers.size(), 3u);
+
+	cache.Destroy();
+	ASSERT_EQ(destroyedSamplers, 3u);
+	ASSERT_EQ(cache.GetSamplerCount(), 0u);
+}
+
+TEST(SamplerCacheTests, DefaultAnisotropyIsTheDeviceLimit) {
+	SamplerCache cache;
+	CreateCache(cache, true);
+
+	SamplerDesc deviceLimit;
+	SamplerDesc sixteen;
+	sixteen.MaxAnisotropy = 16.0f;
+	SamplerDesc tooHigh;
+	tooHigh.MaxAnisotropy = 64.0f;
+
+	// 0, the limit and anything above it are the same sampler
+	VkSampler sampler = cache.Acquire(deviceLimit);
+	ASSERT_EQ(cache.Acquire(sixteen), sampler);
+	ASSERT_EQ(cache.Acquire(tooHigh), sampler);
+	ASSERT_EQ(createdSamplers.size(), 1u);
+	ASSERT_EQ(createdSamplers[0].anisotropyEnable, VK_TRUE);
+	ASSERT_EQ(createdSamplers[0].maxAnisotropy, 16.0f);
+	cache.Destroy();
+
+	// without the feature 0 turns anisotropic filtering off
+	CreateCache(cache, false);
+	cache.Acquire(deviceLimit);
+	ASSERT_EQ(createdSamplers.size(), 1u);
+	ASSERT_EQ(createdSamplers[0].anisotropyEnable, VK_FALSE);
+	ASSERT_EQ(createdSamplers[0].maxAnisotropy, 1.0f);
+	cache.Destroy();
+}
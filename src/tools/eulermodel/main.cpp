@@ -6,25 +6,58 @@
 #include <map>
 #include <algorithm>
 #include <fstream>
+#include <string.h>
+#include <stdlib.h>
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 #include <graphics/Vertex.h>
 #include <graphics/AnimatedVertex.h>
+#include <graphics/PackedVertex.h>
 #include <graphics/Animation.h>
+#include <graphics/MeshLod.h>
+#include <util/MeshSimplifier.h>
+#include <util/MeshOptimizer.h>
+#include <math/Bounds.h>
 #include <math/Mat4.h>
 #include <math/Quaternion.h>
 
+// "BEM3" and "BEA3", see ModelResource and AnimatedModelResource
+const uint32_t MODEL_FILE_MAGIC = 0x334D4542;
+const uint32_t ANIMATED_MODEL_FILE_MAGIC = 0x33414542;
+
+// meshes with at most this many vertices are written with 16-bit indices
+const uint32_t MAX_SHORT_INDEX_VERTICES = 65536;
+
+// levels of detail stop when a level would move the surface further than this fraction of the mesh's radius
+const float MAX_LOD_ERROR = 0.1f;
+const uint32_t MAX_LODS = 6;
+
+// post-transform cache the triangle order is optimized for, and how much of its efficiency the overdraw order may give up
+const uint32_t VERTEX_CACHE_SIZE = 16;
+const float OVERDRAW_THRESHOLD = 1.05f;
+
+// set from the command line: [--no-optimize] [--overdraw <threshold>] [--packed] [--no-short-indices] [--split], a threshold
+// of 0 skips the overdraw order, --packed writes PackedVertex/PackedAnimatedVertex for pipelines with UsePackedVertices
+// and --split writes static meshes too big for 16-bit indices as several meshes that aren't
+bool optimizeMeshes = true;
+float overdrawThreshold = OVERDRAW_THRESHOLD;
+uint32_t vertexFormat = Euler::VERTEX_FORMAT_FULL;
+bool shortIndices = true;
+bool splitMeshes = false;
+
 struct Mesh
 {
 	std::vector<Euler::Vertex> Vertices;
 	std::vector<uint32_t> Indices;
+	std::vector<Euler::MeshLod> Lods;
 };
 
 struct AnimatedMesh
 {
 	std::vector<Euler::AnimatedVertex> Vertices;
 	std::vector<uint32_t> Indices;
+	std::vector<Euler::MeshLod> Lods;
 	std::vector<Mat4> BoneTransforms;
 	std::vector<int> BoneParents;
 	std::vector<Mat4> BoneOffsetMatrices;
@@ -34,8 +67,178 @@ void ProcessScene(std::string filePath, const aiScene* scene);
 void ProcessSceneWithAnimations(std::string filePath, const aiScene* scene);
 void AddBoneToVertex(Euler::AnimatedVertex* vertex, int boneId, float weight);
 
+// reorders the triangles for the vertex cache and overdraw, then the vertices into the order the triangles use them
+template<typename TVertex>
+void OptimizeMesh(std::vector<TVertex>& vertices, std::vector<uint32_t>& indices)
+{
+	if (!optimizeMeshes || vertices.empty() || indices.empty())
+	{
+		return;
+	}
+
+	Euler::VertexCacheStats before = Euler::AnalyzeVertexCache(indices.data(), indices.size(), vertices.size(), VERTEX_CACHE_SIZE);
+
+	std::vector<uint32_t> optimized;
+	if (overdrawThreshold > 0.0f)
+	{
+		Euler::OptimizeOverdraw(&vertices[0].Position, sizeof(TVertex), indices.data(), indices.size(), vertices.size(), overdrawThreshold, optimized, VERTEX_CACHE_SIZE);
+	}
+	else
+	{
+		Euler::OptimizeVertexCache(indices.data(), indices.size(), vertices.size(), optimized, VERTEX_CACHE_SIZE);
+	}
+	indices.swap(optimized);
+
+	uint32_t vertexCount = Euler::OptimizeVertexFetch(vertices.data(), vertices.size(), sizeof(TVertex), indices.data(), indices.size());
+	vertices.resize(vertexCount);
+
+	Euler::VertexCacheStats after = Euler::AnalyzeVertexCache(indices.data(), indices.size(), vertices.size(), VERTEX_CACHE_SIZE);
+
+	std::cout << "ACMR: " << before.Acmr << " -> " << after.Acmr << std::endl;
+	std::cout << "ATVR: " << before.Atvr << " -> " << after.Atvr << std::endl;
+}
+
+// appends the simplified levels to indices, each with about half the triangles of the one before
+template<typename TVertex>
+void GenerateLods(const std::vector<TVertex>& vertices, std::vector<uint32_t>& indices, std::vector<Euler::MeshLod>& lods)
+{
+	uint32_t indexCount = indices.size();
+	lods.clear();
+	lods.push_back({ 0, indexCount, 0.0f });
+
+	if (vertices.empty() || indices.empty())
+	{
+		return;
+	}
+
+	Euler::Math::BoundingSphere sphere = Euler::Math::BoundingSphere::FromPoints(&vertices[0].Position, vertices.size(), sizeof(TVertex));
+	float maxError = sphere.Radius * MAX_LOD_ERROR;
+
+	std::vector<uint32_t> lodIndices;
+	while (lods.size() < MAX_LODS)
+	{
+		uint32_t previousCount = lods.back().IndexCount;
+
+		// always from the full mesh, so the errors don't add up
+		float error = Euler::SimplifyMesh(&vertices[0].Position, vertices.size(), sizeof(TVertex), indices.data(), indexCount, previousCount / 2, maxError, lodIndices);
+
+		// not worth a level when it barely got smaller
+		if (lodIndices.empty() || lodIndices.size() > previousCount * 4 / 5)
+		{
+			break;
+		}
+
+		if (optimizeMeshes)
+		{
+			std::vector<uint32_t> optimized;
+			Euler::OptimizeVertexCache(lodIndices.data(), lodIndices.size(), vertices.size(), optimized, VERTEX_CACHE_SIZE);
+			lodIndices.swap(optimized);
+		}
+
+		Euler::MeshLod lod;
+		lod.FirstIndex = indices.size();
+		lod.IndexCount = lodIndices.size();
+		lod.Error = std::max(error, lods.back().Error);
+		lods.push_back(lod);
+
+		indices.insert(indices.end(), lodIndices.begin(), lodIndices.end());
+
+		std::cout << "LOD " << lods.size() - 1 << ": " << lod.IndexCount / 3 << " triangles, error " << lod.Error << std::endl;
+	}
+}
+
+template<typename TVertex, typename TPackedVertex>
+void WriteVertices(std::ofstream& bfs, const std::vector<TVertex>& vertices, TPackedVertex(*pack)(const TVertex&))
+{
+	if (vertexFormat == Euler::VERTEX_FORMAT_PACKED)
+	{
+		std::vector<TPackedVertex> packed(vertices.size());
+		for (uint32_t i = 0; i < vertices.size(); i++)
+		{
+			packed[i] = pack(vertices[i]);
+		}
+		bfs.write((const char*)packed.data(), packed.size() * sizeof(TPackedVertex));
+	}
+	else
+	{
+		bfs.write((const char*)vertices.data(), vertices.size() * sizeof(TVertex));
+	}
+}
+
+template<typename TVertex>
+uint32_t GetIndexSize(const std::vector<TVertex>& vertices)
+{
+	return shortIndices && vertices.size() <= MAX_SHORT_INDEX_VERTICES ? sizeof(uint16_t) : sizeof(uint32_t);
+}
+
+void WriteIndices(std::ofstream& bfs, const std::vector<uint32_t>& indices, uint32_t indexSize)
+{
+	if (indexSize == sizeof(uint16_t))
+	{
+		std::vector<uint16_t> shortIndices(indices.begin(), indices.end());
+		bfs.write((const char*)shortIndices.data(), shortIndices.size() * sizeof(uint16_t));
+	}
+	else
+	{
+		bfs.write((const char*)indices.data(), indices.size() * sizeof(uint32_t));
+	}
+}
+
+// splits the mesh into meshes of at most MAX_SHORT_INDEX_VERTICES vertices, after ordering the triangles for the
+// vertex cache so the parts stay compact
+void SplitMesh(const Mesh& mesh, std::vector<Mesh>& parts)
+{
+	if (mesh.Vertices.size() <= MAX_SHORT_INDEX_VERTICES)
+	{
+		parts.push_back(mesh);
+		return;
+	}
+
+	std::vector<uint32_t> ordered;
+	Euler::OptimizeVertexCache(mesh.Indices.data(), mesh.Indices.size(), mesh.Vertices.size(), ordered, VERTEX_CACHE_SIZE);
+
+	std::vector<Euler::MeshPart> meshParts;
+	Euler::SplitMesh(ordered.data(), ordered.size(), mesh.Vertices.size(), MAX_SHORT_INDEX_VERTICES, meshParts);
+	std::cout << "Split into " << meshParts.size() << " meshes" << std::endl;
+
+	for (const Euler::MeshPart& meshPart : meshParts)
+	{
+		Mesh part;
+		part.Indices = meshPart.Indices;
+		for (uint32_t vertex : meshPart.Vertices)
+		{
+			part.Vertices.push_back(mesh.Vertices[vertex]);
+		}
+		parts.push_back(part);
+	}
+}
+
 int main(int argc, char** argv)
 {
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--no-optimize") == 0)
+		{
+			optimizeMeshes = false;
+		}
+		else if (strcmp(argv[i], "--overdraw") == 0 && i + 1 < argc)
+		{
+			overdrawThreshold = (float)atof(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--packed") == 0)
+		{
+			vertexFormat = Euler::VERTEX_FORMAT_PACKED;
+		}
+		else if (strcmp(argv[i], "--no-short-indices") == 0)
+		{
+			shortIndices = false;
+		}
+		else if (strcmp(argv[i], "--split") == 0)
+		{
+			splitMeshes = true;
+		}
+	}
+
 	Assimp::Importer importer;
 
 	std::cout << "Enter file path: ";
@@ -149,6 +352,24 @@ void ProcessScene(std::string filePath, const aiScene* scene)
 			mesh->Indices[i + 1] = face.mIndices[1];
 			mesh->Indices[i + 2] = face.mIndices[2];
 		}
+
+	}
+
+	if (splitMeshes)
+	{
+		std::vector<Mesh> parts;
+		for (const Mesh& mesh : meshes)
+		{
+			SplitMesh(mesh, parts);
+		}
+		meshes.swap(parts);
+	}
+
+	// optimize for the GPU and generate levels of detail
+	for (Mesh& mesh : meshes)
+	{
+		OptimizeMesh(mesh.Vertices, mesh.Indices);
+		GenerateLods(mesh.Vertices, mesh.Indices, mesh.Lods);
 	}
 
 	/* === write the .bem (binary euler model) file === */
@@ -159,8 +380,21 @@ void ProcessScene(std::string filePath, const aiScene* scene)
 
 	std::ofstream bfs(fileName, std::ios::out | std::ios::binary);
 
+	bfs.write((const char*)(&MODEL_FILE_MAGIC), sizeof(MODEL_FILE_MAGIC));
+
 	uint32_t numberOfMeshes = meshes.size();
 	bfs.write((const char*)(&numberOfMeshes), sizeof(numberOfMeshes));
+	bfs.write((const char*)(&vertexFormat), sizeof(vertexFormat));
+
+	/*
+	* vertex_count
+	* index_count, of all levels
+	* lod_count
+	* index_size, 2 or 4 bytes
+	* [vertices]
+	* [indices], full detail first
+	* [lods]
+	*/
 
 	for (int meshIndex = 0; meshIndex < numberOfMeshes; meshIndex++)
 	{
@@ -168,12 +402,17 @@ void ProcessScene(std::string filePath, const aiScene* scene)
 
 		uint32_t vertexCount = mesh->Vertices.size();
 		uint32_t indexCount = mesh->Indices.size();
+		uint32_t lodCount = mesh->Lods.size();
+		uint32_t indexSize = GetIndexSize(mesh->Vertices);
 
 		bfs.write((const char*)(&vertexCount), sizeof(vertexCount));
 		bfs.write((const char*)(&indexCount), sizeof(indexCount));
+		bfs.write((const char*)(&lodCount), sizeof(lodCount));
+		bfs.write((const char*)(&indexSize), sizeof(indexSize));
 
-		bfs.write((const char*)mesh->Vertices.data(), mesh->Vertices.size() * sizeof(Euler::Vertex));
-		bfs.write((const char*)mesh->Indices.data(), mesh->Indices.size() * sizeof(uint32_t));
+		WriteVertices(bfs, mesh->Vertices, Euler::PackVertex);
+		WriteIndices(bfs, mesh->Indices, indexSize);
+		bfs.write((const char*)mesh->Lods.data(), mesh->Lods.size() * sizeof(Euler::MeshLod));
 	}
 
 	bfs.close();
@@ -266,6 +505,12 @@ void ProcessSceneWithAnimations(std::string filePath, const aiScene* scene)
 			}
 		}
 
+		// the weights are in place, the vertices can move now
+		OptimizeMesh(mesh->Vertices, mesh->Indices);
+
+		// generate levels of detail
+		GenerateLods(mesh->Vertices, mesh->Indices, mesh->Lods);
+
 		mesh->BoneParents.resize(MAX_BONES, -1);
 		mesh->BoneOffsetMatrices.resize(MAX_BONES);
 		for (int i = 0; i < aiMesh->mNumBones; i++)
@@ -378,8 +623,11 @@ void ProcessSceneWithAnimations(std::string filePath, const aiScene* scene)
 
 	std::ofstream bfs(fileName, std::ios::out | std::ios::binary);
 
+	bfs.write((const char*)(&ANIMATED_MODEL_FILE_MAGIC), sizeof(ANIMATED_MODEL_FILE_MAGIC));
+
 	uint32_t numberOfMeshes = meshes.size();
 	bfs.write((const char*)(&numberOfMeshes), sizeof(numberOfMeshes));
+	bfs.write((const char*)(&vertexFormat), sizeof(vertexFormat));
 
 	for (int meshIndex = 0; meshIndex < numberOfMeshes; meshIndex++)
 	{
@@ -387,12 +635,17 @@ void ProcessSceneWithAnimations(std::string filePath, const aiScene* scene)
 
 		uint32_t vertexCount = mesh->Vertices.size();
 		uint32_t indexCount = mesh->Indices.size();
+		uint32_t lodCount = mesh->Lods.size();
+		uint32_t indexSize = GetIndexSize(mesh->Vertices);
 
 		bfs.write((const char*)(&vertexCount), sizeof(vertexCount));
 		bfs.write((const char*)(&indexCount), sizeof(indexCount));
+		bfs.write((const char*)(&lodCount), sizeof(lodCount));
+		bfs.write((const char*)(&indexSize), sizeof(indexSize));
 
-		bfs.write((const char*)mesh->Vertices.data(), mesh->Vertices.size() * sizeof(Euler::AnimatedVertex));
-		bfs.write((const char*)mesh->Indices.data(), mesh->Indices.size() * sizeof(uint32_t));
+		WriteVertices(bfs, mesh->Vertices, Euler::PackAnimatedVertex);
+		WriteIndices(bfs, mesh->Indices, indexSize);
+		bfs.write((const char*)mesh->Lods.data(), mesh->Lods.size() * sizeof(Euler::MeshLod));
 
 		bfs.write((const char*)mesh->BoneParents.data(), MAX_BONES * sizeof(int));
 		bfs.write((const char*)mesh->BoneOffsetMatrices.data(), MAX_BONES * sizeof(Mat4));
@@ -0,0 +1,289 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <string.h>
+#include <math.h>
+#include <resources/TextureResource.h>
+#include <resources/Ktx2.h>
+#include <util/BlockCompression.h>
+#include <util/MipChain.h>
+#include <io/Utils.h>
+
+// Khronos data format descriptor values for the basic descriptor block, see the KTX 2.0 and data format specs
+const uint32_t DFD_VERSION = 2;
+const uint32_t DFD_COLOR_MODEL_BC1A = 128;
+const uint32_t DFD_COLOR_MODEL_BC3 = 130;
+const uint32_t DFD_COLOR_MODEL_BC5 = 132;
+const uint32_t DFD_COLOR_MODEL_BC7 = 134;
+const uint32_t DFD_PRIMARIES_BT709 = 1;
+const uint32_t DFD_TRANSFER_LINEAR = 1;
+const uint32_t DFD_TRANSFER_SRGB = 2;
+const uint32_t DFD_CHANNEL_COLOR = 0;
+const uint32_t DFD_CHANNEL_RED = 0;
+const uint32_t DFD_CHANNEL_GREEN = 1;
+const uint32_t DFD_CHANNEL_ALPHA = 15;
+const uint32_t DFD_SAMPLE_LINEAR = 0x10;
+
+// set from the command line: [--format bc1|bc3|bc5|bc7] [--normal] [--linear] [files...]. Colors are BC7 by default,
+// --normal is BC5 with renormalized mips and --linear is for data that isn't sRGB. Without files it asks for one
+Euler::TextureFormat textureFormat = Euler::TEXTURE_FORMAT_BC7;
+bool normalMap = false;
+bool srgb = true;
+
+struct DfdSample
+{
+	uint32_t BitOffset;
+	uint32_t BitLength;
+	uint32_t Channel;
+};
+
+std::vector<uint32_t> CreateDfd(Euler::TextureFormat format, bool srgb)
+{
+	uint32_t colorModel;
+	std::vector<DfdSample> samples;
+	switch (format)
+	{
+	case Euler::TEXTURE_FORMAT_BC1:
+		colorModel = DFD_COLOR_MODEL_BC1A;
+		samples.push_back({ 0, 64, DFD_CHANNEL_COLOR });
+		break;
+
+	case Euler::TEXTURE_FORMAT_BC3:
+		colorModel = DFD_COLOR_MODEL_BC3;
+		samples.push_back({ 0, 64, DFD_CHANNEL_ALPHA | (srgb ? DFD_SAMPLE_LINEAR : 0) });
+		samples.push_back({ 64, 64, DFD_CHANNEL_COLOR });
+		break;
+
+	case Euler::TEXTURE_FORMAT_BC5:
+		colorModel = DFD_COLOR_MODEL_BC5;
+		samples.push_back({ 0, 64, DFD_CHANNEL_RED });
+		samples.push_back({ 64, 64, DFD_CHANNEL_GREEN });
+		break;
+
+	default:
+	case Euler::TEXTURE_FORMAT_BC7:
+		colorModel = DFD_COLOR_MODEL_BC7;
+		samples.push_back({ 0, 128, DFD_CHANNEL_COLOR });
+		break;
+	}
+
+	uint32_t blockSize = 24 + 16 * samples.size();
+
+	std::vector<uint32_t> dfd;
+	dfd.push_back(4 + blockSize);
+	dfd.push_back(0);
+	dfd.push_back(DFD_VERSION | (blockSize << 16));
+	dfd.push_back(colorModel | (DFD_PRIMARIES_BT709 << 8) | ((srgb ? DFD_TRANSFER_SRGB : DFD_TRANSFER_LINEAR) << 16));
+	// 4x4x1x1 texel blocks, stored minus one
+	dfd.push_back(3 | (3 << 8));
+	dfd.push_back(Euler::GetBlockSize(format));
+	dfd.push_back(0);
+
+	for (const DfdSample& sample : samples)
+	{
+		dfd.push_back(sample.BitOffset | ((sample.BitLength - 1) << 16) | (sample.Channel << 24));
+		dfd.push_back(0);
+		dfd.push_back(0);
+		dfd.push_back(0xFFFFFFFF);
+	}
+
+	return dfd;
+}
+
+void Append(std::vector<char>& data, const void* value, size_t size)
+{
+	data.insert(data.end(), (const char*)value, (const char*)value + size);
+}
+
+// xyz back to unit length, the box filter shortens normals where they diverge
+void RenormalizeNormals(std::vector<uint8_t>& pixels)
+{
+	for (uint32_t i = 0; i < pixels.size(); i += 4)
+	{
+		float normal[3];
+		float length = 0.0f;
+		for (uint32_t c = 0; c < 3; c++)
+		{
+			normal[c] = pixels[i + c] / 255.0f * 2.0f - 1.0f;
+			length += normal[c] * normal[c];
+		}
+
+		length = sqrtf(length);
+		if (length == 0.0f)
+		{
+			continue;
+		}
+
+		for (uint32_t c = 0; c < 3; c++)
+		{
+			pixels[i + c] = (uint8_t)roundf((normal[c] / length * 0.5f + 0.5f) * 255.0f);
+		}
+	}
+}
+
+bool CookTexture(const std::string& filePath)
+{
+	std::cout << "Reading file " << filePath << std::endl;
+
+	Euler::TextureResource textureResource;
+	textureResource.Load(filePath.c_str(), Euler::TEXTURE_CHANNELS_RGBA);
+	if (textureResource.GetData() == nullptr)
+	{
+		std::cout << "Failed to load " << filePath << std::endl;
+		return false;
+	}
+
+	uint32_t width = textureResource.GetWidth();
+	uint32_t height = textureResource.GetHeight();
+
+	/* === generate the mip chain === */
+
+	std::vector<std::vector<uint8_t>> levels(1);
+	levels[0].assign(textureResource.GetData(), textureResource.GetData() + width * height * 4);
+	textureResource.Unload();
+
+	std::vector<std::vector<uint8_t>> mipChain;
+	Euler::GenerateMipChain(levels[0].data(), width, height, srgb, mipChain);
+	for (std::vector<uint8_t>& level : mipChain)
+	{
+		if (normalMap)
+		{
+			RenormalizeNormals(level);
+		}
+		levels.push_back(level);
+	}
+
+	/* === compress the levels === */
+
+	std::vector<std::vector<uint8_t>> blocks(levels.size());
+	uint64_t compressedSize = 0;
+	uint64_t uncompressedSize = 0;
+	for (uint32_t i = 0; i < levels.size(); i++)
+	{
+		uint32_t levelWidth = width >> i > 0 ? width >> i : 1;
+		uint32_t levelHeight = height >> i > 0 ? height >> i : 1;
+		Euler::CompressBlocks(levels[i].data(), levelWidth, levelHeight, textureFormat, blocks[i]);
+
+		compressedSize += blocks[i].size();
+		uncompressedSize += levels[i].size();
+	}
+
+	/* === write the .ktx2 file === */
+
+	std::vector<uint32_t> dfd = CreateDfd(textureFormat, srgb);
+
+	Euler::Ktx2Header header = {};
+	memcpy(header.Identifier, Euler::KTX2_IDENTIFIER, sizeof(header.Identifier));
+	header.VkFormat = Euler::GetVkFormat(textureFormat, srgb);
+	header.TypeSize = 1;
+	header.PixelWidth = width;
+	header.PixelHeight = height;
+	header.FaceCount = 1;
+	header.LevelCount = levels.size();
+	header.DfdByteOffset = sizeof(header) + levels.size() * sizeof(Euler::Ktx2Level);
+	header.DfdByteLength = dfd.size() * sizeof(uint32_t);
+
+	// the levels are stored smallest first, each aligned to the block size
+	std::vector<Euler::Ktx2Level> levelIndex(levels.size());
+	uint64_t offset = header.DfdByteOffset + header.DfdByteLength;
+	for (int32_t i = levels.size() - 1; i >= 0; i--)
+	{
+		offset = (offset + 15) & ~15ull;
+		levelIndex[i].ByteOffset = offset;
+		levelIndex[i].ByteLength = blocks[i].size();
+		levelIndex[i].UncompressedByteLength = blocks[i].size();
+		offset += blocks[i].size();
+	}
+
+	std::vector<char> data;
+	Append(data, &header, sizeof(header));
+	Append(data, levelIndex.data(), levelIndex.size() * sizeof(Euler::Ktx2Level));
+	Append(data, dfd.data(), dfd.size() * sizeof(uint32_t));
+	for (int32_t i = levels.size() - 1; i >= 0; i--)
+	{
+		data.resize(levelIndex[i].ByteOffset);
+		Append(data, blocks[i].data(), blocks[i].size());
+	}
+
+	std::string fileName = filePath.substr(0, filePath.find_last_of(".")) + ".ktx2";
+	if (!Euler::WriteFile(fileName.c_str(), data))
+	{
+		std::cout << "Failed to write " << fileName << std::endl;
+		return false;
+	}
+
+	std::cout << "Wrote " << fileName << ": " << width << "x" << height << ", " << levels.size() << " levels, "
+		<< compressedSize / 1024 << " KB instead of " << uncompressedSize / 1024 << " KB" << std::endl;
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	bool formatSet = false;
+	std::vector<std::string> filePaths;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--format") == 0 && i + 1 < argc)
+		{
+			const char* format = argv[++i];
+			formatSet = true;
+			if (strcmp(format, "bc1") == 0)
+			{
+				textureFormat = Euler::TEXTURE_FORMAT_BC1;
+			}
+			else if (strcmp(format, "bc3") == 0)
+			{
+				textureFormat = Euler::TEXTURE_FORMAT_BC3;
+			}
+			else if (strcmp(format, "bc5") == 0)
+			{
+				textureFormat = Euler::TEXTURE_FORMAT_BC5;
+			}
+			else if (strcmp(format, "bc7") == 0)
+			{
+				textureFormat = Euler::TEXTURE_FORMAT_BC7;
+			}
+			else
+			{
+				std::cout << "Unknown format " << format << std::endl;
+				return 1;
+			}
+		}
+		else if (strcmp(argv[i], "--normal") == 0)
+		{
+			normalMap = true;
+		}
+		else if (strcmp(argv[i], "--linear") == 0)
+		{
+			srgb = false;
+		}
+		else
+		{
+			filePaths.push_back(argv[i]);
+		}
+	}
+
+	if (normalMap)
+	{
+		textureFormat = formatSet ? textureFormat : Euler::TEXTURE_FORMAT_BC5;
+		srgb = false;
+	}
+
+	if (filePaths.empty())
+	{
+		std::cout << "Enter file path: ";
+
+		std::string filePath;
+		std::cin >> filePath;
+		filePaths.push_back(filePath);
+	}
+
+	bool succeeded = true;
+	for (const std::string& filePath : filePaths)
+	{
+		succeeded = CookTexture(filePath) && succeeded;
+	}
+
+	std::cout << "Completed" << std::endl;
+	return succeeded ? 0 : 1;
+}